@@ -2312,6 +2312,8 @@ void AbstractClient::createDecoration(const QRect &oldGeometry)
     if (decoration) {
         QMetaObject::invokeMethod(decoration, "update", Qt::QueuedConnection);
         connect(decoration, &KDecoration2::Decoration::shadowChanged, this, &Toplevel::updateShadow);
+        connect(decoration, &KDecoration2::Decoration::opaqueChanged,
+                this, &AbstractClient::decorationHasAlphaChanged);
         connect(decoration, &KDecoration2::Decoration::bordersChanged,
                 this, &AbstractClient::updateDecorationInputShape);
         connect(decoration, &KDecoration2::Decoration::resizeOnlyBordersChanged,
@@ -917,6 +917,10 @@ Q_SIGNALS:
     void hasApplicationMenuChanged(bool);
     void applicationMenuActiveChanged(bool);
     void unresponsiveChanged(bool);
+    /**
+     * Emitted whenever the decoration switches between being opaque and having an alpha channel.
+     */
+    void decorationHasAlphaChanged();
 
 protected:
     AbstractClient();
@@ -0,0 +1,147 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "platform.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+using namespace KWin;
+using namespace KWayland::Client;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_client_lookup-0");
+
+class ClientLookupTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testLookup();
+    void benchmarkLookup_data();
+    void benchmarkLookup();
+};
+
+void ClientLookupTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+}
+
+void ClientLookupTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void ClientLookupTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void ClientLookupTest::testLookup()
+{
+    // This test verifies that clients are found by their surface and by their internal id,
+    // and that they can't be found anymore once they are closed.
+    const int clientCount = 10;
+    QVector<Surface *> surfaces;
+    QVector<XdgShellSurface *> shellSurfaces;
+    QVector<AbstractClient *> clients;
+    for (int i = 0; i < clientCount; ++i) {
+        Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        AbstractClient *client = Test::renderAndWaitForShown(surface, QSize(100, 50), Qt::blue);
+        QVERIFY(client);
+        surfaces << surface;
+        shellSurfaces << shellSurface;
+        clients << client;
+    }
+
+    for (AbstractClient *client : qAsConst(clients)) {
+        QCOMPARE(waylandServer()->findClient(client->surface()), client);
+        QCOMPARE(workspace()->findAbstractClient(client->internalId()), client);
+        QCOMPARE(workspace()->findToplevel(client->internalId()), client);
+    }
+
+    // Close every other client, the remaining ones are still found.
+    for (int i = 0; i < clientCount; i += 2) {
+        AbstractClient *client = clients[i];
+        KWaylandServer::SurfaceInterface *surface = client->surface();
+        const QUuid internalId = client->internalId();
+
+        delete shellSurfaces[i];
+        delete surfaces[i];
+        QVERIFY(Test::waitForWindowDestroyed(client));
+
+        QVERIFY(!waylandServer()->findClient(surface));
+        QVERIFY(!workspace()->findAbstractClient(internalId));
+        QVERIFY(!workspace()->findToplevel(internalId));
+    }
+
+    for (int i = 1; i < clientCount; i += 2) {
+        AbstractClient *client = clients[i];
+        QCOMPARE(waylandServer()->findClient(client->surface()), client);
+        QCOMPARE(workspace()->findAbstractClient(client->internalId()), client);
+        QCOMPARE(workspace()->findToplevel(client->internalId()), client);
+    }
+}
+
+void ClientLookupTest::benchmarkLookup_data()
+{
+    QTest::addColumn<int>("clientCount");
+
+    QTest::addRow("1000") << 1000;
+    QTest::addRow("3000") << 3000;
+}
+
+void ClientLookupTest::benchmarkLookup()
+{
+    // Measures how long it takes to find every client by its surface and by its internal id.
+    QFETCH(int, clientCount);
+
+    QVector<AbstractClient *> clients;
+    QVector<KWaylandServer::SurfaceInterface *> surfaces;
+    QVector<QUuid> internalIds;
+    clients.reserve(clientCount);
+    surfaces.reserve(clientCount);
+    internalIds.reserve(clientCount);
+    for (int i = 0; i < clientCount; ++i) {
+        // The wayland objects are destroyed along with the connection.
+        Surface *surface = Test::createSurface(Test::waylandCompositor());
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface, surface);
+        QVERIFY(shellSurface);
+        AbstractClient *client = Test::renderAndWaitForShown(surface, QSize(10, 10), Qt::blue);
+        QVERIFY(client);
+        clients << client;
+        surfaces << client->surface();
+        internalIds << client->internalId();
+    }
+
+    QBENCHMARK {
+        for (int i = 0; i < clientCount; ++i) {
+            QCOMPARE(waylandServer()->findClient(surfaces[i]), clients[i]);
+            QCOMPARE(workspace()->findAbstractClient(internalIds[i]), clients[i]);
+            QCOMPARE(workspace()->findToplevel(internalIds[i]), clients[i]);
+        }
+    }
+}
+
+WAYLANDTEST_MAIN(ClientLookupTest)
+#include "client_lookup_test.moc"
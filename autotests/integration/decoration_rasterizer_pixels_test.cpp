@@ -0,0 +1,157 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "abstract_wayland_output.h"
+#include "composite.h"
+#include "platform.h"
+#include "scene.h"
+#include "screens.h"
+#include "wayland_server.h"
+#include "decorations/decoratedclient.h"
+#include "decorations/decorationbridge.h"
+#include "decorations/decorationrasterizer.h"
+#include "plugins/scenes/qpainter/scene_qpainter.h"
+
+#include <KDecoration2/Decoration>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_decoration_rasterizer_pixels-0");
+
+using DecorationPart = SceneQPainterDecorationRenderer::DecorationPart;
+
+class DecorationRasterizerPixelsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testThreadedMatchesSynchronous_data();
+    void testThreadedMatchesSynchronous();
+};
+
+void DecorationRasterizerPixelsTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->scene()->compositingType(), KWin::QPainterCompositing);
+    QVERIFY(Decoration::DecorationBridge::self());
+}
+
+void DecorationRasterizerPixelsTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection(Test::AdditionalWaylandInterface::Decoration));
+}
+
+void DecorationRasterizerPixelsTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+    Decoration::DecorationBridge::self()->rasterizer()->setThreaded(true);
+}
+
+static void setOutputScale(qreal scale)
+{
+    auto output = static_cast<AbstractWaylandOutput *>(kwinApp()->platform()->enabledOutputs().first());
+    output->setScale(scale);
+    Q_EMIT kwinApp()->platform()->screensQueried();
+    QCOMPARE(screens()->scale(0), scale);
+}
+
+static QVector<QImage> decorationImages(AbstractClient *client)
+{
+    auto renderer = static_cast<SceneQPainterDecorationRenderer *>(client->decoratedClient()->renderer());
+    QVector<QImage> images;
+    for (int i = 0; i < int(DecorationPart::Count); ++i) {
+        images << renderer->image(DecorationPart(i));
+    }
+    return images;
+}
+
+// Repaints the whole decoration and returns its images once they have been uploaded.
+static QVector<QImage> repaintDecoration(AbstractClient *client, bool threaded)
+{
+    Decoration::Rasterizer *rasterizer = Decoration::DecorationBridge::self()->rasterizer();
+    rasterizer->setThreaded(threaded);
+
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    client->decoration()->update();
+    if (!frameRenderedSpy.wait()) {
+        return {};
+    }
+    if (threaded) {
+        // The tiles have been recorded, they are uploaded with the frame after they are done.
+        rasterizer->waitForDone();
+        if (!frameRenderedSpy.wait()) {
+            return {};
+        }
+    }
+    return decorationImages(client);
+}
+
+void DecorationRasterizerPixelsTest::testThreadedMatchesSynchronous_data()
+{
+    QTest::addColumn<qreal>("scale");
+
+    QTest::newRow("1") << 1.0;
+    QTest::newRow("1.5") << 1.5;
+}
+
+void DecorationRasterizerPixelsTest::testThreadedMatchesSynchronous()
+{
+    // This test verifies that a decoration that is rasterized on a worker thread looks the
+    // same as one that is painted on the main thread, also at a fractional scale.
+    QFETCH(qreal, scale);
+    setOutputScale(scale);
+
+    QScopedPointer<QObject> window(new QObject);
+    AbstractClient *client = Test::createDecoratedClient(QSize(500, 50), window.data());
+    QVERIFY(client);
+    QVERIFY(client->isDecorated());
+    QCOMPARE(client->screenScale(), scale);
+
+    const QVector<QImage> synchronous = repaintDecoration(client, false);
+    QCOMPARE(synchronous.count(), int(DecorationPart::Count));
+    const QImage &top = synchronous[int(DecorationPart::Top)];
+    QCOMPARE(top.devicePixelRatio(), scale);
+    QVERIFY(!top.isNull());
+
+    // Nothing would be compared if the decoration didn't paint anything.
+    bool painted = false;
+    for (int y = 0; y < top.height() && !painted; ++y) {
+        for (int x = 0; x < top.width() && !painted; ++x) {
+            painted = qAlpha(top.pixel(x, y)) != 0;
+        }
+    }
+    QVERIFY(painted);
+
+    const QVector<QImage> threaded = repaintDecoration(client, true);
+    QCOMPARE(threaded.count(), int(DecorationPart::Count));
+    // The renderer had to detach its images from the ones above to upload the tiles.
+    QVERIFY(threaded[int(DecorationPart::Top)].constBits() != top.constBits());
+    for (int i = 0; i < int(DecorationPart::Count); ++i) {
+        QCOMPARE(threaded[i], synchronous[i]);
+    }
+
+    window.reset();
+    setOutputScale(1.0);
+}
+
+WAYLANDTEST_MAIN(DecorationRasterizerPixelsTest)
+#include "decoration_rasterizer_pixels_test.moc"
@@ -0,0 +1,114 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "deleted.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "decorations/decorationbridge.h"
+#include "decorations/decorationrasterizer.h"
+
+#include <KDecoration2/Decoration>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_decoration_rasterizer-0");
+
+class DecorationRasterizerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testReuseImages();
+    void testRepaintAndClose();
+};
+
+void DecorationRasterizerTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::Deleted *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QVERIFY(Decoration::DecorationBridge::self());
+}
+
+void DecorationRasterizerTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection(Test::AdditionalWaylandInterface::Decoration));
+}
+
+void DecorationRasterizerTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void DecorationRasterizerTest::testReuseImages()
+{
+    Decoration::Rasterizer *rasterizer = Decoration::DecorationBridge::self()->rasterizer();
+
+    QImage image = rasterizer->acquireImage(QSize(100, 20), 2);
+    QCOMPARE(image.size(), QSize(100, 20));
+    QCOMPARE(image.devicePixelRatio(), 2.0);
+    const uchar *bits = image.constBits();
+    rasterizer->releaseImage(std::move(image));
+
+    // An image of the same size is handed out again.
+    QImage reused = rasterizer->acquireImage(QSize(100, 20), 2);
+    QCOMPARE(reused.constBits(), bits);
+
+    // An image that is still in use elsewhere is not.
+    const QImage copy = reused;
+    rasterizer->releaseImage(std::move(reused));
+    QImage other = rasterizer->acquireImage(QSize(100, 20), 2);
+    QVERIFY(other.constBits() != copy.constBits());
+}
+
+void DecorationRasterizerTest::testRepaintAndClose()
+{
+    // This test verifies that repainting a decoration while it's being rasterized and closing
+    // the window right after that doesn't break anything.
+    QScopedPointer<QObject> window(new QObject);
+    AbstractClient *client = Test::createDecoratedClient(QSize(500, 50), window.data());
+    QVERIFY(client);
+    QVERIFY(client->isDecorated());
+
+    QSignalSpy frameRenderedSpy(Compositor::self()->scene(), &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    for (int i = 0; i < 10; ++i) {
+        client->decoration()->update();
+        QVERIFY(frameRenderedSpy.wait());
+    }
+
+    QSignalSpy windowClosedSpy(client, &AbstractClient::windowClosed);
+    QVERIFY(windowClosedSpy.isValid());
+    client->decoration()->update();
+    window.reset();
+    QVERIFY(windowClosedSpy.wait());
+
+    Deleted *deleted = windowClosedSpy.first().at(1).value<Deleted *>();
+    QVERIFY(deleted);
+    QVERIFY(deleted->wasDecorated());
+    QVERIFY(deleted->decorationRenderer());
+}
+
+WAYLANDTEST_MAIN(DecorationRasterizerTest)
+#include "decoration_rasterizer_test.moc"
@@ -0,0 +1,288 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "effect_builtins.h"
+#include "framearena.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <kwinglutils.h>
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/surface.h>
+
+#include <QRegularExpression>
+
+using namespace KWin;
+using namespace KWayland::Client;
+
+static const QString s_socketName = QStringLiteral("wayland_test_effects_blur_cache-0");
+
+class BlurCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testInvalidation();
+    void testCachedMatchesUncached();
+    void benchmarkPanelRepaint_data();
+    void benchmarkPanelRepaint();
+
+private:
+    Effect *loadBlur(bool cacheEnabled);
+    void createWindows();
+    void renderFrame(const QRegion &damage = QRegion(), GLRenderTarget *renderTarget = nullptr);
+
+    AbstractClient *m_background = nullptr;
+    AbstractClient *m_panel = nullptr;
+    QList<Surface *> m_surfaces;
+    QList<XdgShellSurface *> m_shellSurfaces;
+};
+
+static int cacheCounter(Effect *effect, const QString &name)
+{
+    const QRegularExpression expression(name + QStringLiteral(": (\\d+)"));
+    const QRegularExpressionMatch match = expression.match(effect->debug(QStringLiteral("cache")));
+    return match.hasMatch() ? match.captured(1).toInt() : -1;
+}
+
+void BlurCacheTest::initTestCase()
+{
+    qputenv("XDG_DATA_DIRS", QCoreApplication::applicationDirPath().toUtf8());
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::Effect *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->scene()->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void BlurCacheTest::init()
+{
+    QVERIFY(Test::setupWaylandConnection());
+}
+
+void BlurCacheTest::cleanup()
+{
+    qDeleteAll(m_shellSurfaces);
+    m_shellSurfaces.clear();
+    qDeleteAll(m_surfaces);
+    m_surfaces.clear();
+    m_background = nullptr;
+    m_panel = nullptr;
+    Test::destroyWaylandConnection();
+
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl *>(effects);
+    while (!e->loadedEffects().isEmpty()) {
+        const QString effect = e->loadedEffects().first();
+        e->unloadEffect(effect);
+        QVERIFY(!e->isEffectLoaded(effect));
+    }
+    qunsetenv("KWIN_BLUR_CACHE");
+}
+
+Effect *BlurCacheTest::loadBlur(bool cacheEnabled)
+{
+    qputenv("KWIN_BLUR_CACHE", cacheEnabled ? QByteArrayLiteral("1") : QByteArrayLiteral("0"));
+
+    EffectsHandlerImpl *e = static_cast<EffectsHandlerImpl *>(effects);
+    auto effectloader = e->findChild<AbstractEffectLoader *>();
+    if (!effectloader) {
+        return nullptr;
+    }
+    QSignalSpy effectLoadedSpy(effectloader, &AbstractEffectLoader::effectLoaded);
+    if (!e->loadEffect(QStringLiteral("blur")) || effectLoadedSpy.count() != 1) {
+        return nullptr;
+    }
+    return effectLoadedSpy.first().first().value<Effect *>();
+}
+
+void BlurCacheTest::createWindows()
+{
+    // An opaque window fills the screen, a translucent panel with a blurred background
+    // sits on top of it.
+    const QVector<std::pair<QSize, QColor>> windows{
+        {QSize(1280, 1024), Qt::darkCyan},
+        {QSize(1280, 48), QColor(255, 255, 255, 96)},
+    };
+    for (const auto &[size, color] : windows) {
+        Surface *surface = Test::createSurface();
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface);
+        QVERIFY(shellSurface);
+        m_surfaces << surface;
+        m_shellSurfaces << shellSurface;
+
+        AbstractClient *client = Test::renderAndWaitForShown(surface, size, color,
+                                                             QImage::Format_ARGB32_Premultiplied);
+        QVERIFY(client);
+        client->move(QPoint(0, 0));
+        if (!m_background) {
+            m_background = client;
+        } else {
+            m_panel = client;
+        }
+    }
+
+    // An empty region blurs behind the whole window.
+    m_panel->effectWindow()->setData(WindowBlurBehindRole, QRegion());
+}
+
+void BlurCacheTest::renderFrame(const QRegion &damage, GLRenderTarget *renderTarget)
+{
+    Scene *scene = Compositor::self()->scene();
+    if (renderTarget) {
+        // Paint into the given render target rather than the back buffer of the virtual
+        // output, the blur effect reads the background from it as well.
+        QVERIFY(scene->makeOpenGLContextCurrent());
+        GLRenderTarget::pushRenderTarget(renderTarget);
+        GLint framebuffer = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+        GLRenderTarget::setKWinFramebuffer(framebuffer);
+    }
+
+    scene->paint(0, damage, workspace()->xStackingOrder(), std::chrono::milliseconds::zero());
+    Compositor::self()->frameArena()->reset();
+
+    if (renderTarget) {
+        // The output pops the render target at the end of the frame.
+        if (GLRenderTarget::currentRenderTarget() == renderTarget) {
+            GLRenderTarget::popRenderTarget();
+        }
+        GLRenderTarget::setKWinFramebuffer(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+void BlurCacheTest::testInvalidation()
+{
+    Effect *blur = loadBlur(true);
+    QVERIFY(blur);
+    createWindows();
+
+    // The first frame has nothing to reuse.
+    renderFrame(QRegion(0, 0, 1280, 1024));
+    QCOMPARE(cacheCounter(blur, QStringLiteral("entries")), 1);
+    const int misses = cacheCounter(blur, QStringLiteral("misses"));
+    QVERIFY(misses > 0);
+
+    // The panel changing its own contents keeps the blurred background.
+    m_panel->addRepaint(QRect(1200, 10, 40, 20));
+    renderFrame();
+    QVERIFY(cacheCounter(blur, QStringLiteral("hits")) > 0);
+    QCOMPARE(cacheCounter(blur, QStringLiteral("misses")), misses);
+
+    // Damage elsewhere on the screen doesn't matter either.
+    const int hits = cacheCounter(blur, QStringLiteral("hits"));
+    m_background->addRepaint(QRect(100, 500, 100, 100));
+    m_panel->addRepaint(QRect(1200, 10, 40, 20));
+    renderFrame();
+    QCOMPARE(cacheCounter(blur, QStringLiteral("misses")), misses);
+    QVERIFY(cacheCounter(blur, QStringLiteral("hits")) > hits);
+
+    // But the window underneath changing behind the panel invalidates it.
+    m_background->addRepaint(QRect(100, 10, 100, 20));
+    renderFrame();
+    QVERIFY(cacheCounter(blur, QStringLiteral("misses")) > misses);
+
+    // So does damage of the screen itself.
+    const int missesAfterBackground = cacheCounter(blur, QStringLiteral("misses"));
+    renderFrame(QRegion(600, 0, 10, 10));
+    QVERIFY(cacheCounter(blur, QStringLiteral("misses")) > missesAfterBackground);
+}
+
+void BlurCacheTest::testCachedMatchesUncached()
+{
+    // This test verifies that a panel that is repainted on top of the cached blurred
+    // background looks the same as one whose background is blurred again.
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+    const QRect screen(0, 0, 1280, 1024);
+    GLTexture texture(GL_RGBA8, screen.size());
+    GLRenderTarget renderTarget(texture);
+    QVERIFY(renderTarget.valid());
+
+    QImage panels[2];
+    for (const bool cacheEnabled : {false, true}) {
+        if (cacheEnabled) {
+            // Start over with new windows and a blur effect that caches.
+            cleanup();
+            init();
+        }
+        Effect *blur = loadBlur(cacheEnabled);
+        QVERIFY(blur);
+        createWindows();
+        renderFrame(screen, &renderTarget);
+
+        const int hits = cacheCounter(blur, QStringLiteral("hits"));
+        m_panel->addRepaint(QRect(1200, 10, 40, 20));
+        renderFrame(QRegion(), &renderTarget);
+        if (cacheEnabled) {
+            QVERIFY(cacheCounter(blur, QStringLiteral("hits")) > hits);
+        }
+
+        // The rows of the texture go from the bottom of the screen to the top.
+        panels[cacheEnabled] = texture.toImage().mirrored().copy(m_panel->frameGeometry());
+        QVERIFY(!panels[cacheEnabled].isNull());
+    }
+    QCOMPARE(panels[true], panels[false]);
+}
+
+void BlurCacheTest::benchmarkPanelRepaint_data()
+{
+    QTest::addColumn<bool>("cacheEnabled");
+
+    QTest::newRow("uncached") << false;
+    QTest::newRow("cached") << true;
+}
+
+void BlurCacheTest::benchmarkPanelRepaint()
+{
+    // A clock ticking in a static panel, nothing behind the panel changes.
+    QFETCH(bool, cacheEnabled);
+    Effect *blur = loadBlur(cacheEnabled);
+    QVERIFY(blur);
+    createWindows();
+    renderFrame(QRegion(0, 0, 1280, 1024));
+
+    QBENCHMARK {
+        m_panel->addRepaint(QRect(1200, 10, 40, 20));
+        renderFrame();
+    }
+}
+
+WAYLANDTEST_MAIN(BlurCacheTest)
+#include "blur_cache_test.moc"
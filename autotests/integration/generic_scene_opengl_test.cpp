@@ -18,7 +18,11 @@
 
 #include <KConfigGroup>
 
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
 using namespace KWin;
+using namespace KWayland::Client;
 static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_opengl-0");
 
 GenericSceneOpenGLTest::GenericSceneOpenGLTest(const QByteArray &envVariable)
@@ -106,3 +110,58 @@ void GenericSceneOpenGLTest::testRestart()
     // TODO: introduce frameRendered signal in SceneOpenGL
     QTest::qWait(100);
 }
+
+void GenericSceneOpenGLTest::testBatchedRendering_data()
+{
+    QTest::addColumn<QByteArray>("batched");
+    QTest::addColumn<int>("drawCallCount");
+    QTest::addColumn<int>("batchedWindowCount");
+
+    QTest::newRow("disabled") << QByteArrayLiteral("0") << 3 << 0;
+    QTest::newRow("enabled") << QByteArrayLiteral("1") << 1 << 3;
+}
+
+void GenericSceneOpenGLTest::testBatchedRendering()
+{
+    // This test verifies that opaque windows are painted with a single draw call if
+    // batched rendering is enabled.
+    QFETCH(QByteArray, batched);
+    qputenv("KWIN_GL_BATCHED_RENDERING", batched);
+
+    QSignalSpy sceneCreatedSpy(KWin::Compositor::self(), &Compositor::sceneCreated);
+    QVERIFY(sceneCreatedSpy.isValid());
+    KWin::Compositor::self()->reinitialize();
+    if (sceneCreatedSpy.isEmpty()) {
+        QVERIFY(sceneCreatedSpy.wait());
+    }
+    auto scene = KWin::Compositor::self()->scene();
+    QVERIFY(scene);
+
+    QVERIFY(Test::setupWaylandConnection());
+    QVector<Surface *> surfaces;
+    QVector<XdgShellSurface *> shellSurfaces;
+    for (int i = 0; i < 3; ++i) {
+        Surface *surface = Test::createSurface();
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface);
+        AbstractClient *client = Test::renderAndWaitForShown(surface, QSize(100, 100), Qt::red, QImage::Format_RGB32);
+        QVERIFY(client);
+        client->move(QPoint(i * 200, 0));
+        surfaces << surface;
+        shellSurfaces << shellSurface;
+    }
+
+    QSignalSpy frameRenderedSpy(scene, &Scene::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    KWin::Compositor::self()->addRepaintFull();
+    QVERIFY(frameRenderedSpy.wait());
+
+    QFETCH(int, drawCallCount);
+    QFETCH(int, batchedWindowCount);
+    const Scene::FrameStatistics statistics = scene->frameStatistics();
+    QCOMPARE(statistics.drawCallCount, drawCallCount);
+    QCOMPARE(statistics.batchedWindowCount, batchedWindowCount);
+
+    qDeleteAll(shellSurfaces);
+    qDeleteAll(surfaces);
+    qunsetenv("KWIN_GL_BATCHED_RENDERING");
+}
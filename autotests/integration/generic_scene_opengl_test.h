@@ -23,6 +23,8 @@ private Q_SLOTS:
     void cleanup();
     void testRestart_data();
     void testRestart();
+    void testBatchedRendering_data();
+    void testBatchedRendering();
 
 private:
     QByteArray m_envVariable;
@@ -349,6 +349,13 @@ AbstractClient *waitForWaylandWindowShown(int timeout = 5000);
  */
 AbstractClient *renderAndWaitForShown(KWayland::Client::Surface *surface, const QSize &size, const QColor &color, const QImage::Format &format = QImage::Format_ARGB32, int timeout = 5000);
 
+/**
+ * Creates a toplevel with a server-side decoration, renders it in @p size and waits till it's
+ * shown. The Wayland objects are children of @p parent, so deleting @p parent closes the window.
+ * Requires the AdditionalWaylandInterface::Decoration.
+ */
+AbstractClient *createDecoratedClient(const QSize &size, QObject *parent);
+
 /**
  * Waits for the @p client to be destroyed.
  */
@@ -0,0 +1,188 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effect_builtins.h"
+#include "framearena.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/surface.h>
+
+#include <QPainter>
+
+using namespace KWin;
+using namespace KWayland::Client;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_scene_occlusion-0");
+
+class SceneOcclusionTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void testRenderingMatches_data();
+    void testRenderingMatches();
+    void benchmarkPaint_data();
+    void benchmarkPaint();
+
+private:
+    void createStack(int count);
+    QImage renderFrame(const QRegion &damage);
+
+    QList<Surface *> m_surfaces;
+    QList<XdgShellSurface *> m_shellSurfaces;
+};
+
+void SceneOcclusionTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("Q"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(kwinApp()->platform()->selectedCompositor(), QPainterCompositing);
+}
+
+void SceneOcclusionTest::cleanup()
+{
+    qDeleteAll(m_shellSurfaces);
+    m_shellSurfaces.clear();
+    qDeleteAll(m_surfaces);
+    m_surfaces.clear();
+    Test::destroyWaylandConnection();
+    Compositor::self()->scene()->setIncrementalOcclusionEnabled(true);
+}
+
+void SceneOcclusionTest::createStack(int count)
+{
+    // Windows cascade from the top left corner, every one of them partially covers the
+    // previous one. Every third window is translucent so that not everything gets clipped.
+    QVERIFY(Test::setupWaylandConnection());
+    for (int i = 0; i < count; ++i) {
+        Surface *surface = Test::createSurface();
+        QVERIFY(surface);
+        XdgShellSurface *shellSurface = Test::createXdgShellStableSurface(surface);
+        QVERIFY(shellSurface);
+        m_surfaces << surface;
+        m_shellSurfaces << shellSurface;
+
+        const QColor color = (i % 3 == 0) ? QColor(0, 0, 255, 128) : QColor::fromHsv((i * 37) % 360, 255, 255);
+        AbstractClient *client = Test::renderAndWaitForShown(surface, QSize(400, 300), color,
+                                                             QImage::Format_ARGB32_Premultiplied);
+        QVERIFY(client);
+        client->move(QPoint((i * 23) % 880, (i * 17) % 724));
+    }
+}
+
+QImage SceneOcclusionTest::renderFrame(const QRegion &damage)
+{
+    Scene *scene = Compositor::self()->scene();
+    scene->paint(0, damage, workspace()->xStackingOrder(), std::chrono::milliseconds::zero());
+    Compositor::self()->frameArena()->reset();
+    return *scene->qpainterRenderBuffer(0);
+}
+
+void SceneOcclusionTest::testRenderingMatches_data()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("10") << 10;
+    QTest::newRow("50") << 50;
+}
+
+void SceneOcclusionTest::testRenderingMatches()
+{
+    // This test verifies that culling undamaged windows and caching their opaque regions
+    // doesn't change what ends up on the screen.
+    QFETCH(int, windowCount);
+    createStack(windowCount);
+
+    Scene *scene = Compositor::self()->scene();
+    const QRegion fullDamage(0, 0, 1280, 1024);
+    const QRegion partialDamage = QRegion(100, 100, 32, 32) | QRegion(900, 700, 64, 64);
+
+    scene->setIncrementalOcclusionEnabled(false);
+    const QImage referenceFull = renderFrame(fullDamage);
+    const QImage referencePartial = renderFrame(partialDamage);
+
+    scene->setIncrementalOcclusionEnabled(true);
+    QCOMPARE(renderFrame(fullDamage), referenceFull);
+    QCOMPARE(renderFrame(partialDamage), referencePartial);
+
+    // The cached opaque region has to follow the window around.
+    AbstractClient *client = workspace()->activeClient();
+    QVERIFY(client);
+    client->move(client->pos() + QPoint(50, 50));
+
+    scene->setIncrementalOcclusionEnabled(false);
+    const QImage referenceMoved = renderFrame(fullDamage);
+    scene->setIncrementalOcclusionEnabled(true);
+    QCOMPARE(renderFrame(fullDamage), referenceMoved);
+}
+
+void SceneOcclusionTest::benchmarkPaint_data()
+{
+    QTest::addColumn<int>("windowCount");
+    QTest::addColumn<bool>("incremental");
+
+    for (int windowCount : {10, 50, 100}) {
+        const QByteArray name = QByteArray::number(windowCount);
+        QTest::newRow((name + " windows/full").constData()) << windowCount << false;
+        QTest::newRow((name + " windows/incremental").constData()) << windowCount << true;
+    }
+}
+
+void SceneOcclusionTest::benchmarkPaint()
+{
+    // Compares the cost of painting a frame with a small amount of damage, such as
+    // a blinking cursor, with and without incremental occlusion culling.
+    QFETCH(int, windowCount);
+    QFETCH(bool, incremental);
+    createStack(windowCount);
+
+    Scene *scene = Compositor::self()->scene();
+    scene->setIncrementalOcclusionEnabled(incremental);
+
+    const QRegion damage(640, 512, 8, 16);
+    const QList<Toplevel *> windows = workspace()->xStackingOrder();
+    QBENCHMARK {
+        scene->paint(0, damage, windows, std::chrono::milliseconds::zero());
+        Compositor::self()->frameArena()->reset();
+    }
+}
+
+WAYLANDTEST_MAIN(SceneOcclusionTest)
+#include "scene_occlusion_test.moc"
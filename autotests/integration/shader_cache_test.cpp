@@ -0,0 +1,178 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effect_builtins.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+
+#include <kwinglutils.h>
+
+#include <KConfigGroup>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStandardPaths>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_shader_cache-0");
+
+class ShaderCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testStoreAndLoad();
+    void testInvalidBinary();
+    void testPruneOtherDrivers();
+};
+
+static QString cacheLocation()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/kwin/shaders");
+}
+
+static void createDriverDirectory(const QString &name, const QDateTime &lastUsed)
+{
+    QDir(cacheLocation()).mkpath(name);
+    QFile marker(QDir(cacheLocation()).filePath(name + QStringLiteral("/.last-used")));
+    QVERIFY(marker.open(QIODevice::WriteOnly));
+    QVERIFY(marker.setFileTime(lastUsed, QFileDevice::FileModificationTime));
+}
+
+static QString supportValue(const QString &name)
+{
+    const QRegularExpression expression(QStringLiteral("^%1: (.*)$").arg(name), QRegularExpression::MultilineOption);
+    return expression.match(ShaderManager::instance()->supportInformation()).captured(1);
+}
+
+static int compiledCount()
+{
+    return supportValue(QStringLiteral("Shaders compiled")).section(QLatin1Char(' '), 0, 0).toInt();
+}
+
+static int loadedCount()
+{
+    return supportValue(QStringLiteral("Shaders loaded from cache")).section(QLatin1Char(' '), 0, 0).toInt();
+}
+
+void ShaderCacheTest::initTestCase()
+{
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    // start with an empty cache, apart from the binaries of two other drivers
+    QDir(cacheLocation()).removeRecursively();
+    const QDateTime now = QDateTime::currentDateTime();
+    createDriverDirectory(QStringLiteral("recent"), now.addDays(-1));
+    createDriverDirectory(QStringLiteral("expired"), now.addDays(-60));
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->scene()->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void ShaderCacheTest::testStoreAndLoad()
+{
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+    const QString directory = supportValue(QStringLiteral("Shader cache"));
+    if (directory == QLatin1String("disabled")) {
+        QSKIP("The driver doesn't support program binaries");
+    }
+
+    // Nothing has been cached before kwin was started, so the shaders used so far have
+    // been compiled and stored.
+    QVERIFY(compiledCount() > 0);
+    QCOMPARE(loadedCount(), 0);
+    const int storedCount = QDir(directory).entryList(QDir::Files).count();
+    QVERIFY(storedCount > 0);
+
+    const ShaderTraits traits = ShaderTrait::MapTexture | ShaderTrait::ClampTexture | ShaderTrait::AdjustSaturation;
+    const int compiled = compiledCount();
+    QScopedPointer<GLShader> shader(ShaderManager::instance()->generateCustomShader(traits));
+    QVERIFY(shader->isValid());
+    QCOMPARE(compiledCount(), compiled + 1);
+    QCOMPARE(QDir(directory).entryList(QDir::Files).count(), storedCount + 1);
+
+    // The second time the same shader is needed, it comes from the cache.
+    QScopedPointer<GLShader> cachedShader(ShaderManager::instance()->generateCustomShader(traits));
+    QVERIFY(cachedShader->isValid());
+    QCOMPARE(compiledCount(), compiled + 1);
+    QCOMPARE(loadedCount(), 1);
+}
+
+void ShaderCacheTest::testInvalidBinary()
+{
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+    const QString directory = supportValue(QStringLiteral("Shader cache"));
+    if (directory == QLatin1String("disabled")) {
+        QSKIP("The driver doesn't support program binaries");
+    }
+
+    const ShaderTraits traits = ShaderTrait::UniformColor | ShaderTrait::AdjustSaturation;
+    QScopedPointer<GLShader> shader(ShaderManager::instance()->generateCustomShader(traits));
+    QVERIFY(shader->isValid());
+
+    // Damage every binary in the cache, the shader has to be compiled again.
+    const QStringList files = QDir(directory).entryList(QDir::Files);
+    for (const QString &fileName : files) {
+        QFile file(QDir(directory).filePath(fileName));
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write("garbage");
+    }
+
+    const int compiled = compiledCount();
+    const int loaded = loadedCount();
+    QScopedPointer<GLShader> recompiledShader(ShaderManager::instance()->generateCustomShader(traits));
+    QVERIFY(recompiledShader->isValid());
+    QCOMPARE(compiledCount(), compiled + 1);
+    QCOMPARE(loadedCount(), loaded);
+}
+
+void ShaderCacheTest::testPruneOtherDrivers()
+{
+    // The binaries of a driver that has been used recently, e.g. the one of the other GPU
+    // in a hybrid system, are kept, the ones of a driver that hasn't been used for a long
+    // time are removed.
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+    const QString directory = supportValue(QStringLiteral("Shader cache"));
+    if (directory == QLatin1String("disabled")) {
+        QSKIP("The driver doesn't support program binaries");
+    }
+
+    const QDir cacheDir(cacheLocation());
+    QVERIFY(cacheDir.exists(QStringLiteral("recent")));
+    QVERIFY(!cacheDir.exists(QStringLiteral("expired")));
+    QVERIFY(QFileInfo::exists(QDir(directory).filePath(QStringLiteral(".last-used"))));
+}
+
+WAYLANDTEST_MAIN(ShaderCacheTest)
+#include "shader_cache_test.moc"
@@ -0,0 +1,202 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effects.h"
+#include "effect_builtins.h"
+#include "framearena.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "plugins/scenes/opengl/scene_opengl.h"
+
+#include <KConfigGroup>
+
+#include <KWayland/Client/buffer.h>
+#include <KWayland/Client/shm_pool.h>
+#include <KWayland/Client/surface.h>
+#include <KWayland/Client/xdgshell.h>
+
+#include <QPainter>
+
+using namespace KWin;
+using namespace KWayland::Client;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_shm_upload-0");
+static const QSize s_surfaceSize(3840, 2160);
+
+class ShmUploadTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void testPartialUpload_data();
+    void testPartialUpload();
+    void benchmarkUpload_data();
+    void benchmarkUpload();
+};
+
+void ShmUploadTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(s_surfaceSize);
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->scene()->compositingType(), KWin::OpenGL2Compositing);
+}
+
+void ShmUploadTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+void ShmUploadTest::testPartialUpload_data()
+{
+    QTest::addColumn<QByteArray>("pboUpload");
+
+    // The pixel unpack buffer is the default, so it stays enabled for the benchmark.
+    QTest::newRow("direct") << QByteArrayLiteral("0");
+    QTest::newRow("pbo") << QByteArrayLiteral("1");
+}
+
+void ShmUploadTest::testPartialUpload()
+{
+    // This test verifies that only the damaged part of a shm buffer ends up in the texture,
+    // with and without the pixel unpack buffer.
+    QFETCH(QByteArray, pboUpload);
+    qputenv("KWIN_PBO_UPLOAD", pboUpload);
+
+    QSignalSpy sceneCreatedSpy(Compositor::self(), &Compositor::sceneCreated);
+    QVERIFY(sceneCreatedSpy.isValid());
+    Compositor::self()->reinitialize();
+    if (sceneCreatedSpy.isEmpty()) {
+        QVERIFY(sceneCreatedSpy.wait());
+    }
+    Scene *scene = Compositor::self()->scene();
+    QVERIFY(scene);
+
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    const QSize size(256, 256);
+    AbstractClient *client = Test::renderAndWaitForShown(surface.data(), size, Qt::blue,
+                                                         QImage::Format_ARGB32_Premultiplied);
+    QVERIFY(client);
+
+    // The damage is centered vertically, so it doesn't matter whether the texture is y-inverted.
+    const QRect damage(64, 112, 32, 32);
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    QPainter painter(&image);
+    painter.fillRect(damage, Qt::green);
+    painter.end();
+
+    QSignalSpy damagedSpy(client, &AbstractClient::damaged);
+    QVERIFY(damagedSpy.isValid());
+    surface->attachBuffer(Test::waylandShmPool()->createBuffer(image));
+    surface->damage(damage);
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+
+    scene->paint(0, QRegion(), workspace()->xStackingOrder(), std::chrono::milliseconds::zero());
+    Compositor::self()->frameArena()->reset();
+
+    Scene::Window *window = static_cast<EffectWindowImpl *>(client->effectWindow())->sceneWindow();
+    QVERIFY(window);
+    OpenGLWindowPixmap *pixmap = window->windowPixmap<OpenGLWindowPixmap>();
+    QVERIFY(pixmap);
+    QVERIFY(scene->makeOpenGLContextCurrent());
+    const QImage texture = pixmap->texture()->toImage();
+    QCOMPARE(texture.size(), size);
+
+    QCOMPARE(texture.pixelColor(damage.center()), QColor(Qt::green));
+    QCOMPARE(texture.pixelColor(damage.topLeft()), QColor(Qt::green));
+    QCOMPARE(texture.pixelColor(damage.bottomRight()), QColor(Qt::green));
+    QCOMPARE(texture.pixelColor(damage.left() - 1, damage.center().y()), QColor(Qt::blue));
+    QCOMPARE(texture.pixelColor(damage.right() + 1, damage.center().y()), QColor(Qt::blue));
+    QCOMPARE(texture.pixelColor(16, 16), QColor(Qt::blue));
+    QCOMPARE(texture.pixelColor(200, 200), QColor(Qt::blue));
+
+    scene->doneOpenGLContextCurrent();
+    qunsetenv("KWIN_PBO_UPLOAD");
+}
+
+void ShmUploadTest::benchmarkUpload_data()
+{
+    QTest::addColumn<QRect>("damage");
+
+    QTest::newRow("full") << QRect(QPoint(0, 0), s_surfaceSize);
+    QTest::newRow("quarter") << QRect(960, 540, 1920, 1080);
+    QTest::newRow("line") << QRect(0, 1000, 3840, 32);
+    QTest::newRow("cursor") << QRect(1900, 1000, 8, 16);
+}
+
+void ShmUploadTest::benchmarkUpload()
+{
+    // Measures how long it takes to get the damaged part of a 4K software rendered client
+    // onto the screen. Run with KWIN_PBO_UPLOAD=0 to compare with direct texture uploads.
+    QFETCH(QRect, damage);
+
+    QVERIFY(Test::setupWaylandConnection());
+    QScopedPointer<Surface> surface(Test::createSurface());
+    QVERIFY(!surface.isNull());
+    QScopedPointer<XdgShellSurface> shellSurface(Test::createXdgShellStableSurface(surface.data()));
+    QVERIFY(!shellSurface.isNull());
+    AbstractClient *client = Test::renderAndWaitForShown(surface.data(), s_surfaceSize, Qt::blue,
+                                                         QImage::Format_ARGB32_Premultiplied);
+    QVERIFY(client);
+    client->move(QPoint(0, 0));
+
+    QImage image(s_surfaceSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    const BufferPtr buffer = Test::waylandShmPool()->createBuffer(image);
+    QVERIFY(buffer);
+
+    QSignalSpy damagedSpy(client, &AbstractClient::damaged);
+    QVERIFY(damagedSpy.isValid());
+
+    Scene *scene = Compositor::self()->scene();
+    QBENCHMARK {
+        surface->attachBuffer(buffer);
+        surface->damage(damage);
+        surface->commit(Surface::CommitFlag::None);
+        QVERIFY(damagedSpy.wait());
+
+        scene->paint(0, QRegion(), workspace()->xStackingOrder(), std::chrono::milliseconds::zero());
+        Compositor::self()->frameArena()->reset();
+    }
+}
+
+WAYLANDTEST_MAIN(ShmUploadTest)
+#include "shm_upload_test.moc"
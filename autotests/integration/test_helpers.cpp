@@ -685,6 +685,25 @@ AbstractClient *renderAndWaitForShown(Surface *surface, const QSize &size, const
     return clientAddedSpy.first().first().value<AbstractClient *>();
 }
 
+AbstractClient *createDecoratedClient(const QSize &size, QObject *parent)
+{
+    if (!s_waylandConnection.decoration) {
+        return nullptr;
+    }
+    // The surface is reparented last, so it's destroyed after the objects that use it.
+    Surface *surface = createSurface();
+    if (!surface) {
+        return nullptr;
+    }
+    s_waylandConnection.decoration->create(surface, parent);
+    if (!createXdgShellStableSurface(surface, parent)) {
+        delete surface;
+        return nullptr;
+    }
+    surface->setParent(parent);
+    return renderAndWaitForShown(surface, size, Qt::blue);
+}
+
 void flushWaylandConnection()
 {
     if (s_waylandConnection.connection) {
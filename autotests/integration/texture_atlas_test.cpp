@@ -0,0 +1,243 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "abstract_client.h"
+#include "composite.h"
+#include "effectloader.h"
+#include "effect_builtins.h"
+#include "framearena.h"
+#include "platform.h"
+#include "scene.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "plugins/scenes/opengl/textureatlas.h"
+
+#include <KConfigGroup>
+
+#include <QDir>
+
+#include <memory>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_kwin_texture_atlas-0");
+
+class TextureAtlasTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+    void testDecoratedWindows();
+    void testRepackAndEviction();
+    void benchmarkDecoratedWindows();
+};
+
+void TextureAtlasTest::initTestCase()
+{
+    qRegisterMetaType<KWin::AbstractClient *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+
+    // disable all effects - we don't want to have it interact with the rendering
+    auto config = KSharedConfig::openConfig(QString(), KConfig::SimpleConfig);
+    KConfigGroup plugins(config, QStringLiteral("Plugins"));
+    ScriptedEffectLoader loader;
+    const auto builtinNames = BuiltInEffects::availableEffectNames() << loader.listOfKnownEffects();
+    for (QString name : builtinNames) {
+        plugins.writeEntry(name + QStringLiteral("Enabled"), false);
+    }
+
+    config->sync();
+    kwinApp()->setConfig(config);
+
+    qputenv("KWIN_COMPOSE", QByteArrayLiteral("O2"));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    QVERIFY(Compositor::self());
+    QCOMPARE(Compositor::self()->scene()->compositingType(), KWin::OpenGL2Compositing);
+
+    // Use the fake decoration with shadows, so both end up in the texture atlas.
+    QCoreApplication::addLibraryPath(
+        QDir(QCoreApplication::applicationDirPath()).absoluteFilePath("fakes")
+    );
+    KConfigGroup group = kwinApp()->config()->group("org.kde.kdecoration2");
+    group.writeEntry("library", "org.kde.test.fakedecowithshadows");
+    group.sync();
+    Workspace::self()->slotReconfigure();
+}
+
+void TextureAtlasTest::cleanup()
+{
+    Test::destroyWaylandConnection();
+}
+
+static void createDecoratedWindows(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        // The wayland objects are destroyed along with the connection.
+        AbstractClient *client = Test::createDecoratedClient(QSize(200 + i, 100), Test::waylandCompositor());
+        QVERIFY(client);
+        QVERIFY(client->isDecorated());
+        client->move(QPoint(i * 10 % 1000, i * 7 % 800));
+    }
+}
+
+void TextureAtlasTest::testDecoratedWindows()
+{
+    QVERIFY(Test::setupWaylandConnection(Test::AdditionalWaylandInterface::Decoration));
+    createDecoratedWindows(20);
+
+    Scene *scene = Compositor::self()->scene();
+    scene->paint(0, QRegion(), workspace()->xStackingOrder(), std::chrono::milliseconds::zero());
+    Compositor::self()->frameArena()->reset();
+
+    const Scene::FrameStatistics statistics = scene->frameStatistics();
+    if (statistics.atlasPageCount == 0) {
+        QSKIP("The texture atlas is disabled");
+    }
+
+    // The decorations and the shadows of all windows share one texture.
+    QCOMPARE(statistics.atlasPageCount, 1);
+    QCOMPARE(statistics.atlasDedicatedTextureCount, 0);
+    QVERIFY(statistics.atlasUsedTexelCount > 0);
+    QVERIFY(statistics.atlasUsedTexelCount <= statistics.atlasTexelCount);
+
+    // All of it is given back when the windows are gone.
+    Test::destroyWaylandConnection();
+    QTRY_COMPARE(scene->frameStatistics().atlasUsedTexelCount, 0);
+}
+
+static QColor regionColor(int index)
+{
+    return QColor::fromHsv(index * 20, 255, 255);
+}
+
+static void fillRegion(TextureAtlasRegion *region, const QColor &color)
+{
+    QImage image(region->size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(color);
+    region->update(image);
+}
+
+// Reads the contents of the region back from the texture it currently lives in.
+static QImage readRegion(TextureAtlasRegion *region)
+{
+    GLTexture *texture = region->texture();
+    const QPointF topLeft = region->matrix(UnnormalizedCoordinates).map(QPointF(0, 0));
+    const QPoint position(qRound(topLeft.x() * texture->width()), qRound(topLeft.y() * texture->height()));
+    return texture->toImage().copy(QRect(position, region->size()));
+}
+
+static bool isFilledWith(const QImage &image, const QColor &color)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            if (image.pixel(x, y) != color.rgba()) {
+                return false;
+            }
+        }
+    }
+    return !image.isNull();
+}
+
+void TextureAtlasTest::testRepackAndEviction()
+{
+    // This test verifies that a full atlas reclaims the space of released regions by
+    // repacking a page, that the least recently used regions are evicted to make room and
+    // that the regions that are kept take their contents with them. Pages of 512x512 texels
+    // hold four regions of 256x256 texels, so the atlas is full after sixteen of them.
+    QVERIFY(Compositor::self()->scene()->makeOpenGLContextCurrent());
+    TextureAtlas atlas(512);
+    if (!atlas.isEnabled()) {
+        QSKIP("The texture atlas is disabled");
+    }
+    QSignalSpy aboutToRearrangeSpy(&atlas, &TextureAtlas::aboutToRearrange);
+    QVERIFY(aboutToRearrangeSpy.isValid());
+
+    const QSize size(256, 256);
+    std::unique_ptr<TextureAtlasRegion> regions[16];
+    for (int i = 0; i < 16; ++i) {
+        regions[i].reset(atlas.allocate(size));
+        QVERIFY(regions[i]);
+        QVERIFY(regions[i]->isValid());
+        fillRegion(regions[i].get(), regionColor(i));
+
+        if (i == 1) {
+            // The first page starts out with room for two regions...
+            QCOMPARE(atlas.texelCount(), qint64(512 * 256));
+            QCOMPARE(aboutToRearrangeSpy.count(), 0);
+        } else if (i == 2) {
+            // ...and grows for the third one, the regions in it are copied over.
+            QCOMPARE(atlas.texelCount(), qint64(512 * 512));
+            QCOMPARE(aboutToRearrangeSpy.count(), 1);
+            QVERIFY(isFilledWith(readRegion(regions[0].get()), regionColor(0)));
+            QVERIFY(isFilledWith(readRegion(regions[1].get()), regionColor(1)));
+            QVERIFY(isFilledWith(readRegion(regions[2].get()), regionColor(2)));
+        }
+    }
+    QCOMPARE(atlas.pageCount(), 4);
+    QCOMPARE(atlas.dedicatedTextureCount(), 0);
+    QCOMPARE(atlas.usedTexelCount(), qint64(16 * 256 * 256));
+
+    // Free a region on the second page, pin the one before it and use the one after it,
+    // which leaves the last region of the page as the least recently used one.
+    regions[5].reset();
+    regions[4]->setPinned(true);
+    QVERIFY(regions[6]->texture());
+
+    // The freed space can only be reclaimed by repacking the page, which is filled up to
+    // three quarters, so one more region has to go.
+    aboutToRearrangeSpy.clear();
+    std::unique_ptr<TextureAtlasRegion> region(atlas.allocate(size));
+    QVERIFY(region);
+    QVERIFY(region->isValid());
+    QCOMPARE(aboutToRearrangeSpy.count(), 1);
+    QCOMPARE(atlas.pageCount(), 4);
+    QCOMPARE(atlas.dedicatedTextureCount(), 0);
+    QCOMPARE(atlas.usedTexelCount(), qint64(15 * 256 * 256));
+    QCOMPARE(region->texture(), regions[4]->texture());
+
+    QVERIFY(!regions[7]->isValid());
+    QVERIFY(!regions[7]->texture());
+    QVERIFY(regions[4]->isValid());
+    QVERIFY(regions[6]->isValid());
+    QVERIFY(isFilledWith(readRegion(regions[4].get()), regionColor(4)));
+    QVERIFY(isFilledWith(readRegion(regions[6].get()), regionColor(6)));
+
+    // The other pages haven't been touched.
+    for (int i : {0, 1, 2, 3, 8, 9, 10, 11, 12, 13, 14, 15}) {
+        QVERIFY(regions[i]->isValid());
+        QVERIFY(isFilledWith(readRegion(regions[i].get()), regionColor(i)));
+    }
+}
+
+void TextureAtlasTest::benchmarkDecoratedWindows()
+{
+    // Measures how long it takes to paint a hundred decorated windows. Run with
+    // KWIN_TEXTURE_ATLAS=0 to compare with a texture per decoration and shadow, and with
+    // KWIN_GL_BATCHED_RENDERING=1 to see how far the windows can be batched.
+    QVERIFY(Test::setupWaylandConnection(Test::AdditionalWaylandInterface::Decoration));
+    createDecoratedWindows(100);
+
+    const QRegion damage(0, 0, 1280, 1024);
+    Scene *scene = Compositor::self()->scene();
+    QBENCHMARK {
+        scene->paint(0, damage, workspace()->xStackingOrder(), std::chrono::milliseconds::zero());
+        Compositor::self()->frameArena()->reset();
+    }
+
+    QVERIFY(scene->frameStatistics().drawCallCount > 0);
+}
+
+WAYLANDTEST_MAIN(TextureAtlasTest)
+#include "texture_atlas_test.moc"
@@ -0,0 +1,190 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "kwin_wayland_test.h"
+#include "deleted.h"
+#include "platform.h"
+#include "unmanaged.h"
+#include "wayland_server.h"
+#include "workspace.h"
+#include "x11client.h"
+
+#include <xcb/xcb.h>
+
+#include <algorithm>
+
+using namespace KWin;
+
+static const QString s_socketName = QStringLiteral("wayland_test_x11_window_index-0");
+
+struct XcbConnectionDeleter
+{
+    static inline void cleanup(xcb_connection_t *pointer)
+    {
+        xcb_disconnect(pointer);
+    }
+};
+
+// This is how the clients used to be looked up, before the X11WindowIndex.
+static X11Client *findClientLinear(Predicate predicate, xcb_window_t w)
+{
+    const QList<X11Client *> &clients = workspace()->clientList();
+    auto it = std::find_if(clients.begin(), clients.end(), [predicate, w](const X11Client *c) {
+        switch (predicate) {
+        case Predicate::WindowMatch:
+            return c->window() == w;
+        case Predicate::WrapperIdMatch:
+            return c->wrapperId() == w;
+        case Predicate::FrameIdMatch:
+            return c->frameId() == w;
+        case Predicate::InputIdMatch:
+            return c->inputId() == w;
+        }
+        return false;
+    });
+    return it != clients.end() ? *it : nullptr;
+}
+
+class X11WindowIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testLookup();
+};
+
+void X11WindowIndexTest::initTestCase()
+{
+    qRegisterMetaType<KWin::Deleted *>();
+    qRegisterMetaType<KWin::AbstractClient *>();
+    qRegisterMetaType<KWin::Unmanaged *>();
+    QSignalSpy applicationStartedSpy(kwinApp(), &Application::started);
+    QVERIFY(applicationStartedSpy.isValid());
+    kwinApp()->platform()->setInitialWindowSize(QSize(1280, 1024));
+    QVERIFY(waylandServer()->init(s_socketName));
+    kwinApp()->setConfig(KSharedConfig::openConfig(QString(), KConfig::SimpleConfig));
+
+    kwinApp()->start();
+    QVERIFY(applicationStartedSpy.wait());
+    waylandServer()->initWorkspace();
+}
+
+static void verifyLookups(X11Client *client)
+{
+    const QVector<QPair<Predicate, xcb_window_t>> windows{
+        {Predicate::WindowMatch, client->window()},
+        {Predicate::WrapperIdMatch, client->wrapperId()},
+        {Predicate::FrameIdMatch, client->frameId()},
+        {Predicate::InputIdMatch, client->inputId()},
+    };
+    for (const auto &window : windows) {
+        if (window.second == XCB_WINDOW_NONE) {
+            continue;
+        }
+        QCOMPARE(workspace()->findClient(window.first, window.second), client);
+        QCOMPARE(workspace()->findClient(window.first, window.second), findClientLinear(window.first, window.second));
+    }
+
+    // A window is found only in the role that it plays for the client.
+    QCOMPARE(workspace()->findClient(Predicate::WindowMatch, client->frameId()), nullptr);
+    QCOMPARE(workspace()->findClient(Predicate::FrameIdMatch, client->window()), nullptr);
+}
+
+void X11WindowIndexTest::testLookup()
+{
+    // This test verifies that Workspace::findClient() and Workspace::findUnmanaged() find
+    // the same windows as a search of the window lists, also after the stacking order has
+    // changed and after windows have been closed.
+    QScopedPointer<xcb_connection_t, XcbConnectionDeleter> c(xcb_connect(nullptr, nullptr));
+    QVERIFY(!xcb_connection_has_error(c.data()));
+
+    const int clientCount = 3;
+    QVector<xcb_window_t> windows;
+    QVector<X11Client *> clients;
+    QSignalSpy clientAddedSpy(workspace(), &Workspace::clientAdded);
+    QVERIFY(clientAddedSpy.isValid());
+    for (int i = 0; i < clientCount; ++i) {
+        xcb_window_t w = xcb_generate_id(c.data());
+        xcb_create_window(c.data(), XCB_COPY_FROM_PARENT, w, rootWindow(),
+                          i * 100, 0, 100, 200,
+                          0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, 0, nullptr);
+        xcb_map_window(c.data(), w);
+        xcb_flush(c.data());
+
+        QVERIFY(clientAddedSpy.wait());
+        X11Client *client = clientAddedSpy.last().first().value<X11Client *>();
+        QVERIFY(client);
+        QCOMPARE(client->window(), w);
+        windows << w;
+        clients << client;
+    }
+
+    // An override-redirect window is an unmanaged window.
+    QSignalSpy unmanagedAddedSpy(workspace(), &Workspace::unmanagedAdded);
+    QVERIFY(unmanagedAddedSpy.isValid());
+    const uint32_t values[] = { true };
+    xcb_window_t unmanagedWindow = xcb_generate_id(c.data());
+    xcb_create_window(c.data(), XCB_COPY_FROM_PARENT, unmanagedWindow, rootWindow(),
+                      500, 500, 100, 100,
+                      0, XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT,
+                      XCB_CW_OVERRIDE_REDIRECT, values);
+    xcb_map_window(c.data(), unmanagedWindow);
+    xcb_flush(c.data());
+    QVERIFY(unmanagedAddedSpy.wait());
+    Unmanaged *unmanaged = unmanagedAddedSpy.first().first().value<Unmanaged *>();
+    QVERIFY(unmanaged);
+    QCOMPARE(workspace()->findUnmanaged(unmanagedWindow), unmanaged);
+    QCOMPARE(workspace()->findClient(Predicate::WindowMatch, unmanagedWindow), nullptr);
+
+    for (X11Client *client : qAsConst(clients)) {
+        verifyLookups(client);
+    }
+
+    // Changing the stacking order doesn't change what the windows belong to.
+    workspace()->lowerClient(clients.last());
+    workspace()->raiseClient(clients.first());
+    QTRY_VERIFY(workspace()->xStackingOrder().contains(unmanaged));
+    for (X11Client *client : qAsConst(clients)) {
+        verifyLookups(client);
+    }
+    QCOMPARE(workspace()->findUnmanaged(unmanagedWindow), unmanaged);
+
+    // The windows of a closed client can't be found anymore.
+    X11Client *closed = clients.takeFirst();
+    const xcb_window_t closedWindow = closed->window();
+    const xcb_window_t closedFrame = closed->frameId();
+    const xcb_window_t closedWrapper = closed->wrapperId();
+    QSignalSpy windowClosedSpy(closed, &X11Client::windowClosed);
+    QVERIFY(windowClosedSpy.isValid());
+    xcb_destroy_window(c.data(), windows.takeFirst());
+    xcb_flush(c.data());
+    QVERIFY(windowClosedSpy.wait());
+
+    QCOMPARE(workspace()->findClient(Predicate::WindowMatch, closedWindow), nullptr);
+    QCOMPARE(workspace()->findClient(Predicate::FrameIdMatch, closedFrame), nullptr);
+    QCOMPARE(workspace()->findClient(Predicate::WrapperIdMatch, closedWrapper), nullptr);
+    QCOMPARE(findClientLinear(Predicate::WindowMatch, closedWindow), nullptr);
+    for (X11Client *client : qAsConst(clients)) {
+        verifyLookups(client);
+    }
+
+    QSignalSpy unmanagedClosedSpy(unmanaged, &Unmanaged::windowClosed);
+    QVERIFY(unmanagedClosedSpy.isValid());
+    xcb_destroy_window(c.data(), unmanagedWindow);
+    xcb_flush(c.data());
+    QVERIFY(unmanagedClosedSpy.wait());
+    QCOMPARE(workspace()->findUnmanaged(unmanagedWindow), nullptr);
+
+    for (xcb_window_t w : qAsConst(windows)) {
+        xcb_destroy_window(c.data(), w);
+    }
+    xcb_flush(c.data());
+}
+
+WAYLANDTEST_MAIN(X11WindowIndexTest)
+#include "x11_window_index_test.moc"
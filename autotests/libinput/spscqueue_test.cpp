@@ -0,0 +1,119 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "../../libinput/spscqueue.h"
+
+#include <QtTest>
+
+#include <thread>
+
+using namespace KWin::LibInput;
+
+class TestLibinputSpscQueue : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testCapacity();
+    void testPushPop();
+    void testWrapAround();
+    void testTwoThreads();
+    void benchmarkTwoThreads();
+};
+
+void TestLibinputSpscQueue::testCapacity()
+{
+    QCOMPARE(SpscQueue<int>(1).capacity(), 1u);
+    QCOMPARE(SpscQueue<int>(100).capacity(), 128u);
+    QCOMPARE(SpscQueue<int>(1024).capacity(), 1024u);
+}
+
+void TestLibinputSpscQueue::testPushPop()
+{
+    SpscQueue<int> queue(4);
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.peek(), nullptr);
+
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(queue.push(i));
+    }
+    QCOMPARE(queue.count(), 4u);
+    QVERIFY(!queue.push(4));
+
+    QCOMPARE(*queue.peek(), 0);
+    int item;
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY(queue.pop(&item));
+        QCOMPARE(item, i);
+    }
+    QVERIFY(!queue.pop(&item));
+    QVERIFY(queue.isEmpty());
+}
+
+void TestLibinputSpscQueue::testWrapAround()
+{
+    SpscQueue<int> queue(4);
+    int item;
+    for (int i = 0; i < 100; ++i) {
+        QVERIFY(queue.push(i));
+        QVERIFY(queue.push(i + 1000));
+        QVERIFY(queue.pop(&item));
+        QCOMPARE(item, i);
+        QVERIFY(queue.pop(&item));
+        QCOMPARE(item, i + 1000);
+    }
+    QVERIFY(queue.isEmpty());
+}
+
+// Returns the number of items that didn't arrive in the order in which they were pushed.
+// All items are popped before the producer is joined, otherwise it would wait forever for
+// space in a full queue.
+static int runProducerConsumer(SpscQueue<int> *queue, int count)
+{
+    std::thread producer([queue, count]() {
+        for (int i = 0; i < count; ++i) {
+            while (!queue->push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int mismatches = 0;
+    int expected = 0;
+    while (expected < count) {
+        int item;
+        if (queue->pop(&item)) {
+            if (item != expected) {
+                ++mismatches;
+            }
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    return mismatches;
+}
+
+void TestLibinputSpscQueue::testTwoThreads()
+{
+    // Items must arrive in order and without gaps, also when the queue runs full.
+    SpscQueue<int> queue(1024);
+    QCOMPARE(runProducerConsumer(&queue, 200000), 0);
+    QVERIFY(queue.isEmpty());
+}
+
+void TestLibinputSpscQueue::benchmarkTwoThreads()
+{
+    SpscQueue<int> queue(1024);
+    QBENCHMARK {
+        QCOMPARE(runProducerConsumer(&queue, 100000), 0);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestLibinputSpscQueue)
+#include "spscqueue_test.moc"
@@ -0,0 +1,139 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "framearena.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+class FrameArenaTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testAlignment();
+    void testReset();
+    void testGrowth();
+    void testSteadyStateAllocatesNoBlocks();
+    void testFrameVector();
+    void benchmarkFrameVector();
+    void benchmarkQVector();
+};
+
+void FrameArenaTest::testAlignment()
+{
+    FrameArena arena(1024);
+    arena.allocate(1, 1);
+    void *aligned = arena.allocate(16, 16);
+    QCOMPARE(reinterpret_cast<quintptr>(aligned) % 16, quintptr(0));
+    arena.allocate(3, 1);
+    void *pointer = arena.allocate(sizeof(void *), alignof(void *));
+    QCOMPARE(reinterpret_cast<quintptr>(pointer) % alignof(void *), quintptr(0));
+}
+
+void FrameArenaTest::testReset()
+{
+    FrameArena arena(1024);
+    void *first = arena.allocate(100);
+    arena.allocate(100);
+    QCOMPARE(arena.currentFrameStatistics().allocationCount, quint64(2));
+    QCOMPARE(arena.currentFrameStatistics().blockAllocationCount, quint64(0));
+
+    arena.reset();
+    QCOMPARE(arena.lastFrameStatistics().allocationCount, quint64(2));
+    QCOMPARE(arena.currentFrameStatistics().allocationCount, quint64(0));
+
+    // The memory is handed out again after a reset.
+    QCOMPARE(arena.allocate(100), first);
+}
+
+void FrameArenaTest::testGrowth()
+{
+    FrameArena arena(1024);
+    QCOMPARE(arena.totalBlockAllocationCount(), quint64(1));
+
+    for (int i = 0; i < 10; ++i) {
+        arena.allocate(512);
+    }
+    QVERIFY(arena.capacity() >= 5120);
+    QVERIFY(arena.currentFrameStatistics().blockAllocationCount > 0);
+
+    // The blocks are merged into one when the arena is reset.
+    const size_t capacity = arena.capacity();
+    arena.reset();
+    QCOMPARE(arena.capacity(), capacity);
+
+    const quint64 blockAllocationCount = arena.totalBlockAllocationCount();
+    for (int i = 0; i < 10; ++i) {
+        arena.allocate(512);
+    }
+    QCOMPARE(arena.totalBlockAllocationCount(), blockAllocationCount);
+}
+
+void FrameArenaTest::testSteadyStateAllocatesNoBlocks()
+{
+    // This test simulates a sequence of frames with a similar working set. After the first
+    // frame, the arena must not allocate blocks anymore.
+    FrameArena arena(256);
+    for (int frame = 0; frame < 100; ++frame) {
+        FrameVector<int> indices(&arena);
+        indices.reserve(100 + frame % 10);
+        for (int i = 0; i < 100; ++i) {
+            indices.push_back(i);
+        }
+        FrameVector<QRect> rects(&arena);
+        rects.reserve(50);
+        rects.resize(50);
+        arena.reset();
+        if (frame > 0) {
+            QCOMPARE(arena.lastFrameStatistics().blockAllocationCount, quint64(0));
+        }
+    }
+}
+
+void FrameArenaTest::testFrameVector()
+{
+    FrameArena arena;
+    FrameVector<QString> strings(&arena);
+    for (int i = 0; i < 100; ++i) {
+        strings.push_back(QString::number(i));
+    }
+    QCOMPARE(strings.size(), size_t(100));
+    QCOMPARE(strings[42], QStringLiteral("42"));
+    strings.insert(strings.begin(), QStringLiteral("first"));
+    QCOMPARE(strings.front(), QStringLiteral("first"));
+    QCOMPARE(strings.back(), QStringLiteral("99"));
+}
+
+void FrameArenaTest::benchmarkFrameVector()
+{
+    FrameArena arena;
+    QBENCHMARK {
+        FrameVector<QRect> rects(&arena);
+        rects.reserve(64);
+        for (int i = 0; i < 64; ++i) {
+            rects.push_back(QRect(i, i, 10, 10));
+        }
+        arena.reset();
+    }
+}
+
+void FrameArenaTest::benchmarkQVector()
+{
+    QBENCHMARK {
+        QVector<QRect> rects;
+        rects.reserve(64);
+        for (int i = 0; i < 64; ++i) {
+            rects.append(QRect(i, i, 10, 10));
+        }
+    }
+}
+
+QTEST_MAIN(FrameArenaTest)
+#include "test_framearena.moc"
@@ -0,0 +1,188 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "hittestgrid.h"
+#include "testutils.h"
+
+#include <QRandomGenerator>
+#include <QTest>
+
+using namespace KWin;
+
+static const QRect s_extent(0, 0, 3840, 2160);
+
+// Windows are at least 100x100 and have random positions, some stick out of the extent.
+static QVector<QRect> createWindows(int count)
+{
+    QRandomGenerator generator(count);
+    QVector<QRect> windows;
+    windows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const int width = generator.bounded(100, 1600);
+        const int height = generator.bounded(100, 1000);
+        const int x = generator.bounded(-200, s_extent.width() - width + 200);
+        const int y = generator.bounded(-200, s_extent.height() - height + 200);
+        windows.append(QRect(x, y, width, height));
+    }
+    return windows;
+}
+
+// Simulates a 1000 Hz mouse that is moved diagonally across the screen.
+static QVector<QPoint> createMotionStream(int count)
+{
+    QVector<QPoint> positions;
+    positions.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        positions.append(QPoint(i * 7 % s_extent.width(), i * 3 % s_extent.height()));
+    }
+    return positions;
+}
+
+// The windows are topmost last, like the stacking order.
+static int findLinear(const QVector<QRect> &windows, const QPoint &pos)
+{
+    for (int i = windows.count() - 1; i >= 0; --i) {
+        if (windows[i].contains(pos)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void buildGrid(HitTestGrid *grid, const QVector<QRect> &windows)
+{
+    grid->reset(s_extent);
+    for (int i = windows.count() - 1; i >= 0; --i) {
+        grid->insert(i, windows[i]);
+    }
+}
+
+static int findGrid(const HitTestGrid &grid, const QVector<QRect> &windows, const QPoint &pos)
+{
+    const QVector<int> *candidates = grid.candidates(pos);
+    if (!candidates) {
+        return findLinear(windows, pos);
+    }
+    for (int index : *candidates) {
+        if (windows[index].contains(pos)) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+class HitTestGridTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testCandidates();
+    void testOutsideExtent();
+    void testReset();
+    void testMatchesLinearSearch();
+    void benchmarkGrid_data();
+    void benchmarkGrid();
+    void benchmarkLinear_data();
+    void benchmarkLinear();
+};
+
+void HitTestGridTest::testCandidates()
+{
+    HitTestGrid grid(100);
+    grid.reset(QRect(0, 0, 1000, 1000));
+    grid.insert(2, QRect(0, 0, 150, 150));
+    grid.insert(1, QRect(50, 50, 50, 50));
+    grid.insert(0, QRect(900, 900, 500, 500));
+
+    QCOMPARE(*grid.candidates(QPoint(10, 10)), QVector<int>({2, 1}));
+    QCOMPARE(*grid.candidates(QPoint(149, 149)), QVector<int>({2}));
+    QCOMPARE(*grid.candidates(QPoint(500, 500)), QVector<int>());
+    QCOMPARE(*grid.candidates(QPoint(999, 999)), QVector<int>({0}));
+}
+
+void HitTestGridTest::testOutsideExtent()
+{
+    HitTestGrid grid(100);
+    grid.reset(QRect(-100, 0, 1000, 1000));
+    grid.insert(0, QRect(-200, 0, 150, 50));
+
+    QCOMPARE(grid.candidates(QPoint(-101, 0)), nullptr);
+    QCOMPARE(grid.candidates(QPoint(0, 1000)), nullptr);
+    QCOMPARE(*grid.candidates(QPoint(-100, 0)), QVector<int>({0}));
+}
+
+void HitTestGridTest::testReset()
+{
+    HitTestGrid grid(100);
+    grid.reset(QRect(0, 0, 1000, 1000));
+    grid.insert(0, QRect(0, 0, 1000, 1000));
+
+    grid.reset(QRect(0, 0, 2000, 500));
+    QCOMPARE(grid.extent(), QRect(0, 0, 2000, 500));
+    QCOMPARE(*grid.candidates(QPoint(0, 0)), QVector<int>());
+    QCOMPARE(*grid.candidates(QPoint(1999, 499)), QVector<int>());
+    QCOMPARE(grid.candidates(QPoint(0, 500)), nullptr);
+}
+
+void HitTestGridTest::testMatchesLinearSearch()
+{
+    const QVector<QRect> windows = createWindows(500);
+    HitTestGrid grid;
+    buildGrid(&grid, windows);
+
+    const QVector<QPoint> positions = createMotionStream(10000);
+    for (const QPoint &pos : positions) {
+        QCOMPARE(findGrid(grid, windows, pos), findLinear(windows, pos));
+    }
+}
+
+void HitTestGridTest::benchmarkGrid_data()
+{
+    addWindowCountRows();
+}
+
+void HitTestGridTest::benchmarkGrid()
+{
+    QFETCH(int, windowCount);
+    const QVector<QRect> windows = createWindows(windowCount);
+    const QVector<QPoint> positions = createMotionStream(1000);
+
+    HitTestGrid grid;
+    buildGrid(&grid, windows);
+
+    int hits = 0;
+    QBENCHMARK {
+        for (const QPoint &pos : positions) {
+            hits += findGrid(grid, windows, pos) != -1;
+        }
+    }
+    QVERIFY(hits >= 0);
+}
+
+void HitTestGridTest::benchmarkLinear_data()
+{
+    benchmarkGrid_data();
+}
+
+void HitTestGridTest::benchmarkLinear()
+{
+    QFETCH(int, windowCount);
+    const QVector<QRect> windows = createWindows(windowCount);
+    const QVector<QPoint> positions = createMotionStream(1000);
+
+    int hits = 0;
+    QBENCHMARK {
+        for (const QPoint &pos : positions) {
+            hits += findLinear(windows, pos) != -1;
+        }
+    }
+    QVERIFY(hits >= 0);
+}
+
+QTEST_MAIN(HitTestGridTest)
+#include "test_hittestgrid.moc"
@@ -0,0 +1,106 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "inputlatencytracer.h"
+#include "renderloop.h"
+
+#include <QTest>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class InputLatencyTracerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testLatency();
+    void testNoFrame();
+    void testUnpresentedFrame();
+    void testSeparateRenderLoops();
+};
+
+void InputLatencyTracerTest::testLatency()
+{
+    InputLatencyTracer tracer;
+    RenderLoop renderLoop;
+
+    tracer.inputProcessed(1000us);
+    tracer.inputProcessed(3000us);
+    tracer.frameStarted(&renderLoop);
+
+    // Events processed after the frame has started are not reflected by it.
+    tracer.inputProcessed(9000us);
+    emit renderLoop.framePresented(&renderLoop, 10ms);
+
+    InputLatencyTracer::Statistics statistics = tracer.statistics();
+    QCOMPARE(statistics.count, quint64(2));
+    QCOMPARE(statistics.total, 16000us);
+    QCOMPARE(statistics.maximum, 9000us);
+
+    tracer.frameStarted(&renderLoop);
+    emit renderLoop.framePresented(&renderLoop, 12ms);
+
+    statistics = tracer.statistics();
+    QCOMPARE(statistics.count, quint64(3));
+    QCOMPARE(statistics.total, 19000us);
+    QCOMPARE(statistics.maximum, 9000us);
+}
+
+void InputLatencyTracerTest::testNoFrame()
+{
+    InputLatencyTracer tracer;
+    RenderLoop renderLoop;
+
+    tracer.inputProcessed(1000us);
+    tracer.frameStarted(&renderLoop);
+    emit renderLoop.framePresented(&renderLoop, 2ms);
+
+    // A frame that has been presented without being started by the tracer reflects nothing.
+    emit renderLoop.framePresented(&renderLoop, 4ms);
+    QCOMPARE(tracer.statistics().count, quint64(1));
+    QCOMPARE(tracer.statistics().total, 1000us);
+}
+
+void InputLatencyTracerTest::testUnpresentedFrame()
+{
+    InputLatencyTracer tracer;
+    RenderLoop renderLoop;
+
+    // If a started frame hasn't been presented yet, the next presented frame reflects
+    // the events of both frames.
+    tracer.inputProcessed(1000us);
+    tracer.frameStarted(&renderLoop);
+    tracer.inputProcessed(2000us);
+    tracer.frameStarted(&renderLoop);
+    emit renderLoop.framePresented(&renderLoop, 5ms);
+
+    const InputLatencyTracer::Statistics statistics = tracer.statistics();
+    QCOMPARE(statistics.count, quint64(2));
+    QCOMPARE(statistics.total, 7000us);
+    QCOMPARE(statistics.maximum, 4000us);
+}
+
+void InputLatencyTracerTest::testSeparateRenderLoops()
+{
+    InputLatencyTracer tracer;
+    RenderLoop first;
+    RenderLoop second;
+
+    tracer.inputProcessed(1000us);
+    tracer.frameStarted(&first);
+    emit second.framePresented(&second, 3ms);
+    QCOMPARE(tracer.statistics().count, quint64(0));
+
+    emit first.framePresented(&first, 5ms);
+    QCOMPARE(tracer.statistics().count, quint64(1));
+    QCOMPARE(tracer.statistics().maximum, 4000us);
+}
+
+QTEST_GUILESS_MAIN(InputLatencyTracerTest)
+#include "test_inputlatencytracer.moc"
@@ -0,0 +1,381 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "rectset.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTest>
+#include <QTextStream>
+
+using namespace KWin;
+
+/**
+ * A damage trace is a sequence of frames, every frame contains the damage of the frame
+ * and the opaque regions of the windows in the stacking order, from bottom to top.
+ */
+struct DamageFrame
+{
+    QRegion damage;
+    QVector<QRegion> clips;
+};
+using DamageTrace = QVector<DamageFrame>;
+
+Q_DECLARE_METATYPE(DamageTrace)
+
+class RectSetTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testEmpty();
+    void testRect();
+    void testUnite_data();
+    void testUnite();
+    void testSubtract_data();
+    void testSubtract();
+    void testIntersect_data();
+    void testIntersect();
+    void testIntersects();
+    void testTranslate();
+    void testCopyAndMove();
+    void testRandomOperations();
+    void benchmarkTrace_data();
+    void benchmarkTrace();
+};
+
+void RectSetTest::testEmpty()
+{
+    RectSet set;
+    QVERIFY(set.isEmpty());
+    QCOMPARE(set.rectCount(), 0);
+    QCOMPARE(set.boundingRect(), QRect());
+    QCOMPARE(set.toRegion(), QRegion());
+    QVERIFY(!set.intersects(QRect(0, 0, 100, 100)));
+
+    set.unite(QRect());
+    QVERIFY(set.isEmpty());
+}
+
+void RectSetTest::testRect()
+{
+    const RectSet set(QRect(10, 20, 30, 40));
+    QCOMPARE(set.rectCount(), 1);
+    QCOMPARE(set.rectAt(0), QRect(10, 20, 30, 40));
+    QCOMPARE(set.boundingRect(), QRect(10, 20, 30, 40));
+    QCOMPARE(set.toRegion(), QRegion(10, 20, 30, 40));
+}
+
+void RectSetTest::testUnite_data()
+{
+    QTest::addColumn<QRegion>("first");
+    QTest::addColumn<QRegion>("second");
+
+    QTest::newRow("disjoint") << QRegion(0, 0, 10, 10) << QRegion(20, 20, 10, 10);
+    QTest::newRow("overlapping") << QRegion(0, 0, 10, 10) << QRegion(5, 5, 10, 10);
+    QTest::newRow("contained") << QRegion(0, 0, 100, 100) << QRegion(10, 10, 10, 10);
+    QTest::newRow("containing") << QRegion(10, 10, 10, 10) << QRegion(0, 0, 100, 100);
+    QTest::newRow("adjacent horizontally") << QRegion(0, 0, 10, 10) << QRegion(10, 0, 10, 10);
+    QTest::newRow("adjacent vertically") << QRegion(0, 0, 10, 10) << QRegion(0, 10, 10, 10);
+    QTest::newRow("cross") << QRegion(0, 40, 100, 20) << QRegion(40, 0, 20, 100);
+    QTest::newRow("complex") << (QRegion(0, 0, 50, 50) | QRegion(100, 0, 50, 50))
+                             << (QRegion(25, 25, 100, 10) | QRegion(0, 100, 200, 5));
+}
+
+void RectSetTest::testUnite()
+{
+    QFETCH(QRegion, first);
+    QFETCH(QRegion, second);
+
+    RectSet set(first);
+    set.unite(RectSet(second));
+    QCOMPARE(set.toRegion(), first | second);
+    QCOMPARE(set.boundingRect(), (first | second).boundingRect());
+}
+
+void RectSetTest::testSubtract_data()
+{
+    QTest::addColumn<QRegion>("first");
+    QTest::addColumn<QRegion>("second");
+
+    QTest::newRow("disjoint") << QRegion(0, 0, 10, 10) << QRegion(20, 20, 10, 10);
+    QTest::newRow("overlapping") << QRegion(0, 0, 10, 10) << QRegion(5, 5, 10, 10);
+    QTest::newRow("hole") << QRegion(0, 0, 100, 100) << QRegion(10, 10, 10, 10);
+    QTest::newRow("everything") << QRegion(10, 10, 10, 10) << QRegion(0, 0, 100, 100);
+    QTest::newRow("cross") << QRegion(0, 40, 100, 20) << QRegion(40, 0, 20, 100);
+    QTest::newRow("complex") << (QRegion(0, 0, 50, 50) | QRegion(100, 0, 50, 50))
+                             << (QRegion(25, 25, 100, 10) | QRegion(0, 100, 200, 5));
+}
+
+void RectSetTest::testSubtract()
+{
+    QFETCH(QRegion, first);
+    QFETCH(QRegion, second);
+
+    RectSet set(first);
+    set.subtract(RectSet(second));
+    QCOMPARE(set.toRegion(), first - second);
+}
+
+void RectSetTest::testIntersect_data()
+{
+    testSubtract_data();
+}
+
+void RectSetTest::testIntersect()
+{
+    QFETCH(QRegion, first);
+    QFETCH(QRegion, second);
+
+    RectSet set(first);
+    set.intersect(RectSet(second));
+    QCOMPARE(set.toRegion(), first & second);
+}
+
+void RectSetTest::testIntersects()
+{
+    RectSet set;
+    for (int i = 0; i < 16; ++i) {
+        set.unite(QRect(i * 20, 0, 10, 10));
+    }
+
+    QVERIFY(set.intersects(QRect(305, 5, 1, 1)));
+    QVERIFY(set.intersects(QRect(0, 0, 1, 1)));
+    QVERIFY(!set.intersects(QRect(10, 0, 10, 10)));
+    QVERIFY(!set.intersects(QRect(0, 10, 400, 10)));
+    QVERIFY(set.intersects(RectSet(QRect(295, 9, 10, 10))));
+    QVERIFY(!set.intersects(RectSet(QRect(330, 0, 10, 10))));
+}
+
+void RectSetTest::testTranslate()
+{
+    const QRegion region = QRegion(0, 0, 10, 10) | QRegion(20, 20, 5, 5);
+    const RectSet set(region);
+    QCOMPARE(set.translated(QPoint(7, -3)).toRegion(), region.translated(7, -3));
+}
+
+void RectSetTest::testCopyAndMove()
+{
+    RectSet large;
+    for (int i = 0; i < 100; ++i) {
+        large.unite(QRect(i * 10, i * 10, 5, 5));
+    }
+    QCOMPARE(large.rectCount(), 100);
+
+    RectSet copy(large);
+    QCOMPARE(copy.toRegion(), large.toRegion());
+
+    RectSet moved(std::move(copy));
+    QVERIFY(copy.isEmpty());
+    QCOMPARE(moved.toRegion(), large.toRegion());
+
+    RectSet small(QRect(0, 0, 1, 1));
+    small = std::move(moved);
+    QCOMPARE(small.toRegion(), large.toRegion());
+
+    small = RectSet(QRect(0, 0, 1, 1));
+    QCOMPARE(small.toRegion(), QRegion(0, 0, 1, 1));
+}
+
+static QRect randomRect(QRandomGenerator *generator)
+{
+    return QRect(generator->bounded(200), generator->bounded(200),
+                 1 + generator->bounded(60), 1 + generator->bounded(60));
+}
+
+void RectSetTest::testRandomOperations()
+{
+    // This test verifies that a long sequence of operations yields the same area as
+    // the corresponding QRegion operations.
+    QRandomGenerator generator(42);
+    RectSet set;
+    QRegion region;
+
+    for (int i = 0; i < 5000; ++i) {
+        const QRect rect = randomRect(&generator);
+        switch (generator.bounded(4)) {
+        case 0:
+        case 1:
+            set.unite(rect);
+            region |= rect;
+            break;
+        case 2:
+            set.subtract(rect);
+            region -= rect;
+            break;
+        case 3:
+            set.intersect(QRect(0, 0, 180, 180));
+            region &= QRect(0, 0, 180, 180);
+            break;
+        }
+        QCOMPARE(set.toRegion(), region);
+        QCOMPARE(set.intersects(rect), region.intersects(rect));
+    }
+}
+
+static DamageTrace loadTrace(const QString &fileName)
+{
+    // Every line describes a frame: the damage followed by the opaque region of every
+    // window, separated by '|'. Regions are lists of "x,y,width,height" separated by ';'.
+    DamageTrace trace;
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return trace;
+    }
+    auto parseRegion = [](const QString &text) {
+        QRegion region;
+        const QStringList rects = text.split(QLatin1Char(';'), Qt::SkipEmptyParts);
+        for (const QString &rect : rects) {
+            const QStringList values = rect.split(QLatin1Char(','));
+            if (values.count() == 4) {
+                region |= QRect(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
+            }
+        }
+        return region;
+    };
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        const QStringList parts = stream.readLine().split(QLatin1Char('|'));
+        if (parts.isEmpty()) {
+            continue;
+        }
+        DamageFrame frame;
+        frame.damage = parseRegion(parts[0]);
+        for (int i = 1; i < parts.count(); ++i) {
+            frame.clips.append(parseRegion(parts[i]));
+        }
+        trace.append(frame);
+    }
+    return trace;
+}
+
+static DamageTrace generateTrace(const QString &workload)
+{
+    // Synthetic traces modelled after common desktop workloads on a 1920x1080 screen with
+    // a maximized window at the bottom, a few cascaded windows and a panel.
+    QRandomGenerator generator(7);
+    QVector<QRegion> clips;
+    clips.append(QRegion(0, 0, 1920, 1044));
+    for (int i = 0; i < 8; ++i) {
+        QRegion clip(100 + i * 60, 80 + i * 40, 800, 600);
+        // Rounded corners make the opaque region of a window consist of several rects.
+        clip -= QRegion(100 + i * 60, 80 + i * 40, 4, 4);
+        clip -= QRegion(100 + i * 60 + 796, 80 + i * 40, 4, 4);
+        clips.append(clip);
+    }
+    clips.append(QRegion(0, 1044, 1920, 36));
+
+    DamageTrace trace;
+    for (int i = 0; i < 600; ++i) {
+        DamageFrame frame;
+        frame.clips = clips;
+        if (workload == QLatin1String("cursor")) {
+            frame.damage = QRegion(640 + (i % 40) * 8, 400, 2, 18);
+        } else if (workload == QLatin1String("terminal")) {
+            frame.damage = QRegion(580, 400, 800, 560);
+            frame.damage |= QRegion(560, 380, 800, 20);
+        } else if (workload == QLatin1String("video")) {
+            frame.damage = QRegion(400, 200, 1280, 720);
+        } else if (workload == QLatin1String("drag")) {
+            const QRect from(100 + i % 400, 100 + i % 300, 800, 600);
+            frame.damage = QRegion(from) | QRegion(from.translated(3, 2));
+            frame.clips[4] = QRegion(from.translated(3, 2));
+        } else {
+            for (int j = 0; j < 12; ++j) {
+                frame.damage |= QRect(generator.bounded(1900), generator.bounded(1060),
+                                      1 + generator.bounded(120), 1 + generator.bounded(40));
+            }
+        }
+        trace.append(frame);
+    }
+    return trace;
+}
+
+void RectSetTest::benchmarkTrace_data()
+{
+    QTest::addColumn<DamageTrace>("trace");
+    QTest::addColumn<bool>("rectSet");
+
+    QStringList workloads{
+        QStringLiteral("cursor"),
+        QStringLiteral("terminal"),
+        QStringLiteral("video"),
+        QStringLiteral("drag"),
+        QStringLiteral("scattered"),
+    };
+    for (const QString &workload : workloads) {
+        const DamageTrace trace = generateTrace(workload);
+        QTest::newRow(qPrintable(workload + QStringLiteral("/QRegion"))) << trace << false;
+        QTest::newRow(qPrintable(workload + QStringLiteral("/RectSet"))) << trace << true;
+    }
+
+    // A trace captured on a real session can be passed with KWIN_DAMAGE_TRACE.
+    const QString fileName = qEnvironmentVariable("KWIN_DAMAGE_TRACE");
+    if (!fileName.isEmpty()) {
+        const DamageTrace trace = loadTrace(fileName);
+        QTest::newRow("captured/QRegion") << trace << false;
+        QTest::newRow("captured/RectSet") << trace << true;
+    }
+}
+
+void RectSetTest::benchmarkTrace()
+{
+    // Replays the region arithmetic that Scene::paintSimpleScreen() and the buffer age
+    // code do for every frame of the trace.
+    QFETCH(DamageTrace, trace);
+    QFETCH(bool, rectSet);
+
+    const int bufferAge = 3;
+
+    if (rectSet) {
+        QBENCHMARK {
+            for (int i = 0; i < trace.count(); ++i) {
+                RectSet damage(trace[i].damage);
+                for (int j = std::max(0, i - bufferAge + 1); j < i; ++j) {
+                    damage.unite(RectSet(trace[j].damage));
+                }
+
+                RectSet allclips;
+                RectSet upperTranslucentDamage;
+                for (int j = trace[i].clips.count() - 1; j >= 0; --j) {
+                    RectSet windowRegion = damage;
+                    windowRegion.unite(upperTranslucentDamage);
+                    windowRegion.subtract(allclips);
+
+                    const RectSet clip(trace[i].clips[j]);
+                    allclips.unite(clip);
+                    upperTranslucentDamage.unite(windowRegion.subtracted(clip));
+                    windowRegion.toRegion();
+                }
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (int i = 0; i < trace.count(); ++i) {
+                QRegion damage = trace[i].damage;
+                for (int j = std::max(0, i - bufferAge + 1); j < i; ++j) {
+                    damage |= trace[j].damage;
+                }
+
+                QRegion allclips;
+                QRegion upperTranslucentDamage;
+                for (int j = trace[i].clips.count() - 1; j >= 0; --j) {
+                    QRegion windowRegion = damage | upperTranslucentDamage;
+                    windowRegion -= allclips;
+
+                    const QRegion &clip = trace[i].clips[j];
+                    allclips |= clip;
+                    upperTranslucentDamage |= windowRegion - clip;
+                }
+            }
+        }
+    }
+}
+
+QTEST_MAIN(RectSetTest)
+#include "test_rectset.moc"
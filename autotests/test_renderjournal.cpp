@@ -0,0 +1,282 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "renderjournal.h"
+
+#include <QTest>
+#include <QTextStream>
+
+using namespace KWin;
+using namespace std::chrono_literals;
+
+class RenderJournalTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testHistogramEmpty();
+    void testHistogramPercentile_data();
+    void testHistogramPercentile();
+    void testHistogramRemove();
+    void testRingBufferWrapsAround();
+    void testPresentation();
+    void testDroppedFrames();
+    void testDirectScanout();
+    void testDump();
+    void testGpuCompletion();
+    void testWakeupError();
+    void testPrediction();
+    void benchmarkRecordFrame();
+};
+
+void RenderJournalTest::testHistogramEmpty()
+{
+    RenderHistogram histogram;
+    QCOMPARE(histogram.count(), quint64(0));
+    QCOMPARE(histogram.percentile(50), 0ns);
+    QCOMPARE(histogram.percentile(99), 0ns);
+}
+
+void RenderJournalTest::testHistogramPercentile_data()
+{
+    QTest::addColumn<qreal>("percentile");
+    QTest::addColumn<qint64>("expected");
+
+    QTest::newRow("p50") << 50.0 << qint64(500);
+    QTest::newRow("p95") << 95.0 << qint64(950);
+    QTest::newRow("p99") << 99.0 << qint64(990);
+    QTest::newRow("p100") << 100.0 << qint64(1000);
+}
+
+void RenderJournalTest::testHistogramPercentile()
+{
+    RenderHistogram histogram;
+    for (int i = 1; i <= 1000; ++i) {
+        histogram.add(std::chrono::microseconds(i));
+    }
+    QCOMPARE(histogram.count(), quint64(1000));
+
+    QFETCH(qreal, percentile);
+    QFETCH(qint64, expected);
+
+    // The histogram has a relative error of about 3%.
+    const qint64 actual = std::chrono::duration_cast<std::chrono::microseconds>(histogram.percentile(percentile)).count();
+    QVERIFY(actual >= expected);
+    QVERIFY(actual <= expected * 1.04);
+}
+
+void RenderJournalTest::testHistogramRemove()
+{
+    RenderHistogram histogram;
+    histogram.add(1ms);
+    histogram.add(10ms);
+    QVERIFY(histogram.percentile(100) >= 10ms);
+
+    histogram.remove(10ms);
+    QCOMPARE(histogram.count(), quint64(1));
+    QVERIFY(histogram.percentile(100) < 2ms);
+}
+
+void RenderJournalTest::testRingBufferWrapsAround()
+{
+    RenderJournal journal;
+    const int frameCount = RenderJournal::s_recordCapacity + 10;
+    for (int i = 0; i < frameCount; ++i) {
+        journal.scheduleFrame(std::chrono::milliseconds(i), std::chrono::milliseconds(i + 16));
+        journal.beginFrame();
+        journal.endFrame();
+        journal.presentFrame(std::chrono::milliseconds(i + 16), 16ms);
+    }
+
+    QCOMPARE(journal.frameCount(), quint64(frameCount));
+
+    const QVector<RenderRecord> records = journal.records();
+    QCOMPARE(records.count(), RenderJournal::s_recordCapacity);
+    QCOMPARE(records.first().scheduledTimestamp, std::chrono::nanoseconds(10ms));
+    QCOMPARE(records.last().scheduledTimestamp, std::chrono::nanoseconds(std::chrono::milliseconds(frameCount - 1)));
+}
+
+void RenderJournalTest::testPresentation()
+{
+    RenderJournal journal;
+
+    journal.scheduleFrame(0ns, 16ms);
+    journal.beginFrame();
+    journal.endFrame();
+    journal.scheduleFrame(16ms, 32ms);
+    journal.beginFrame();
+    journal.endFrame();
+
+    // Frames are presented in the order they have been rendered.
+    journal.presentFrame(16ms, 16ms);
+    journal.presentFrame(48ms, 16ms);
+    journal.presentFrame(64ms, 16ms);
+
+    const QVector<RenderRecord> records = journal.records();
+    QCOMPARE(records.count(), 2);
+    QCOMPARE(records[0].presentationTimestamp, std::chrono::nanoseconds(16ms));
+    QVERIFY(!records[0].missedVblank);
+    QCOMPARE(records[1].presentationTimestamp, std::chrono::nanoseconds(48ms));
+    QVERIFY(records[1].missedVblank);
+    QCOMPARE(journal.missedFrameCount(), quint64(1));
+}
+
+void RenderJournalTest::testDroppedFrames()
+{
+    RenderJournal journal;
+
+    journal.beginFrame();
+    journal.endFrame();
+    journal.dropFrame();
+
+    journal.beginFrame();
+    journal.endFrame();
+    journal.dropPendingFrames();
+
+    journal.presentFrame(16ms, 16ms);
+
+    const QVector<RenderRecord> records = journal.records();
+    QCOMPARE(records.count(), 2);
+    QVERIFY(records[0].failed);
+    QVERIFY(records[1].failed);
+    QCOMPARE(records[1].presentationTimestamp, 0ns);
+}
+
+void RenderJournalTest::testDirectScanout()
+{
+    RenderJournal journal;
+
+    journal.beginFrame();
+    journal.endFrame();
+
+    journal.beginFrame();
+    journal.markDirectScanout();
+    journal.endFrame();
+
+    const QVector<RenderRecord> records = journal.records();
+    QCOMPARE(records.count(), 2);
+    QVERIFY(!records[0].directScanout);
+    QVERIFY(records[1].directScanout);
+    QCOMPARE(journal.frameCount(), quint64(2));
+    QCOMPARE(journal.directScanoutFrameCount(), quint64(1));
+}
+
+void RenderJournalTest::testDump()
+{
+    RenderJournal journal;
+    journal.scheduleFrame(1ms, 2ms);
+    journal.beginFrame();
+    journal.endFrame();
+
+    QString output;
+    QTextStream stream(&output);
+    journal.dump(stream);
+    stream.flush();
+
+    const QStringList lines = output.split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    QCOMPARE(lines.count(), 2);
+    QVERIFY(lines[1].startsWith(QStringLiteral("1000000,")));
+    QCOMPARE(lines[1].split(QLatin1Char(',')).count(), 10);
+}
+
+void RenderJournalTest::testGpuCompletion()
+{
+    RenderJournal journal;
+
+    const quint64 sequence = journal.frameCount();
+    journal.beginFrame();
+    journal.endFrame();
+
+    const RenderRecord cpuRecord = journal.records().last();
+    journal.setGpuCompletionTimestamp(sequence, cpuRecord.renderStartTimestamp + 5ms);
+
+    const RenderRecord gpuRecord = journal.records().last();
+    QCOMPARE(gpuRecord.renderTime(), std::chrono::nanoseconds(5ms));
+    QCOMPARE(journal.predictedRenderTime(), std::chrono::nanoseconds(5ms));
+
+    // Unknown frames are ignored.
+    journal.setGpuCompletionTimestamp(sequence + 1, cpuRecord.renderStartTimestamp + 10ms);
+    QCOMPARE(journal.records().count(), 1);
+    QCOMPARE(journal.predictedRenderTime(), std::chrono::nanoseconds(5ms));
+}
+
+void RenderJournalTest::testWakeupError()
+{
+    RenderJournal journal;
+
+    journal.scheduleFrame(10ms, 16ms);
+    journal.dispatchFrame(10ms + 800us);
+    journal.beginFrame();
+    journal.endFrame();
+
+    journal.scheduleFrame(26ms, 32ms);
+    journal.dispatchFrame(26ms - 200us);
+    journal.beginFrame();
+    journal.endFrame();
+
+    // Frames without a dispatch time don't count.
+    for (int i = 0; i < 3; ++i) {
+        journal.scheduleFrame(42ms, 48ms);
+        journal.beginFrame();
+        journal.endFrame();
+    }
+
+    const QVector<RenderRecord> records = journal.records();
+    QCOMPARE(records[0].wakeupError(), std::chrono::nanoseconds(800us));
+    QCOMPARE(records[1].wakeupError(), std::chrono::nanoseconds(-200us));
+    QCOMPARE(records[2].wakeupError(), std::chrono::nanoseconds::zero());
+
+    QVERIFY(journal.wakeupErrorPercentile(100) >= 800us);
+    QVERIFY(journal.wakeupErrorPercentile(50) >= 200us);
+    QVERIFY(journal.wakeupErrorPercentile(50) < 800us);
+}
+
+void RenderJournalTest::testPrediction()
+{
+    RenderJournal journal;
+
+    for (int i = 0; i < 100; ++i) {
+        const quint64 sequence = journal.frameCount();
+        journal.beginFrame();
+        journal.endFrame();
+        const RenderRecord record = journal.records().last();
+        journal.setGpuCompletionTimestamp(sequence, record.renderStartTimestamp + 4ms);
+    }
+
+    // A stable workload converges to the actual render time with the minimum margin.
+    QVERIFY(journal.predictedRenderTime() > 3900us);
+    QVERIFY(journal.predictedRenderTime() < 4100us);
+    QCOMPARE(journal.predictionMargin(), std::chrono::nanoseconds(1ms));
+
+    for (int i = 0; i < 20; ++i) {
+        const quint64 sequence = journal.frameCount();
+        journal.beginFrame();
+        journal.endFrame();
+        const RenderRecord record = journal.records().last();
+        journal.setGpuCompletionTimestamp(sequence, record.renderStartTimestamp + ((i % 2) ? 2ms : 8ms));
+    }
+
+    // A jittery workload increases the safety margin.
+    QVERIFY(journal.predictionMargin() > 5ms);
+}
+
+void RenderJournalTest::benchmarkRecordFrame()
+{
+    RenderJournal journal;
+    std::chrono::nanoseconds timestamp = 0ns;
+    QBENCHMARK {
+        journal.scheduleFrame(timestamp, timestamp + 7ms);
+        journal.beginFrame();
+        journal.endFrame();
+        journal.presentFrame(timestamp + 7ms, 7ms);
+        timestamp += 7ms;
+    }
+}
+
+QTEST_GUILESS_MAIN(RenderJournalTest)
+#include "test_renderjournal.moc"
@@ -0,0 +1,134 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "testutils.h"
+#include "x11windowindex.h"
+
+#include <QTest>
+
+using namespace KWin;
+
+// The index never dereferences the toplevels, so fake pointers are good enough.
+static Toplevel *fakeToplevel(int id)
+{
+    return reinterpret_cast<Toplevel *>(quintptr(id + 1) * 16);
+}
+
+struct FakeClient
+{
+    Toplevel *toplevel;
+    xcb_window_t window;
+    xcb_window_t wrapper;
+    xcb_window_t frame;
+    xcb_window_t input;
+};
+
+static QVector<FakeClient> createFakeClients(int count)
+{
+    QVector<FakeClient> clients;
+    clients.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const xcb_window_t base = 0x1000000 + i * 4;
+        clients.append(FakeClient{fakeToplevel(i), base, base + 1, base + 2, base + 3});
+    }
+    return clients;
+}
+
+class X11WindowIndexTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testRoles();
+    void testNone();
+    void testRemove();
+    void benchmarkIndex_data();
+    void benchmarkIndex();
+};
+
+void X11WindowIndexTest::testRoles()
+{
+    X11WindowIndex index;
+    index.insert(1, fakeToplevel(0), X11WindowIndex::Role::Client);
+    index.insert(2, fakeToplevel(0), X11WindowIndex::Role::Frame);
+    index.insert(3, fakeToplevel(1), X11WindowIndex::Role::Unmanaged);
+    QCOMPARE(index.count(), 3);
+
+    QCOMPARE(index.find(1, X11WindowIndex::Role::Client), fakeToplevel(0));
+    QCOMPARE(index.find(2, X11WindowIndex::Role::Frame), fakeToplevel(0));
+    QCOMPARE(index.find(3, X11WindowIndex::Role::Unmanaged), fakeToplevel(1));
+
+    // A window matches only in the role that it has been added with.
+    QCOMPARE(index.find(1, X11WindowIndex::Role::Frame), nullptr);
+    QCOMPARE(index.find(2, X11WindowIndex::Role::Client), nullptr);
+    QCOMPARE(index.find(3, X11WindowIndex::Role::Client), nullptr);
+    QCOMPARE(index.find(4, X11WindowIndex::Role::Client), nullptr);
+}
+
+void X11WindowIndexTest::testNone()
+{
+    X11WindowIndex index;
+    index.insert(XCB_WINDOW_NONE, fakeToplevel(0), X11WindowIndex::Role::Input);
+    QCOMPARE(index.count(), 0);
+    QCOMPARE(index.find(XCB_WINDOW_NONE, X11WindowIndex::Role::Input), nullptr);
+}
+
+void X11WindowIndexTest::testRemove()
+{
+    X11WindowIndex index;
+    index.insert(1, fakeToplevel(0), X11WindowIndex::Role::Client);
+
+    // Only the owner can remove the window.
+    index.remove(1, fakeToplevel(1));
+    QCOMPARE(index.find(1, X11WindowIndex::Role::Client), fakeToplevel(0));
+
+    index.remove(1, fakeToplevel(0));
+    QCOMPARE(index.find(1, X11WindowIndex::Role::Client), nullptr);
+    QCOMPARE(index.count(), 0);
+
+    index.insert(1, fakeToplevel(0), X11WindowIndex::Role::Client);
+    index.clear();
+    QCOMPARE(index.count(), 0);
+}
+
+void X11WindowIndexTest::benchmarkIndex_data()
+{
+    addWindowCountRows();
+}
+
+void X11WindowIndexTest::benchmarkIndex()
+{
+    QFETCH(int, windowCount);
+    const QVector<FakeClient> clients = createFakeClients(windowCount);
+
+    X11WindowIndex index;
+    for (const FakeClient &client : clients) {
+        index.insert(client.window, client.toplevel, X11WindowIndex::Role::Client);
+        index.insert(client.wrapper, client.toplevel, X11WindowIndex::Role::Wrapper);
+        index.insert(client.frame, client.toplevel, X11WindowIndex::Role::Frame);
+        index.insert(client.input, client.toplevel, X11WindowIndex::Role::Input);
+    }
+
+    // Simulates the dispatch of an event for the frame of every client, which
+    // is the third lookup in Workspace::workspaceEvent().
+    QBENCHMARK {
+        for (const FakeClient &client : clients) {
+            Toplevel *toplevel = index.find(client.frame, X11WindowIndex::Role::Client);
+            if (!toplevel) {
+                toplevel = index.find(client.frame, X11WindowIndex::Role::Wrapper);
+            }
+            if (!toplevel) {
+                toplevel = index.find(client.frame, X11WindowIndex::Role::Frame);
+            }
+            QCOMPARE(toplevel, client.toplevel);
+        }
+    }
+}
+
+QTEST_MAIN(X11WindowIndexTest)
+#include "test_x11windowindex.moc"
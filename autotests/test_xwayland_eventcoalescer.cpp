@@ -0,0 +1,201 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "xwl/eventreader.h"
+
+#include <QTest>
+
+#include <xcb/damage.h>
+
+#include <cstdlib>
+
+using namespace KWin::Xwl;
+
+static const uint8_t s_damageNotifyEvent = 91;
+
+template <typename T>
+static T *createEvent(uint8_t responseType)
+{
+    // Events read from the connection are always 32 bytes plus the full_sequence field.
+    static_assert(sizeof(T) <= sizeof(xcb_generic_event_t) + sizeof(uint32_t), "not an event");
+    T *event = static_cast<T *>(calloc(1, sizeof(xcb_generic_event_t) + sizeof(uint32_t)));
+    event->response_type = responseType;
+    return event;
+}
+
+static xcb_generic_event_t *damageNotify(xcb_damage_damage_t damage)
+{
+    auto event = createEvent<xcb_damage_notify_event_t>(s_damageNotifyEvent);
+    event->damage = damage;
+    return reinterpret_cast<xcb_generic_event_t *>(event);
+}
+
+static xcb_generic_event_t *propertyNotify(xcb_window_t window, xcb_atom_t atom, uint8_t state = XCB_PROPERTY_NEW_VALUE)
+{
+    auto event = createEvent<xcb_property_notify_event_t>(XCB_PROPERTY_NOTIFY);
+    event->window = window;
+    event->atom = atom;
+    event->state = state;
+    return reinterpret_cast<xcb_generic_event_t *>(event);
+}
+
+static xcb_generic_event_t *configureNotify(xcb_window_t window, int16_t x)
+{
+    auto event = createEvent<xcb_configure_notify_event_t>(XCB_CONFIGURE_NOTIFY);
+    event->event = window;
+    event->window = window;
+    event->x = x;
+    return reinterpret_cast<xcb_generic_event_t *>(event);
+}
+
+static xcb_generic_event_t *motionNotify(xcb_window_t window, int16_t x, uint16_t state = 0)
+{
+    auto event = createEvent<xcb_motion_notify_event_t>(XCB_MOTION_NOTIFY);
+    event->event = window;
+    event->event_x = x;
+    event->state = state;
+    return reinterpret_cast<xcb_generic_event_t *>(event);
+}
+
+static xcb_generic_event_t *selectionRequest(xcb_window_t requestor)
+{
+    auto event = createEvent<xcb_selection_request_event_t>(XCB_SELECTION_REQUEST);
+    event->requestor = requestor;
+    return reinterpret_cast<xcb_generic_event_t *>(event);
+}
+
+static void freeEvents(const QVector<xcb_generic_event_t *> &events)
+{
+    for (xcb_generic_event_t *event : events) {
+        free(event);
+    }
+}
+
+class EventCoalescerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testClassify();
+    void testDamage();
+    void testProperty();
+    void testConfigure();
+    void testMotion();
+    void testSelection();
+    void testSentEvents();
+};
+
+void EventCoalescerTest::testClassify()
+{
+    EventCoalescer coalescer(s_damageNotifyEvent);
+    QVector<xcb_generic_event_t *> events{
+        damageNotify(1),
+        propertyNotify(1, 1),
+        configureNotify(1, 0),
+        selectionRequest(1),
+        motionNotify(1, 0),
+        reinterpret_cast<xcb_generic_event_t *>(createEvent<xcb_map_request_event_t>(XCB_MAP_REQUEST)),
+    };
+    QCOMPARE(coalescer.classify(events[0]), EventCoalescer::Category::Damage);
+    QCOMPARE(coalescer.classify(events[1]), EventCoalescer::Category::Property);
+    QCOMPARE(coalescer.classify(events[2]), EventCoalescer::Category::Configure);
+    QCOMPARE(coalescer.classify(events[3]), EventCoalescer::Category::Selection);
+    QCOMPARE(coalescer.classify(events[4]), EventCoalescer::Category::Motion);
+    QCOMPARE(coalescer.classify(events[5]), EventCoalescer::Category::Other);
+
+    // Without the DAMAGE extension, nothing is a damage event.
+    EventCoalescer withoutDamage;
+    QCOMPARE(withoutDamage.classify(events[0]), EventCoalescer::Category::Other);
+
+    freeEvents(events);
+}
+
+void EventCoalescerTest::testDamage()
+{
+    EventCoalescer coalescer(s_damageNotifyEvent);
+    xcb_generic_event_t *last1 = damageNotify(1);
+    xcb_generic_event_t *last2 = damageNotify(2);
+    QVector<xcb_generic_event_t *> events{damageNotify(1), damageNotify(2), damageNotify(1), last1, last2};
+
+    QCOMPARE(coalescer.coalesce(events), 3);
+    QCOMPARE(events, (QVector<xcb_generic_event_t *>{last1, last2}));
+    freeEvents(events);
+}
+
+void EventCoalescerTest::testProperty()
+{
+    EventCoalescer coalescer(s_damageNotifyEvent);
+    xcb_generic_event_t *name = propertyNotify(1, 10);
+    xcb_generic_event_t *deleted = propertyNotify(1, 11, XCB_PROPERTY_DELETE);
+    xcb_generic_event_t *otherWindow = propertyNotify(2, 10);
+    xcb_generic_event_t *icon = propertyNotify(1, 11);
+    QVector<xcb_generic_event_t *> events{propertyNotify(1, 10), deleted, otherWindow, name, icon};
+
+    // A deletion and a new value of the same property are both kept.
+    QCOMPARE(coalescer.coalesce(events), 1);
+    QCOMPARE(events, (QVector<xcb_generic_event_t *>{deleted, otherWindow, name, icon}));
+    freeEvents(events);
+}
+
+void EventCoalescerTest::testConfigure()
+{
+    EventCoalescer coalescer(s_damageNotifyEvent);
+    xcb_generic_event_t *property = propertyNotify(1, 10);
+    xcb_generic_event_t *last1 = configureNotify(1, 30);
+    xcb_generic_event_t *last2 = configureNotify(2, 10);
+    QVector<xcb_generic_event_t *> events{configureNotify(1, 10), property, configureNotify(1, 20), last2, last1};
+
+    QCOMPARE(coalescer.coalesce(events), 2);
+    QCOMPARE(events, (QVector<xcb_generic_event_t *>{property, last2, last1}));
+    QCOMPARE(reinterpret_cast<xcb_configure_notify_event_t *>(events[2])->x, 30);
+    freeEvents(events);
+}
+
+void EventCoalescerTest::testMotion()
+{
+    EventCoalescer coalescer(s_damageNotifyEvent);
+    xcb_generic_event_t *first = motionNotify(1, 20);
+    xcb_generic_event_t *press = reinterpret_cast<xcb_generic_event_t *>(createEvent<xcb_button_press_event_t>(XCB_BUTTON_PRESS));
+    xcb_generic_event_t *dragged = motionNotify(1, 40, XCB_BUTTON_MASK_1);
+    xcb_generic_event_t *otherWindow = motionNotify(2, 50, XCB_BUTTON_MASK_1);
+    QVector<xcb_generic_event_t *> events{motionNotify(1, 10), first, press, motionNotify(1, 30, XCB_BUTTON_MASK_1), dragged, otherWindow};
+
+    // Motion is only merged with the motion right after it, never across other events.
+    QCOMPARE(coalescer.coalesce(events), 2);
+    QCOMPARE(events, (QVector<xcb_generic_event_t *>{first, press, dragged, otherWindow}));
+    freeEvents(events);
+}
+
+void EventCoalescerTest::testSelection()
+{
+    EventCoalescer coalescer(s_damageNotifyEvent);
+    QVector<xcb_generic_event_t *> events{selectionRequest(1), selectionRequest(1), selectionRequest(1)};
+    const QVector<xcb_generic_event_t *> expected = events;
+
+    QCOMPARE(coalescer.coalesce(events), 0);
+    QCOMPARE(events, expected);
+    freeEvents(events);
+}
+
+void EventCoalescerTest::testSentEvents()
+{
+    EventCoalescer coalescer(s_damageNotifyEvent);
+    xcb_generic_event_t *sent = configureNotify(1, 10);
+    sent->response_type |= 0x80;
+    QCOMPARE(coalescer.classify(sent), EventCoalescer::Category::Other);
+
+    // A synthetic event means something else than a real one, so it is never dropped.
+    xcb_generic_event_t *real = configureNotify(1, 20);
+    QVector<xcb_generic_event_t *> events{sent, real};
+    QCOMPARE(coalescer.coalesce(events), 0);
+    QCOMPARE(events, (QVector<xcb_generic_event_t *>{sent, real}));
+    freeEvents(events);
+}
+
+QTEST_GUILESS_MAIN(EventCoalescerTest)
+#include "test_xwayland_eventcoalescer.moc"
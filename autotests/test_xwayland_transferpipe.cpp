@@ -0,0 +1,243 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "xwl/transferpipe.h"
+
+#include <QRandomGenerator>
+#include <QTest>
+#include <QThread>
+
+#include <csignal>
+#include <thread>
+#include <unistd.h>
+
+using namespace KWin::Xwl;
+
+static const int s_chunkSize = 63 * 1024;
+
+static QByteArray createPayload(int size)
+{
+    QByteArray payload(size, Qt::Uninitialized);
+    QRandomGenerator generator(size);
+    generator.fillRange(reinterpret_cast<quint32 *>(payload.data()), size / sizeof(quint32));
+    return payload;
+}
+
+class TransferPipeTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testChunkPool();
+    void testRead_data();
+    void testRead();
+    void testWrite_data();
+    void testWrite();
+    void testWriteToClosedPipe();
+
+private:
+    QThread m_thread;
+};
+
+void TransferPipeTest::initTestCase()
+{
+    // KWin ignores SIGPIPE as well, writing to a closed pipe must fail rather than kill us.
+    signal(SIGPIPE, SIG_IGN);
+    m_thread.start();
+}
+
+void TransferPipeTest::cleanupTestCase()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void TransferPipeTest::testChunkPool()
+{
+    ChunkPool pool(1024, 2);
+    QByteArray first = pool.acquire();
+    QCOMPARE(first.size(), 1024);
+    const char *data = first.constData();
+
+    // A shrunk chunk is reused with its full size.
+    first.resize(10);
+    pool.release(std::move(first));
+    QCOMPARE(pool.count(), 1);
+    QByteArray second = pool.acquire();
+    QCOMPARE(second.constData(), data);
+    QCOMPARE(second.size(), 1024);
+    QCOMPARE(pool.count(), 0);
+
+    // Chunks that are still shared are not reused.
+    QByteArray shared = second;
+    pool.release(std::move(second));
+    QCOMPARE(pool.count(), 0);
+
+    // The pool doesn't grow beyond its maximum.
+    pool.release(pool.acquire());
+    pool.release(pool.acquire());
+    QByteArray a = pool.acquire();
+    QByteArray b = pool.acquire();
+    QByteArray c = pool.acquire();
+    pool.release(std::move(a));
+    pool.release(std::move(b));
+    pool.release(std::move(c));
+    QCOMPARE(pool.count(), 2);
+}
+
+void TransferPipeTest::testRead_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::addRow("empty") << 0;
+    QTest::addRow("one chunk") << s_chunkSize;
+    QTest::addRow("partial chunk") << 1000;
+    QTest::addRow("8 MiB") << 8 * 1024 * 1024;
+}
+
+void TransferPipeTest::testRead()
+{
+    QFETCH(int, size);
+    const QByteArray payload = createPayload(size);
+
+    int fds[2];
+    QCOMPARE(pipe(fds), 0);
+
+    ChunkPool pool(s_chunkSize);
+    PipeReader *reader = new PipeReader(fds[0], &pool, &m_thread);
+
+    // The signals are emitted on the worker thread, use this as the context to get them queued.
+    QByteArray received;
+    QByteArray lastChunk;
+    int chunkCount = 0;
+    bool finished = false;
+    bool failed = false;
+    connect(reader, &PipeReader::chunkRead, this, [&](const QByteArray &chunk) {
+        QCOMPARE(chunk.size(), s_chunkSize);
+        received.append(chunk);
+        chunkCount++;
+    });
+    connect(reader, &PipeReader::finished, this, [&](const QByteArray &chunk) {
+        lastChunk = chunk;
+        finished = true;
+    });
+    connect(reader, &PipeReader::failed, this, [&failed]() {
+        failed = true;
+    });
+    reader->start();
+
+    std::thread writer([&payload, fd = fds[1]]() {
+        int offset = 0;
+        while (offset < payload.size()) {
+            const ssize_t length = write(fd, payload.constData() + offset, payload.size() - offset);
+            if (length <= 0) {
+                break;
+            }
+            offset += length;
+        }
+        close(fd);
+    });
+
+    QTRY_VERIFY_WITH_TIMEOUT(finished || failed, 10000);
+    writer.join();
+    QVERIFY(!failed);
+
+    QVERIFY(lastChunk.size() < s_chunkSize);
+    received.append(lastChunk);
+    QCOMPARE(chunkCount, size / s_chunkSize);
+    QCOMPARE(received.size(), payload.size());
+    QVERIFY(received == payload);
+
+    reader->destroy();
+}
+
+void TransferPipeTest::testWrite_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::addRow("empty") << 0;
+    QTest::addRow("small") << 1000;
+    QTest::addRow("8 MiB") << 8 * 1024 * 1024;
+}
+
+void TransferPipeTest::testWrite()
+{
+    QFETCH(int, size);
+    const QByteArray payload = createPayload(size);
+
+    int fds[2];
+    QCOMPARE(pipe(fds), 0);
+
+    PipeWriter *writer = new PipeWriter(fds[1], &m_thread);
+    qint64 written = 0;
+    bool drained = false;
+    bool failed = false;
+    connect(writer, &PipeWriter::bytesWritten, this, [&written](qint64 count) {
+        written += count;
+    });
+    connect(writer, &PipeWriter::drained, this, [&drained]() {
+        drained = true;
+    });
+    connect(writer, &PipeWriter::failed, this, [&failed]() {
+        failed = true;
+    });
+
+    // The payload is much larger than the pipe buffer, so the writer has to wait for the peer.
+    QByteArray received;
+    std::thread reader([&received, fd = fds[0]]() {
+        char buffer[16 * 1024];
+        while (true) {
+            const ssize_t length = read(fd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+            received.append(buffer, length);
+        }
+        close(fd);
+    });
+
+    writer->send(QByteArray::fromRawData(payload.constData(), payload.size()));
+    QTRY_VERIFY_WITH_TIMEOUT(drained || failed, 10000);
+    QVERIFY(!failed);
+    QCOMPARE(written, qint64(size));
+
+    // Destroying the writer closes the pipe, which ends the reader.
+    writer->destroy();
+    reader.join();
+    QCOMPARE(received.size(), payload.size());
+    QVERIFY(received == payload);
+}
+
+void TransferPipeTest::testWriteToClosedPipe()
+{
+    int fds[2];
+    QCOMPARE(pipe(fds), 0);
+    close(fds[0]);
+
+    const QByteArray payload = createPayload(1000);
+    PipeWriter *writer = new PipeWriter(fds[1], &m_thread);
+    bool drained = false;
+    bool failed = false;
+    connect(writer, &PipeWriter::drained, this, [&drained]() {
+        drained = true;
+    });
+    connect(writer, &PipeWriter::failed, this, [&failed]() {
+        failed = true;
+    });
+
+    writer->send(payload);
+    QTRY_VERIFY(failed);
+    QVERIFY(!drained);
+
+    writer->destroy();
+}
+
+QTEST_GUILESS_MAIN(TransferPipeTest)
+#include "test_xwayland_transferpipe.moc"
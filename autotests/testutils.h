@@ -10,6 +10,8 @@
 #define TESTUTILS_H
 // KWin
 #include <kwinglobals.h>
+// Qt
+#include <QTest>
 // XCB
 #include <xcb/xcb.h>
 
@@ -47,6 +49,18 @@ static uint32_t noneWindow()
 }
 #endif
 
+/**
+ * Adds the window counts that the benchmarks are run with as the "windowCount" column.
+ */
+static void addWindowCountRows()
+{
+    QTest::addColumn<int>("windowCount");
+
+    QTest::addRow("100") << 100;
+    QTest::addRow("1000") << 1000;
+    QTest::addRow("5000") << 5000;
+}
+
 } // namespace
 
 #endif
@@ -13,10 +13,14 @@
 #include "decorations/decoratedclient.h"
 #include "deleted.h"
 #include "effects.h"
+#include "framearena.h"
 #include "ftrace.h"
+#include "input.h"
+#include "inputlatencytracer.h"
 #include "internal_client.h"
 #include "overlaywindow.h"
 #include "platform.h"
+#include "pointer_input.h"
 #include "renderloop.h"
 #include "scene.h"
 #include "screens.h"
@@ -110,6 +114,7 @@ Compositor::Compositor(QObject* workspace)
     , m_state(State::Off)
     , m_selectionOwner(nullptr)
     , m_scene(nullptr)
+    , m_frameArena(new FrameArena)
 {
     connect(options, &Options::configChanged, this, &Compositor::configChanged);
     connect(options, &Options::animationSpeedChanged, this, &Compositor::configChanged);
@@ -158,6 +163,7 @@ Compositor::~Compositor()
     stop();
     deleteUnusedSupportProperties();
     destroyCompositorSelection();
+    destroyDamageFetchRegion();
     s_compositor = nullptr;
 }
 
@@ -315,6 +321,31 @@ void Compositor::cleanupX11()
 {
     delete m_selectionOwner;
     m_selectionOwner = nullptr;
+    destroyDamageFetchRegion();
+}
+
+xcb_xfixes_region_t Compositor::damageFetchRegion()
+{
+    if (m_damageFetchRegion == XCB_NONE) {
+        xcb_connection_t *connection = kwinApp()->x11Connection();
+        if (!connection) {
+            return XCB_NONE;
+        }
+        m_damageFetchRegion = xcb_generate_id(connection);
+        xcb_xfixes_create_region(connection, m_damageFetchRegion, 0, nullptr);
+    }
+    return m_damageFetchRegion;
+}
+
+void Compositor::destroyDamageFetchRegion()
+{
+    if (m_damageFetchRegion == XCB_NONE) {
+        return;
+    }
+    if (xcb_connection_t *connection = kwinApp()->x11Connection()) {
+        xcb_xfixes_destroy_region(connection, m_damageFetchRegion);
+    }
+    m_damageFetchRegion = XCB_NONE;
 }
 
 void Compositor::startupWithWorkspace()
@@ -588,32 +619,49 @@ void Compositor::addRepaintFull()
 
 void Compositor::handleFrameRequested(RenderLoop *renderLoop)
 {
+    // Apply the coalesced pointer motion so the frame shows the latest cursor position.
+    InputRedirection *redirection = input();
+    if (redirection) {
+        redirection->pointer()->flushCoalescedMotion();
+    }
+
     // If outputs are disabled, we return to the event loop and
     // continue processing events until the outputs are enabled again
     if (!kwinApp()->platform()->areOutputsEnabled()) {
         return;
     }
 
+    if (redirection) {
+        if (InputLatencyTracer *tracer = redirection->latencyTracer()) {
+            tracer->frameStarted(renderLoop);
+        }
+    }
+
     const int screenId = screenForRenderLoop(renderLoop);
 
     fTraceDuration("Paint (", screens()->name(screenId), ")");
 
     // Create a list of all windows in the stacking order
     QList<Toplevel *> windows = Workspace::self()->xStackingOrder();
-    QList<Toplevel *> damaged;
+    FrameVector<Toplevel *> damaged(m_frameArena.data());
+    damaged.reserve(windows.count());
+
+    {
+        fTraceDuration("Request damage");
 
-    // Reset the damage state of each window and fetch the damage region
-    // without waiting for a reply
-    for (Toplevel *win : qAsConst(windows)) {
-        if (win->resetAndFetchDamage()) {
-            damaged << win;
+        // Reset the damage state of each window and fetch the damage region
+        // without waiting for a reply, all requests are sent in one flush
+        for (Toplevel *win : qAsConst(windows)) {
+            if (win->resetAndFetchDamage()) {
+                damaged.push_back(win);
+            }
         }
-    }
 
-    if (damaged.count() > 0) {
-        m_scene->triggerFence();
-        if (auto c = kwinApp()->x11Connection()) {
-            xcb_flush(c);
+        if (!damaged.empty()) {
+            m_scene->triggerFence();
+            if (auto c = kwinApp()->x11Connection()) {
+                xcb_flush(c);
+            }
         }
     }
 
@@ -624,18 +672,22 @@ void Compositor::handleFrameRequested(RenderLoop *renderLoop)
         windows.append(t);
     }
 
-    // Get the replies
-    for (Toplevel *win : qAsConst(damaged)) {
-        // Discard the cached lanczos texture
-        if (win->effectWindow()) {
-            const QVariant texture = win->effectWindow()->data(LanczosCacheRole);
-            if (texture.isValid()) {
-                delete static_cast<GLTexture *>(texture.value<void*>());
-                win->effectWindow()->setData(LanczosCacheRole, QVariant());
+    if (!damaged.empty()) {
+        fTraceDuration("Collect damage");
+
+        // Get the replies
+        for (Toplevel *win : damaged) {
+            // Discard the cached lanczos texture
+            if (win->effectWindow()) {
+                const QVariant texture = win->effectWindow()->data(LanczosCacheRole);
+                if (texture.isValid()) {
+                    delete static_cast<GLTexture *>(texture.value<void*>());
+                    win->effectWindow()->setData(LanczosCacheRole, QVariant());
+                }
             }
-        }
 
-        win->getDamageRegionReply();
+            win->getDamageRegionReply();
+        }
     }
 
     // Skip windows that are not yet ready for being painted and if screen is locked skip windows
@@ -668,6 +720,7 @@ void Compositor::handleFrameRequested(RenderLoop *renderLoop)
     renderLoop->beginFrame();
     m_scene->paint(screenId, repaints, windows, presentTime);
     renderLoop->endFrame();
+    m_frameArena->reset();
 
     if (m_framesToTestForSafety > 0) {
         if (m_scene->compositingType() & OpenGLCompositing) {
@@ -705,6 +758,11 @@ void Compositor::handleFrameRequested(RenderLoop *renderLoop)
     }
 }
 
+FrameArena *Compositor::frameArena() const
+{
+    return m_frameArena.data();
+}
+
 bool Compositor::isActive()
 {
     return m_state == State::On;
@@ -15,11 +15,14 @@
 #include <QTimer>
 #include <QRegion>
 
+#include <xcb/xfixes.h>
+
 namespace KWin
 {
 
 class AbstractOutput;
 class CompositorSelectionOwner;
+class FrameArena;
 class RenderLoop;
 class Scene;
 class X11Client;
@@ -73,6 +76,20 @@ public:
         return m_scene;
     }
 
+    /**
+     * Returns the arena for data that is needed only while a frame is being painted.
+     * The arena is reset after every frame.
+     */
+    FrameArena *frameArena() const;
+
+    /**
+     * Returns the XFixes region that windows copy their damage into before it's fetched.
+     * The X server handles the requests in order, so one region can be shared by all
+     * windows damaged in a frame. The region is created on first use and destroyed
+     * together with the X11 connection.
+     */
+    xcb_xfixes_region_t damageFetchRegion();
+
     /**
      * @brief Static check to test whether the Compositor is available and active.
      *
@@ -124,6 +141,7 @@ private Q_SLOTS:
 private:
     void initializeX11();
     void cleanupX11();
+    void destroyDamageFetchRegion();
 
     void releaseCompositorSelection();
     void deleteUnusedSupportProperties();
@@ -141,6 +159,8 @@ private:
     Scene *m_scene;
     int m_framesToTestForSafety = 3;
     QMap<RenderLoop *, AbstractOutput *> m_renderLoops;
+    QScopedPointer<FrameArena> m_frameArena;
+    xcb_xfixes_region_t m_damageFetchRegion = XCB_NONE;
 };
 
 class KWIN_EXPORT WaylandCompositor : public Compositor
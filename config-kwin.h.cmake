@@ -26,6 +26,7 @@
 #cmakedefine01 HAVE_SYS_PROCCTL_H
 #cmakedefine01 HAVE_PROC_TRACE_CTL
 #cmakedefine01 HAVE_SYS_SYSMACROS_H
+#cmakedefine01 HAVE_SYS_TIMERFD_H
 #cmakedefine01 HAVE_BREEZE_DECO
 #cmakedefine01 HAVE_LIBCAP
 #cmakedefine01 HAVE_SCHED_RESET_ON_FORK
@@ -15,16 +15,20 @@
 
 // kwin
 #include "abstract_client.h"
+#include "abstract_output.h"
 #include "atoms.h"
 #include "composite.h"
 #include "debug_console.h"
+#include "framearena.h"
 #include "main.h"
 #include "placement.h"
 #include "platform.h"
 #include "pluginmanager.h"
 #include "kwinadaptor.h"
+#include "renderloop_p.h"
 #include "scene.h"
 #include "unmanaged.h"
+#include "utils.h"
 #include "workspace.h"
 #include "virtualdesktops.h"
 #ifdef KWIN_BUILD_ACTIVITIES
@@ -34,6 +38,8 @@
 // Qt
 #include <QOpenGLContext>
 #include <QDBusServiceWatcher>
+#include <QFile>
+#include <QTextStream>
 
 namespace KWin
 {
@@ -344,6 +350,81 @@ QStringList CompositorDBusInterface::supportedOpenGLPlatformInterfaces() const
     return interfaces;
 }
 
+static RenderLoop *findRenderLoop(const QString &outputName)
+{
+    const auto outputs = kwinApp()->platform()->enabledOutputs();
+    for (AbstractOutput *output : outputs) {
+        if (outputName.isEmpty() || output->name() == outputName) {
+            return output->renderLoop();
+        }
+    }
+    return nullptr;
+}
+
+QVariantMap CompositorDBusInterface::renderStatistics(const QString &outputName) const
+{
+    RenderLoop *renderLoop = findRenderLoop(outputName);
+    if (!renderLoop) {
+        return QVariantMap();
+    }
+
+    const RenderJournal &journal = RenderLoopPrivate::get(renderLoop)->renderJournal;
+    auto toMicroseconds = [](std::chrono::nanoseconds value) {
+        return qint64(std::chrono::duration_cast<std::chrono::microseconds>(value).count());
+    };
+
+    const FrameArena::Statistics arenaStatistics = m_compositor->frameArena()->lastFrameStatistics();
+    Scene::FrameStatistics sceneStatistics;
+    if (const Scene *scene = m_compositor->scene()) {
+        sceneStatistics = scene->frameStatistics();
+    }
+
+    return QVariantMap{
+        {QStringLiteral("refreshRate"), renderLoop->refreshRate()},
+        {QStringLiteral("frameCount"), journal.frameCount()},
+        {QStringLiteral("missedFrameCount"), journal.missedFrameCount()},
+        {QStringLiteral("directScanoutFrameCount"), journal.directScanoutFrameCount()},
+        {QStringLiteral("compositedFrameCount"), journal.frameCount() - journal.directScanoutFrameCount()},
+        {QStringLiteral("renderTimeMinimum"), toMicroseconds(journal.minimum())},
+        {QStringLiteral("renderTimeAverage"), toMicroseconds(journal.average())},
+        {QStringLiteral("renderTimeMaximum"), toMicroseconds(journal.maximum())},
+        {QStringLiteral("renderTimeP50"), toMicroseconds(journal.renderTimePercentile(50))},
+        {QStringLiteral("renderTimeP95"), toMicroseconds(journal.renderTimePercentile(95))},
+        {QStringLiteral("renderTimeP99"), toMicroseconds(journal.renderTimePercentile(99))},
+        {QStringLiteral("latencyP50"), toMicroseconds(journal.latencyPercentile(50))},
+        {QStringLiteral("latencyP95"), toMicroseconds(journal.latencyPercentile(95))},
+        {QStringLiteral("latencyP99"), toMicroseconds(journal.latencyPercentile(99))},
+        {QStringLiteral("preciseTimer"), renderLoop->timerType() == RenderLoop::TimerType::Precise},
+        {QStringLiteral("wakeupErrorP50"), toMicroseconds(journal.wakeupErrorPercentile(50))},
+        {QStringLiteral("wakeupErrorP99"), toMicroseconds(journal.wakeupErrorPercentile(99))},
+        {QStringLiteral("frameArenaAllocations"), arenaStatistics.allocationCount},
+        {QStringLiteral("frameArenaBytes"), arenaStatistics.allocatedBytes},
+        {QStringLiteral("frameArenaBlockAllocations"), arenaStatistics.blockAllocationCount},
+        {QStringLiteral("frameArenaCapacity"), quint64(m_compositor->frameArena()->capacity())},
+        {QStringLiteral("drawCalls"), sceneStatistics.drawCallCount},
+        {QStringLiteral("batchedDrawCalls"), sceneStatistics.batchCount},
+        {QStringLiteral("batchedWindows"), sceneStatistics.batchedWindowCount},
+    };
+}
+
+bool CompositorDBusInterface::dumpRenderJournal(const QString &outputName, const QString &fileName) const
+{
+    RenderLoop *renderLoop = findRenderLoop(outputName);
+    if (!renderLoop) {
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qCWarning(KWIN_CORE) << "Failed to open" << fileName << "for writing:" << file.errorString();
+        return false;
+    }
+
+    QTextStream stream(&file);
+    RenderLoopPrivate::get(renderLoop)->renderJournal.dump(stream);
+    return true;
+}
+
 
 
 
@@ -162,6 +162,23 @@ public Q_SLOTS:
      */
     void reinitialize();
 
+    /**
+     * @brief Returns frame timing statistics of the output with the given @p outputName.
+     *
+     * All durations are in microseconds. If @p outputName is empty, the statistics of the
+     * first enabled output are returned. The frame arena counters describe the most recently
+     * painted frame, a non-zero number of block allocations means the arena had to grow.
+     */
+    QVariantMap renderStatistics(const QString &outputName) const;
+
+    /**
+     * @brief Writes the recent frame records of the output with the given @p outputName
+     * to @p fileName as comma separated values.
+     *
+     * @return @c true if the records have been written successfully, otherwise @c false
+     */
+    bool dumpRenderJournal(const QString &outputName, const QString &fileName) const;
+
 Q_SIGNALS:
     void compositingToggled(bool active);
 
@@ -630,6 +630,23 @@ void DebugConsole::initGLTab()
 
     m_ui->platformExtensionsLabel->setText(extensionsString(Compositor::self()->scene()->openGLPlatformInterfaceExtensions()));
     m_ui->openGLExtensionsLabel->setText(extensionsString(openGLExtensions()));
+
+    Scene *scene = Compositor::self()->scene();
+    connect(scene, &Scene::frameRendered, this, [this, scene] {
+        const Scene::FrameStatistics statistics = scene->frameStatistics();
+        m_ui->drawCallCountLabel->setText(QString::number(statistics.drawCallCount));
+        m_ui->batchCountLabel->setText(QString::number(statistics.batchCount));
+        m_ui->batchedWindowCountLabel->setText(QString::number(statistics.batchedWindowCount));
+        m_ui->atlasPageCountLabel->setText(QString::number(statistics.atlasPageCount));
+        if (statistics.atlasTexelCount > 0) {
+            m_ui->atlasOccupancyLabel->setText(i18nc("Used part and memory size of the texture atlas", "%1% of %2 MiB",
+                                                     statistics.atlasUsedTexelCount * 100 / statistics.atlasTexelCount,
+                                                     statistics.atlasTexelCount * 4 / (1024 * 1024)));
+        } else {
+            m_ui->atlasOccupancyLabel->setText(QString());
+        }
+        m_ui->atlasDedicatedTextureCountLabel->setText(QString::number(statistics.atlasDedicatedTextureCount));
+    });
 }
 
 template <typename T>
@@ -8,6 +8,7 @@
 */
 #include "decorationbridge.h"
 #include "decoratedclient.h"
+#include "decorationrasterizer.h"
 #include "decorationrenderer.h"
 #include "decorations_logging.h"
 #include "settings.h"
@@ -57,6 +58,7 @@ DecorationBridge::DecorationBridge(QObject *parent)
     , m_showToolTips(false)
     , m_settings()
     , m_noPlugin(false)
+    , m_rasterizer(new Rasterizer(this))
 {
     KConfigGroup cg(KSharedConfig::openConfig(), "KDE");
 
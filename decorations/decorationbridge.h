@@ -33,6 +33,8 @@ class AbstractClient;
 namespace Decoration
 {
 
+class Rasterizer;
+
 class KWIN_EXPORT DecorationBridge : public KDecoration2::DecorationBridge
 {
     Q_OBJECT
@@ -65,6 +67,13 @@ public:
 
     QString supportInformation() const;
 
+    /**
+     * Returns the Rasterizer that is shared by the renderers of all decorations.
+     */
+    Rasterizer *rasterizer() const {
+        return m_rasterizer;
+    }
+
 Q_SIGNALS:
     void metaDataLoaded();
 
@@ -85,6 +94,7 @@ private:
     QString m_theme;
     QSharedPointer<KDecoration2::DecorationSettings> m_settings;
     bool m_noPlugin;
+    Rasterizer *m_rasterizer;
     KWIN_SINGLETON(DecorationBridge)
 };
 } // Decoration
@@ -0,0 +1,88 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "decorationrasterizer.h"
+
+#include <QThread>
+#include <QThreadPool>
+
+namespace KWin
+{
+namespace Decoration
+{
+
+// Images that are not in use anymore are kept until they take more memory than this.
+static const qint64 s_maximumImageBytes = 32 * 1024 * 1024;
+
+Rasterizer::Rasterizer(QObject *parent)
+    : QObject(parent)
+    , m_threadPool(new QThreadPool(this))
+    , m_threaded(qgetenv("KWIN_THREADED_DECORATIONS") != QByteArrayLiteral("0"))
+{
+    // Leave one core to the compositor, a few threads are enough to keep up with decorations.
+    m_threadPool->setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+}
+
+Rasterizer::~Rasterizer()
+{
+    waitForDone();
+}
+
+bool Rasterizer::isThreaded() const
+{
+    return m_threaded;
+}
+
+void Rasterizer::setThreaded(bool threaded)
+{
+    m_threaded = threaded;
+}
+
+void Rasterizer::run(std::function<void()> job)
+{
+    m_threadPool->start(std::move(job));
+}
+
+void Rasterizer::waitForDone()
+{
+    m_threadPool->waitForDone();
+}
+
+QImage Rasterizer::acquireImage(const QSize &size, qreal devicePixelRatio)
+{
+    for (int i = m_images.count() - 1; i >= 0; --i) {
+        const QImage &candidate = m_images.at(i);
+        if (candidate.size() == size && candidate.devicePixelRatio() == devicePixelRatio) {
+            QImage image = m_images.takeAt(i);
+            m_imageBytes -= image.sizeInBytes();
+            return image;
+        }
+    }
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatio);
+    return image;
+}
+
+void Rasterizer::releaseImage(QImage &&image)
+{
+    QImage released = std::move(image);
+    if (released.isNull() || !released.isDetached() || released.format() != QImage::Format_ARGB32_Premultiplied) {
+        return;
+    }
+    m_imageBytes += released.sizeInBytes();
+    m_images.append(released);
+
+    // Drop the images that have been released the longest time ago.
+    while (m_imageBytes > s_maximumImageBytes) {
+        m_imageBytes -= m_images.takeFirst().sizeInBytes();
+    }
+}
+
+}
+}
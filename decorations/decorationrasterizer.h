@@ -0,0 +1,87 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KWIN_DECORATION_RASTERIZER_H
+#define KWIN_DECORATION_RASTERIZER_H
+
+#include <kwin_export.h>
+
+#include <QImage>
+#include <QObject>
+#include <QVector>
+
+#include <functional>
+
+class QThreadPool;
+
+namespace KWin
+{
+namespace Decoration
+{
+
+/**
+ * The Rasterizer runs the expensive part of painting decorations, turning recorded paint
+ * commands into pixels, on a pool of worker threads, so repainting many decorations at
+ * once, e.g. after the color scheme or the scale of an output has changed, doesn't block
+ * the compositor.
+ *
+ * It also keeps the images that decorations have been rasterized into after they have been
+ * uploaded, decorations of the same size can paint into them again rather than allocating
+ * new images.
+ *
+ * Threaded rasterization can be disabled by setting the environment variable
+ * KWIN_THREADED_DECORATIONS to 0.
+ */
+class KWIN_EXPORT Rasterizer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Rasterizer(QObject *parent = nullptr);
+    ~Rasterizer() override;
+
+    /**
+     * Returns @c true if decorations are rasterized on worker threads.
+     */
+    bool isThreaded() const;
+    /**
+     * Sets whether decorations are rasterized on worker threads, regardless of
+     * KWIN_THREADED_DECORATIONS.
+     */
+    void setThreaded(bool threaded);
+
+    /**
+     * Runs @p job on a worker thread.
+     */
+    void run(std::function<void()> job);
+    /**
+     * Blocks until all jobs passed to run() have finished.
+     */
+    void waitForDone();
+
+    /**
+     * Returns an image of the given @p size and @p devicePixelRatio with undefined contents.
+     * Must be called on the main thread.
+     */
+    QImage acquireImage(const QSize &size, qreal devicePixelRatio);
+    /**
+     * Gives @p image back to the Rasterizer, so it can be reused by acquireImage(). Images
+     * that are still referenced elsewhere are not reused. Must be called on the main thread.
+     */
+    void releaseImage(QImage &&image);
+
+private:
+    QThreadPool *m_threadPool;
+    QVector<QImage> m_images;
+    qint64 m_imageBytes = 0;
+    bool m_threaded;
+};
+
+}
+}
+
+#endif
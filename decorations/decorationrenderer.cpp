@@ -8,6 +8,8 @@
 */
 #include "decorationrenderer.h"
 #include "decoratedclient.h"
+#include "decorationbridge.h"
+#include "decorationrasterizer.h"
 #include "decorations/decorations_logging.h"
 #include "deleted.h"
 #include "abstract_client.h"
@@ -16,18 +18,71 @@
 #include <KDecoration2/Decoration>
 #include <KDecoration2/DecoratedClient>
 
+#include <QAtomicInt>
 #include <QDebug>
+#include <QMutex>
 #include <QPainter>
+#include <QPointer>
 
 namespace KWin
 {
 namespace Decoration
 {
 
+/**
+ * The TilePicture class records the paint commands of a tile. It reports the device pixel
+ * ratio of the image that the tile is going to be played on, so icons and other pixmaps
+ * are recorded at the resolution of the output.
+ */
+class TilePicture : public QPicture
+{
+public:
+    explicit TilePicture(qreal devicePixelRatio)
+        : m_devicePixelRatio(devicePixelRatio)
+    {
+    }
+
+protected:
+    int metric(PaintDeviceMetric metric) const override
+    {
+        switch (metric) {
+        case PdmDevicePixelRatio:
+            return m_devicePixelRatio;
+        case PdmDevicePixelRatioScaled:
+            return m_devicePixelRatio * QPaintDevice::devicePixelRatioFScale();
+        default:
+            return QPicture::metric(metric);
+        }
+    }
+
+private:
+    qreal m_devicePixelRatio;
+};
+
+/**
+ * The tiles of one call to rasterize() that are rasterized on a worker thread.
+ */
+struct Renderer::TileBatch
+{
+    /**
+     * Rasterizes the tiles unless that has been done already. Returns @c false if there was
+     * nothing to do.
+     */
+    bool rasterize();
+
+    QVector<Tile> tiles;
+    QRect area;
+    QPointer<Renderer> renderer;
+    QMutex mutex;
+    QAtomicInt ready;
+};
+
 Renderer::Renderer(DecoratedClientImpl *client)
     : QObject(client)
     , m_client(client)
     , m_imageSizesDirty(true)
+    // The first paint of a new window can't wait for a worker thread.
+    , m_synchronous(!client->client()->readyForPainting())
 {
     auto markImageSizesDirty = [this]{
         schedule(m_client->client()->rect());
@@ -91,6 +146,132 @@ void Renderer::renderToPainter(QPainter *painter, const QRect &rect)
     client()->decoration()->paint(painter, rect);
 }
 
+void Renderer::paintTile(Tile &tile, const std::function<void(QPainter *)> &paint)
+{
+    tile.image.fill(Qt::transparent);
+
+    const qreal devicePixelRatio = tile.devicePixelRatio;
+    QPainter painter(&tile.image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setViewport(QRect(tile.viewport.topLeft(), tile.viewport.size() * devicePixelRatio));
+    painter.setWindow(QRect(tile.rect.topLeft(), tile.rect.size() * devicePixelRatio));
+    painter.setClipRect(tile.rect);
+    paint(&painter);
+    painter.end();
+
+    if (tile.finish) {
+        tile.finish(tile.image);
+    }
+}
+
+void Renderer::rasterize(QVector<Tile> tiles)
+{
+    if (tiles.isEmpty()) {
+        return;
+    }
+    Q_ASSERT(m_client);
+
+    Rasterizer *rasterizer = DecorationBridge::self()->rasterizer();
+    for (Tile &tile : tiles) {
+        tile.image = rasterizer->acquireImage(tile.size, tile.devicePixelRatio);
+    }
+
+    if (m_synchronous || !rasterizer->isThreaded()) {
+        // Tiles that are still being rasterized must not overwrite these ones.
+        finishRasterizing();
+        m_synchronous = false;
+
+        for (Tile &tile : tiles) {
+            paintTile(tile, [this, &tile](QPainter *painter) {
+                renderToPainter(painter, tile.rect);
+            });
+        }
+        uploadTiles(tiles);
+        for (Tile &tile : tiles) {
+            rasterizer->releaseImage(std::move(tile.image));
+        }
+        return;
+    }
+
+    // Only recording the paint commands has to happen on the main thread, the decoration
+    // is not thread-safe. Turning them into pixels is the expensive part.
+    QSharedPointer<TileBatch> batch(new TileBatch);
+    for (Tile &tile : tiles) {
+        TilePicture picture(tile.devicePixelRatio);
+        QPainter painter(&picture);
+        painter.setRenderHint(QPainter::Antialiasing);
+        renderToPainter(&painter, tile.rect);
+        painter.end();
+        tile.picture = picture;
+        batch->area |= tile.rect;
+    }
+    batch->tiles = std::move(tiles);
+    batch->renderer = this;
+    m_pendingBatches.append(batch);
+
+    rasterizer->run([rasterizer, batch]() {
+        if (!batch->rasterize()) {
+            return;
+        }
+        QMetaObject::invokeMethod(rasterizer, [batch]() {
+            if (batch->renderer && batch->renderer->m_client) {
+                batch->renderer->m_client->client()->addRepaint(batch->area);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+bool Renderer::TileBatch::rasterize()
+{
+    QMutexLocker locker(&mutex);
+    if (ready.loadAcquire()) {
+        return false;
+    }
+    for (Tile &tile : tiles) {
+        paintTile(tile, [&tile](QPainter *painter) {
+            painter->drawPicture(0, 0, tile.picture);
+        });
+        tile.picture = QPicture();
+    }
+    ready.storeRelease(1);
+    return true;
+}
+
+void Renderer::uploadRasterizedTiles()
+{
+    while (!m_pendingBatches.isEmpty() && m_pendingBatches.first()->ready.loadAcquire()) {
+        QVector<Tile> tiles = std::move(m_pendingBatches.takeFirst()->tiles);
+        uploadTiles(tiles);
+
+        Rasterizer *rasterizer = DecorationBridge::self()->rasterizer();
+        for (Tile &tile : tiles) {
+            rasterizer->releaseImage(std::move(tile.image));
+        }
+    }
+}
+
+void Renderer::finishRasterizing()
+{
+    m_synchronous = true;
+
+    // Tiles that no worker thread has picked up yet are rasterized right here, otherwise
+    // this waits until the worker thread is done with them.
+    for (const QSharedPointer<TileBatch> &batch : qAsConst(m_pendingBatches)) {
+        batch->rasterize();
+    }
+    uploadRasterizedTiles();
+}
+
+void Renderer::cancelRasterizing()
+{
+    m_pendingBatches.clear();
+}
+
+void Renderer::uploadTiles(const QVector<Tile> &tiles)
+{
+    Q_UNUSED(tiles)
+}
+
 void Renderer::reparent(Deleted *deleted)
 {
     setParent(deleted);
@@ -9,11 +9,17 @@
 #ifndef KWIN_DECORATION_RENDERER_H
 #define KWIN_DECORATION_RENDERER_H
 
+#include <QImage>
 #include <QObject>
+#include <QPicture>
 #include <QRegion>
+#include <QSharedPointer>
+#include <QVector>
 
 #include <kwin_export.h>
 
+#include <functional>
+
 namespace KWin
 {
 
@@ -64,10 +70,83 @@ protected:
     QImage renderToImage(const QRect &geo);
     void renderToPainter(QPainter *painter, const QRect &rect);
 
+    /**
+     * The Tile struct describes an image of a part of the decoration.
+     */
+    struct Tile {
+        /**
+         * The area of the decoration that is painted, in logical pixels.
+         */
+        QRect rect;
+        /**
+         * The area of the image that rect is painted into, in logical pixels. The rest of
+         * the image can be filled by finish, e.g. with padding.
+         */
+        QRect viewport;
+        /**
+         * The size of the image, in device pixels.
+         */
+        QSize size;
+        qreal devicePixelRatio = 1;
+        /**
+         * Post-processes the image after the decoration has been painted into it. This may
+         * run on a worker thread, so it must not touch the renderer.
+         */
+        std::function<void(QImage &)> finish;
+        /**
+         * The part of the decoration and the place that the image belongs to, free for use
+         * by uploadTiles().
+         */
+        int part = 0;
+        QPoint offset;
+
+        QPicture picture;
+        QImage image;
+    };
+
+    /**
+     * Paints @p tiles and passes them to uploadTiles() once they are ready.
+     *
+     * The decoration is recorded on the calling thread and rasterized on a worker thread,
+     * the tiles are handed to uploadTiles() by a later call to uploadRasterizedTiles(). The
+     * first paint of a new window, and the paint after finishRasterizing(), are done right
+     * away. Call finishRasterizing() before painting into new images or textures, so the
+     * window is never shown without its decoration, or with a decoration that doesn't fit.
+     */
+    void rasterize(QVector<Tile> tiles);
+    /**
+     * Passes the tiles that worker threads are done with to uploadTiles(), in the order in
+     * which they have been requested. The window gets a repaint when tiles are ready, call
+     * this before painting the decoration.
+     */
+    void uploadRasterizedTiles();
+    /**
+     * Waits until all tiles have been rasterized and passes them to uploadTiles(). The
+     * next call to rasterize() paints on the calling thread.
+     */
+    void finishRasterizing();
+    /**
+     * Drops the tiles that are still being rasterized, e.g. because the images they are
+     * meant for have been replaced.
+     */
+    void cancelRasterizing();
+
+    /**
+     * Copies @p tiles into the images or the textures of the decoration. Reimplement this if
+     * the renderer uses rasterize().
+     */
+    virtual void uploadTiles(const QVector<Tile> &tiles);
+
 private:
+    struct TileBatch;
+
+    static void paintTile(Tile &tile, const std::function<void(QPainter *)> &paint);
+
     DecoratedClientImpl *m_client;
     QRegion m_scheduled;
     bool m_imageSizesDirty;
+    bool m_synchronous;
+    QVector<QSharedPointer<TileBatch>> m_pendingBatches;
 };
 
 }
@@ -507,6 +507,16 @@ void EffectsHandlerImpl::startPaint()
     m_currentPaintEffectFrameIterator = m_activeEffects.constBegin();
 }
 
+bool EffectsHandlerImpl::blocksDirectScanout() const
+{
+    for (const EffectPair &pair : loaded_effects) {
+        if (pair.second->isActive() && pair.second->blocksDirectScanout()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void EffectsHandlerImpl::slotClientMaximized(KWin::AbstractClient *c, MaximizeMode maxMode)
 {
     bool horizontal = false;
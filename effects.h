@@ -191,6 +191,11 @@ public:
 
     // internal (used by kwin core or compositing code)
     void startPaint();
+    /**
+     * Returns @c true if an active effect may change the contents of fullscreen windows,
+     * in which case they cannot be presented with direct scanout.
+     */
+    bool blocksDirectScanout() const;
     void grabbedKeyboardEvent(QKeyEvent* e);
     bool hasKeyboardGrab() const;
     void desktopResized(const QSize &size);
@@ -516,5 +516,11 @@ bool ContrastEffect::isActive() const
     return !effects->isScreenLocked();
 }
 
+bool ContrastEffect::blocksDirectScanout() const
+{
+    // Only the area behind translucent windows is changed.
+    return false;
+}
+
 } // namespace KWin
 
@@ -44,6 +44,7 @@ public:
 
     bool provides(Feature feature) override;
     bool isActive() const override;
+    bool blocksDirectScanout() const override;
 
     int requestedEffectChainPosition() const override {
         return 76;
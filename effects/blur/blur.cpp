@@ -16,6 +16,7 @@
 #include <QScreen> // for QGuiApplication
 #include <QTime>
 #include <QWindow>
+#include <algorithm>
 #include <cmath> // for ceil()
 
 #include <KWaylandServer/surface_interface.h>
@@ -34,6 +35,7 @@ BlurEffect::BlurEffect()
 {
     initConfig<BlurConfig>();
     m_shader = new BlurShader(this);
+    m_cacheEnabled = qgetenv("KWIN_BLUR_CACHE") != QByteArrayLiteral("0");
 
     initBlurStrengthValues();
     reconfigure(ReconfigureAll);
@@ -93,6 +95,9 @@ bool BlurEffect::renderTargetsValid() const
 
 void BlurEffect::deleteFBOs()
 {
+    // The cached textures have the size of the render textures.
+    clearCache();
+
     qDeleteAll(m_renderTargets);
 
     m_renderTargets.clear();
@@ -321,6 +326,12 @@ void BlurEffect::slotWindowAdded(EffectWindow *w)
 
 void BlurEffect::slotWindowDeleted(EffectWindow *w)
 {
+    if (BlurCacheEntry *entry = m_cache.take(w)) {
+        effects->makeOpenGLContextCurrent();
+        delete entry;
+        effects->doneOpenGLContextCurrent();
+    }
+
     auto it = windowBlurChangedConnections.find(w);
     if (it == windowBlurChangedConnections.end()) {
         return;
@@ -475,6 +486,14 @@ void BlurEffect::prePaintScreen(ScreenPrePaintData &data, std::chrono::milliseco
     m_currentBlur = QRegion();
 
     effects->prePaintScreen(data, presentTime);
+
+    ++m_cacheFrame;
+    for (BlurCacheEntry *entry : qAsConst(m_cache)) {
+        entry->visited = false;
+    }
+    // The damage of the screen itself, e.g. the area a window has moved away from, is
+    // behind every window.
+    invalidateCache(data.paint);
 }
 
 void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, std::chrono::milliseconds presentTime)
@@ -511,9 +530,21 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, std::
     const QRegion blurArea = blurRegion(w).translated(w->pos()) & screen;
     const QRegion expandedBlur = (w->isDock() ? blurArea : expand(blurArea)) & screen;
 
+    // the windows underneath have been pre-painted already, the cached blur is still valid
+    // unless one of them has invalidated it
+    bool cached = false;
+    if (BlurCacheEntry *entry = findCacheEntry(w)) {
+        entry->visited = true;
+        if (entry->blurArea != blurArea) {
+            entry->valid = false;
+        }
+        cached = entry->valid && (blurArea & GLRenderTarget::virtualScreenGeometry()).subtracted(entry->region).isEmpty();
+    }
+
     // if this window or a window underneath the blurred area is painted again we have to
-    // blur everything
-    if (m_paintedArea.intersects(expandedBlur) || data.paint.intersects(blurArea)) {
+    // blur everything, unless only this window is painted and its blurred background is
+    // still cached
+    if (m_paintedArea.intersects(expandedBlur) || (!cached && data.paint.intersects(blurArea))) {
         data.paint |= expandedBlur;
         // we have to check again whether we do not damage a blurred area
         // of a window
@@ -526,6 +557,9 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, std::
 
     m_paintedArea -= data.clip;
     m_paintedArea |= data.paint;
+
+    // whatever this window paints is behind the windows that come after it
+    invalidateCache(data.paint);
 }
 
 bool BlurEffect::shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const
@@ -585,7 +619,12 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, const QRegion &region, Wi
         const bool transientForIsDock = (modal ? modal->isDock() : false);
 
         if (!shape.isEmpty()) {
-            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock() || transientForIsDock, w->geometry());
+            // The cached blur can't follow a transformed window.
+            BlurCacheEntry *cacheEntry = nullptr;
+            if (!scaled && !translated) {
+                cacheEntry = cacheEntryForWindow(w, blurRegion(w).translated(w->pos()) & effects->virtualScreenGeometry());
+            }
+            doBlur(shape, screen, data.opacity(), data.screenProjectionMatrix(), w->isDock() || transientForIsDock, w->geometry(), cacheEntry);
         }
     }
 
@@ -633,7 +672,7 @@ void BlurEffect::generateNoiseTexture()
     m_noiseTexture.setWrapMode(GL_REPEAT);
 }
 
-void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect)
+void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCacheEntry *cacheEntry)
 {
     // Blur would not render correctly on a secondary monitor because of wrong coordinates
     // BUG: 393723
@@ -644,47 +683,78 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
 
     const bool useSRGB = m_renderTextures.first().internalFormat() == GL_SRGB8_ALPHA8;
 
+    // If nothing behind the window has changed, the cache entry still holds the blurred
+    // background and only the final pass has to be redone.
+    const bool cacheHit = cacheEntry && cacheEntry->valid && (shape - cacheEntry->region).isEmpty();
+    if (cacheEntry) {
+        if (cacheHit) {
+            m_cacheHits++;
+        } else {
+            m_cacheMisses++;
+            cacheEntry->region = shape;
+            cacheEntry->valid = true;
+        }
+        // The blurred background ends up in the texture of the cache entry instead of the
+        // shared one, the last down sample and up sample iterations render into it.
+        std::swap(m_renderTextures[1], cacheEntry->texture);
+    }
+
     // Upload geometry for the down and upsample iterations
     GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
     vbo->reset();
 
-    uploadGeometry(vbo, expandedBlurRegion.translated(xTranslate, yTranslate), shape);
+    uploadGeometry(vbo, cacheHit ? QRegion() : expandedBlurRegion.translated(xTranslate, yTranslate), shape);
     vbo->bindArrays();
 
-    const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
-    const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
-
-    GLRenderTarget::pushRenderTargets(m_renderTargetStack);
-    int blurRectCount = expandedBlurRegion.rectCount() * 6;
-
-    /*
-     * If the window is a dock or panel we avoid the "extended blur" effect.
-     * Extended blur is when windows that are not under the blurred area affect
-     * the final blur result.
-     * We want to avoid this on panels, because it looks really weird and ugly
-     * when maximized windows or windows near the panel affect the dock blur.
-     */
-    if (isDock) {
-        m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
-
+    int vboStart = 0;
+    if (cacheHit) {
         if (useSRGB) {
             glEnable(GL_FRAMEBUFFER_SRGB);
         }
-
-        copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
     } else {
-        m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
+        const QRect sourceRect = expandedBlurRegion.boundingRect() & screen;
+        const QRect destRect = sourceRect.translated(xTranslate, yTranslate);
 
-        if (useSRGB) {
-            glEnable(GL_FRAMEBUFFER_SRGB);
+        if (cacheEntry) {
+            QStack<GLRenderTarget *> renderTargetStack = m_renderTargetStack;
+            std::replace(renderTargetStack.begin(), renderTargetStack.end(), m_renderTargets[1], cacheEntry->renderTarget.data());
+            GLRenderTarget::pushRenderTargets(renderTargetStack);
+        } else {
+            GLRenderTarget::pushRenderTargets(m_renderTargetStack);
         }
+        int blurRectCount = expandedBlurRegion.rectCount() * 6;
+
+        /*
+         * If the window is a dock or panel we avoid the "extended blur" effect.
+         * Extended blur is when windows that are not under the blurred area affect
+         * the final blur result.
+         * We want to avoid this on panels, because it looks really weird and ugly
+         * when maximized windows or windows near the panel affect the dock blur.
+         */
+        if (isDock) {
+            m_renderTargets.last()->blitFromFramebuffer(sourceRect, destRect);
+
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
 
-        // Remove the m_renderTargets[0] from the top of the stack that we will not use
-        GLRenderTarget::popRenderTarget();
-    }
+            copyScreenSampleTexture(vbo, blurRectCount, shape.translated(xTranslate, yTranslate), screenProjection);
+        } else {
+            m_renderTargets.first()->blitFromFramebuffer(sourceRect, destRect);
 
-    downSampleTexture(vbo, blurRectCount);
-    upSampleTexture(vbo, blurRectCount);
+            if (useSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            }
+
+            // Remove the m_renderTargets[0] from the top of the stack that we will not use
+            GLRenderTarget::popRenderTarget();
+        }
+
+        downSampleTexture(vbo, blurRectCount);
+        upSampleTexture(vbo, blurRectCount);
+
+        vboStart = blurRectCount * (m_downSampleIterations + 1);
+    }
 
     // Modulate the blurred texture with the window opacity if the window isn't opaque
     if (opacity < 1.0) {
@@ -700,7 +770,7 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
         glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
     }
 
-    upscaleRenderToScreen(vbo, blurRectCount * (m_downSampleIterations + 1), shape.rectCount() * 6, screenProjection, windowRect.topLeft());
+    upscaleRenderToScreen(vbo, vboStart, shape.rectCount() * 6, screenProjection, windowRect.topLeft());
 
     if (useSRGB) {
         glDisable(GL_FRAMEBUFFER_SRGB);
@@ -710,6 +780,10 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
         glDisable(GL_BLEND);
     }
 
+    if (cacheEntry) {
+        std::swap(m_renderTextures[1], cacheEntry->texture);
+    }
+
     vbo->unbindArrays();
 }
 
@@ -809,10 +883,102 @@ void BlurEffect::copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount,
     m_shader->unbind();
 }
 
+BlurEffect::BlurCacheEntry *BlurEffect::findCacheEntry(const EffectWindow *w) const
+{
+    BlurCacheEntry *entry = m_cache.value(w);
+    if (!entry || entry->screen != GLRenderTarget::virtualScreenGeometry()) {
+        return nullptr;
+    }
+    return entry;
+}
+
+BlurEffect::BlurCacheEntry *BlurEffect::cacheEntryForWindow(const EffectWindow *w, const QRegion &blurArea)
+{
+    if (!m_cacheEnabled) {
+        return nullptr;
+    }
+
+    BlurCacheEntry *entry = m_cache.value(w);
+    if (!entry) {
+        // Every entry is as big as the shared render texture it stands in for, only keep
+        // a few of them around.
+        static const int s_maxCacheEntries = 4;
+        if (m_cache.count() >= s_maxCacheEntries) {
+            auto leastRecentlyUsed = std::min_element(m_cache.begin(), m_cache.end(),
+                [](const BlurCacheEntry *a, const BlurCacheEntry *b) {
+                    return a->lastUsed < b->lastUsed;
+                });
+            delete *leastRecentlyUsed;
+            m_cache.erase(leastRecentlyUsed);
+        }
+
+        entry = new BlurCacheEntry;
+        entry->texture = GLTexture(m_renderTextures[1].internalFormat(), m_renderTextures[1].size());
+        entry->texture.setFilter(GL_LINEAR);
+        entry->texture.setWrapMode(GL_CLAMP_TO_EDGE);
+        entry->renderTarget.reset(new GLRenderTarget(entry->texture));
+        if (!entry->renderTarget->valid()) {
+            delete entry;
+            return nullptr;
+        }
+        m_cache.insert(w, entry);
+    }
+
+    const QRect screen = GLRenderTarget::virtualScreenGeometry();
+    if (entry->screen != screen) {
+        entry->screen = screen;
+        entry->valid = false;
+    }
+    entry->blurArea = blurArea;
+    entry->lastUsed = m_cacheFrame;
+    return entry;
+}
+
+void BlurEffect::invalidateCache(const QRegion &damage)
+{
+    if (damage.isEmpty()) {
+        return;
+    }
+    const QRect screen = GLRenderTarget::virtualScreenGeometry();
+    for (BlurCacheEntry *entry : qAsConst(m_cache)) {
+        // Entries of the windows that have been pre-painted already are below the damage.
+        if (!entry->valid || entry->visited || entry->screen != screen) {
+            continue;
+        }
+        const QRegion expandedRegion = expand(entry->region);
+        if (expandedRegion.intersects(damage)) {
+            entry->valid = false;
+        }
+    }
+}
+
+void BlurEffect::clearCache()
+{
+    qDeleteAll(m_cache);
+    m_cache.clear();
+}
+
+QString BlurEffect::debug(const QString &parameter) const
+{
+    if (parameter == QLatin1String("cache")) {
+        return QStringLiteral("entries: %1, hits: %2, misses: %3")
+            .arg(m_cache.count())
+            .arg(m_cacheHits)
+            .arg(m_cacheMisses);
+    }
+    return QString();
+}
+
 bool BlurEffect::isActive() const
 {
     return !effects->isScreenLocked();
 }
 
+bool BlurEffect::blocksDirectScanout() const
+{
+    // Only the area behind translucent windows is blurred.
+    return false;
+}
+
 } // namespace KWin
 
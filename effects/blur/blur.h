@@ -12,6 +12,8 @@
 #include <kwinglplatform.h>
 #include <kwinglutils.h>
 
+#include <QHash>
+#include <QScopedPointer>
 #include <QVector>
 #include <QVector2D>
 #include <QStack>
@@ -47,6 +49,7 @@ public:
 
     bool provides(Feature feature) override;
     bool isActive() const override;
+    bool blocksDirectScanout() const override;
 
     int requestedEffectChainPosition() const override {
         return 75;
@@ -54,6 +57,8 @@ public:
 
     bool eventFilter(QObject *watched, QEvent *event) override;
 
+    QString debug(const QString &parameter) const override;
+
 public Q_SLOTS:
     void slotWindowAdded(KWin::EffectWindow *w);
     void slotWindowDeleted(KWin::EffectWindow *w);
@@ -61,6 +66,20 @@ public Q_SLOTS:
     void slotScreenGeometryChanged();
 
 private:
+    /**
+     * The blurred background of a window, kept until something behind the window changes.
+     */
+    struct BlurCacheEntry {
+        GLTexture texture;
+        QScopedPointer<GLRenderTarget> renderTarget;
+        QRect screen; // the render target geometry the entry belongs to
+        QRegion blurArea; // the blurred area of the window when the entry was last used
+        QRegion region; // the part of the blurred area that holds a valid blur
+        bool valid = false;
+        bool visited = false; // whether the window has been pre-painted in the current frame
+        quint64 lastUsed = 0;
+    };
+
     QRect expand(const QRect &rect) const;
     QRegion expand(const QRegion &region) const;
     bool renderTargetsValid() const;
@@ -70,7 +89,7 @@ private:
     QRegion blurRegion(const EffectWindow *w) const;
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
-    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect);
+    void doBlur(const QRegion &shape, const QRect &screen, const float opacity, const QMatrix4x4 &screenProjection, bool isDock, QRect windowRect, BlurCacheEntry *cacheEntry = nullptr);
     void uploadRegion(QVector2D *&map, const QRegion &region, const int downSampleIterations);
     void uploadGeometry(GLVertexBuffer *vbo, const QRegion &blurRegion, const QRegion &windowRegion);
     void generateNoiseTexture();
@@ -80,6 +99,11 @@ private:
     void upSampleTexture(GLVertexBuffer *vbo, int blurRectCount);
     void copyScreenSampleTexture(GLVertexBuffer *vbo, int blurRectCount, QRegion blurShape, QMatrix4x4 screenProjection);
 
+    BlurCacheEntry *findCacheEntry(const EffectWindow *w) const;
+    BlurCacheEntry *cacheEntryForWindow(const EffectWindow *w, const QRegion &blurArea);
+    void invalidateCache(const QRegion &damage);
+    void clearCache();
+
 private:
     BlurShader *m_shader;
     QVector <GLRenderTarget*> m_renderTargets;
@@ -114,6 +138,12 @@ private:
 
     QVector <BlurValuesStruct> blurStrengthValues;
 
+    QHash<const EffectWindow *, BlurCacheEntry *> m_cache;
+    bool m_cacheEnabled;
+    quint64 m_cacheFrame = 0;
+    quint64 m_cacheHits = 0;
+    quint64 m_cacheMisses = 0;
+
     QMap <EffectWindow*, QMetaObject::Connection> windowBlurChangedConnections;
     KWaylandServer::BlurManagerInterface *m_blurManager = nullptr;
 };
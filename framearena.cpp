@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "framearena.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace KWin
+{
+
+FrameArena::FrameArena(size_t initialCapacity)
+{
+    allocateBlock(initialCapacity);
+    // The initial block is not part of any frame.
+    m_currentFrame = Statistics();
+}
+
+FrameArena::~FrameArena()
+{
+    releaseBlocks();
+}
+
+void FrameArena::allocateBlock(size_t size)
+{
+    char *data = static_cast<char *>(std::malloc(size));
+    if (!data) {
+        qFatal("Failed to allocate %zu bytes for the frame arena", size);
+    }
+    m_blocks.append(Block{data, size});
+    m_offset = 0;
+    m_currentFrame.blockAllocationCount++;
+    m_totalBlockAllocationCount++;
+}
+
+void FrameArena::releaseBlocks()
+{
+    for (const Block &block : qAsConst(m_blocks)) {
+        std::free(block.data);
+    }
+    m_blocks.clear();
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment)
+{
+    const Block &block = m_blocks.last();
+    const uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + m_offset;
+    const size_t padding = (alignment - address % alignment) % alignment;
+
+    m_currentFrame.allocationCount++;
+    if (m_offset + padding + size <= block.size) {
+        m_offset += padding + size;
+        m_currentFrame.allocatedBytes += padding + size;
+        return reinterpret_cast<void *>(address + padding);
+    }
+
+    // std::malloc() returns memory that is suitably aligned for any fundamental type.
+    const size_t blockSize = std::max(2 * block.size, size);
+    qCDebug(KWIN_CORE, "Frame arena exhausted, allocating an extra block of %zu bytes", blockSize);
+    allocateBlock(blockSize);
+    m_offset = size;
+    m_currentFrame.allocatedBytes += size;
+    return m_blocks.last().data;
+}
+
+void FrameArena::reset()
+{
+    if (m_blocks.count() > 1) {
+        size_t capacity = 0;
+        for (const Block &block : qAsConst(m_blocks)) {
+            capacity += block.size;
+        }
+        releaseBlocks();
+        allocateBlock(capacity);
+    }
+    m_offset = 0;
+    m_lastFrame = m_currentFrame;
+    m_currentFrame = Statistics();
+}
+
+size_t FrameArena::capacity() const
+{
+    size_t capacity = 0;
+    for (const Block &block : m_blocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+FrameArena::Statistics FrameArena::currentFrameStatistics() const
+{
+    return m_currentFrame;
+}
+
+FrameArena::Statistics FrameArena::lastFrameStatistics() const
+{
+    return m_lastFrame;
+}
+
+quint64 FrameArena::totalBlockAllocationCount() const
+{
+    return m_totalBlockAllocationCount;
+}
+
+} // namespace KWin
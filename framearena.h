@@ -0,0 +1,155 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwinglobals.h"
+
+#include <QVector>
+
+#include <cstddef>
+#include <vector>
+
+namespace KWin
+{
+
+/**
+ * The FrameArena class is a bump allocator for data that lives no longer than a frame.
+ *
+ * Allocations are served from a large block of memory by moving a pointer forward and
+ * are never freed individually. The Compositor resets the arena after every frame. If a
+ * frame needs more memory than the arena has, extra blocks are allocated and merged into
+ * a single larger block on the next reset, so the arena stops allocating blocks once it
+ * has grown to the working set of a typical frame.
+ *
+ * The arena is not thread-safe, it must be used only on the main thread.
+ */
+class KWIN_EXPORT FrameArena
+{
+public:
+    struct Statistics
+    {
+        /**
+         * The number of allocations served by the arena.
+         */
+        quint64 allocationCount = 0;
+        /**
+         * The number of bytes handed out by the arena, including alignment padding.
+         */
+        quint64 allocatedBytes = 0;
+        /**
+         * The number of blocks that the arena had to allocate. Other heap allocations made
+         * while painting the frame are not counted.
+         */
+        quint64 blockAllocationCount = 0;
+    };
+
+    explicit FrameArena(size_t initialCapacity = 64 * 1024);
+    ~FrameArena();
+
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Releases all allocations made since the last reset. Objects that live in the arena
+     * must have been destroyed at this point.
+     */
+    void reset();
+
+    /**
+     * Returns the total amount of memory owned by the arena.
+     */
+    size_t capacity() const;
+
+    /**
+     * Returns the statistics of the allocations made since the last reset.
+     */
+    Statistics currentFrameStatistics() const;
+
+    /**
+     * Returns the statistics of the allocations made between the last two resets.
+     */
+    Statistics lastFrameStatistics() const;
+
+    /**
+     * Returns the number of blocks allocated by the arena over its lifetime.
+     */
+    quint64 totalBlockAllocationCount() const;
+
+private:
+    struct Block
+    {
+        char *data;
+        size_t size;
+    };
+
+    void allocateBlock(size_t size);
+    void releaseBlocks();
+
+    QVector<Block> m_blocks;
+    size_t m_offset = 0;
+    Statistics m_currentFrame;
+    Statistics m_lastFrame;
+    quint64 m_totalBlockAllocationCount = 0;
+
+    Q_DISABLE_COPY(FrameArena)
+};
+
+/**
+ * The FrameAllocator class makes it possible to use standard containers with a FrameArena,
+ * e.g. FrameVector. Memory is reclaimed only when the arena is reset, so it's a good idea
+ * to reserve the expected size of the container up front.
+ */
+template <typename T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+
+    FrameAllocator(FrameArena *arena)
+        : m_arena(arena)
+    {
+    }
+
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U> &other)
+        : m_arena(other.arena())
+    {
+    }
+
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t)
+    {
+    }
+
+    FrameArena *arena() const
+    {
+        return m_arena;
+    }
+
+    template <typename U>
+    bool operator==(const FrameAllocator<U> &other) const
+    {
+        return m_arena == other.arena();
+    }
+
+    template <typename U>
+    bool operator!=(const FrameAllocator<U> &other) const
+    {
+        return m_arena != other.arena();
+    }
+
+private:
+    FrameArena *m_arena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+} // namespace KWin
@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "hittestgrid.h"
+
+namespace KWin
+{
+
+HitTestGrid::HitTestGrid(int cellSize)
+    : m_cellSize(cellSize)
+{
+}
+
+void HitTestGrid::reset(const QRect &extent)
+{
+    m_extent = extent;
+    m_columnCount = (extent.width() + m_cellSize - 1) / m_cellSize;
+    m_rowCount = (extent.height() + m_cellSize - 1) / m_cellSize;
+
+    m_cells.resize(m_columnCount * m_rowCount);
+    for (QVector<int> &cell : m_cells) {
+        cell.clear();
+    }
+}
+
+QRect HitTestGrid::extent() const
+{
+    return m_extent;
+}
+
+void HitTestGrid::insert(int id, const QRect &bounds)
+{
+    const QRect clipped = bounds & m_extent;
+    if (clipped.isEmpty()) {
+        return;
+    }
+
+    const int firstColumn = (clipped.left() - m_extent.left()) / m_cellSize;
+    const int lastColumn = (clipped.right() - m_extent.left()) / m_cellSize;
+    const int firstRow = (clipped.top() - m_extent.top()) / m_cellSize;
+    const int lastRow = (clipped.bottom() - m_extent.top()) / m_cellSize;
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            m_cells[row * m_columnCount + column].append(id);
+        }
+    }
+}
+
+const QVector<int> *HitTestGrid::candidates(const QPoint &pos) const
+{
+    if (!m_extent.contains(pos)) {
+        return nullptr;
+    }
+    const int column = (pos.x() - m_extent.left()) / m_cellSize;
+    const int row = (pos.y() - m_extent.top()) / m_cellSize;
+    return &m_cells[row * m_columnCount + column];
+}
+
+} // namespace KWin
@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwinglobals.h"
+
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The HitTestGrid class is a uniform grid that narrows down the items that may contain
+ * a given point.
+ *
+ * The grid covers a fixed area, usually the bounding rectangle of all screens, split into
+ * square cells. Every item is added to all cells that its bounding rectangle intersects.
+ * Looking up a point only returns the items of one cell, so the cost of a lookup depends
+ * on the number of items that overlap that cell rather than on the total number of items.
+ *
+ * The grid is rebuilt from scratch when the items change. The cells keep their memory
+ * between rebuilds.
+ */
+class KWIN_EXPORT HitTestGrid
+{
+public:
+    explicit HitTestGrid(int cellSize = 256);
+
+    /**
+     * Removes all items and makes the grid cover the given @p extent.
+     */
+    void reset(const QRect &extent);
+
+    /**
+     * Returns the area covered by the grid.
+     */
+    QRect extent() const;
+
+    /**
+     * Adds the item with the given @p id and the bounding rectangle @p bounds to the grid.
+     * The parts of @p bounds outside the extent of the grid are ignored.
+     */
+    void insert(int id, const QRect &bounds);
+
+    /**
+     * Returns the ids of the items whose bounding rectangles may contain @p pos, in the
+     * order in which they have been inserted. Returns @c null if @p pos is outside the
+     * extent of the grid, in which case the caller has to check all items.
+     */
+    const QVector<int> *candidates(const QPoint &pos) const;
+
+private:
+    QVector<QVector<int>> m_cells;
+    QRect m_extent;
+    int m_cellSize;
+    int m_columnCount = 0;
+    int m_rowCount = 0;
+};
+
+} // namespace KWin
@@ -14,6 +14,7 @@
 #include "globalshortcuts.h"
 #include "input_event.h"
 #include "input_event_spy.h"
+#include "inputlatencytracer.h"
 #include "keyboard_input.h"
 #include "logind.h"
 #include "main.h"
@@ -52,6 +53,7 @@
 #include <KScreenLocker/KsldApp>
 // Qt
 #include <QKeyEvent>
+#include <QSocketNotifier>
 
 #include <xkbcommon/xkbcommon.h>
 
@@ -1382,7 +1384,13 @@ public:
         case QEvent::MouseMove: {
             seat->setPointerPos(event->globalPos());
             MouseEvent *e = static_cast<MouseEvent*>(event);
-            if (e->delta() != QSizeF()) {
+            const QVector<RelativeMotion> motions = e->coalescedMotions();
+            if (!motions.isEmpty()) {
+                // Clients that use relative pointer motions get every single motion.
+                for (const RelativeMotion &motion : motions) {
+                    seat->relativePointerMotion(motion.delta, motion.deltaUnaccelerated, motion.timestampMicroseconds);
+                }
+            } else if (e->delta() != QSizeF()) {
                 seat->relativePointerMotion(e->delta(), e->deltaUnaccelerated(), e->timestampMicroseconds());
             }
             break;
@@ -2023,6 +2031,9 @@ InputRedirection::InputRedirection(QObject *parent)
     qRegisterMetaType<KWin::InputRedirection::KeyboardKeyState>();
     qRegisterMetaType<KWin::InputRedirection::PointerButtonState>();
     qRegisterMetaType<KWin::InputRedirection::PointerAxis>();
+    if (qgetenv("KWIN_INPUT_LATENCY_TRACE") == QByteArrayLiteral("1")) {
+        m_latencyTracer = new InputLatencyTracer(this);
+    }
     if (Application::usesLibinput()) {
         if (LogindIntegration::self()->hasSessionControl()) {
             setupLibInput();
@@ -2200,6 +2211,7 @@ void InputRedirection::setupWorkspace()
         m_touch->init();
         m_tablet->init();
     }
+    connect(screens(), &Screens::changed, this, &InputRedirection::invalidateHitTestIndex);
     setupInputFilters();
 }
 
@@ -2295,10 +2307,11 @@ void InputRedirection::setupLibInput()
         waylandServer()->updateKeyState(m_keyboard->xkb()->leds());
         connect(m_keyboard, &KeyboardInputRedirection::ledsChanged, waylandServer(), &WaylandServer::updateKeyState);
         connect(m_keyboard, &KeyboardInputRedirection::ledsChanged, conn, &LibInput::Connection::updateLEDs);
-        connect(conn, &LibInput::Connection::eventsRead, this,
+        QSocketNotifier *eventsNotifier = new QSocketNotifier(conn->eventsFileDescriptor(), QSocketNotifier::Read, this);
+        connect(eventsNotifier, &QSocketNotifier::activated, this,
             [this] {
                 m_libInput->processEvents();
-            }, Qt::QueuedConnection
+            }
         );
         conn->setup();
         connect(conn, &LibInput::Connection::pointerButtonChanged, m_pointer, &PointerInputRedirection::processButton);
@@ -2312,15 +2325,12 @@ void InputRedirection::setupLibInput()
         connect(conn, &LibInput::Connection::swipeGestureEnd, m_pointer, &PointerInputRedirection::processSwipeGestureEnd);
         connect(conn, &LibInput::Connection::swipeGestureCancelled, m_pointer, &PointerInputRedirection::processSwipeGestureCancelled);
         connect(conn, &LibInput::Connection::keyChanged, m_keyboard, &KeyboardInputRedirection::processKey);
-        connect(conn, &LibInput::Connection::pointerMotion, this,
-            [this] (const QSizeF &delta, const QSizeF &deltaNonAccel, uint32_t time, quint64 timeMicroseconds, LibInput::Device *device) {
-                m_pointer->processMotion(m_pointer->pos() + QPointF(delta.width(), delta.height()), delta, deltaNonAccel, time, timeMicroseconds, device);
-            }
-        );
+        connect(conn, &LibInput::Connection::pointerMotion,
+                m_pointer, &PointerInputRedirection::processRelativeMotion);
         connect(conn, &LibInput::Connection::pointerMotionAbsolute, this,
             [this] (QPointF orig, QPointF screen, uint32_t time, LibInput::Device *device) {
                 Q_UNUSED(orig)
-                m_pointer->processMotion(screen, time, device);
+                m_pointer->processAbsoluteMotion(screen, time, device);
             }
         );
         connect(conn, &LibInput::Connection::touchDown, m_touch, &TouchInputRedirection::processDown);
@@ -2554,52 +2564,171 @@ Toplevel *InputRedirection::findToplevel(const QPoint &pos)
         if (effects && static_cast<EffectsHandlerImpl*>(effects)->isMouseInterception()) {
             return nullptr;
         }
-        const QList<Unmanaged *> &unmanaged = Workspace::self()->unmanagedList();
-        foreach (Unmanaged *u, unmanaged) {
-            if (u->hitTest(pos)) {
-                return u;
+        updateHitTestIndex();
+        if (const QVector<int> *candidates = m_unmanagedHitTestGrid.candidates(pos)) {
+            for (int index : *candidates) {
+                Unmanaged *u = m_hitTestUnmanaged[index];
+                if (u->hitTest(pos)) {
+                    return u;
+                }
+            }
+        } else {
+            for (Unmanaged *u : qAsConst(m_hitTestUnmanaged)) {
+                if (u->hitTest(pos)) {
+                    return u;
+                }
             }
         }
     }
     return findManagedToplevel(pos);
 }
 
+static bool acceptsPointerInput(Toplevel *t, bool isScreenLocked)
+{
+    if (t->isDeleted()) {
+        // a deleted window doesn't get mouse events
+        return false;
+    }
+    if (AbstractClient *c = dynamic_cast<AbstractClient*>(t)) {
+        if (!c->isOnCurrentActivity() || !c->isOnCurrentDesktop() || c->isMinimized() || c->isHiddenInternal()) {
+            return false;
+        }
+    }
+    if (!t->readyForPainting()) {
+        return false;
+    }
+    if (isScreenLocked) {
+        if (!t->isLockScreen() && !t->isInputMethod()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 Toplevel *InputRedirection::findManagedToplevel(const QPoint &pos)
 {
     if (!Workspace::self()) {
         return nullptr;
     }
     const bool isScreenLocked = waylandServer() && waylandServer()->isScreenLocked();
-    const QList<Toplevel *> &stacking = Workspace::self()->stackingOrder();
-    if (stacking.isEmpty()) {
+    updateHitTestIndex();
+    if (const QVector<int> *candidates = m_stackingHitTestGrid.candidates(pos)) {
+        // The candidates are ordered from top to bottom.
+        for (int index : *candidates) {
+            Toplevel *t = m_hitTestStackingOrder[index];
+            if (acceptsPointerInput(t, isScreenLocked) && t->hitTest(pos)) {
+                return t;
+            }
+        }
         return nullptr;
     }
-    auto it = stacking.end();
-    do {
-        --it;
-        Toplevel *t = (*it);
+    for (auto it = m_hitTestStackingOrder.crbegin(); it != m_hitTestStackingOrder.crend(); ++it) {
+        Toplevel *t = *it;
+        if (acceptsPointerInput(t, isScreenLocked) && t->hitTest(pos)) {
+            return t;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Returns a rectangle that contains all points at which the toplevel @p t can accept
+ * pointer input, including the resize borders and subsurfaces that stick out.
+ */
+static QRect hitTestBounds(const Toplevel *t)
+{
+    QRect bounds = t->frameGeometry() | t->inputGeometry();
+    if (const KWaylandServer::SurfaceInterface *surface = t->surface()) {
+        bounds |= surface->boundingRect().translated(t->bufferGeometry().topLeft());
+    } else {
+        bounds |= t->bufferGeometry();
+    }
+    return bounds;
+}
+
+void InputRedirection::invalidateHitTestIndex()
+{
+    m_hitTestIndexDirty = true;
+}
+
+void InputRedirection::updateHitTestIndex()
+{
+    const QList<Toplevel *> &stacking = workspace()->stackingOrder();
+    const QList<Unmanaged *> &unmanaged = workspace()->unmanagedList();
+    if (!m_hitTestIndexDirty && m_hitTestStackingOrder.isSharedWith(stacking)
+            && m_hitTestUnmanaged.isSharedWith(unmanaged)) {
+        return;
+    }
+    m_hitTestStackingOrder = stacking;
+    m_hitTestUnmanaged = unmanaged;
+    m_hitTestIndexDirty = false;
+
+    QHash<Toplevel *, HitTestWatch> watches;
+    watches.reserve(m_hitTestStackingOrder.count() + m_hitTestUnmanaged.count());
+    auto watch = [this, &watches](Toplevel *t) {
+        // Deleted windows never receive input and never change, no need to watch them.
         if (t->isDeleted()) {
-            // a deleted window doesn't get mouse events
-            continue;
+            return false;
         }
-        if (AbstractClient *c = dynamic_cast<AbstractClient*>(t)) {
-            if (!c->isOnCurrentActivity() || !c->isOnCurrentDesktop() || c->isMinimized() || c->isHiddenInternal()) {
-                continue;
-            }
+        if (watches.contains(t)) {
+            return true;
         }
-        if (!t->readyForPainting()) {
-            continue;
+        KWaylandServer::SurfaceInterface *surface = t->surface();
+        KDecoration2::Decoration *decoration = nullptr;
+        if (AbstractClient *client = qobject_cast<AbstractClient *>(t)) {
+            decoration = client->decoration();
         }
-        if (isScreenLocked) {
-            if (!t->isLockScreen() && !t->isInputMethod()) {
-                continue;
+        HitTestWatch w = m_hitTestWatches.take(t);
+        if (w.toplevel != t || w.surface != surface || w.decoration != decoration) {
+            for (const QMetaObject::Connection &connection : qAsConst(w.connections)) {
+                disconnect(connection);
+            }
+            w = HitTestWatch{t, surface, decoration, {}};
+            w.connections << connect(t, &Toplevel::frameGeometryChanged, this, &InputRedirection::invalidateHitTestIndex);
+            w.connections << connect(t, &Toplevel::bufferGeometryChanged, this, &InputRedirection::invalidateHitTestIndex);
+            w.connections << connect(t, &Toplevel::geometryShapeChanged, this, &InputRedirection::invalidateHitTestIndex);
+            w.connections << connect(t, &Toplevel::surfaceChanged, this, &InputRedirection::invalidateHitTestIndex);
+            if (surface) {
+                w.connections << connect(surface, &KWaylandServer::SurfaceInterface::sizeChanged,
+                                         this, &InputRedirection::invalidateHitTestIndex);
+                w.connections << connect(surface, &KWaylandServer::SurfaceInterface::subSurfaceTreeChanged,
+                                         this, &InputRedirection::invalidateHitTestIndex);
+            }
+            if (decoration) {
+                // The resize only borders are part of the input geometry.
+                w.connections << connect(decoration, &KDecoration2::Decoration::bordersChanged,
+                                         this, &InputRedirection::invalidateHitTestIndex);
+                w.connections << connect(decoration, &KDecoration2::Decoration::resizeOnlyBordersChanged,
+                                         this, &InputRedirection::invalidateHitTestIndex);
             }
         }
-        if (t->hitTest(pos)) {
-            return t;
+        watches.insert(t, w);
+        return true;
+    };
+
+    const QRect extent = screens()->geometry();
+    m_stackingHitTestGrid.reset(extent);
+    for (int i = m_hitTestStackingOrder.count() - 1; i >= 0; --i) {
+        Toplevel *t = m_hitTestStackingOrder[i];
+        if (watch(t)) {
+            m_stackingHitTestGrid.insert(i, hitTestBounds(t));
         }
-    } while (it != stacking.begin());
-    return nullptr;
+    }
+    m_unmanagedHitTestGrid.reset(extent);
+    for (int i = 0; i < m_hitTestUnmanaged.count(); ++i) {
+        Unmanaged *u = m_hitTestUnmanaged[i];
+        if (watch(u)) {
+            m_unmanagedHitTestGrid.insert(i, hitTestBounds(u));
+        }
+    }
+
+    // Stop watching the windows that are gone.
+    for (const HitTestWatch &w : qAsConst(m_hitTestWatches)) {
+        for (const QMetaObject::Connection &connection : w.connections) {
+            disconnect(connection);
+        }
+    }
+    m_hitTestWatches = std::move(watches);
 }
 
 Qt::KeyboardModifiers InputRedirection::keyboardModifiers() const
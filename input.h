@@ -11,6 +11,7 @@
 #ifndef KWIN_INPUT_H
 #define KWIN_INPUT_H
 #include <kwinglobals.h>
+#include "hittestgrid.h"
 #include <QAction>
 #include <QObject>
 #include <QPoint>
@@ -29,9 +30,20 @@ class QMouseEvent;
 class QKeyEvent;
 class QWheelEvent;
 
+namespace KDecoration2
+{
+class Decoration;
+}
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+}
+
 namespace KWin
 {
 class GlobalShortcutsManager;
+class InputLatencyTracer;
 class Toplevel;
 class InputEventFilter;
 class InputEventSpy;
@@ -39,6 +51,7 @@ class KeyboardInputRedirection;
 class PointerInputRedirection;
 class TabletInputRedirection;
 class TouchInputRedirection;
+class Unmanaged;
 class WindowSelectorFilter;
 class SwitchEvent;
 class TabletEvent;
@@ -255,6 +268,13 @@ public:
     TouchInputRedirection *touch() const {
         return m_touch;
     }
+    /**
+     * Returns the input to photon latency tracer, or @c null if tracing is disabled. It
+     * can be enabled with KWIN_INPUT_LATENCY_TRACE=1.
+     */
+    InputLatencyTracer *latencyTracer() const {
+        return m_latencyTracer;
+    }
 
     bool hasAlphaNumericKeyboard();
     bool hasTabletModeSwitch();
@@ -307,8 +327,10 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void handleInputConfigChanged(const KConfigGroup &group);
+    void invalidateHitTestIndex();
 
 private:
+    void updateHitTestIndex();
     void setupLibInput();
     void setupTouchpadShortcuts();
     void setupLibInputWithScreens();
@@ -321,6 +343,7 @@ private:
     TabletInputRedirection *m_tablet;
     TouchInputRedirection *m_touch;
     TabletInputFilter *m_tabletSupport = nullptr;
+    InputLatencyTracer *m_latencyTracer = nullptr;
 
     GlobalShortcutsManager *m_shortcuts;
 
@@ -332,6 +355,24 @@ private:
     QVector<InputEventSpy*> m_spies;
     KConfigWatcher::Ptr m_inputConfigWatcher;
 
+    // The lists are implicitly shared with the Workspace, so changes to the stacking
+    // order or the unmanaged windows can be detected with a pointer comparison.
+    QList<Toplevel *> m_hitTestStackingOrder;
+    QList<Unmanaged *> m_hitTestUnmanaged;
+    // The connections that invalidate the hit test index when the toplevel, its surface or
+    // its decoration change their input geometry.
+    struct HitTestWatch
+    {
+        QPointer<Toplevel> toplevel;
+        QPointer<KWaylandServer::SurfaceInterface> surface;
+        QPointer<KDecoration2::Decoration> decoration;
+        QVector<QMetaObject::Connection> connections;
+    };
+    QHash<Toplevel *, HitTestWatch> m_hitTestWatches;
+    HitTestGrid m_stackingHitTestGrid;
+    HitTestGrid m_unmanagedHitTestGrid;
+    bool m_hitTestIndexDirty = true;
+
     KWIN_SINGLETON(InputRedirection)
     friend InputRedirection *input();
     friend class DecorationEventFilter;
@@ -12,6 +12,7 @@
 #include "input.h"
 
 #include <QInputEvent>
+#include <QVector>
 
 namespace KWin
 {
@@ -21,6 +22,16 @@ namespace LibInput
 class Device;
 }
 
+/**
+ * A relative pointer motion that has been merged into a MouseEvent.
+ */
+struct RelativeMotion
+{
+    QSizeF delta;
+    QSizeF deltaUnaccelerated;
+    quint64 timestampMicroseconds;
+};
+
 class MouseEvent : public QMouseEvent
 {
 public:
@@ -61,6 +72,18 @@ public:
         m_nativeButton = button;
     }
 
+    /**
+     * Returns the relative motions that have been merged into this event, oldest first.
+     * The list is empty unless pointer motion coalescing is enabled.
+     */
+    QVector<RelativeMotion> coalescedMotions() const {
+        return m_coalescedMotions;
+    }
+
+    void setCoalescedMotions(const QVector<RelativeMotion> &motions) {
+        m_coalescedMotions = motions;
+    }
+
 private:
     QSizeF m_delta;
     QSizeF m_deltaUnccelerated;
@@ -68,6 +91,7 @@ private:
     LibInput::Device *m_device;
     Qt::KeyboardModifiers m_modifiersRelevantForShortcuts = Qt::KeyboardModifiers();
     quint32 m_nativeButton = 0;
+    QVector<RelativeMotion> m_coalescedMotions;
 };
 
 // TODO: Don't derive from QWheelEvent, this event is quite domain specific.
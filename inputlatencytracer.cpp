@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "inputlatencytracer.h"
+#include "renderloop.h"
+#include "utils.h"
+
+namespace KWin
+{
+
+InputLatencyTracer::InputLatencyTracer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void InputLatencyTracer::inputProcessed(std::chrono::microseconds timestamp)
+{
+    if (!m_pending.count || timestamp < m_pending.oldest) {
+        m_pending.oldest = timestamp;
+    }
+    m_pending.sum += timestamp;
+    m_pending.count++;
+}
+
+void InputLatencyTracer::frameStarted(RenderLoop *renderLoop)
+{
+    if (!m_pending.count) {
+        return;
+    }
+
+    auto it = m_frames.find(renderLoop);
+    if (it == m_frames.end()) {
+        m_frames.insert(renderLoop, m_pending);
+        connect(renderLoop, &RenderLoop::framePresented,
+                this, &InputLatencyTracer::handleFramePresented, Qt::UniqueConnection);
+        connect(renderLoop, &QObject::destroyed,
+                this, &InputLatencyTracer::handleRenderLoopDestroyed, Qt::UniqueConnection);
+    } else {
+        // The previous frame hasn't been presented yet, it will reflect the events as well.
+        it->count += m_pending.count;
+        it->sum += m_pending.sum;
+        it->oldest = std::min(it->oldest, m_pending.oldest);
+    }
+    m_pending = Batch();
+}
+
+InputLatencyTracer::Statistics InputLatencyTracer::statistics() const
+{
+    return m_statistics;
+}
+
+void InputLatencyTracer::handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp)
+{
+    const Batch batch = m_frames.take(renderLoop);
+    if (!batch.count) {
+        return;
+    }
+
+    const auto presentationTimestamp = std::chrono::duration_cast<std::chrono::microseconds>(timestamp);
+    m_statistics.count += batch.count;
+    m_statistics.total += presentationTimestamp * qint64(batch.count) - batch.sum;
+    m_statistics.maximum = std::max(m_statistics.maximum, presentationTimestamp - batch.oldest);
+
+    if (m_lastReport == std::chrono::microseconds::zero()) {
+        m_lastReport = presentationTimestamp;
+    } else if (presentationTimestamp - m_lastReport >= std::chrono::seconds(1)) {
+        qCInfo(KWIN_CORE, "Input to photon latency over %llu events: average %lld us, maximum %lld us",
+               m_statistics.count,
+               static_cast<long long>(m_statistics.total.count() / qint64(m_statistics.count)),
+               static_cast<long long>(m_statistics.maximum.count()));
+        m_statistics = Statistics();
+        m_lastReport = presentationTimestamp;
+    }
+}
+
+void InputLatencyTracer::handleRenderLoopDestroyed(QObject *object)
+{
+    m_frames.remove(static_cast<RenderLoop *>(object));
+}
+
+} // namespace KWin
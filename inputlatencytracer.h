@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwinglobals.h"
+
+#include <QHash>
+#include <QObject>
+
+#include <chrono>
+
+namespace KWin
+{
+
+class RenderLoop;
+
+/**
+ * The InputLatencyTracer class measures the time between the moment when the kernel has
+ * generated an input event and the moment when the first frame that reflects the input
+ * event has been presented on the screen.
+ *
+ * Processed input events are attached to the next frame that is started on any render
+ * loop. The latency is computed once that render loop reports the presentation of a frame.
+ * The statistics are logged once per second.
+ */
+class KWIN_EXPORT InputLatencyTracer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        quint64 count = 0;
+        std::chrono::microseconds total = std::chrono::microseconds::zero();
+        std::chrono::microseconds maximum = std::chrono::microseconds::zero();
+    };
+
+    explicit InputLatencyTracer(QObject *parent = nullptr);
+
+    /**
+     * Notifies the tracer that an input event generated at @p timestamp has been processed.
+     * The timestamp must be sourced from the monotonic clock.
+     */
+    void inputProcessed(std::chrono::microseconds timestamp);
+
+    /**
+     * Notifies the tracer that the given @p renderLoop is about to render a frame.
+     */
+    void frameStarted(RenderLoop *renderLoop);
+
+    /**
+     * Returns the statistics that have been collected since the last report.
+     */
+    Statistics statistics() const;
+
+private:
+    struct Batch
+    {
+        quint64 count = 0;
+        std::chrono::microseconds sum = std::chrono::microseconds::zero();
+        std::chrono::microseconds oldest = std::chrono::microseconds::zero();
+    };
+
+    void handleFramePresented(RenderLoop *renderLoop, std::chrono::nanoseconds timestamp);
+    void handleRenderLoopDestroyed(QObject *object);
+
+    Batch m_pending;
+    QHash<RenderLoop *, Batch> m_frames;
+    Statistics m_statistics;
+    std::chrono::microseconds m_lastReport = std::chrono::microseconds::zero();
+};
+
+} // namespace KWin
@@ -13,6 +13,7 @@
 #include "keyboard_repeat.h"
 #include "abstract_client.h"
 #include "modifier_only_shortcuts.h"
+#include "pointer_input.h"
 #include "utils.h"
 #include "screenlockerwatcher.h"
 #include "toplevel.h"
@@ -180,6 +181,9 @@ void KeyboardInputRedirection::update()
 
 void KeyboardInputRedirection::processKey(uint32_t key, InputRedirection::KeyboardKeyState state, uint32_t time, LibInput::Device *device)
 {
+    // The pointer motion must see the modifiers that were active when it happened.
+    m_input->pointer()->flushCoalescedMotion();
+
     QEvent::Type type;
     bool autoRepeat = false;
     switch (state) {
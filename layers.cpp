@@ -731,13 +731,9 @@ void Workspace::updateXStackingOrder()
         for (unsigned int i = 0;
                 i < count;
                 ++i) {
-            for (auto it = m_unmanaged.constBegin(); it != m_unmanaged.constEnd(); ++it) {
-                Unmanaged *u = *it;
-                if (u->window() == windows[i]) {
-                    x_stacking.append(u);
-                    foundUnmanagedCount--;
-                    break;
-                }
+            if (Unmanaged *u = findUnmanaged(windows[i])) {
+                x_stacking.append(u);
+                foundUnmanagedCount--;
             }
             if (foundUnmanagedCount == 0) {
                 break;
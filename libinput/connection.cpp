@@ -18,6 +18,7 @@
 #include "../platform.h"
 #include "../workspace.h"
 #include "../abstract_client.h"
+#include "../schedulingpolicy.h"
 #include "../screens.h"
 #endif
 
@@ -35,6 +36,11 @@
 
 #include <libinput.h>
 #include <cmath>
+#include <errno.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
 
 namespace KWin
 {
@@ -101,6 +107,59 @@ static quint32 toLibinputLEDS(Xkb::LEDs leds)
     return libinputLeds;
 }
 
+static const quint32 s_eventQueueCapacity = 1024;
+
+static quint64 monotonicTimeMicroseconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * Returns the time when the kernel has generated the @p event, or 0 if the event has no
+ * timestamp. libinput uses CLOCK_MONOTONIC for the timestamps.
+ */
+static quint64 eventTimestamp(const Event *event)
+{
+    libinput_event *nativeEvent = *event;
+    switch (event->type()) {
+    case LIBINPUT_EVENT_KEYBOARD_KEY:
+        return libinput_event_keyboard_get_time_usec(libinput_event_get_keyboard_event(nativeEvent));
+    case LIBINPUT_EVENT_POINTER_MOTION:
+    case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+    case LIBINPUT_EVENT_POINTER_BUTTON:
+    case LIBINPUT_EVENT_POINTER_AXIS:
+        return libinput_event_pointer_get_time_usec(libinput_event_get_pointer_event(nativeEvent));
+    case LIBINPUT_EVENT_TOUCH_DOWN:
+    case LIBINPUT_EVENT_TOUCH_UP:
+    case LIBINPUT_EVENT_TOUCH_MOTION:
+    case LIBINPUT_EVENT_TOUCH_CANCEL:
+    case LIBINPUT_EVENT_TOUCH_FRAME:
+        return libinput_event_touch_get_time_usec(libinput_event_get_touch_event(nativeEvent));
+    case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+    case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+    case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+    case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+    case LIBINPUT_EVENT_GESTURE_PINCH_END:
+        return libinput_event_gesture_get_time_usec(libinput_event_get_gesture_event(nativeEvent));
+    case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+    case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+    case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+    case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+        return libinput_event_tablet_tool_get_time_usec(libinput_event_get_tablet_tool_event(nativeEvent));
+    case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+    case LIBINPUT_EVENT_TABLET_PAD_RING:
+    case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+        return libinput_event_tablet_pad_get_time_usec(libinput_event_get_tablet_pad_event(nativeEvent));
+    case LIBINPUT_EVENT_SWITCH_TOGGLE:
+        return libinput_event_switch_get_time_usec(libinput_event_get_switch_event(nativeEvent));
+    default:
+        return 0;
+    }
+}
+
 Connection::Connection(QObject *parent)
     : Connection(nullptr, parent)
 {
@@ -142,7 +201,18 @@ Connection *Connection::create(QObject *parent)
     }
     Connection::createThread();
     s_self = new Connection(s_context);
+    if (s_self->m_eventsFd == -1) {
+        qCWarning(KWIN_LIBINPUT) << "Failed to create an eventfd:" << strerror(errno);
+        delete s_self;
+        return nullptr;
+    }
     s_self->moveToThread(s_thread);
+#ifndef KWIN_BUILD_TESTING
+    // The thread inherited the priority of the main thread, give it the one of its own role.
+    QMetaObject::invokeMethod(s_self, []() {
+        SchedulingPolicy::self()->applyToCurrentThread(SchedulingPolicy::Role::Input);
+    }, Qt::QueuedConnection);
+#endif
     QObject::connect(s_thread, &QThread::finished, s_self, &QObject::deleteLater);
     QObject::connect(s_thread, &QThread::finished, s_thread, &QObject::deleteLater);
     QObject::connect(parent, &QObject::destroyed, s_thread, &QThread::quit);
@@ -159,6 +229,10 @@ Connection::Connection(Context *input, QObject *parent)
     , m_input(input)
     , m_notifier(nullptr)
     , m_mutex(QMutex::Recursive)
+    , m_eventQueue(s_eventQueueCapacity)
+    , m_consumedEvents(s_eventQueueCapacity)
+    , m_eventsFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    , m_eventAgeTraceEnabled(qgetenv("KWIN_LIBINPUT_LATENCY_TRACE") == QByteArrayLiteral("1"))
     , m_leds()
 {
     Q_ASSERT(m_input);
@@ -169,6 +243,16 @@ Connection::Connection(Context *input, QObject *parent)
 
 Connection::~Connection()
 {
+    Event *event;
+    while (m_eventQueue.pop(&event)) {
+        delete event;
+    }
+    while (m_consumedEvents.pop(&event)) {
+        delete event;
+    }
+    if (m_eventsFd != -1) {
+        close(m_eventsFd);
+    }
     delete s_adaptor;
     s_adaptor = nullptr;
     s_self = nullptr;
@@ -225,20 +309,81 @@ void Connection::deactivate()
     handleEvent();
 }
 
+int Connection::eventsFileDescriptor() const
+{
+    return m_eventsFd;
+}
+
 void Connection::handleEvent()
 {
     QMutexLocker locker(&m_mutex);
-    const bool wasEmpty = m_eventQueue.isEmpty();
+
+    // libinput is not thread-safe, so the events are destroyed on the thread that reads them.
+    Event *consumed;
+    while (m_consumedEvents.pop(&consumed)) {
+        delete consumed;
+    }
+
+    bool queued = false;
     do {
+        if (m_eventQueue.count() == m_eventQueue.capacity()) {
+            // The main thread is lagging behind, leave the remaining events in libinput
+            // until processEvents() asks for more. Check again after raising the flag in
+            // case processEvents() has drained the queue in the meantime.
+            m_eventQueueStalled = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_eventQueue.count() == m_eventQueue.capacity()) {
+                // The libinput fd stays readable, don't spin on it until there is room.
+                if (m_notifier) {
+                    m_notifier->setEnabled(false);
+                }
+                break;
+            }
+            m_eventQueueStalled = false;
+        }
         m_input->dispatch();
         Event *event = m_input->event();
         if (!event) {
             break;
         }
-        m_eventQueue << event;
+        m_eventQueue.push(event);
+        queued = true;
     } while (true);
-    if (wasEmpty && !m_eventQueue.isEmpty()) {
-        emit eventsRead();
+
+    if (queued) {
+        const quint64 value = 1;
+        if (write(m_eventsFd, &value, sizeof(value)) != sizeof(value) && errno != EAGAIN) {
+            qCWarning(KWIN_LIBINPUT) << "Failed to wake up the main thread:" << strerror(errno);
+        }
+    }
+}
+
+void Connection::releaseEvent(Event *event)
+{
+    if (!m_consumedEvents.push(event)) {
+        QMutexLocker locker(&m_mutex);
+        delete event;
+    }
+}
+
+void Connection::recordEventAge(const Event *event)
+{
+    const quint64 timestamp = eventTimestamp(event);
+    if (!timestamp) {
+        return;
+    }
+    const quint64 now = monotonicTimeMicroseconds();
+    const quint64 age = now > timestamp ? now - timestamp : 0;
+
+    m_eventAge.count++;
+    m_eventAge.total += age;
+    m_eventAge.maximum = std::max(m_eventAge.maximum, age);
+
+    if (now - m_eventAge.reportTimestamp >= 1000000) {
+        qCInfo(KWIN_LIBINPUT, "Input event age over %llu events: average %llu us, maximum %llu us",
+               m_eventAge.count, m_eventAge.total / m_eventAge.count, m_eventAge.maximum);
+        m_eventAge = EventAgeStatistics();
+        m_eventAge.reportTimestamp = now;
     }
 }
 
@@ -331,11 +476,19 @@ KWin::TabletToolId createTabletId(libinput_tablet_tool *tool, void *userData)
 
 void Connection::processEvents()
 {
-    QMutexLocker locker(&m_mutex);
-    while (!m_eventQueue.isEmpty()) {
-        QScopedPointer<Event> event(m_eventQueue.takeFirst());
+    quint64 wakeUps;
+    if (read(m_eventsFd, &wakeUps, sizeof(wakeUps)) != sizeof(wakeUps) && errno != EAGAIN) {
+        qCWarning(KWIN_LIBINPUT) << "Failed to read the eventfd:" << strerror(errno);
+    }
+
+    Event *event;
+    while (m_eventQueue.pop(&event)) {
+        if (m_eventAgeTraceEnabled) {
+            recordEventAge(event);
+        }
         switch (event->type()) {
             case LIBINPUT_EVENT_DEVICE_ADDED: {
+                QMutexLocker locker(&m_mutex);
                 auto device = new Device(event->nativeDevice());
                 device->moveToThread(s_thread);
                 m_devices << device;
@@ -379,6 +532,7 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_DEVICE_REMOVED: {
+                QMutexLocker locker(&m_mutex);
                 auto it = std::find_if(m_devices.begin(), m_devices.end(), [&event] (Device *d) { return event->device() == d; } );
                 if (it == m_devices.end()) {
                     // we don't know this device
@@ -422,12 +576,12 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_KEYBOARD_KEY: {
-                KeyEvent *ke = static_cast<KeyEvent*>(event.data());
+                KeyEvent *ke = static_cast<KeyEvent*>(event);
                 emit keyChanged(ke->key(), ke->state(), ke->time(), ke->device());
                 break;
             }
             case LIBINPUT_EVENT_POINTER_AXIS: {
-                PointerEvent *pe = static_cast<PointerEvent*>(event.data());
+                PointerEvent *pe = static_cast<PointerEvent*>(event);
                 const auto axes = pe->axis();
                 for (const InputRedirection::PointerAxis &axis : axes) {
                     emit pointerAxisChanged(axis, pe->axisValue(axis), pe->discreteAxisValue(axis),
@@ -436,40 +590,43 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_POINTER_BUTTON: {
-                PointerEvent *pe = static_cast<PointerEvent*>(event.data());
+                PointerEvent *pe = static_cast<PointerEvent*>(event);
                 emit pointerButtonChanged(pe->button(), pe->buttonState(), pe->time(), pe->device());
                 break;
             }
             case LIBINPUT_EVENT_POINTER_MOTION: {
-                PointerEvent *pe = static_cast<PointerEvent*>(event.data());
+                PointerEvent *pe = static_cast<PointerEvent*>(event);
                 auto delta = pe->delta();
                 auto deltaNonAccel = pe->deltaUnaccelerated();
                 quint32 latestTime = pe->time();
                 quint64 latestTimeUsec = pe->timeMicroseconds();
-                auto it = m_eventQueue.begin();
-                while (it != m_eventQueue.end()) {
-                    if ((*it)->type() == LIBINPUT_EVENT_POINTER_MOTION) {
-                        QScopedPointer<PointerEvent> p(static_cast<PointerEvent*>(*it));
-                        delta += p->delta();
-                        deltaNonAccel += p->deltaUnaccelerated();
-                        latestTime = p->time();
-                        latestTimeUsec = p->timeMicroseconds();
-                        it = m_eventQueue.erase(it);
-                    } else {
+                while (Event **next = m_eventQueue.peek()) {
+                    if ((*next)->type() != LIBINPUT_EVENT_POINTER_MOTION) {
                         break;
                     }
+                    Event *motion;
+                    m_eventQueue.pop(&motion);
+                    PointerEvent *p = static_cast<PointerEvent*>(motion);
+                    if (m_eventAgeTraceEnabled) {
+                        recordEventAge(p);
+                    }
+                    delta += p->delta();
+                    deltaNonAccel += p->deltaUnaccelerated();
+                    latestTime = p->time();
+                    latestTimeUsec = p->timeMicroseconds();
+                    releaseEvent(p);
                 }
                 emit pointerMotion(delta, deltaNonAccel, latestTime, latestTimeUsec, pe->device());
                 break;
             }
             case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE: {
-                PointerEvent *pe = static_cast<PointerEvent*>(event.data());
+                PointerEvent *pe = static_cast<PointerEvent*>(event);
                 emit pointerMotionAbsolute(pe->absolutePos(), pe->absolutePos(m_size), pe->time(), pe->device());
                 break;
             }
             case LIBINPUT_EVENT_TOUCH_DOWN: {
 #ifndef KWIN_BUILD_TESTING
-                TouchEvent *te = static_cast<TouchEvent*>(event.data());
+                TouchEvent *te = static_cast<TouchEvent*>(event);
                 const auto *output = static_cast<AbstractWaylandOutput*>(
                             kwinApp()->platform()->enabledOutputs()[te->device()->screenId()]);
                 const QPointF globalPos =
@@ -480,13 +637,13 @@ void Connection::processEvents()
 #endif
             }
             case LIBINPUT_EVENT_TOUCH_UP: {
-                TouchEvent *te = static_cast<TouchEvent*>(event.data());
+                TouchEvent *te = static_cast<TouchEvent*>(event);
                 emit touchUp(te->id(), te->time(), te->device());
                 break;
             }
             case LIBINPUT_EVENT_TOUCH_MOTION: {
 #ifndef KWIN_BUILD_TESTING
-                TouchEvent *te = static_cast<TouchEvent*>(event.data());
+                TouchEvent *te = static_cast<TouchEvent*>(event);
                 const auto *output = static_cast<AbstractWaylandOutput*>(
                             kwinApp()->platform()->enabledOutputs()[te->device()->screenId()]);
                 const QPointF globalPos =
@@ -505,17 +662,17 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN: {
-                PinchGestureEvent *pe = static_cast<PinchGestureEvent*>(event.data());
+                PinchGestureEvent *pe = static_cast<PinchGestureEvent*>(event);
                 emit pinchGestureBegin(pe->fingerCount(), pe->time(), pe->device());
                 break;
             }
             case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE: {
-                PinchGestureEvent *pe = static_cast<PinchGestureEvent*>(event.data());
+                PinchGestureEvent *pe = static_cast<PinchGestureEvent*>(event);
                 emit pinchGestureUpdate(pe->scale(), pe->angleDelta(), pe->delta(), pe->time(), pe->device());
                 break;
             }
             case LIBINPUT_EVENT_GESTURE_PINCH_END: {
-                PinchGestureEvent *pe = static_cast<PinchGestureEvent*>(event.data());
+                PinchGestureEvent *pe = static_cast<PinchGestureEvent*>(event);
                 if (pe->isCancelled()) {
                     emit pinchGestureCancelled(pe->time(), pe->device());
                 } else {
@@ -524,17 +681,17 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN: {
-                SwipeGestureEvent *se = static_cast<SwipeGestureEvent*>(event.data());
+                SwipeGestureEvent *se = static_cast<SwipeGestureEvent*>(event);
                 emit swipeGestureBegin(se->fingerCount(), se->time(), se->device());
                 break;
             }
             case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE: {
-                SwipeGestureEvent *se = static_cast<SwipeGestureEvent*>(event.data());
+                SwipeGestureEvent *se = static_cast<SwipeGestureEvent*>(event);
                 emit swipeGestureUpdate(se->delta(), se->time(), se->device());
                 break;
             }
             case LIBINPUT_EVENT_GESTURE_SWIPE_END: {
-                SwipeGestureEvent *se = static_cast<SwipeGestureEvent*>(event.data());
+                SwipeGestureEvent *se = static_cast<SwipeGestureEvent*>(event);
                 if (se->isCancelled()) {
                     emit swipeGestureCancelled(se->time(), se->device());
                 } else {
@@ -543,7 +700,7 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_SWITCH_TOGGLE: {
-                SwitchEvent *se = static_cast<SwitchEvent*>(event.data());
+                SwitchEvent *se = static_cast<SwitchEvent*>(event);
                 switch (se->state()) {
                 case SwitchEvent::State::Off:
                     emit switchToggledOff(se->time(), se->timeMicroseconds(), se->device());
@@ -559,7 +716,7 @@ void Connection::processEvents()
             case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
             case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
             case LIBINPUT_EVENT_TABLET_TOOL_TIP: {
-                auto *tte = static_cast<TabletToolEvent *>(event.data());
+                auto *tte = static_cast<TabletToolEvent *>(event);
 
                 KWin::InputRedirection::TabletEventType tabletEventType;
                 switch (event->type()) {
@@ -592,21 +749,21 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_TABLET_TOOL_BUTTON: {
-                auto *tabletEvent = static_cast<TabletToolButtonEvent *>(event.data());
+                auto *tabletEvent = static_cast<TabletToolButtonEvent *>(event);
                 emit tabletToolButtonEvent(tabletEvent->buttonId(),
                                            tabletEvent->isButtonPressed(),
                                            createTabletId(tabletEvent->tool(), event->device()->groupUserData()));
                 break;
             }
             case LIBINPUT_EVENT_TABLET_PAD_BUTTON: {
-                auto *tabletEvent = static_cast<TabletPadButtonEvent *>(event.data());
+                auto *tabletEvent = static_cast<TabletPadButtonEvent *>(event);
                 emit tabletPadButtonEvent(tabletEvent->buttonId(),
                                           tabletEvent->isButtonPressed(),
                                           { event->device()->groupUserData() });
                 break;
             }
             case LIBINPUT_EVENT_TABLET_PAD_RING: {
-                auto *tabletEvent = static_cast<TabletPadRingEvent *>(event.data());
+                auto *tabletEvent = static_cast<TabletPadRingEvent *>(event);
                 tabletEvent->position();
                 emit tabletPadRingEvent(tabletEvent->number(),
                                         tabletEvent->position(),
@@ -615,7 +772,7 @@ void Connection::processEvents()
                 break;
             }
             case LIBINPUT_EVENT_TABLET_PAD_STRIP: {
-                auto *tabletEvent = static_cast<TabletPadStripEvent *>(event.data());
+                auto *tabletEvent = static_cast<TabletPadStripEvent *>(event);
                 emit tabletPadStripEvent(tabletEvent->number(),
                                          tabletEvent->position(),
                                          tabletEvent->source() == LIBINPUT_TABLET_PAD_STRIP_SOURCE_FINGER,
@@ -626,7 +783,22 @@ void Connection::processEvents()
                 // nothing
                 break;
         }
+        releaseEvent(event);
+    }
+
+    // Pairs with the fence in handleEvent(), so a stall can't go unnoticed while the
+    // queue is being drained.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_eventQueueStalled.exchange(false)) {
+        // Runs on the libinput thread, which the socket notifier belongs to.
+        QMetaObject::invokeMethod(this, [this]() {
+            if (m_notifier) {
+                m_notifier->setEnabled(true);
+            }
+            handleEvent();
+        }, Qt::QueuedConnection);
     }
+
     if (wasSuspended) {
         if (m_keyboardBeforeSuspend && !m_keyboard) {
             emit hasKeyboardChanged(false);
@@ -11,6 +11,7 @@
 
 #include "../input.h"
 #include "../keyboard_input.h"
+#include "spscqueue.h"
 #include <kwinglobals.h>
 
 #include <QObject>
@@ -20,6 +21,8 @@
 #include <QVector>
 #include <QStringList>
 
+#include <atomic>
+
 class QSocketNotifier;
 class QThread;
 
@@ -72,6 +75,15 @@ public:
 
     void deactivate();
 
+    /**
+     * Returns a file descriptor that becomes readable when events have been read from
+     * libinput. The main thread is supposed to call processEvents() then.
+     */
+    int eventsFileDescriptor() const;
+    /**
+     * Dispatches the events that have been read by the libinput thread. Must be called
+     * on the main thread.
+     */
     void processEvents();
 
     void toggleTouchpads();
@@ -129,8 +141,6 @@ Q_SIGNALS:
     void tabletPadStripEvent(int number, int position, bool isFinger, const TabletPadId &tabletPadId);
     void tabletPadRingEvent(int number, int position, bool isFinger, const TabletPadId &tabletPadId);
 
-    void eventsRead();
-
 private Q_SLOTS:
     void doSetup();
     void slotKGlobalSettingsNotifyChange(int type, int arg);
@@ -138,6 +148,8 @@ private Q_SLOTS:
 private:
     Connection(Context *input, QObject *parent = nullptr);
     void handleEvent();
+    void releaseEvent(Event *event);
+    void recordEventAge(const Event *event);
     void applyDeviceConfig(Device *device);
     void applyScreenToDevice(Device *device);
     Context *m_input;
@@ -154,7 +166,20 @@ private:
     bool m_touchBeforeSuspend = false;
     bool m_tabletModeSwitchBeforeSuspend = false;
     QMutex m_mutex;
-    QVector<Event*> m_eventQueue;
+    // Events read by the libinput thread, waiting to be dispatched on the main thread.
+    SpscQueue<Event *> m_eventQueue;
+    // Dispatched events, waiting to be destroyed on the libinput thread.
+    SpscQueue<Event *> m_consumedEvents;
+    std::atomic<bool> m_eventQueueStalled{false};
+    int m_eventsFd = -1;
+    struct EventAgeStatistics {
+        quint64 count = 0;
+        quint64 total = 0;
+        quint64 maximum = 0;
+        quint64 reportTimestamp = 0;
+    };
+    EventAgeStatistics m_eventAge;
+    bool m_eventAgeTraceEnabled = false;
     bool wasSuspended = false;
     QVector<Device*> m_devices;
     KSharedConfigPtr m_config;
@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <vector>
+
+namespace KWin
+{
+namespace LibInput
+{
+
+/**
+ * The SpscQueue class is a bounded lock-free queue with exactly one producer thread
+ * and exactly one consumer thread.
+ *
+ * The storage is allocated once, pushing and popping items never allocates memory or
+ * takes a lock. The capacity is rounded up to the next power of two.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(quint32 capacity)
+        : m_slots(roundUpToPowerOfTwo(capacity))
+        , m_mask(m_slots.size() - 1)
+    {
+    }
+
+    quint32 capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    /**
+     * Returns the number of items in the queue. The value is only a snapshot if it's
+     * called while the other thread is modifying the queue.
+     */
+    quint32 count() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const
+    {
+        return count() == 0;
+    }
+
+    /**
+     * Appends the @p item to the queue. Returns @c false if the queue is full. This
+     * function may only be called by the producer.
+     */
+    bool push(const T &item)
+    {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == capacity()) {
+            return false;
+        }
+        m_slots[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Returns the item at the front of the queue without removing it, or @c null if the
+     * queue is empty. This function may only be called by the consumer.
+     */
+    T *peek()
+    {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_slots[head & m_mask];
+    }
+
+    /**
+     * Removes the front item from the queue and stores it in @p item. Returns @c false
+     * if the queue is empty. This function may only be called by the consumer.
+     */
+    bool pop(T *item)
+    {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *item = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static quint32 roundUpToPowerOfTwo(quint32 value)
+    {
+        quint32 result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<T> m_slots;
+    const quint32 m_mask;
+    // The indices are written by different threads, keep them in different cache lines.
+    alignas(64) std::atomic<quint32> m_head{0};
+    alignas(64) std::atomic<quint32> m_tail{0};
+};
+
+} // namespace LibInput
+} // namespace KWin
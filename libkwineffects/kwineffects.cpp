@@ -612,6 +612,11 @@ bool Effect::isActive() const
     return true;
 }
 
+bool Effect::blocksDirectScanout() const
+{
+    return true;
+}
+
 QString Effect::debug(const QString &) const
 {
     return QString();
@@ -174,7 +174,7 @@ X-KDE-Library=kwin4_effect_cooleffect
 
 #define KWIN_EFFECT_API_MAKE_VERSION( major, minor ) (( major ) << 8 | ( minor ))
 #define KWIN_EFFECT_API_VERSION_MAJOR 0
-#define KWIN_EFFECT_API_VERSION_MINOR 232
+#define KWIN_EFFECT_API_VERSION_MINOR 233
 #define KWIN_EFFECT_API_VERSION KWIN_EFFECT_API_MAKE_VERSION( \
         KWIN_EFFECT_API_VERSION_MAJOR, KWIN_EFFECT_API_VERSION_MINOR )
 
@@ -538,6 +538,19 @@ public:
      */
     virtual bool isActive() const;
 
+    /**
+     * Reimplement this method to indicate whether the effect prevents presenting fullscreen
+     * windows without compositing, i.e. by scanning out their buffers directly. The method
+     * is only consulted while the effect is active.
+     *
+     * An effect should return @c false only if it never alters what an opaque fullscreen
+     * window looks like, e.g. if it paints only behind translucent windows.
+     *
+     * The default implementation of this method returns @c true.
+     * @since 5.22
+     */
+    virtual bool blocksDirectScanout() const;
+
     /**
      * Reimplement this method to provide online debugging.
      * This could be as trivial as printing specific detail information about the effect state
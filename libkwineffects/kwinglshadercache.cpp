@@ -0,0 +1,200 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kwinglshadercache_p.h"
+#include "kwinglplatform.h"
+#include "logging_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+
+#include <algorithm>
+
+namespace KWin
+{
+
+static const quint32 s_magic = 0x4b575342; // "KWSB"
+static const quint32 s_formatVersion = 1;
+
+// The binaries of other drivers are kept for a while, they are still needed if several drivers
+// are used in turn, e.g. on a hybrid GPU system or in a nested session.
+static const int s_maximumDriverCount = 4;
+static const int s_maximumUnusedDays = 30;
+static const QString s_lastUsedFileName = QStringLiteral(".last-used");
+
+static QDateTime lastUsed(const QDir &directory)
+{
+    const QFileInfo marker(directory.filePath(s_lastUsedFileName));
+    if (marker.exists()) {
+        return marker.lastModified();
+    }
+    return QFileInfo(directory.path()).lastModified();
+}
+
+static void pruneDriverDirectories(const QDir &cacheDir, const QString &currentDriverId)
+{
+    QVector<QPair<QDateTime, QString>> others;
+    const QStringList entries = cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        if (entry != currentDriverId) {
+            others.append(qMakePair(lastUsed(QDir(cacheDir.filePath(entry))), entry));
+        }
+    }
+    std::sort(others.begin(), others.end(), [](const auto &a, const auto &b) {
+        return a.first > b.first;
+    });
+
+    const QDateTime expiry = QDateTime::currentDateTime().addDays(-s_maximumUnusedDays);
+    for (int i = 0; i < others.count(); ++i) {
+        if (i >= s_maximumDriverCount - 1 || others[i].first < expiry) {
+            QDir(cacheDir.filePath(others[i].second)).removeRecursively();
+        }
+    }
+}
+
+ShaderCache *ShaderCache::create()
+{
+    if (qgetenv("KWIN_SHADER_CACHE") == QByteArrayLiteral("0")) {
+        return nullptr;
+    }
+
+    bool supported;
+    if (GLPlatform::instance()->isGLES()) {
+        supported = hasGLVersion(3, 0);
+    } else {
+        supported = hasGLVersion(4, 1) || hasGLExtension(QByteArrayLiteral("GL_ARB_get_program_binary"));
+    }
+    if (!supported) {
+        return nullptr;
+    }
+
+    // Some drivers implement the entry points but don't provide any binary format.
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        qCDebug(LIBKWINGLUTILS) << "The driver provides no program binary formats, not caching shaders";
+        return nullptr;
+    }
+
+    const GLPlatform *platform = GLPlatform::instance();
+    QCryptographicHash driverHash(QCryptographicHash::Sha1);
+    driverHash.addData(platform->glVendorString());
+    driverHash.addData(platform->glRendererString());
+    driverHash.addData(platform->glVersionString());
+    driverHash.addData(platform->glShadingLanguageVersionString());
+    const QString driverId = QString::fromLatin1(driverHash.result().toHex());
+
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/kwin/shaders"));
+    if (!cacheDir.mkpath(driverId)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to create the shader cache in" << cacheDir.path();
+        return nullptr;
+    }
+
+    // Other kwin instances decide by the time of the last use which binaries are stale.
+    QFile marker(QDir(cacheDir.filePath(driverId)).filePath(s_lastUsedFileName));
+    if (marker.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        marker.write(QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toLatin1());
+    }
+    pruneDriverDirectories(cacheDir, driverId);
+
+    return new ShaderCache(cacheDir.filePath(driverId));
+}
+
+ShaderCache::ShaderCache(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+QByteArray ShaderCache::key(ShaderTraits traits, const QByteArray &vertexSource, const QByteArray &fragmentSource) const
+{
+    QCryptographicHash sourceHash(QCryptographicHash::Sha1);
+    sourceHash.addData(vertexSource);
+    sourceHash.addData("\0", 1);
+    sourceHash.addData(fragmentSource);
+    return QByteArray::number(uint(traits), 16) + '-' + sourceHash.result().toHex();
+}
+
+QString ShaderCache::filePath(const QByteArray &key) const
+{
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key) + QStringLiteral(".bin");
+}
+
+bool ShaderCache::load(GLuint program, const QByteArray &key) const
+{
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic;
+    quint32 version;
+    quint32 format;
+    QByteArray binary;
+    stream >> magic >> version >> format >> binary;
+    if (stream.status() != QDataStream::Ok || magic != s_magic || version != s_formatVersion) {
+        qCDebug(LIBKWINGLUTILS) << "Discarding invalid shader binary" << file.fileName();
+        file.remove();
+        return false;
+    }
+
+    glProgramBinary(program, format, binary.constData(), binary.size());
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        // The driver may reject binaries for reasons of its own, compile the shader again.
+        qCDebug(LIBKWINGLUTILS) << "The driver rejected shader binary" << file.fileName();
+        file.remove();
+        return false;
+    }
+    return true;
+}
+
+void ShaderCache::store(GLuint program, const QByteArray &key) const
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    QByteArray binary(length, Qt::Uninitialized);
+    GLsizei written = 0;
+    GLenum format = GL_NONE;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+    binary.resize(written);
+
+    QSaveFile file(filePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to open" << file.fileName() << "for writing:" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_15);
+    stream << s_magic << s_formatVersion << quint32(format) << binary;
+    if (!file.commit()) {
+        qCWarning(LIBKWINGLUTILS) << "Failed to write" << file.fileName() << ":" << file.errorString();
+    }
+}
+
+}
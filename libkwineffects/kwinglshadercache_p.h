@@ -0,0 +1,68 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KWIN_GLSHADERCACHE_P_H
+#define KWIN_GLSHADERCACHE_P_H
+
+#include "kwinglutils.h"
+
+#include <QByteArray>
+#include <QString>
+#include <epoxy/gl.h>
+
+namespace KWin
+{
+
+/**
+ * The ShaderCache keeps the binaries of linked shader programs on disk, so they don't have to
+ * be compiled again when kwin is started the next time.
+ *
+ * The binaries live in a directory of $XDG_CACHE_HOME/kwin/shaders that is specific to the
+ * OpenGL vendor, renderer and version, the cache of a previous driver is removed as soon as
+ * a different driver is used. A binary is looked up by the traits and the source code of the
+ * shader.
+ */
+class ShaderCache
+{
+public:
+    /**
+     * Creates a ShaderCache for the current OpenGL context, or returns @c nullptr if the
+     * driver can't provide program binaries or the cache has been disabled by setting the
+     * environment variable KWIN_SHADER_CACHE to 0.
+     */
+    static ShaderCache *create();
+
+    QString directory() const {
+        return m_directory;
+    }
+
+    QByteArray key(ShaderTraits traits, const QByteArray &vertexSource, const QByteArray &fragmentSource) const;
+
+    /**
+     * Loads the binary stored for @p key into @p program. Returns @c true if @p program has
+     * been linked successfully.
+     */
+    bool load(GLuint program, const QByteArray &key) const;
+    /**
+     * Stores the binary of the linked @p program for @p key. The program must have been
+     * linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+     */
+    void store(GLuint program, const QByteArray &key) const;
+
+private:
+    explicit ShaderCache(const QString &directory);
+
+    QString filePath(const QByteArray &key) const;
+
+    QString m_directory;
+};
+
+}
+
+#endif
@@ -12,6 +12,7 @@
 
 // need to call GLTexturePrivate::initStatic()
 #include "kwingltexture_p.h"
+#include "kwinglshadercache_p.h"
 
 #include "kwineffects.h"
 #include "kwinglplatform.h"
@@ -20,6 +21,7 @@
 #include <QPixmap>
 #include <QImage>
 #include <QHash>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QVector2D>
 #include <QVector3D>
@@ -543,6 +545,7 @@ ShaderManager::ShaderManager()
     } else {
         m_resourcePath = QStringLiteral(":/effect-shaders-1.10/");
     }
+    m_cache = ShaderCache::create();
 }
 
 ShaderManager::~ShaderManager()
@@ -553,6 +556,7 @@ ShaderManager::~ShaderManager()
 
     qDeleteAll(m_shaderHash);
     m_shaderHash.clear();
+    delete m_cache;
 }
 
 static bool fuzzyCompare(const QVector4D &lhs, const QVector4D &rhs)
@@ -910,13 +914,38 @@ GLShader *ShaderManager::generateCustomShader(ShaderTraits traits, const QByteAr
 #endif
 
     GLShader *shader = new GLShader(GLShader::ExplicitLinking);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QByteArray cacheKey;
+    if (m_cache) {
+        cacheKey = m_cache->key(traits, vertex, fragment);
+        if (m_cache->load(shader->mProgram, cacheKey)) {
+            shader->mValid = true;
+            m_loadedCount++;
+            m_loadTime += timer.nsecsElapsed();
+            return shader;
+        }
+    }
+
     shader->load(vertex, fragment);
 
     shader->bindAttributeLocation("position", VA_Position);
     shader->bindAttributeLocation("texcoord", VA_TexCoord);
     shader->bindFragDataLocation("fragColor", 0);
 
+    if (m_cache) {
+        glProgramParameteri(shader->mProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     shader->link();
+    m_compiledCount++;
+    m_compileTime += timer.nsecsElapsed();
+
+    if (m_cache && shader->isValid()) {
+        m_cache->store(shader->mProgram, cacheKey);
+    }
     return shader;
 }
 
@@ -959,6 +988,37 @@ GLShader *ShaderManager::shader(ShaderTraits traits)
     return shader;
 }
 
+bool ShaderManager::warmUp()
+{
+    static const ShaderTraits commonTraits[] = {
+        ShaderTrait::MapTexture,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate,
+        ShaderTrait::MapTexture | ShaderTrait::AdjustSaturation,
+        ShaderTrait::MapTexture | ShaderTrait::Modulate | ShaderTrait::AdjustSaturation,
+        ShaderTrait::UniformColor,
+        ShaderTrait::UniformColor | ShaderTrait::Modulate,
+    };
+
+    for (const ShaderTraits &traits : commonTraits) {
+        if (!m_shaderHash.contains(traits)) {
+            shader(traits);
+            m_warmedUpCount++;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString ShaderManager::supportInformation() const
+{
+    QString support;
+    support.append(QStringLiteral("Shader cache: %1\n").arg(m_cache ? m_cache->directory() : QStringLiteral("disabled")));
+    support.append(QStringLiteral("Shaders compiled: %1 in %2 ms\n").arg(m_compiledCount).arg(m_compileTime / 1000000));
+    support.append(QStringLiteral("Shaders loaded from cache: %1 in %2 ms\n").arg(m_loadedCount).arg(m_loadTime / 1000000));
+    support.append(QStringLiteral("Shaders generated ahead of use: %1\n").arg(m_warmedUpCount));
+    return support;
+}
+
 GLShader *ShaderManager::getBoundShader() const
 {
     if (m_boundShaders.isEmpty()) {
@@ -1064,6 +1124,11 @@ bool GLRenderTarget::isRenderTargetBound()
     return !s_renderTargets.isEmpty();
 }
 
+GLRenderTarget *GLRenderTarget::currentRenderTarget()
+{
+    return s_renderTargets.isEmpty() ? nullptr : s_renderTargets.top();
+}
+
 bool GLRenderTarget::blitSupported()
 {
     return s_blitSupported;
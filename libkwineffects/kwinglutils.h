@@ -36,6 +36,7 @@ namespace KWin
 
 class GLVertexBuffer;
 class GLVertexBufferPrivate;
+class ShaderCache;
 
 // Initializes OpenGL stuff. This includes resolving function pointers as
 //  well as checking for GL version and extensions
@@ -291,6 +292,25 @@ public:
      */
     bool selfTest();
 
+    /**
+     * Generates the next shader of the trait combinations that are used by most windows and
+     * effects, if it hasn't been generated yet. Returns @c false once all of them exist.
+     *
+     * The compositor calls this whenever it is idle after startup, so the first frame that
+     * needs one of these shaders doesn't have to wait for it to be compiled.
+     * @internal
+     * @since 5.22
+     */
+    bool warmUp();
+
+    /**
+     * Returns how many shaders have been compiled or loaded from the shader cache and how
+     * long that took, for the support information.
+     * @internal
+     * @since 5.22
+     */
+    QString supportInformation() const;
+
     /**
      * @return a pointer to the ShaderManager instance
      */
@@ -315,6 +335,12 @@ private:
     QStack<GLShader*> m_boundShaders;
     QHash<ShaderTraits, GLShader *> m_shaderHash;
     QString m_resourcePath;
+    ShaderCache *m_cache = nullptr;
+    int m_compiledCount = 0;
+    qint64 m_compileTime = 0;
+    int m_loadedCount = 0;
+    qint64 m_loadTime = 0;
+    int m_warmedUpCount = 0;
     static ShaderManager *s_shaderManager;
 };
 
@@ -461,6 +487,11 @@ public:
     static void pushRenderTarget(GLRenderTarget *target);
     static GLRenderTarget *popRenderTarget();
     static bool isRenderTargetBound();
+    /**
+     * Returns the render target that is currently bound, or @c null if none.
+     * @since 5.22
+     */
+    static GLRenderTarget *currentRenderTarget();
     /**
      * Whether the GL_EXT_framebuffer_blit extension is supported.
      * This functionality is not available in OpenGL ES 2.0.
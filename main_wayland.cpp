@@ -12,7 +12,10 @@
 #include "workspace.h"
 #include <config-kwin.h>
 // kwin
+#include "abstract_output.h"
 #include "platform.h"
+#include "renderloop.h"
+#include "schedulingpolicy.h"
 #include "effects.h"
 #include "tabletmodemanager.h"
 
@@ -53,8 +56,6 @@
 #include <sys/capability.h>
 #endif
 
-#include <sched.h>
-
 #include <iostream>
 #include <iomanip>
 
@@ -82,29 +83,7 @@ void disableDrKonqi()
 // that would enable drkonqi
 Q_CONSTRUCTOR_FUNCTION(disableDrKonqi)
 
-enum class RealTimeFlags
-{
-    DontReset,
-    ResetOnFork
-};
-
-namespace {
-void gainRealTime(RealTimeFlags flags = RealTimeFlags::DontReset)
-{
-#if HAVE_SCHED_RESET_ON_FORK
-    const int minPriority = sched_get_priority_min(SCHED_RR);
-    struct sched_param sp;
-    sp.sched_priority = minPriority;
-    int policy = SCHED_RR;
-    if (flags == RealTimeFlags::ResetOnFork) {
-        policy |= SCHED_RESET_ON_FORK;
-    }
-    sched_setscheduler(0, policy, &sp);
-#else
-    Q_UNUSED(flags);
-#endif
-}
-}
+void dropNiceCapability();
 
 //************************************
 // ApplicationWayland
@@ -164,7 +143,7 @@ void ApplicationWayland::performStartup()
     // try creating the Wayland Backend
     createInput();
     // now libinput thread has been created, adjust scheduler to not leak into other processes
-    gainRealTime(RealTimeFlags::ResetOnFork);
+    SchedulingPolicy::self()->applyToCurrentThread(SchedulingPolicy::Role::Compositor, true);
 
     InputMethod::create(this);
     createBackend();
@@ -202,10 +181,33 @@ void ApplicationWayland::finalizeStartup()
     notifyStarted();
 }
 
+void ApplicationWayland::applyDeadlineScheduling()
+{
+    // The compositor has to be able to render a frame for the fastest output in every period.
+    int refreshRate = 0;
+    if (RenderLoop *renderLoop = platform()->renderLoop()) {
+        refreshRate = renderLoop->refreshRate();
+    }
+    const auto outputs = platform()->enabledOutputs();
+    for (AbstractOutput *output : outputs) {
+        if (RenderLoop *renderLoop = output->renderLoop()) {
+            refreshRate = std::max(refreshRate, renderLoop->refreshRate());
+        }
+    }
+    SchedulingPolicy::self()->applyDeadline(refreshRate);
+
+    // Any later change of the policy would need the capability, it is not kept around for that.
+    dropNiceCapability();
+}
+
 void ApplicationWayland::continueStartupWithScene()
 {
     disconnect(Compositor::self(), &Compositor::sceneCreated, this, &ApplicationWayland::continueStartupWithScene);
 
+    if (SchedulingPolicy::self()->wantsDeadline()) {
+        applyDeadlineScheduling();
+    }
+
     // Note that we start accepting client connections after creating the Workspace.
     createWorkspace();
 
@@ -462,8 +464,11 @@ int main(int argc, char * argv[])
     KWin::disablePtrace();
     KWin::Application::setupMalloc();
     KWin::Application::setupLocalizedString();
-    KWin::gainRealTime();
-    KWin::dropNiceCapability();
+    KWin::SchedulingPolicy::self()->gainRealTime();
+    // SCHED_DEADLINE needs CAP_SYS_NICE until the refresh rate of the outputs is known
+    if (!KWin::SchedulingPolicy::self()->wantsDeadline()) {
+        KWin::dropNiceCapability();
+    }
 
     if (signal(SIGTERM, KWin::sighandler) == SIG_IGN)
         signal(SIGTERM, SIG_IGN);
@@ -54,6 +54,7 @@ private:
     void createBackend();
     void continueStartupWithScreens();
     void continueStartupWithScene();
+    void applyDeadlineScheduling();
     void finalizeStartup();
     void startSession() override;
     void startInputMethod(const QString &executable);
@@ -60,6 +60,9 @@ enum RenderTimeEstimator {
     RenderTimeEstimatorMinimum,
     RenderTimeEstimatorMaximum,
     RenderTimeEstimatorAverage,
+    RenderTimeEstimatorPercentile95,
+    RenderTimeEstimatorPercentile99,
+    RenderTimeEstimatorPredictive,
 };
 
 class Settings;
@@ -9,6 +9,7 @@
 #include "abstract_egl_backend.h"
 #include "egl_dmabuf.h"
 #include "kwineglext.h"
+#include "pixeluploadbuffer.h"
 #include "composite.h"
 #include "egl_context_attribute_builder.h"
 #include "options.h"
@@ -116,6 +117,7 @@ void AbstractEglBackend::teardown()
 
 void AbstractEglBackend::cleanup()
 {
+    m_pixelUploadBuffer.reset();
     cleanupGL();
     doneCurrent();
     eglDestroyContext(m_display, m_context);
@@ -177,6 +179,7 @@ void AbstractEglBackend::initKWinGL()
         options->setGlPreferBufferSwap('e'); // for unknown drivers - should not happen
     glPlatform->printResults();
     initGL(&getProcAddress);
+    m_pixelUploadBuffer.reset(PixelUploadBuffer::create());
 }
 
 void AbstractEglBackend::initBufferAge()
@@ -542,6 +545,12 @@ bool AbstractEglTexture::createTextureImage(const QImage &image)
 void AbstractEglTexture::createTextureSubImage(const QImage &image, const QRegion &damage)
 {
     q->bind();
+    if (PixelUploadBuffer *uploadBuffer = m_backend->pixelUploadBuffer()) {
+        if (uploadBuffer->upload(m_target, image, damage)) {
+            q->unbind();
+            return;
+        }
+    }
     if (GLPlatform::instance()->isGLES()) {
         if (s_supportsARGB32 && (image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_ARGB32_Premultiplied)) {
             const QImage im = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
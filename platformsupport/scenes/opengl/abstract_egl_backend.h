@@ -14,6 +14,8 @@
 #include <QObject>
 #include <epoxy/egl.h>
 
+#include <memory>
+
 class QOpenGLFramebufferObject;
 
 namespace KWaylandServer
@@ -26,6 +28,7 @@ namespace KWin
 
 class EglDmabuf;
 class AbstractOutput;
+class PixelUploadBuffer;
 
 class KWIN_EXPORT AbstractEglBackend : public QObject, public OpenGLBackend
 {
@@ -61,6 +64,14 @@ public:
         return this == s_primaryBackend;
     }
 
+    /**
+     * Returns the buffer used to stream shared memory client buffers into textures, or
+     * @c nullptr if they are uploaded directly.
+     */
+    PixelUploadBuffer *pixelUploadBuffer() const {
+        return m_pixelUploadBuffer.get();
+    }
+
 protected:
     AbstractEglBackend();
     void setEglDisplay(const EGLDisplay &display);
@@ -87,6 +98,7 @@ private:
     // note: m_dmaBuf is nullptr if this is not the primary backend
     EglDmabuf *m_dmaBuf = nullptr;
     QList<QByteArray> m_clientExtensions;
+    std::unique_ptr<PixelUploadBuffer> m_pixelUploadBuffer;
 
     static AbstractEglBackend * s_primaryBackend;
 };
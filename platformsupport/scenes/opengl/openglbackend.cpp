@@ -11,6 +11,7 @@
 #include <kwineffects.h>
 #include <logging.h>
 
+#include "rectset.h"
 #include "screens.h"
 
 #include <epoxy/gl.h>
@@ -45,18 +46,16 @@ void OpenGLBackend::addToDamageHistory(const QRegion &region)
 
 QRegion OpenGLBackend::accumulatedDamageHistory(int bufferAge) const
 {
-    QRegion region;
-
     // Note: An age of zero means the buffer contents are undefined
     if (bufferAge > 0 && bufferAge <= m_damageHistory.count()) {
+        RectSet region;
         for (int i = 0; i < bufferAge - 1; i++)
-            region |= m_damageHistory[i];
-    } else {
-        const QSize &s = screens()->size();
-        region = QRegion(0, 0, s.width(), s.height());
+            region.unite(RectSet(m_damageHistory[i]));
+        return region.toRegion();
     }
 
-    return region;
+    const QSize &s = screens()->size();
+    return QRegion(0, 0, s.width(), s.height());
 }
 
 OverlayWindow* OpenGLBackend::overlayWindow() const
@@ -83,6 +82,26 @@ QSharedPointer<KWin::GLTexture> OpenGLBackend::textureForOutput(AbstractOutput*
     return {};
 }
 
+bool OpenGLBackend::scanout(int screenId, KWaylandServer::SurfaceInterface *surface)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(surface)
+    return false;
+}
+
+bool OpenGLBackend::supportsOverlays(int screenId) const
+{
+    Q_UNUSED(screenId)
+    return false;
+}
+
+QRegion OpenGLBackend::assignOverlays(int screenId, const QVector<OverlayCandidate> &candidates)
+{
+    Q_UNUSED(screenId)
+    Q_UNUSED(candidates)
+    return QRegion();
+}
+
 void OpenGLBackend::aboutToStartPainting(int screenId, const QRegion &damage)
 {
     Q_UNUSED(screenId)
@@ -11,9 +11,15 @@
 #define KWIN_SCENE_OPENGL_BACKEND_H
 
 #include <QRegion>
+#include <QVector>
 
 #include <kwin_export.h>
 
+namespace KWaylandServer
+{
+class SurfaceInterface;
+}
+
 namespace KWin
 {
 class AbstractOutput;
@@ -150,6 +156,49 @@ public:
 
     virtual QSharedPointer<GLTexture> textureForOutput(AbstractOutput *output) const;
 
+    /**
+     * Tries to present the buffer attached to the given @p surface on the screen with the
+     * specified @p screenId without compositing. Returns @c true if the buffer has been
+     * queued for presentation; otherwise the frame has to be composited as usual.
+     *
+     * The default implementation returns @c false.
+     */
+    virtual bool scanout(int screenId, KWaylandServer::SurfaceInterface *surface);
+
+    /**
+     * The OverlayCandidate struct describes a surface that can be shown on a hardware
+     * overlay plane instead of being composited.
+     */
+    struct OverlayCandidate
+    {
+        KWaylandServer::SurfaceInterface *surface;
+        /**
+         * The geometry of the surface in the global logical coordinates.
+         */
+        QRect geometry;
+    };
+
+    /**
+     * Returns @c true if surfaces can be shown on hardware overlay planes of the screen with
+     * the specified @p screenId. The scene looks for overlay candidates only if it can.
+     *
+     * The default implementation returns @c false.
+     */
+    virtual bool supportsOverlays(int screenId) const;
+
+    /**
+     * Tries to put the given overlay @p candidates on the hardware overlay planes of the
+     * screen with the specified @p screenId. The candidates are ordered from top to bottom
+     * and don't overlap with each other or with anything painted above them. Returns the
+     * region that is covered by the assigned overlays; the scene doesn't need to paint it.
+     *
+     * This is called for every composited frame, before beginFrame(). Overlays that are
+     * not assigned again are turned off with the next frame.
+     *
+     * The default implementation returns an empty region.
+     */
+    virtual QRegion assignOverlays(int screenId, const QVector<OverlayCandidate> &candidates);
+
 protected:
     /**
      * @brief Sets the backend initialization to failed.
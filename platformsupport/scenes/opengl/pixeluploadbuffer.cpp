@@ -0,0 +1,245 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "pixeluploadbuffer.h"
+
+#include <logging.h>
+#include <kwinglplatform.h>
+#include <kwinglutils.h>
+
+#include <cstring>
+
+namespace KWin
+{
+
+static const size_t s_minimumBufferSize = 8 * 1024 * 1024;
+
+static size_t align(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+PixelUploadBuffer *PixelUploadBuffer::create()
+{
+    if (qgetenv("KWIN_PBO_UPLOAD") == QByteArrayLiteral("0")) {
+        return nullptr;
+    }
+
+    bool supported;
+    bool persistent;
+    if (GLPlatform::instance()->isGLES()) {
+        // Textures of client buffers are only BGRA if GL_EXT_texture_format_BGRA8888 is
+        // supported, there is nothing to gain from a pixel buffer otherwise since the pixels
+        // have to be converted anyway.
+        supported = hasGLVersion(3, 0)
+                && QSysInfo::ByteOrder == QSysInfo::LittleEndian
+                && hasGLExtension(QByteArrayLiteral("GL_EXT_texture_format_BGRA8888"));
+        persistent = hasGLExtension(QByteArrayLiteral("GL_EXT_buffer_storage"));
+    } else {
+        supported = hasGLVersion(3, 0);
+        persistent = (hasGLVersion(4, 4) || hasGLExtension(QByteArrayLiteral("GL_ARB_buffer_storage")))
+                && (hasGLVersion(3, 2) || hasGLExtension(QByteArrayLiteral("GL_ARB_sync")));
+    }
+    if (!supported) {
+        return nullptr;
+    }
+    if (qgetenv("KWIN_PERSISTENT_VBO") == QByteArrayLiteral("0")) {
+        persistent = false;
+    }
+    return new PixelUploadBuffer(persistent);
+}
+
+PixelUploadBuffer::PixelUploadBuffer(bool persistent)
+    : m_persistent(persistent)
+{
+    qCDebug(KWIN_OPENGL) << "Uploading client buffers through a" << (persistent ? "persistent" : "streaming")
+                         << "pixel unpack buffer";
+}
+
+PixelUploadBuffer::~PixelUploadBuffer()
+{
+    deleteFences();
+    if (m_buffer) {
+        // This also unmaps the buffer
+        glDeleteBuffers(1, &m_buffer);
+    }
+}
+
+void PixelUploadBuffer::deleteFences()
+{
+    for (const Fence &fence : m_fences) {
+        glDeleteSync(fence.sync);
+    }
+    m_fences.clear();
+}
+
+void PixelUploadBuffer::reallocate(size_t size)
+{
+    // Leave room for the next upload while the previous one is still in flight.
+    m_bufferSize = align(qMax(size * 2, s_minimumBufferSize), 1024 * 1024);
+    m_nextOffset = 0;
+
+    if (m_buffer) {
+        // Pending uploads keep the old data store alive.
+        deleteFences();
+        glDeleteBuffers(1, &m_buffer);
+        m_map = nullptr;
+    }
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+
+    if (m_persistent) {
+        const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_bufferSize, nullptr, access);
+        m_map = static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_bufferSize, access));
+        if (!m_map) {
+            qCWarning(KWIN_OPENGL) << "Failed to map the pixel unpack buffer";
+        }
+    } else {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, m_bufferSize, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+bool PixelUploadBuffer::awaitRange(intptr_t begin, intptr_t end)
+{
+    // The GPU signals the fences in order, so waiting for the newest fence that covers the
+    // range also retires all older ones.
+    auto newest = m_fences.cend();
+    for (auto it = m_fences.cbegin(); it != m_fences.cend(); ++it) {
+        if (it->begin < end && begin < it->end) {
+            newest = it;
+        }
+    }
+    if (newest == m_fences.cend()) {
+        return true;
+    }
+
+    GLint status;
+    glGetSynciv(newest->sync, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status != GL_SIGNALED) {
+        qCDebug(KWIN_OPENGL) << "Stalling on pixel unpack buffer fence";
+        const GLenum ret = glClientWaitSync(newest->sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        if (ret == GL_TIMEOUT_EXPIRED || ret == GL_WAIT_FAILED) {
+            qCCritical(KWIN_OPENGL) << "Wait for pixel unpack buffer fence failed";
+            return false;
+        }
+    }
+
+    const auto last = newest + 1;
+    for (auto it = m_fences.cbegin(); it != last; ++it) {
+        glDeleteSync(it->sync);
+    }
+    m_fences.erase(m_fences.cbegin(), last);
+    return true;
+}
+
+uint8_t *PixelUploadBuffer::mapRange(intptr_t offset, size_t size, bool wrapped)
+{
+    if (m_persistent) {
+        if (!m_map || !awaitRange(offset, offset + size)) {
+            return nullptr;
+        }
+        return m_map + offset;
+    }
+
+    // Ranges are never written twice before the buffer is orphaned on wrap-around, so the
+    // driver doesn't have to synchronize with uploads that are still pending.
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (wrapped) {
+        access |= GL_MAP_INVALIDATE_BUFFER_BIT;
+        access ^= GL_MAP_UNSYNCHRONIZED_BIT;
+    }
+    return static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size, access));
+}
+
+bool PixelUploadBuffer::upload(GLenum target, const QImage &image, const QRegion &damage)
+{
+    GLenum format;
+    switch (image.format()) {
+    case QImage::Format_ARGB32_Premultiplied:
+        format = GLPlatform::instance()->isGLES() ? GL_BGRA_EXT : GL_BGRA;
+        break;
+    case QImage::Format_RGB32:
+        // Textures of opaque buffers are RGBA on OpenGL ES, the pixels have to be swizzled.
+        if (GLPlatform::instance()->isGLES()) {
+            return false;
+        }
+        format = GL_BGRA;
+        break;
+    default:
+        return false;
+    }
+
+    const QRegion region = damage & image.rect();
+    if (region.isEmpty()) {
+        return true;
+    }
+
+    const int bytesPerPixel = 4;
+    size_t size = 0;
+    for (const QRect &rect : region) {
+        size += size_t(rect.width()) * rect.height() * bytesPerPixel;
+    }
+
+    if (!m_buffer || size > m_bufferSize / 2) {
+        reallocate(size);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    }
+
+    bool wrapped = false;
+    if (m_nextOffset + size > m_bufferSize) {
+        m_nextOffset = 0;
+        wrapped = true;
+    }
+
+    const intptr_t offset = m_nextOffset;
+    uint8_t *map = mapRange(offset, size, wrapped);
+    if (!map) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    // Copy the damaged rows tightly packed, the texture uploads below read them back in the
+    // same order.
+    const uchar *bits = image.constBits();
+    const int stride = image.bytesPerLine();
+    uint8_t *dst = map;
+    for (const QRect &rect : region) {
+        const size_t rowSize = size_t(rect.width()) * bytesPerPixel;
+        const uchar *src = bits + rect.y() * stride + rect.x() * bytesPerPixel;
+        if (size_t(stride) == rowSize) {
+            memcpy(dst, src, rowSize * rect.height());
+            dst += rowSize * rect.height();
+        } else {
+            for (int y = 0; y < rect.height(); ++y) {
+                memcpy(dst, src, rowSize);
+                src += stride;
+                dst += rowSize;
+            }
+        }
+    }
+
+    if (!m_persistent) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    intptr_t rectOffset = offset;
+    for (const QRect &rect : region) {
+        glTexSubImage2D(target, 0, rect.x(), rect.y(), rect.width(), rect.height(),
+                        format, GL_UNSIGNED_BYTE, reinterpret_cast<const GLvoid *>(rectOffset));
+        rectOffset += intptr_t(rect.width()) * rect.height() * bytesPerPixel;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (m_persistent) {
+        m_fences.push_back(Fence{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), offset, intptr_t(offset + size)});
+    }
+    m_nextOffset = offset + size;
+    return true;
+}
+
+} // namespace KWin
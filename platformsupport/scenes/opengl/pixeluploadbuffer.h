@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <epoxy/gl.h>
+
+#include <QImage>
+#include <QRegion>
+
+#include <deque>
+
+namespace KWin
+{
+
+/**
+ * The PixelUploadBuffer streams client pixels into textures through a ring of pixel unpack
+ * buffer memory.
+ *
+ * Only the damaged rows are copied into the ring, without any intermediate QImage, and the
+ * texture upload itself is scheduled with glTexSubImage2D() sourcing from the buffer, so the
+ * driver can perform it asynchronously instead of stalling the compositor until the pixels
+ * have been consumed.
+ *
+ * If the GL implementation supports buffer storage and sync objects, the ring is mapped
+ * persistently and every upload is fenced, the ring space of an upload is reused only after
+ * the GPU has signaled its fence. Otherwise, the ring is mapped for every upload and orphaned
+ * when it wraps around.
+ *
+ * The PixelUploadBuffer requires the OpenGL context to be current whenever it's used.
+ */
+class PixelUploadBuffer
+{
+public:
+    ~PixelUploadBuffer();
+
+    /**
+     * Creates a PixelUploadBuffer for the current OpenGL context, or returns @c nullptr if the
+     * context doesn't support pixel unpack buffers or they have been disabled by setting the
+     * environment variable KWIN_PBO_UPLOAD to 0.
+     */
+    static PixelUploadBuffer *create();
+
+    /**
+     * Uploads the @p damage of @p image to the same area of the texture currently bound to
+     * @p target. Returns @c false if the image is not in a format that can be uploaded as is,
+     * in which case the caller has to fall back to glTexSubImage2D().
+     */
+    bool upload(GLenum target, const QImage &image, const QRegion &damage);
+
+private:
+    PixelUploadBuffer(bool persistent);
+
+    struct Fence
+    {
+        GLsync sync;
+        intptr_t begin;
+        intptr_t end;
+    };
+
+    void reallocate(size_t size);
+    uint8_t *mapRange(intptr_t offset, size_t size, bool wrapped);
+    bool awaitRange(intptr_t begin, intptr_t end);
+    void deleteFences();
+
+    GLuint m_buffer = 0;
+    size_t m_bufferSize = 0;
+    intptr_t m_nextOffset = 0;
+    uint8_t *m_map = nullptr;
+    std::deque<Fence> m_fences;
+    bool m_persistent;
+};
+
+} // namespace KWin
@@ -12,14 +12,18 @@
 
 #include "logging.h"
 
+#include <KWaylandServer/buffer_interface.h>
+
 // system
 #include <sys/mman.h>
 // c++
 #include <cerrno>
+#include <cstring>
 // drm
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 #include <gbm.h>
+#include <drm_fourcc.h>
 
 namespace KWin
 {
@@ -52,6 +56,43 @@ DrmSurfaceBuffer::DrmSurfaceBuffer(int fd, gbm_bo *buffer)
     gbm_bo_set_user_data(m_bo, this, nullptr);
 }
 
+DrmSurfaceBuffer::DrmSurfaceBuffer(int fd, gbm_bo *buffer, KWaylandServer::BufferInterface *clientBuffer)
+    : DrmBuffer(fd)
+    , m_bo(buffer)
+    , m_clientBuffer(clientBuffer)
+{
+    m_clientBuffer->ref();
+    m_size = QSize(gbm_bo_get_width(m_bo), gbm_bo_get_height(m_bo));
+
+    // Client buffers can have any format and layout, so drmModeAddFB() can't be used.
+    uint32_t handles[4] = {};
+    uint32_t strides[4] = {};
+    uint32_t offsets[4] = {};
+    uint64_t modifiers[4] = {};
+    const uint64_t modifier = gbm_bo_get_modifier(m_bo);
+    for (int i = 0; i < gbm_bo_get_plane_count(m_bo); ++i) {
+        handles[i] = gbm_bo_get_handle_for_plane(m_bo, i).u32;
+        strides[i] = gbm_bo_get_stride_for_plane(m_bo, i);
+        offsets[i] = gbm_bo_get_offset(m_bo, i);
+        modifiers[i] = modifier;
+    }
+
+    int ret;
+    if (modifier != DRM_FORMAT_MOD_INVALID) {
+        ret = drmModeAddFB2WithModifiers(fd, m_size.width(), m_size.height(), gbm_bo_get_format(m_bo),
+                                         handles, strides, offsets, modifiers, &m_bufferId,
+                                         DRM_MODE_FB_MODIFIERS);
+    } else {
+        ret = drmModeAddFB2(fd, m_size.width(), m_size.height(), gbm_bo_get_format(m_bo),
+                            handles, strides, offsets, &m_bufferId, 0);
+    }
+    if (ret != 0) {
+        qCDebug(KWIN_DRM) << "drmModeAddFB2 failed for a client buffer:" << strerror(errno);
+        m_bufferId = 0;
+    }
+    gbm_bo_set_user_data(m_bo, this, nullptr);
+}
+
 DrmSurfaceBuffer::~DrmSurfaceBuffer()
 {
     if (m_bufferId) {
@@ -68,6 +109,10 @@ void DrmSurfaceBuffer::releaseGbm()
         gbm_bo_destroy(m_bo);
     }
     m_bo = nullptr;
+    if (m_clientBuffer) {
+        m_clientBuffer->unref();
+        m_clientBuffer = nullptr;
+    }
 }
 
 }
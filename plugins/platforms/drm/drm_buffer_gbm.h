@@ -12,10 +12,17 @@
 
 #include "drm_buffer.h"
 
+#include <QPointer>
+
 #include <memory>
 
 struct gbm_bo;
 
+namespace KWaylandServer
+{
+class BufferInterface;
+}
+
 namespace KWin
 {
 
@@ -26,6 +33,12 @@ class DrmSurfaceBuffer : public DrmBuffer
 public:
     DrmSurfaceBuffer(int fd, const std::shared_ptr<GbmSurface> &surface);
     DrmSurfaceBuffer(int fd, gbm_bo *buffer);
+    /**
+     * Creates a framebuffer for the @p buffer that has been imported from the given client
+     * buffer. The client buffer is kept referenced until the framebuffer is released, so the
+     * client doesn't reuse it while it is being scanned out.
+     */
+    DrmSurfaceBuffer(int fd, gbm_bo *buffer, KWaylandServer::BufferInterface *clientBuffer);
     ~DrmSurfaceBuffer() override;
 
     bool needsModeChange(DrmBuffer *b) const override {
@@ -44,11 +57,19 @@ public:
         return m_bo;
     }
 
+    /**
+     * Returns the client buffer that this framebuffer has been created for, if any.
+     */
+    KWaylandServer::BufferInterface *clientBuffer() const {
+        return m_clientBuffer;
+    }
+
     void releaseGbm() override;
 
 private:
     std::shared_ptr<GbmSurface> m_surface;
     gbm_bo *m_bo = nullptr;
+    QPointer<KWaylandServer::BufferInterface> m_clientBuffer;
 };
 
 }
@@ -55,6 +55,9 @@ DrmGpu::DrmGpu(DrmBackend *backend, QByteArray devNode, int fd, int drmId) : m_b
         m_presentationClock = CLOCK_REALTIME;
     }
 
+    ret = drmGetCap(fd, DRM_CAP_ADDFB2_MODIFIERS, &capability);
+    m_addFB2ModifiersSupported = ret == 0 && capability == 1;
+
     // find out if this GPU is using the NVidia proprietary driver
     DrmScopedPointer<drmVersion> version(drmGetVersion(fd));
     m_useEglStreams = strstr(version->name, "nvidia-drm");
@@ -288,12 +291,49 @@ bool DrmGpu::updateOutputs()
         removedOutput->m_crtc = nullptr;
         removedOutput->m_conn = nullptr;
     }
+    distributeOverlayPlanes();
 
     qDeleteAll(oldConnectors);
     qDeleteAll(oldCrtcs);
     return true;
 }
 
+void DrmGpu::distributeOverlayPlanes()
+{
+    // Overlay planes can usually be used only with a subset of the CRTCs. The outputs take
+    // turns at claiming a plane, so that the output that is initialized first doesn't get
+    // all of them. Planes that are turned off are handed out anew, e.g. after hotplug.
+    QVector<DrmPlane *> freePlanes;
+    for (DrmPlane *plane : qAsConst(m_overlayPlanes)) {
+        if (DrmOutput *output = plane->output()) {
+            if (plane->current() || plane->next()) {
+                continue;
+            }
+            output->m_overlayPlanes.removeOne(plane);
+            plane->setOutput(nullptr);
+        }
+        freePlanes << plane;
+    }
+
+    bool claimed = true;
+    while (claimed && !freePlanes.isEmpty()) {
+        claimed = false;
+        for (DrmOutput *output : qAsConst(m_outputs)) {
+            auto it = std::find_if(freePlanes.begin(), freePlanes.end(), [output](DrmPlane *plane) {
+                return output->claimOverlayPlane(plane);
+            });
+            if (it != freePlanes.end()) {
+                freePlanes.erase(it);
+                claimed = true;
+            }
+        }
+    }
+
+    for (DrmOutput *output : qAsConst(m_outputs)) {
+        qCDebug(KWIN_DRM) << "Output" << output->name() << "has" << output->m_overlayPlanes.count() << "overlay planes";
+    }
+}
+
 DrmOutput *DrmGpu::findOutput(quint32 connector)
 {
     auto it = std::find_if(m_outputs.constBegin(), m_outputs.constEnd(), [connector] (DrmOutput *o) {
@@ -61,6 +61,13 @@ public:
         return m_deleteBufferAfterPageFlip;
     }
 
+    /**
+     * Returns @c true if framebuffers can be created for buffers with explicit modifiers.
+     */
+    bool addFB2ModifiersSupported() const {
+        return m_addFB2ModifiersSupported;
+    }
+
     QByteArray devNode() const {
         return m_devNode;
     }
@@ -77,6 +84,10 @@ public:
         return m_planes;
     }
 
+    QVector<DrmPlane*> overlayPlanes() const {
+        return m_overlayPlanes;
+    }
+
     AbstractEglBackend *eglBackend() {
         return m_eglBackend;
     }
@@ -121,6 +132,7 @@ protected:
 
 private:
     DrmOutput *findOutput(quint32 connector);
+    void distributeOverlayPlanes();
 
     DrmBackend* const m_backend;
     AbstractEglBackend *m_eglBackend;
@@ -132,6 +144,7 @@ private:
     bool m_atomicModeSetting;
     bool m_useEglStreams;
     bool m_deleteBufferAfterPageFlip;
+    bool m_addFB2ModifiersSupported = false;
     gbm_device* m_gbmDevice;
     EGLDisplay m_eglDisplay = EGL_NO_DISPLAY;
     clockid_t m_presentationClock;
@@ -11,6 +11,8 @@
 #include "drm_pointer.h"
 #include "logging.h"
 
+#include <drm_fourcc.h>
+
 namespace KWin
 {
 
@@ -46,6 +48,64 @@ bool DrmPlane::atomicInit()
     if (!initProps()) {
         return false;
     }
+    initModifiers();
+    return true;
+}
+
+void DrmPlane::initModifiers()
+{
+    auto property = m_props.at(int(PropertyIndex::InFormats));
+    if (!property) {
+        return;
+    }
+    DrmScopedPointer<drmModePropertyBlobRes> blob(drmModeGetPropertyBlob(fd(), property->value()));
+    if (!blob) {
+        qCWarning(KWIN_DRM) << "Failed to get the IN_FORMATS blob of plane" << m_id;
+        return;
+    }
+
+    const auto header = static_cast<const drm_format_modifier_blob *>(blob->data);
+    const auto data = static_cast<const char *>(blob->data);
+    const auto formats = reinterpret_cast<const uint32_t *>(data + header->formats_offset);
+    const auto modifiers = reinterpret_cast<const drm_format_modifier *>(data + header->modifiers_offset);
+
+    // Every modifier carries a bit mask of the formats, starting at the given offset, that
+    // it can be used with.
+    for (uint32_t i = 0; i < header->count_modifiers; ++i) {
+        const drm_format_modifier &modifier = modifiers[i];
+        for (uint32_t bit = 0; bit < 64; ++bit) {
+            if (!(modifier.formats & (uint64_t(1) << bit))) {
+                continue;
+            }
+            const uint32_t index = modifier.offset + bit;
+            if (index < header->count_formats) {
+                m_modifiers[formats[index]].append(modifier.modifier);
+            }
+        }
+    }
+}
+
+bool DrmPlane::isFormatSupported(uint32_t format, uint64_t modifier) const
+{
+    if (modifier == DRM_FORMAT_MOD_INVALID) {
+        return m_formats.contains(format);
+    }
+    return m_modifiers.value(format).contains(modifier);
+}
+
+int DrmPlane::zpos() const
+{
+    auto property = m_props.at(int(PropertyIndex::Zpos));
+    return property ? int(property->value()) : -1;
+}
+
+bool DrmPlane::setZpos(int position)
+{
+    auto property = m_props.at(int(PropertyIndex::Zpos));
+    if (!property || property->isImmutable()) {
+        return false;
+    }
+    property->setValue(position);
     return true;
 }
 
@@ -68,7 +128,9 @@ bool DrmPlane::initProps()
         QByteArrayLiteral("CRTC_H"),
         QByteArrayLiteral("FB_ID"),
         QByteArrayLiteral("CRTC_ID"),
-        QByteArrayLiteral("rotation")
+        QByteArrayLiteral("rotation"),
+        QByteArrayLiteral("IN_FORMATS"),
+        QByteArrayLiteral("zpos")
     });
 
     QVector<QByteArray> typeNames = {
@@ -10,6 +10,8 @@
 
 #include "drm_object.h"
 
+#include <QHash>
+
 #include <qobjectdefs.h>
 #include <xf86drmMode.h>
 
@@ -39,6 +41,8 @@ public:
         FbId,
         CrtcId,
         Rotation,
+        InFormats,
+        Zpos,
         Count
     };
     Q_ENUM(PropertyIndex)
@@ -72,6 +76,21 @@ public:
     QVector<uint32_t> formats() const {
         return m_formats;
     }
+    /**
+     * Returns @c true if buffers with the given @p format and @p modifier can be shown on
+     * this plane. Pass DRM_FORMAT_MOD_INVALID if the buffer has an implicit modifier.
+     */
+    bool isFormatSupported(uint32_t format, uint64_t modifier) const;
+    /**
+     * Returns the position of the plane in the stack of planes of a CRTC, or @c -1 if the
+     * driver doesn't expose it.
+     */
+    int zpos() const;
+    /**
+     * Moves the plane to the given stacking @p position with the next commit. Returns
+     * @c false if the driver doesn't allow to change the position of the plane.
+     */
+    bool setZpos(int position);
 
     DrmBuffer *current() const {
         return m_current;
@@ -96,11 +115,14 @@ public:
     bool atomicPopulate(drmModeAtomicReq *req) const override;
 
 private:
+    void initModifiers();
+
     DrmBuffer *m_current = nullptr;
     DrmBuffer *m_next = nullptr;
 
     // TODO: See weston drm_output_check_plane_format for future use of these member variables
     QVector<uint32_t> m_formats;        // Possible formats, which can be presented on this plane
+    QHash<uint32_t, QVector<uint64_t>> m_modifiers; // Explicit modifiers per format, from IN_FORMATS
 
     // TODO: when using overlay planes in the future: restrict possible screens / crtcs of planes
     uint32_t m_possibleCrtcs;
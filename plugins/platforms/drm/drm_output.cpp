@@ -69,7 +69,6 @@ void DrmOutput::teardown()
     m_crtc->blank();
 
     if (m_primaryPlane) {
-        // TODO: when having multiple planes, also clean up these
         m_primaryPlane->setOutput(nullptr);
 
         if (m_gpu->deleteBufferAfterPageFlip()) {
@@ -80,6 +79,19 @@ void DrmOutput::teardown()
     if (m_cursorPlane) {
         m_cursorPlane->setOutput(nullptr);
     }
+    for (DrmPlane *plane : qAsConst(m_overlayPlanes)) {
+        plane->setOutput(nullptr);
+
+        if (m_gpu->deleteBufferAfterPageFlip()) {
+            if (plane->next() != plane->current()) {
+                delete plane->next();
+            }
+            delete plane->current();
+        }
+        plane->setCurrent(nullptr);
+        plane->setNext(nullptr);
+    }
+    m_overlayPlanes.clear();
 
     m_crtc->setOutput(nullptr);
     m_conn->setOutput(nullptr);
@@ -424,6 +436,23 @@ bool DrmOutput::initCursorPlane()       // TODO: Add call in init (but needs lay
     return false;
 }
 
+bool DrmOutput::claimOverlayPlane(DrmPlane *plane)
+{
+    if (!m_primaryPlane || !plane->isCrtcSupported(m_crtc->resIndex())) {
+        return false;
+    }
+    // The primary plane is opaque, a plane below it would never be visible.
+    const int primaryZpos = m_primaryPlane->zpos();
+    if (primaryZpos != -1 && plane->zpos() != -1 && plane->zpos() <= primaryZpos) {
+        if (!plane->setZpos(primaryZpos + 1)) {
+            return false;
+        }
+    }
+    plane->setOutput(this);
+    m_overlayPlanes << plane;
+    return true;
+}
+
 bool DrmOutput::initCursor(const QSize &cursorSize)
 {
     auto createCursor = [this, cursorSize] (int index) {
@@ -791,17 +820,111 @@ bool DrmOutput::present(DrmBuffer *buffer)
     }
 }
 
+bool DrmOutput::testPresent(DrmBuffer *buffer)
+{
+    if (!m_gpu->atomicModeSetting() || m_modesetRequested || m_pageFlipPending) {
+        return false;
+    }
+    if (m_dpmsModePending != DpmsMode::On || !LogindIntegration::self()->isActiveSession()) {
+        return false;
+    }
+    m_primaryPlane->setNext(buffer);
+    m_nextPlanesFlipList << m_primaryPlane;
+
+    const bool ok = doAtomicCommit(AtomicCommitMode::Test);
+
+    // presentAtomically() queues the plane again, the staged overlay planes stay.
+    m_primaryPlane->setNext(nullptr);
+    m_nextPlanesFlipList.removeOne(m_primaryPlane);
+
+    return ok;
+}
+
+bool DrmOutput::setOverlay(DrmPlane *plane, DrmBuffer *buffer, const QRect &geometry)
+{
+    Q_ASSERT(m_overlayPlanes.contains(plane));
+    if (!m_gpu->atomicModeSetting() || m_modesetRequested || m_pageFlipPending) {
+        return false;
+    }
+
+    if (plane->next() && plane->next() != plane->current() && m_gpu->deleteBufferAfterPageFlip()) {
+        delete plane->next();
+    }
+    plane->setNext(buffer);
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcX), 0);
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcY), 0);
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcW), buffer->size().width() << 16);
+    plane->setValue(int(DrmPlane::PropertyIndex::SrcH), buffer->size().height() << 16);
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcX), geometry.x());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcY), geometry.y());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcW), geometry.width());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcH), geometry.height());
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcId), m_crtc->id());
+    if (!m_nextPlanesFlipList.contains(plane)) {
+        m_nextPlanesFlipList << plane;
+    }
+
+    if (!doAtomicCommit(AtomicCommitMode::Test)) {
+        // The buffer still belongs to the caller.
+        plane->setNext(nullptr);
+        stageOverlayOff(plane);
+        return false;
+    }
+    return true;
+}
+
+void DrmOutput::clearOverlays()
+{
+    for (DrmPlane *plane : qAsConst(m_overlayPlanes)) {
+        stageOverlayOff(plane);
+    }
+}
+
+void DrmOutput::stageOverlayOff(DrmPlane *plane)
+{
+    if (plane->next() && plane->next() != plane->current() && m_gpu->deleteBufferAfterPageFlip()) {
+        delete plane->next();
+    }
+    plane->setNext(nullptr);
+    plane->setValue(int(DrmPlane::PropertyIndex::CrtcId), 0);
+
+    // Only planes that are currently shown have to be turned off explicitly.
+    if (plane->current()) {
+        if (!m_nextPlanesFlipList.contains(plane)) {
+            m_nextPlanesFlipList << plane;
+        }
+    } else {
+        m_nextPlanesFlipList.removeOne(plane);
+    }
+}
+
+void DrmOutput::discardStagedPlanes()
+{
+    for (DrmPlane *p : qAsConst(m_nextPlanesFlipList)) {
+        // The buffer of the primary plane is owned by the caller of present().
+        if (p != m_primaryPlane && p->next() && p->next() != p->current()
+                && m_gpu->deleteBufferAfterPageFlip()) {
+            delete p->next();
+        }
+        p->setNext(nullptr);
+    }
+    m_nextPlanesFlipList.clear();
+}
+
 bool DrmOutput::dpmsAtomicOff()
 {
     m_atomicOffPending = false;
 
-    // TODO: With multiple planes: deactivate all of them here
+    clearOverlays();
     delete m_primaryPlane->next();
     m_primaryPlane->setNext(nullptr);
-    m_nextPlanesFlipList << m_primaryPlane;
+    if (!m_nextPlanesFlipList.contains(m_primaryPlane)) {
+        m_nextPlanesFlipList << m_primaryPlane;
+    }
 
     if (!doAtomicCommit(AtomicCommitMode::Test)) {
         qCDebug(KWIN_DRM) << "Atomic test commit to Dpms Off failed. Aborting.";
+        discardStagedPlanes();
         return false;
     }
     if (!doAtomicCommit(AtomicCommitMode::Real)) {
@@ -839,9 +962,8 @@ bool DrmOutput::presentAtomically(DrmBuffer *buffer)
     m_nextPlanesFlipList << m_primaryPlane;
 
     if (!doAtomicCommit(AtomicCommitMode::Test)) {
-        //TODO: When we use planes for layered rendering, fallback to renderer instead. Also for direct scanout?
-        //TODO: Probably should undo setNext and reset the flip list
         qCDebug(KWIN_DRM) << "Atomic test commit failed. Aborting present.";
+        discardStagedPlanes();
         // go back to previous state
         if (m_lastWorkingState.valid) {
             m_mode = m_lastWorkingState.mode;
@@ -864,7 +986,6 @@ bool DrmOutput::presentAtomically(DrmBuffer *buffer)
     const bool wasModeset = m_modesetRequested;
     if (!doAtomicCommit(AtomicCommitMode::Real)) {
         qCDebug(KWIN_DRM) << "Atomic commit failed. This should have never happened! Aborting present.";
-        //TODO: Probably should undo setNext and reset the flip list
         return false;
     }
     if (wasModeset) {
@@ -923,9 +1044,6 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
     drmModeAtomicReq *req = drmModeAtomicAlloc();
 
     auto errorHandler = [this, mode, req] () {
-        if (mode == AtomicCommitMode::Test) {
-            // TODO: when we later test overlay planes, make sure we change only the right stuff back
-        }
         if (req) {
             drmModeAtomicFree(req);
         }
@@ -938,12 +1056,11 @@ bool DrmOutput::doAtomicCommit(AtomicCommitMode mode)
             }
         }
 
-        // TODO: see above, rework later for overlay planes!
-        for (DrmPlane *p : m_nextPlanesFlipList) {
-            p->setNext(nullptr);
+        // A failed test commit leaves the staged planes alone, so the caller can try
+        // another configuration, e.g. without one of the overlay planes.
+        if (mode == AtomicCommitMode::Real) {
+            discardStagedPlanes();
         }
-        m_nextPlanesFlipList.clear();
-
     };
 
     if (!req) {
@@ -1038,6 +1155,13 @@ bool DrmOutput::atomicReqModesetPopulate(drmModeAtomicReq *req, bool enable)
         m_primaryPlane->setCurrent(nullptr);
         m_primaryPlane->setNext(nullptr);
 
+        for (DrmPlane *plane : qAsConst(m_overlayPlanes)) {
+            if (m_gpu->deleteBufferAfterPageFlip()) {
+                delete plane->current();
+            }
+            plane->setCurrent(nullptr);
+        }
+
         m_primaryPlane->setValue(int(DrmPlane::PropertyIndex::SrcX), 0);
         m_primaryPlane->setValue(int(DrmPlane::PropertyIndex::SrcY), 0);
         m_primaryPlane->setValue(int(DrmPlane::PropertyIndex::SrcW), 0);
@@ -17,6 +17,7 @@
 
 #include <QObject>
 #include <QPoint>
+#include <QRect>
 #include <QSize>
 #include <QVector>
 #include <xf86drmMode.h>
@@ -52,6 +53,31 @@ public:
     void moveCursor();
     bool init(drmModeConnector *connector);
     bool present(DrmBuffer *buffer);
+    /**
+     * Checks with an atomic test commit whether the given @p buffer can be shown on the
+     * primary plane as is. Unlike a failed present(), a rejected buffer doesn't change the
+     * state of the output, so the caller can composite the frame instead.
+     */
+    bool testPresent(DrmBuffer *buffer);
+    /**
+     * Returns the overlay planes that have been claimed by this output.
+     */
+    QVector<DrmPlane *> overlayPlanes() const {
+        return m_overlayPlanes;
+    }
+    /**
+     * Queues showing the given @p buffer on the overlay @p plane with the next present().
+     * The @p geometry is specified in device pixels relative to the top-left corner of
+     * the output. The configuration is checked with an atomic test commit. If the test
+     * fails, the plane is turned off, @c false is returned and the caller still owns the
+     * buffer; otherwise the output takes the ownership of the buffer.
+     */
+    bool setOverlay(DrmPlane *plane, DrmBuffer *buffer, const QRect &geometry);
+    /**
+     * Queues turning off all overlay planes with the next present(). Buffers that have
+     * been queued with setOverlay() but not presented yet are discarded.
+     */
+    void clearOverlays();
     void pageFlipped();
 
     // These values are defined by the kernel
@@ -123,6 +149,9 @@ private:
     void initUuid();
     bool initPrimaryPlane();
     bool initCursorPlane();
+    bool claimOverlayPlane(DrmPlane *plane);
+    void stageOverlayOff(DrmPlane *plane);
+    void discardStagedPlanes();
 
     void atomicEnable();
     void atomicDisable();
@@ -161,6 +190,7 @@ private:
     uint32_t m_blobId = 0;
     DrmPlane *m_primaryPlane = nullptr;
     DrmPlane *m_cursorPlane = nullptr;
+    QVector<DrmPlane*> m_overlayPlanes;
     QVector<DrmPlane*> m_nextPlanesFlipList;
     bool m_pageFlipPending = false;
     bool m_atomicOffPending = false;
@@ -10,6 +10,8 @@
 // kwin
 #include "composite.h"
 #include "drm_backend.h"
+#include "drm_buffer_gbm.h"
+#include "drm_object_plane.h"
 #include "drm_output.h"
 #include "gbm_surface.h"
 #include "logging.h"
@@ -17,10 +19,15 @@
 #include "renderloop_p.h"
 #include "screens.h"
 #include "drm_gpu.h"
+#include "linux_dmabuf.h"
 // kwin libs
 #include <kwinglplatform.h>
 #include <kwineglimagetexture.h>
+// KWayland
+#include <KWaylandServer/buffer_interface.h>
+#include <KWaylandServer/surface_interface.h>
 // system
+#include <drm_fourcc.h>
 #include <gbm.h>
 #include <unistd.h>
 #include <errno.h>
@@ -30,6 +37,8 @@ namespace KWin
 
 EglGbmBackend::EglGbmBackend(DrmBackend *drmBackend, DrmGpu *gpu)
     : AbstractEglDrmBackend(drmBackend, gpu)
+    , m_directScanoutAllowed(!qEnvironmentVariableIsSet("KWIN_DRM_NO_DIRECT_SCANOUT"))
+    , m_overlayPlanesAllowed(qEnvironmentVariableIsSet("KWIN_DRM_OVERLAY_PLANES"))
 {
 }
 
@@ -498,12 +507,16 @@ bool EglGbmBackend::makeContextCurrent(const Output &output) const
 
 bool EglGbmBackend::initBufferConfigs()
 {
+    // The OpenGL scene can use a depth buffer to reject occluded pixels.
+    const bool depthOcclusion = qgetenv("KWIN_GL_DEPTH_OCCLUSION") == QByteArrayLiteral("1");
+
     const EGLint config_attribs[] = {
         EGL_SURFACE_TYPE,         EGL_WINDOW_BIT,
         EGL_RED_SIZE,             1,
         EGL_GREEN_SIZE,           1,
         EGL_BLUE_SIZE,            1,
         EGL_ALPHA_SIZE,           0,
+        EGL_DEPTH_SIZE,           depthOcclusion ? 16 : 0,
         EGL_RENDERABLE_TYPE,      isOpenGLES() ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_BIT,
         EGL_CONFIG_CAVEAT,        EGL_NONE,
         EGL_NONE,
@@ -679,6 +692,11 @@ void EglGbmBackend::endFrame(int screenId, const QRegion &renderedRegion,
     Output &output = m_outputs[screenId];
     DrmOutput *drmOutput = output.output;
 
+    if (output.directScanout) {
+        qCDebug(KWIN_DRM) << "Direct scanout stopped on output" << drmOutput->name();
+        output.directScanout = false;
+    }
+
     renderFramebufferToSurface(output);
 
     if (!presentOnOutput(output, damagedRegion)) {
@@ -697,6 +715,171 @@ void EglGbmBackend::endFrame(int screenId, const QRegion &renderedRegion,
     }
 }
 
+DrmSurfaceBuffer *EglGbmBackend::importClientBuffer(KWaylandServer::SurfaceInterface *surface,
+                                                    const DrmPlane *plane, const QSize &size) const
+{
+    KWaylandServer::BufferInterface *buffer = surface->buffer();
+    if (!buffer || surface->bufferTransform() != KWaylandServer::OutputInterface::Transform::Normal) {
+        return nullptr;
+    }
+    auto dmabuf = static_cast<DmabufBuffer *>(buffer->linuxDmabufBuffer());
+    if (!dmabuf || dmabuf->size() != size) {
+        return nullptr;
+    }
+
+    const QVector<DmabufBuffer::Plane> planes = dmabuf->planes();
+    const uint64_t modifier = planes.first().modifier;
+    if (!plane->isFormatSupported(dmabuf->format(), modifier)) {
+        return nullptr;
+    }
+    if (modifier != DRM_FORMAT_MOD_INVALID && !m_gpu->addFB2ModifiersSupported()) {
+        return nullptr;
+    }
+
+    gbm_bo *importedBuffer;
+    if (modifier != DRM_FORMAT_MOD_INVALID || planes.count() > 1 || planes.first().offset > 0) {
+        gbm_import_fd_modifier_data data = {};
+        data.width = dmabuf->size().width();
+        data.height = dmabuf->size().height();
+        data.format = dmabuf->format();
+        data.num_fds = planes.count();
+        data.modifier = modifier;
+        for (int i = 0; i < planes.count(); ++i) {
+            data.fds[i] = planes[i].fd;
+            data.strides[i] = planes[i].stride;
+            data.offsets[i] = planes[i].offset;
+        }
+        importedBuffer = gbm_bo_import(m_gpu->gbmDevice(), GBM_BO_IMPORT_FD_MODIFIER, &data, GBM_BO_USE_SCANOUT);
+    } else {
+        gbm_import_fd_data data = {};
+        data.fd = planes.first().fd;
+        data.width = dmabuf->size().width();
+        data.height = dmabuf->size().height();
+        data.stride = planes.first().stride;
+        data.format = dmabuf->format();
+        importedBuffer = gbm_bo_import(m_gpu->gbmDevice(), GBM_BO_IMPORT_FD, &data, GBM_BO_USE_SCANOUT);
+    }
+    if (!importedBuffer) {
+        qCDebug(KWIN_DRM) << "Failed to import a client buffer for scanout:" << strerror(errno);
+        return nullptr;
+    }
+
+    DrmSurfaceBuffer *importedDrmBuffer = new DrmSurfaceBuffer(m_gpu->fd(), importedBuffer, buffer);
+    if (!importedDrmBuffer->bufferId()) {
+        delete importedDrmBuffer;
+        return nullptr;
+    }
+    return importedDrmBuffer;
+}
+
+bool EglGbmBackend::scanout(int screenId, KWaylandServer::SurfaceInterface *surface)
+{
+    if (!m_directScanoutAllowed || !isPrimary()) {
+        return false;
+    }
+
+    Output &output = m_outputs[screenId];
+    DrmOutput *drmOutput = output.output;
+    if (output.onSecondaryGPU || drmOutput->transform() != DrmOutput::Transform::Normal) {
+        return false;
+    }
+
+    DrmSurfaceBuffer *scanoutBuffer = importClientBuffer(surface, drmOutput->primaryPlane(), drmOutput->modeSize());
+    if (!scanoutBuffer) {
+        return false;
+    }
+
+    // The fullscreen window covers everything, including the overlays.
+    drmOutput->clearOverlays();
+    if (!drmOutput->testPresent(scanoutBuffer)) {
+        delete scanoutBuffer;
+        return false;
+    }
+
+    // The commit can still fail even though it has been tested, e.g. if the output has been
+    // turned off meanwhile. The buffer is gone then, composite the frame instead.
+    if (!m_backend->present(scanoutBuffer, drmOutput)) {
+        qCDebug(KWIN_DRM) << "Failed to present a client buffer on output" << drmOutput->name();
+        output.damageHistory.clear();
+        return false;
+    }
+    Q_EMIT drmOutput->outputChange(drmOutput->geometry());
+
+    // The back buffers of the gbm surface don't contain what has been shown meanwhile.
+    output.damageHistory.clear();
+    if (!output.directScanout) {
+        qCDebug(KWIN_DRM) << "Direct scanout started on output" << drmOutput->name();
+        output.directScanout = true;
+    }
+    return true;
+}
+
+bool EglGbmBackend::supportsOverlays(int screenId) const
+{
+    if (!m_overlayPlanesAllowed || !isPrimary()) {
+        return false;
+    }
+    const Output &output = m_outputs[screenId];
+    if (output.onSecondaryGPU || output.output->transform() != DrmOutput::Transform::Normal) {
+        return false;
+    }
+    return !output.output->overlayPlanes().isEmpty();
+}
+
+QRegion EglGbmBackend::assignOverlays(int screenId, const QVector<OverlayCandidate> &candidates)
+{
+    if (!isPrimary()) {
+        return QRegion();
+    }
+
+    // Overlays from the previous frame are assigned from scratch.
+    DrmOutput *drmOutput = m_outputs[screenId].output;
+    drmOutput->clearOverlays();
+
+    if (!supportsOverlays(screenId)) {
+        return QRegion();
+    }
+
+    const QVector<DrmPlane *> planes = drmOutput->overlayPlanes();
+    const QRect outputGeometry = drmOutput->geometry();
+    const qreal scale = drmOutput->scale();
+
+    QRegion assignedRegion;
+    int planeIndex = 0;
+    for (const OverlayCandidate &candidate : candidates) {
+        if (planeIndex == planes.count()) {
+            break;
+        }
+        const QRect deviceGeometry((candidate.geometry.topLeft() - outputGeometry.topLeft()) * scale,
+                                   candidate.geometry.size() * scale);
+
+        DrmPlane *plane = planes[planeIndex];
+
+        // The plane most likely shows the same buffer as in the previous frame, e.g. if
+        // only something else on the output has changed.
+        DrmSurfaceBuffer *buffer = dynamic_cast<DrmSurfaceBuffer *>(plane->current());
+        const bool reused = buffer && buffer->clientBuffer()
+                && buffer->clientBuffer() == candidate.surface->buffer()
+                && buffer->size() == deviceGeometry.size();
+        if (!reused) {
+            buffer = importClientBuffer(candidate.surface, plane, deviceGeometry.size());
+            if (!buffer) {
+                continue;
+            }
+        }
+        if (!drmOutput->setOverlay(plane, buffer, deviceGeometry)) {
+            if (!reused) {
+                delete buffer;
+            }
+            continue;
+        }
+        assignedRegion += candidate.geometry;
+        planeIndex++;
+    }
+
+    return assignedRegion;
+}
+
 QSharedPointer<GLTexture> EglGbmBackend::textureForOutput(AbstractOutput *abstractOutput) const
 {
     const QVector<KWin::EglGbmBackend::Output>::const_iterator itOutput = std::find_if(m_outputs.begin(), m_outputs.end(),
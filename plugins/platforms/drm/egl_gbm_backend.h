@@ -21,6 +21,7 @@ class AbstractOutput;
 class DrmBuffer;
 class DrmSurfaceBuffer;
 class DrmOutput;
+class DrmPlane;
 class GbmSurface;
 
 /**
@@ -48,6 +49,9 @@ public:
     int getDmabufForSecondaryGpuOutput(AbstractOutput *output, uint32_t *format, uint32_t *stride) override;
     void cleanupDmabufForSecondaryGpuOutput(AbstractOutput *output) override;
     QRegion beginFrameForSecondaryGpu(AbstractOutput *output) override;
+    bool scanout(int screenId, KWaylandServer::SurfaceInterface *surface) override;
+    bool supportsOverlays(int screenId) const override;
+    QRegion assignOverlays(int screenId, const QVector<OverlayCandidate> &candidates) override;
 
 protected:
     void cleanupSurfaces() override;
@@ -79,6 +83,11 @@ private:
         int dmabufFd = 0;
         gbm_bo *secondaryGbmBo = nullptr;
         gbm_bo *importedGbmBo = nullptr;
+
+        /**
+         * Whether the last frame has been presented with direct scanout.
+         */
+        bool directScanout = false;
     };
 
     bool resetOutput(Output &output, DrmOutput *drmOutput);
@@ -96,12 +105,16 @@ private:
     QRegion prepareRenderingForOutput(const Output &output) const;
 
     bool presentOnOutput(Output &output, const QRegion &damagedRegion);
+    DrmSurfaceBuffer *importClientBuffer(KWaylandServer::SurfaceInterface *surface,
+                                         const DrmPlane *plane, const QSize &size) const;
 
     void cleanupOutput(Output &output);
     void cleanupFramebuffer(Output &output);
 
     QVector<Output> m_outputs;
     QVector<Output> m_secondaryGpuOutputs;
+    bool m_directScanoutAllowed;
+    bool m_overlayPlanesAllowed;
 
     friend class EglGbmTexture;
 };
@@ -119,12 +119,16 @@ bool EglGbmBackend::initRenderingContext()
 
 bool EglGbmBackend::initBufferConfigs()
 {
+    // The OpenGL scene can use a depth buffer to reject occluded pixels.
+    const bool depthOcclusion = qgetenv("KWIN_GL_DEPTH_OCCLUSION") == QByteArrayLiteral("1");
+
     const EGLint config_attribs[] = {
         EGL_SURFACE_TYPE,         EGL_WINDOW_BIT,
         EGL_RED_SIZE,             1,
         EGL_GREEN_SIZE,           1,
         EGL_BLUE_SIZE,            1,
         EGL_ALPHA_SIZE,           0,
+        EGL_DEPTH_SIZE,           depthOcclusion ? 16 : 0,
         EGL_RENDERABLE_TYPE,      isOpenGLES() ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_BIT,
         EGL_CONFIG_CAVEAT,        EGL_NONE,
         EGL_NONE,
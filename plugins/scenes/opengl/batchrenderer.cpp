@@ -0,0 +1,337 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "batchrenderer.h"
+#include "logging.h"
+
+#include "kwinglplatform.h"
+
+#include <QTextStream>
+
+#include <cstring>
+
+namespace KWin
+{
+
+BatchRenderer::BatchRenderer()
+{
+    GLint textureUnitCount = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnitCount);
+    m_textureUnitCount = qBound(1, textureUnitCount, s_maxTextureUnitCount);
+
+    m_shader.reset(ShaderManager::instance()->generateCustomShader(ShaderTrait::MapTexture,
+                                                                   generateVertexSource(),
+                                                                   generateFragmentSource()));
+    if (!m_shader->isValid()) {
+        qCWarning(KWIN_OPENGL) << "Failed to compile the batch shader";
+        return;
+    }
+
+    // The samplers are bound to fixed texture units, no need to set them every frame.
+    ShaderManager::instance()->pushShader(m_shader.data());
+    for (int i = 0; i < m_textureUnitCount; ++i) {
+        const QByteArray name = QByteArrayLiteral("sampler") + QByteArray::number(i);
+        m_shader->setUniform(name.constData(), i);
+    }
+    ShaderManager::instance()->popShader();
+
+    qCDebug(KWIN_OPENGL) << "Batched rendering uses" << m_textureUnitCount << "texture units";
+}
+
+BatchRenderer::~BatchRenderer()
+{
+}
+
+bool BatchRenderer::isValid() const
+{
+    return m_shader->isValid();
+}
+
+bool BatchRenderer::canBatch(const GLTexture *texture)
+{
+    // External textures need a different sampler type.
+    return texture->target() == GL_TEXTURE_2D;
+}
+
+QByteArray BatchRenderer::generateVertexSource() const
+{
+    QByteArray source;
+    QTextStream stream(&source);
+
+    GLPlatform * const gl = GLPlatform::instance();
+    bool modern;
+    if (!gl->isGLES()) {
+        modern = gl->glslVersion() >= kVersionNumber(1, 40);
+        if (modern) {
+            stream << "#version 140\n\n";
+        }
+    } else {
+        modern = gl->glslVersion() >= kVersionNumber(3, 0);
+        if (modern) {
+            stream << "#version 300 es\n\n";
+        }
+    }
+
+    const QByteArray attribute = modern ? QByteArrayLiteral("in") : QByteArrayLiteral("attribute");
+    const QByteArray varying = modern ? QByteArrayLiteral("out") : QByteArrayLiteral("varying");
+
+    stream << attribute << " vec4 position;\n";
+    stream << attribute << " vec4 texcoord;\n\n";
+    stream << varying << " vec4 texcoord0;\n\n";
+    stream << "uniform mat4 modelViewProjectionMatrix;\n\n";
+    stream << "void main()\n{\n";
+    stream << "    texcoord0 = texcoord;\n";
+    stream << "    gl_Position = modelViewProjectionMatrix * vec4(position.xy, 0.0, 1.0);\n";
+    // The depth is specified in normalized device coordinates.
+    stream << "    gl_Position.z = position.z * gl_Position.w;\n";
+    stream << "}\n";
+
+    stream.flush();
+    return source;
+}
+
+QByteArray BatchRenderer::generateFragmentSource() const
+{
+    QByteArray source;
+    QTextStream stream(&source);
+
+    GLPlatform * const gl = GLPlatform::instance();
+    bool modern;
+    if (!gl->isGLES()) {
+        modern = gl->glslVersion() >= kVersionNumber(1, 40);
+        if (modern) {
+            stream << "#version 140\n\n";
+        }
+    } else {
+        modern = gl->glslVersion() >= kVersionNumber(3, 0);
+        if (modern) {
+            stream << "#version 300 es\n\n";
+        }
+        stream << "precision highp float;\n\n";
+    }
+
+    const QByteArray varying = modern ? QByteArrayLiteral("in") : QByteArrayLiteral("varying");
+    const QByteArray textureLookup = modern ? QByteArrayLiteral("texture") : QByteArrayLiteral("texture2D");
+    const QByteArray output = modern ? QByteArrayLiteral("fragColor") : QByteArrayLiteral("gl_FragColor");
+
+    for (int i = 0; i < m_textureUnitCount; ++i) {
+        stream << "uniform sampler2D sampler" << i << ";\n";
+    }
+    stream << "\n" << varying << " vec4 texcoord0;\n";
+    if (modern) {
+        stream << "\nout vec4 " << output << ";\n";
+    }
+
+    // GLSL ES 1.00 doesn't allow indexing sampler arrays with non-constant expressions,
+    // so the sampler is picked with a chain of branches. The texture unit is the same for
+    // all fragments of a quad, so the branches don't diverge except along window edges.
+    stream << "\nvoid main(void)\n{\n";
+    stream << "    vec4 texel;\n";
+    if (m_textureUnitCount == 1) {
+        stream << "    texel = " << textureLookup << "(sampler0, texcoord0.st);\n";
+    } else {
+        for (int i = 0; i < m_textureUnitCount; ++i) {
+            if (i == 0) {
+                stream << "    if (texcoord0.z < 0.5) {\n";
+            } else if (i == m_textureUnitCount - 1) {
+                stream << "    } else {\n";
+            } else {
+                stream << "    } else if (texcoord0.z < " << i << ".5) {\n";
+            }
+            stream << "        texel = " << textureLookup << "(sampler" << i << ", texcoord0.st);\n";
+        }
+        stream << "    }\n";
+    }
+    stream << "    if (texcoord0.w > 0.5) {\n";
+    stream << "        texel.a = 1.0;\n";
+    stream << "    }\n";
+    stream << "    " << output << " = texel;\n";
+    stream << "}\n";
+
+    stream.flush();
+    return source;
+}
+
+void BatchRenderer::begin(const QMatrix4x4 &projectionMatrix, GLenum filter)
+{
+    Q_ASSERT(!m_active);
+    m_projectionMatrix = projectionMatrix;
+    m_filter = filter;
+    m_renderTarget = GLRenderTarget::currentRenderTarget();
+    m_active = true;
+}
+
+void BatchRenderer::end()
+{
+    Q_ASSERT(m_active);
+    flush();
+    m_active = false;
+    m_depthTest = false;
+}
+
+void BatchRenderer::setDepthTestEnabled(bool enabled)
+{
+    m_depthTest = enabled;
+}
+
+bool BatchRenderer::isActive() const
+{
+    return m_active;
+}
+
+GLRenderTarget *BatchRenderer::renderTarget() const
+{
+    return m_renderTarget;
+}
+
+BatchRenderer::Batch &BatchRenderer::batchForTexture(GLTexture *texture, int *unit)
+{
+    if (!m_batches.isEmpty()) {
+        Batch &batch = m_batches.last();
+        for (int i = 0; i < batch.textureCount; ++i) {
+            if (batch.textures[i] == texture) {
+                *unit = i;
+                return batch;
+            }
+        }
+        if (batch.textureCount < m_textureUnitCount) {
+            *unit = batch.textureCount;
+            batch.textures[batch.textureCount++] = texture;
+            return batch;
+        }
+    }
+
+    Batch batch;
+    batch.textures[0] = texture;
+    batch.textureCount = 1;
+    batch.firstVertex = m_vertices.count();
+    batch.vertexCount = 0;
+    m_batches.append(batch);
+
+    *unit = 0;
+    return m_batches.last();
+}
+
+void BatchRenderer::addQuads(GLTexture *texture, const WindowQuadList &quads,
+                             const QMatrix4x4 &textureMatrix, const QPointF &offset, bool opaque, float depth)
+{
+    Q_ASSERT(m_active);
+    if (quads.isEmpty()) {
+        return;
+    }
+
+    int unit;
+    Batch &batch = batchForTexture(texture, &unit);
+
+    // The texture matrix only scales and translates, see WindowQuadList::makeInterleavedArrays().
+    const QVector2D coeff(textureMatrix(0, 0), textureMatrix(1, 1));
+    const QVector2D textureOffset(textureMatrix(0, 3), textureMatrix(1, 3));
+
+    const int first = m_vertices.count();
+    m_vertices.resize(first + quads.count() * 6);
+    Vertex *vertex = m_vertices.data() + first;
+
+    for (const WindowQuad &quad : quads) {
+        Vertex v[4];
+        for (int j = 0; j < 4; ++j) {
+            const WindowVertex &wv = quad[j];
+            const QVector2D texcoord = QVector2D(wv.u(), wv.v()) * coeff + textureOffset;
+            v[j].position = QVector3D(wv.x() + offset.x(), wv.y() + offset.y(), depth);
+            v[j].texcoord = QVector4D(texcoord.x(), texcoord.y(), unit, opaque ? 1 : 0);
+        }
+
+        // First triangle
+        *(vertex++) = v[1]; // Top-right
+        *(vertex++) = v[0]; // Top-left
+        *(vertex++) = v[3]; // Bottom-left
+
+        // Second triangle
+        *(vertex++) = v[3]; // Bottom-left
+        *(vertex++) = v[2]; // Bottom-right
+        *(vertex++) = v[1]; // Top-right
+    }
+
+    batch.vertexCount += quads.count() * 6;
+}
+
+void BatchRenderer::addWindow()
+{
+    m_windowCount++;
+}
+
+int BatchRenderer::windowCount() const
+{
+    return m_windowCount;
+}
+
+int BatchRenderer::flush()
+{
+    if (m_batches.isEmpty()) {
+        m_windowCount = 0;
+        return 0;
+    }
+
+    const GLVertexAttrib attribs[] = {
+        { VA_Position, 3, GL_FLOAT, offsetof(Vertex, position) },
+        { VA_TexCoord, 4, GL_FLOAT, offsetof(Vertex, texcoord) },
+    };
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setAttribLayout(attribs, 2, sizeof(Vertex));
+
+    const size_t size = m_vertices.count() * sizeof(Vertex);
+    void *map = vbo->map(size);
+    memcpy(map, m_vertices.constData(), size);
+    vbo->unmap();
+    vbo->bindArrays();
+
+    ShaderManager::instance()->pushShader(m_shader.data());
+    m_shader->setUniform(GLShader::ModelViewProjectionMatrix, m_projectionMatrix);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    if (m_depthTest) {
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+    }
+
+    for (const Batch &batch : qAsConst(m_batches)) {
+        for (int i = 0; i < batch.textureCount; ++i) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            batch.textures[i]->setFilter(m_filter);
+            batch.textures[i]->setWrapMode(GL_CLAMP_TO_EDGE);
+            batch.textures[i]->bind();
+        }
+        vbo->draw(GL_TRIANGLES, batch.firstVertex, batch.vertexCount);
+    }
+
+    // Other code expects the first texture unit to be active.
+    for (int i = m_textureUnitCount - 1; i >= 0; --i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    glDisable(GL_BLEND);
+    if (m_depthTest) {
+        glDisable(GL_DEPTH_TEST);
+    }
+
+    ShaderManager::instance()->popShader();
+    vbo->unbindArrays();
+
+    const int drawCallCount = m_batches.count();
+    m_vertices.clear();
+    m_batches.clear();
+    m_windowCount = 0;
+
+    return drawCallCount;
+}
+
+} // namespace KWin
@@ -0,0 +1,140 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwineffects.h"
+#include "kwinglutils.h"
+
+#include <QMatrix4x4>
+#include <QScopedPointer>
+#include <QVector>
+#include <QVector2D>
+#include <QVector3D>
+#include <QVector4D>
+
+namespace KWin
+{
+
+/**
+ * The BatchRenderer class paints the geometry of several windows with a single draw call.
+ *
+ * Window textures usually have different sizes, so they cannot be put in one texture
+ * array. Instead, every vertex carries the index of the texture unit that its texture is
+ * bound to and the fragment shader picks the matching sampler. Textures are assigned to
+ * texture units in the order in which they are added. When all texture units are taken,
+ * a new batch is started, which costs an extra draw call.
+ *
+ * The batch renderer can paint only untransformed geometry with the default shader, i.e.
+ * without opacity, brightness or saturation adjustments. Callers must flush the batch
+ * before painting anything that is not batched.
+ */
+class BatchRenderer
+{
+public:
+    BatchRenderer();
+    ~BatchRenderer();
+
+    /**
+     * Returns @c true if the batch shader has been compiled successfully.
+     */
+    bool isValid() const;
+
+    /**
+     * Returns @c true if the given @p texture can be painted by the batch renderer.
+     */
+    static bool canBatch(const GLTexture *texture);
+
+    /**
+     * Starts collecting geometry. @p projectionMatrix maps the global coordinates to clip
+     * space, and @p filter is the filter that will be used for all textures. The batch is
+     * painted into the render target that is bound at this point.
+     */
+    void begin(const QMatrix4x4 &projectionMatrix, GLenum filter);
+
+    /**
+     * Paints all collected geometry and stops collecting.
+     */
+    void end();
+
+    /**
+     * Returns @c true between begin() and end().
+     */
+    bool isActive() const;
+
+    /**
+     * Returns the render target that was bound when begin() was called, or @c null if it
+     * was the default framebuffer. Only geometry that would be painted into that render
+     * target can be added to the batch.
+     */
+    GLRenderTarget *renderTarget() const;
+
+    /**
+     * Sets whether fragments that fail the depth test are rejected. This is reset by end().
+     */
+    void setDepthTestEnabled(bool enabled);
+
+    /**
+     * Adds the given @p quads to the batch. The quads are translated by @p offset, and their
+     * texture coordinates are transformed with the @p textureMatrix. If @p opaque is @c true,
+     * the alpha channel of the texture is ignored. @p depth is the normalized device depth
+     * of the quads, it matters only if the depth test is enabled.
+     */
+    void addQuads(GLTexture *texture, const WindowQuadList &quads, const QMatrix4x4 &textureMatrix,
+                  const QPointF &offset, bool opaque, float depth = 0);
+
+    /**
+     * Marks the end of the geometry of a window. This is only used for statistics.
+     */
+    void addWindow();
+
+    /**
+     * Paints all collected geometry. Returns the number of issued draw calls.
+     */
+    int flush();
+
+    /**
+     * Returns the number of windows that have been added since the last flush().
+     */
+    int windowCount() const;
+
+private:
+    static constexpr int s_maxTextureUnitCount = 8;
+
+    struct Vertex
+    {
+        QVector3D position; // x, y, depth
+        QVector4D texcoord; // s, t, texture unit, opaque
+    };
+
+    struct Batch
+    {
+        GLTexture *textures[s_maxTextureUnitCount];
+        int textureCount;
+        int firstVertex;
+        int vertexCount;
+    };
+
+    Batch &batchForTexture(GLTexture *texture, int *unit);
+    QByteArray generateVertexSource() const;
+    QByteArray generateFragmentSource() const;
+
+    QScopedPointer<GLShader> m_shader;
+    QVector<Vertex> m_vertices;
+    QVector<Batch> m_batches;
+    QMatrix4x4 m_projectionMatrix;
+    GLRenderTarget *m_renderTarget = nullptr;
+    GLenum m_filter = GL_LINEAR;
+    int m_textureUnitCount = 0;
+    int m_windowCount = 0;
+    bool m_active = false;
+    bool m_depthTest = false;
+};
+
+} // namespace KWin
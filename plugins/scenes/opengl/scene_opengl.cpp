@@ -19,7 +19,9 @@
 #include "scene_opengl.h"
 #include "texture.h"
 
+#include "abstract_output.h"
 #include "platform.h"
+#include "renderloop_p.h"
 #include "wayland_server.h"
 
 #include <kwinglplatform.h>
@@ -27,13 +29,16 @@
 
 #include "utils.h"
 #include "x11client.h"
+#include "batchrenderer.h"
 #include "composite.h"
 #include "deleted.h"
 #include "effects.h"
+#include "framearena.h"
 #include "lanczosfilter.h"
 #include "main.h"
 #include "overlaywindow.h"
 #include "screens.h"
+#include "textureatlas.h"
 #include "cursor.h"
 #include "decorations/decoratedclient.h"
 #include <logging.h>
@@ -53,9 +58,12 @@
 #include <QGraphicsScale>
 #include <QPainter>
 #include <QStringList>
+#include <QTimer>
 #include <QVector2D>
 #include <QVector4D>
 #include <QMatrix4x4>
+#include <QPointer>
+#include <QVarLengthArray>
 
 #include <KLocalizedString>
 #include <KNotification>
@@ -291,6 +299,139 @@ bool SyncManager::updateFences()
 }
 
 
+// -----------------------------------------------------------------------
+
+
+/**
+ * RenderTimeQuery measures when the GPU has finished executing the commands of a frame
+ * by placing a GL_TIMESTAMP query at the end of the command stream. The GPU timestamp is
+ * translated to the monotonic clock and reported to the RenderLoop that requested the frame.
+ */
+class RenderTimeQuery
+{
+public:
+    RenderTimeQuery();
+    ~RenderTimeQuery();
+
+    bool isPending() const { return m_pending; }
+
+    void begin(RenderLoop *renderLoop);
+    void end();
+    bool collect();
+
+private:
+    GLuint m_query = 0;
+    std::chrono::nanoseconds m_clockOffset = std::chrono::nanoseconds::zero();
+    QPointer<RenderLoop> m_renderLoop;
+    quint64 m_sequence = 0;
+    bool m_pending = false;
+};
+
+RenderTimeQuery::RenderTimeQuery()
+{
+    glGenQueries(1, &m_query);
+}
+
+RenderTimeQuery::~RenderTimeQuery()
+{
+    glDeleteQueries(1, &m_query);
+}
+
+void RenderTimeQuery::begin(RenderLoop *renderLoop)
+{
+    Q_ASSERT(!m_pending);
+
+    GLint64 gpuTimestamp = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTimestamp);
+    const std::chrono::nanoseconds cpuTimestamp = std::chrono::steady_clock::now().time_since_epoch();
+
+    m_clockOffset = cpuTimestamp - std::chrono::nanoseconds(gpuTimestamp);
+    m_renderLoop = renderLoop;
+    m_sequence = RenderLoopPrivate::get(renderLoop)->renderJournal.frameCount();
+}
+
+void RenderTimeQuery::end()
+{
+    glQueryCounter(m_query, GL_TIMESTAMP);
+    m_pending = true;
+}
+
+bool RenderTimeQuery::collect()
+{
+    if (!m_pending) {
+        return true;
+    }
+
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(m_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+
+    GLuint64 gpuTimestamp = 0;
+    glGetQueryObjectui64v(m_query, GL_QUERY_RESULT, &gpuTimestamp);
+    m_pending = false;
+
+    if (m_renderLoop) {
+        const std::chrono::nanoseconds timestamp = std::chrono::nanoseconds(gpuTimestamp) + m_clockOffset;
+        RenderLoopPrivate::get(m_renderLoop)->notifyFrameRendered(m_sequence, timestamp);
+    }
+    return true;
+}
+
+
+// -----------------------------------------------------------------------
+
+
+/**
+ * RenderTimeQueryPool manages a set of timestamp queries, so several frames can be in
+ * flight without waiting for the GPU.
+ */
+class RenderTimeQueryPool
+{
+public:
+    enum { MaxQueries = 4 };
+
+    static bool isSupported();
+
+    RenderTimeQuery *begin(RenderLoop *renderLoop);
+    void collect();
+
+private:
+    std::array<RenderTimeQuery, MaxQueries> m_queries;
+};
+
+bool RenderTimeQueryPool::isSupported()
+{
+    if (GLPlatform::instance()->isGLES()) {
+        return false;
+    }
+    return hasGLVersion(3, 3) || hasGLExtension(QByteArrayLiteral("GL_ARB_timer_query"));
+}
+
+RenderTimeQuery *RenderTimeQueryPool::begin(RenderLoop *renderLoop)
+{
+    collect();
+
+    for (RenderTimeQuery &query : m_queries) {
+        if (!query.isPending()) {
+            query.begin(renderLoop);
+            return &query;
+        }
+    }
+
+    // The GPU is lagging behind by more than MaxQueries frames, skip the measurement.
+    return nullptr;
+}
+
+void RenderTimeQueryPool::collect()
+{
+    for (RenderTimeQuery &query : m_queries) {
+        query.collect();
+    }
+}
+
+
 // -----------------------------------------------------------------------
 
 /************************************************
@@ -303,11 +444,13 @@ SceneOpenGL::SceneOpenGL(OpenGLBackend *backend, QObject *parent)
     , m_backend(backend)
     , m_syncManager(nullptr)
     , m_currentFence(nullptr)
+    , m_renderTimeQueries(nullptr)
 {
     if (m_backend->isFailed()) {
         init_ok = false;
         return;
     }
+    m_textureAtlas = new TextureAtlas(this);
     if (!viewportLimitsMatched(screens()->size()))
         return;
 
@@ -347,6 +490,13 @@ SceneOpenGL::SceneOpenGL(OpenGLBackend *backend, QObject *parent)
             qCDebug(KWIN_OPENGL) << "Explicit synchronization with the X command stream disabled by environment variable";
         }
     }
+
+    // Without timer queries, the render journal falls back to CPU render times.
+    if (RenderTimeQueryPool::isSupported()) {
+        m_renderTimeQueries = new RenderTimeQueryPool;
+    } else {
+        qCDebug(KWIN_OPENGL) << "Timer queries are not supported, GPU render times will not be measured";
+    }
 }
 
 SceneOpenGL::~SceneOpenGL()
@@ -356,7 +506,9 @@ SceneOpenGL::~SceneOpenGL()
     }
     SceneOpenGL::EffectFrame::cleanup();
 
+    delete m_textureAtlas;
     delete m_syncManager;
+    delete m_renderTimeQueries;
 
     // backend might be still needed for a different scene
     delete m_backend;
@@ -601,6 +753,14 @@ void SceneOpenGL::aboutToStartPainting(int screenId, const QRegion &damage)
     m_backend->aboutToStartPainting(screenId, damage);
 }
 
+static RenderLoop *renderLoopForScreen(int screenId)
+{
+    if (screenId == -1) {
+        return kwinApp()->platform()->renderLoop();
+    }
+    return kwinApp()->platform()->enabledOutputs().at(screenId)->renderLoop();
+}
+
 void SceneOpenGL::paint(int screenId, const QRegion &damage, const QList<Toplevel *> &toplevels,
                         std::chrono::milliseconds presentTime)
 {
@@ -609,9 +769,47 @@ void SceneOpenGL::paint(int screenId, const QRegion &damage, const QList<Topleve
     }
 
     painted_screen = screenId;
+    m_frameStatistics = FrameStatistics();
     // actually paint the frame, flushed with the NEXT frame
     createStackingOrder(toplevels);
 
+    if (screenId != -1) {
+        if (Window *window = findScanoutCandidate(screenId)) {
+            if (m_backend->scanout(screenId, window->window()->surface())) {
+                if (makeOpenGLContextCurrent()) {
+                    static_cast<OpenGLWindow *>(window)->updateTexture();
+                }
+                RenderLoopPrivate::get(renderLoopForScreen(screenId))->renderJournal.markDirectScanout();
+                m_overlayRegions.remove(screenId);
+                skipPaintScreen(presentTime);
+                clearStackingOrder();
+                return;
+            }
+        }
+    }
+
+    // Surfaces on overlay planes are not painted. The area that they leave behind has
+    // to be repainted though.
+    QRegion overlayRegion;
+    QRegion releasedRegion;
+    QVector<OpenGLBackend::OverlayCandidate> overlayCandidates;
+    QVector<Window *> overlayWindows;
+    if (screenId != -1) {
+        if (m_backend->supportsOverlays(screenId)) {
+            overlayCandidates = findOverlayCandidates(screenId, &overlayWindows);
+        }
+        // The overlays of the previous frame have to be turned off, too.
+        if (!overlayCandidates.isEmpty() || m_overlayRegions.contains(screenId)) {
+            overlayRegion = m_backend->assignOverlays(screenId, overlayCandidates);
+        }
+        releasedRegion = m_overlayRegions.value(screenId) - overlayRegion;
+        if (overlayRegion.isEmpty()) {
+            m_overlayRegions.remove(screenId);
+        } else {
+            m_overlayRegions.insert(screenId, overlayRegion);
+        }
+    }
+
     QRegion update;
     QRegion valid;
     QRegion repaint;
@@ -620,6 +818,16 @@ void SceneOpenGL::paint(int screenId, const QRegion &damage, const QList<Topleve
 
     // prepare rendering makes context current on the output
     repaint = m_backend->beginFrame(screenId);
+
+    // The windows on overlay planes may not be painted at all. Their textures are needed
+    // as soon as they are composited again though.
+    if (!overlayRegion.isEmpty()) {
+        for (int i = 0; i < overlayCandidates.count(); ++i) {
+            if (overlayRegion.intersects(overlayCandidates[i].geometry)) {
+                static_cast<OpenGLWindow *>(overlayWindows[i])->updateTexture();
+            }
+        }
+    }
     if (screenId != -1) {
         geo = screens()->geometry(screenId);
         scaling = screens()->scale(screenId);
@@ -637,11 +845,16 @@ void SceneOpenGL::paint(int screenId, const QRegion &damage, const QList<Topleve
     if (status != GL_NO_ERROR) {
         handleGraphicsReset(status);
     } else {
+        RenderTimeQuery *renderTimeQuery = nullptr;
+        if (m_renderTimeQueries) {
+            renderTimeQuery = m_renderTimeQueries->begin(renderLoopForScreen(screenId));
+        }
+
         int mask = 0;
         updateProjectionMatrix();
 
-        paintScreen(&mask, damage.intersected(geo), repaint, &update, &valid,
-                    presentTime, projectionMatrix(), geo, scaling);   // call generic implementation
+        paintScreen(&mask, (damage.intersected(geo) | releasedRegion) - overlayRegion, repaint - overlayRegion,
+                    &update, &valid, presentTime, projectionMatrix(), geo, scaling);   // call generic implementation
         paintCursor(valid);
 
         if (!GLPlatform::instance()->isGLES() && screenId == -1) {
@@ -659,6 +872,10 @@ void SceneOpenGL::paint(int screenId, const QRegion &damage, const QList<Topleve
             }
         }
 
+        if (renderTimeQuery) {
+            renderTimeQuery->end();
+        }
+
         GLVertexBuffer::streamingBuffer()->endOfFrame();
         m_backend->endFrame(screenId, valid, update);
         GLVertexBuffer::streamingBuffer()->framePosted();
@@ -678,6 +895,137 @@ void SceneOpenGL::paint(int screenId, const QRegion &damage, const QList<Topleve
     clearStackingOrder();
 }
 
+/**
+ * Returns the window whose buffer can be presented on the screen with the given @p screenId
+ * as is, or @c null if the screen has to be composited.
+ */
+Scene::Window *SceneOpenGL::findScanoutCandidate(int screenId) const
+{
+    if (static_cast<EffectsHandlerImpl *>(effects)->blocksDirectScanout()) {
+        return nullptr;
+    }
+
+    const QRect screenGeometry = screens()->geometry(screenId);
+
+    // The software cursor is painted on top of the windows.
+    if (kwinApp()->platform()->usesSoftwareCursor() && !kwinApp()->platform()->isCursorHidden()) {
+        if (Cursors::self()->currentCursor()->geometry().intersects(screenGeometry)) {
+            return nullptr;
+        }
+    }
+
+    for (int i = stacking_order.count() - 1; i >= 0; --i) {
+        Window *window = stacking_order[i];
+        Toplevel *toplevel = window->window();
+        if (!toplevel->isOnScreen(screenId) || !window->isVisible() || toplevel->opacity() == 0) {
+            continue;
+        }
+
+        // Only the topmost window can be scanned out, and only if it covers the whole screen.
+        AbstractClient *client = qobject_cast<AbstractClient *>(toplevel);
+        if (!client || !client->isFullScreen() || !window->isOpaque()) {
+            return nullptr;
+        }
+        if (client->bufferGeometry() != screenGeometry) {
+            return nullptr;
+        }
+        KWaylandServer::SurfaceInterface *surface = client->surface();
+        if (!surface || !surface->childSubSurfaces().isEmpty()) {
+            return nullptr;
+        }
+        return window;
+    }
+
+    return nullptr;
+}
+
+static bool isOverlaySurface(KWaylandServer::SurfaceInterface *surface, const QRect &geometry)
+{
+    KWaylandServer::BufferInterface *buffer = surface->buffer();
+    if (!buffer || !buffer->linuxDmabufBuffer()) {
+        return false;
+    }
+    if (surface->bufferTransform() != KWaylandServer::OutputInterface::Transform::Normal) {
+        return false;
+    }
+    // Overlay planes are stacked above the primary plane, so the surface must not be
+    // blended with the windows below it.
+    if (buffer->hasAlphaChannel() && !surface->opaque().contains(QRect(QPoint(0, 0), geometry.size()))) {
+        return false;
+    }
+    // Scaled buffers are not worth the trouble, not all planes can scale.
+    return buffer->size() == geometry.size() * surface->bufferScale();
+}
+
+static void collectOverlayCandidates(KWaylandServer::SurfaceInterface *surface, const QPoint &position,
+                                     const QRect &screenGeometry, QRegion *occluded,
+                                     QVector<OpenGLBackend::OverlayCandidate> *candidates)
+{
+    if (!surface->buffer()) {
+        return; // unmapped, so are its subsurfaces
+    }
+
+    // Subsurfaces above the parent come first, the candidates are ordered top to bottom.
+    const auto subSurfaces = surface->childSubSurfaces();
+    for (int i = subSurfaces.count() - 1; i >= 0; --i) {
+        const QPointer<KWaylandServer::SubSurfaceInterface> &subSurface = subSurfaces[i];
+        if (subSurface && subSurface->surface()) {
+            collectOverlayCandidates(subSurface->surface(), position + subSurface->position(),
+                                     screenGeometry, occluded, candidates);
+        }
+    }
+
+    const QRect geometry(position, surface->size());
+    if (screenGeometry.contains(geometry) && !occluded->intersects(geometry)
+            && isOverlaySurface(surface, geometry)) {
+        candidates->append({ surface, geometry });
+    }
+    *occluded += geometry;
+}
+
+/**
+ * Returns the surfaces that can be shown on hardware overlay planes on the screen with
+ * the given @p screenId, ordered from top to bottom. A surface qualifies if it has an
+ * opaque dmabuf buffer and nothing is painted above it. The window of each candidate is
+ * appended to @p windows.
+ */
+QVector<OpenGLBackend::OverlayCandidate> SceneOpenGL::findOverlayCandidates(int screenId, QVector<Window *> *windows) const
+{
+    QVector<OpenGLBackend::OverlayCandidate> candidates;
+    if (static_cast<EffectsHandlerImpl *>(effects)->blocksDirectScanout()) {
+        return candidates;
+    }
+
+    const QRect screenGeometry = screens()->geometry(screenId);
+
+    // The software cursor is painted on top of the windows.
+    QRegion occluded;
+    if (kwinApp()->platform()->usesSoftwareCursor() && !kwinApp()->platform()->isCursorHidden()) {
+        occluded = Cursors::self()->currentCursor()->geometry();
+    }
+
+    for (int i = stacking_order.count() - 1; i >= 0; --i) {
+        Window *window = stacking_order[i];
+        Toplevel *toplevel = window->window();
+        if (!toplevel->isOnScreen(screenId) || !window->isVisible() || toplevel->opacity() == 0) {
+            continue;
+        }
+        if (KWaylandServer::SurfaceInterface *surface = toplevel->surface()) {
+            if (toplevel->opacity() == 1.0) {
+                collectOverlayCandidates(surface, toplevel->bufferGeometry().topLeft(),
+                                         screenGeometry, &occluded, &candidates);
+                while (windows->count() < candidates.count()) {
+                    windows->append(window);
+                }
+            }
+        }
+        // Decorations and shadows are painted too.
+        occluded += toplevel->visibleRect();
+    }
+
+    return candidates;
+}
+
 QMatrix4x4 SceneOpenGL::transformation(int mask, const ScreenPaintData &data) const
 {
     QMatrix4x4 matrix;
@@ -869,9 +1217,69 @@ QSharedPointer<GLTexture> SceneOpenGL::textureForOutput(AbstractOutput* output)
     return m_backend->textureForOutput(output);
 }
 
+Scene::FrameStatistics SceneOpenGL::frameStatistics() const
+{
+    FrameStatistics statistics = m_frameStatistics;
+    if (m_textureAtlas) {
+        statistics.atlasPageCount = m_textureAtlas->pageCount();
+        statistics.atlasDedicatedTextureCount = m_textureAtlas->dedicatedTextureCount();
+        statistics.atlasTexelCount = m_textureAtlas->texelCount();
+        statistics.atlasUsedTexelCount = m_textureAtlas->usedTexelCount();
+    }
+    return statistics;
+}
+
+void SceneOpenGL::addDrawCalls(int count)
+{
+    m_frameStatistics.drawCallCount += count;
+}
+
+TextureAtlas *SceneOpenGL::textureAtlas() const
+{
+    return m_textureAtlas;
+}
+
 //****************************************
 // SceneOpenGL2
 //****************************************
+
+/**
+ * Returns the given projection @p matrix adjusted so that all geometry ends up at
+ * the specified normalized device @p depth.
+ */
+static QMatrix4x4 depthMatrix(float depth, const QMatrix4x4 &matrix)
+{
+    QMatrix4x4 result = matrix;
+    // z = depth * w, so the depth is preserved by the perspective division.
+    result.setRow(2, matrix.row(3) * depth);
+    return result;
+}
+
+static int framebufferDepthSize()
+{
+    if (!hasGLVersion(3, 0)) {
+        GLint depthBits = 0;
+        glGetIntegerv(GL_DEPTH_BITS, &depthBits);
+        return depthBits;
+    }
+
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    const GLenum attachment = framebuffer ? GL_DEPTH_ATTACHMENT : GL_DEPTH;
+
+    GLint objectType = GL_NONE;
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, attachment,
+                                          GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &objectType);
+    if (objectType == GL_NONE) {
+        return 0;
+    }
+
+    GLint depthSize = 0;
+    glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, attachment,
+                                          GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthSize);
+    return depthSize;
+}
+
 bool SceneOpenGL2::supported(OpenGLBackend *backend)
 {
     const QByteArray forceEnv = qgetenv("KWIN_COMPOSE");
@@ -897,6 +1305,8 @@ bool SceneOpenGL2::supported(OpenGLBackend *backend)
 SceneOpenGL2::SceneOpenGL2(OpenGLBackend *backend, QObject *parent)
     : SceneOpenGL(backend, parent)
     , m_lanczosFilter(nullptr)
+    , m_batchedRendering(qgetenv("KWIN_GL_BATCHED_RENDERING") == QByteArrayLiteral("1"))
+    , m_depthOcclusion(qgetenv("KWIN_GL_DEPTH_OCCLUSION") == QByteArrayLiteral("1"))
 {
     if (!init_ok) {
         // base ctor already failed
@@ -934,6 +1344,19 @@ SceneOpenGL2::SceneOpenGL2(OpenGLBackend *backend, QObject *parent)
         return;
     }
 
+    // Batched quads refer to regions of the texture atlas by their current place.
+    connect(textureAtlas(), &TextureAtlas::aboutToRearrange, this, &SceneOpenGL2::flushBatch);
+
+    // Generate the shaders that most windows and effects need one at a time while the
+    // compositor is idle, rather than when the first frame that uses them is painted.
+    QTimer *warmUpTimer = new QTimer(this);
+    connect(warmUpTimer, &QTimer::timeout, this, [this, warmUpTimer]() {
+        if (!makeOpenGLContextCurrent() || !ShaderManager::instance()->warmUp()) {
+            warmUpTimer->deleteLater();
+        }
+    });
+    warmUpTimer->start(0);
+
     qCDebug(KWIN_OPENGL) << "OpenGL 2 compositing successfully initialized";
     init_ok = true;
 }
@@ -945,6 +1368,10 @@ SceneOpenGL2::~SceneOpenGL2()
         delete m_lanczosFilter;
         m_lanczosFilter = nullptr;
     }
+    if (m_batchRenderer) {
+        makeOpenGLContextCurrent();
+        m_batchRenderer.reset();
+    }
 }
 
 QMatrix4x4 SceneOpenGL2::createProjectionMatrix() const
@@ -988,7 +1415,189 @@ void SceneOpenGL2::paintSimpleScreen(int mask, const QRegion &region)
 {
     m_screenProjectionMatrix = m_projectionMatrix;
 
+    if (m_batchedRendering && !m_batchRenderer) {
+        m_batchRenderer.reset(new BatchRenderer());
+        if (!m_batchRenderer->isValid()) {
+            qCWarning(KWIN_OPENGL) << "Disabling batched rendering";
+            m_batchRenderer.reset();
+            m_batchedRendering = false;
+        }
+    }
+
+    if (!m_batchedRendering) {
+        Scene::paintSimpleScreen(mask, region);
+        return;
+    }
+
+    // Windows are painted with nearest neighbor filtering on X11 unless they are transformed,
+    // see OpenGLWindow::performPaint(). Batched windows are never transformed.
+    m_batchRenderer->begin(m_projectionMatrix, waylandServer() ? GL_LINEAR : GL_NEAREST);
     Scene::paintSimpleScreen(mask, region);
+    flushBatch();
+    m_batchRenderer->end();
+}
+
+void SceneOpenGL2::paintWindow(Window *w, int mask, const QRegion &region, const WindowQuadList &quads)
+{
+    // Effects may paint right before the window, for example the blur effect samples the
+    // framebuffer behind translucent windows. Everything that is below such a window must
+    // be in the framebuffer at that point.
+    if (activeBatchRenderer()) {
+        if (!(mask & PAINT_WINDOW_OPAQUE) || (mask & PAINT_WINDOW_TRANSFORMED)
+                || effectWindow(w)->decorationHasAlpha()) {
+            flushBatch();
+        }
+    }
+    SceneOpenGL::paintWindow(w, mask, region, quads);
+}
+
+bool SceneOpenGL2::isBatchedRenderingEnabled() const
+{
+    return m_batchedRendering;
+}
+
+void SceneOpenGL2::setBatchedRenderingEnabled(bool enabled)
+{
+    m_batchedRendering = enabled;
+}
+
+BatchRenderer *SceneOpenGL2::activeBatchRenderer() const
+{
+    if (m_batchRenderer && m_batchRenderer->isActive()) {
+        return m_batchRenderer.data();
+    }
+    return nullptr;
+}
+
+void SceneOpenGL2::flushBatch()
+{
+    if (!activeBatchRenderer()) {
+        return;
+    }
+    const int windowCount = m_batchRenderer->windowCount();
+    const int drawCallCount = m_batchRenderer->flush();
+
+    m_frameStatistics.drawCallCount += drawCallCount;
+    m_frameStatistics.batchCount += drawCallCount;
+    m_frameStatistics.batchedWindowCount += windowCount;
+}
+
+bool SceneOpenGL2::isDepthOcclusionEnabled() const
+{
+    return m_depthOcclusion;
+}
+
+void SceneOpenGL2::setDepthOcclusionEnabled(bool enabled)
+{
+    m_depthOcclusion = enabled;
+}
+
+bool SceneOpenGL2::usesDepthOcclusion() const
+{
+    // The check applies to the framebuffer that is currently bound, which can be either
+    // the default framebuffer or an offscreen render target.
+    return m_depthOcclusion && framebufferDepthSize() > 0;
+}
+
+void SceneOpenGL2::beginDepthOcclusion(const FrameVector<Phase2Data> &phase2data)
+{
+    struct Occluder
+    {
+        int firstVertex;
+        int vertexCount;
+        float depth;
+    };
+
+    // Every window gets its own depth, the topmost window is the closest one. The
+    // background is behind all windows.
+    const float step = 1.0 / (phase2data.size() + 2);
+    m_backgroundDepth = 1.0 - step;
+
+    FrameVector<Occluder> occluders(Compositor::self()->frameArena());
+    m_occluderVertices.clear();
+
+    for (size_t i = 0; i < phase2data.size(); ++i) {
+        const Phase2Data &data = phase2data[i];
+        OpenGLWindow *window = static_cast<OpenGLWindow *>(data.window);
+        const float depth = 1.0 - step * (i + 2);
+        window->setDepth(depth);
+        m_depthTestedWindows.append(window);
+
+        // The same rule as in the occlusion culling pass in Scene::paintSimpleScreen().
+        if (data.clip.isEmpty() || (data.mask & PAINT_WINDOW_TRANSLUCENT)) {
+            continue;
+        }
+
+        const int firstVertex = m_occluderVertices.count() / 2;
+        for (const QRect &rect : data.clip) {
+            const float x1 = rect.x();
+            const float y1 = rect.y();
+            const float x2 = rect.x() + rect.width();
+            const float y2 = rect.y() + rect.height();
+            m_occluderVertices << x2 << y1 << x1 << y1 << x1 << y2
+                               << x1 << y2 << x2 << y2 << x2 << y1;
+        }
+        // Slightly behind the window, so the window itself passes the depth test.
+        occluders.push_back(Occluder{firstVertex, m_occluderVertices.count() / 2 - firstVertex, depth + step / 4});
+    }
+
+    glDepthMask(GL_TRUE);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    if (!occluders.empty()) {
+        GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+        vbo->reset();
+        vbo->setData(m_occluderVertices.count() / 2, 2, m_occluderVertices.constData(), nullptr);
+
+        ShaderBinder binder(ShaderTrait::UniformColor);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+        vbo->bindArrays();
+        for (const Occluder &occluder : occluders) {
+            binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix,
+                                        depthMatrix(occluder.depth, m_projectionMatrix));
+            vbo->draw(GL_TRIANGLES, occluder.firstVertex, occluder.vertexCount);
+        }
+        vbo->unbindArrays();
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDisable(GL_DEPTH_TEST);
+
+        addDrawCalls(occluders.size());
+    }
+
+    // Only the occluders write depth, windows merely test against it.
+    glDepthMask(GL_FALSE);
+
+    if (BatchRenderer *renderer = activeBatchRenderer()) {
+        renderer->setDepthTestEnabled(true);
+    }
+    m_depthRenderTarget = GLRenderTarget::currentRenderTarget();
+    m_depthOcclusionActive = true;
+}
+
+void SceneOpenGL2::endDepthOcclusion()
+{
+    if (BatchRenderer *renderer = activeBatchRenderer()) {
+        flushBatch();
+        renderer->setDepthTestEnabled(false);
+    }
+
+    for (OpenGLWindow *window : qAsConst(m_depthTestedWindows)) {
+        window->resetDepth();
+    }
+    m_depthTestedWindows.clear();
+
+    glDepthMask(GL_TRUE);
+    m_depthRenderTarget = nullptr;
+    m_depthOcclusionActive = false;
+}
+
+GLRenderTarget *SceneOpenGL2::depthRenderTarget() const
+{
+    return m_depthRenderTarget;
 }
 
 void SceneOpenGL2::paintGenericScreen(int mask, const ScreenPaintData &data)
@@ -1008,9 +1617,21 @@ void SceneOpenGL2::doPaintBackground(const QVector< float >& vertices)
     vbo->setData(vertices.count() / 2, 2, vertices.data(), nullptr);
 
     ShaderBinder binder(ShaderTrait::UniformColor);
-    binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, m_projectionMatrix);
+    if (m_depthOcclusionActive) {
+        // Only the parts that are not covered by opaque windows need to be painted.
+        binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix,
+                                    depthMatrix(m_backgroundDepth, m_projectionMatrix));
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+    } else {
+        binder.shader()->setUniform(GLShader::ModelViewProjectionMatrix, m_projectionMatrix);
+    }
 
     vbo->render(GL_TRIANGLES);
+
+    if (m_depthOcclusionActive) {
+        glDisable(GL_DEPTH_TEST);
+    }
 }
 
 Scene::Window *SceneOpenGL2::createWindow(Toplevel *t)
@@ -1075,6 +1696,14 @@ bool OpenGLWindow::bindTexture()
     return pixmap->bind();
 }
 
+void OpenGLWindow::updateTexture()
+{
+    // Otherwise the damage keeps accumulating and the window pixmap keeps referencing
+    // the buffer that was attached when the window was painted for the last time.
+    preprocess();
+    bindTexture();
+}
+
 QMatrix4x4 OpenGLWindow::transformation(int mask, const WindowPaintData &data) const
 {
     QMatrix4x4 matrix;
@@ -1161,7 +1790,7 @@ void OpenGLWindow::endRenderWindow()
     }
 }
 
-GLTexture *OpenGLWindow::getDecorationTexture() const
+TextureAtlasRegion *OpenGLWindow::getDecorationTexture() const
 {
     if (AbstractClient *client = dynamic_cast<AbstractClient *>(toplevel)) {
         if (!client->isDecorated()) {
@@ -1236,6 +1865,15 @@ void OpenGLWindow::initializeRenderContext(RenderContext &context, const WindowP
 
     QVector<RenderNode> &renderNodes = context.renderNodes;
     renderNodes.resize(nodeCount);
+    for (RenderNode &renderNode : renderNodes) {
+        // Clearing the window quad list keeps its capacity around.
+        renderNode.quads.clear();
+        renderNode.texture = nullptr;
+        renderNode.firstVertex = 0;
+        renderNode.vertexCount = 0;
+        renderNode.opacity = 1.0;
+        renderNode.hasAlpha = false;
+    }
 
     for (const WindowQuad &quad : data.quads) {
         switch (quad.type()) {
@@ -1257,22 +1895,33 @@ void OpenGLWindow::initializeRenderContext(RenderContext &context, const WindowP
         }
     }
 
+    // Bring the shadow and the decoration up to date before looking up where they are in
+    // the texture atlas, each of them may need a new place, which can move the other one.
     RenderNode &shadowRenderNode = renderNodes[context.shadowOffset];
+    TextureAtlasRegion *shadowTexture = nullptr;
     if (!shadowRenderNode.quads.isEmpty()) {
-        SceneOpenGLShadow *shadow = static_cast<SceneOpenGLShadow *>(m_shadow);
-        shadowRenderNode.texture = shadow->shadowTexture();
+        shadowTexture = static_cast<SceneOpenGLShadow *>(m_shadow)->shadowTexture();
+    }
+
+    RenderNode &decorationRenderNode = renderNodes[context.decorationOffset];
+    TextureAtlasRegion *decorationTexture = nullptr;
+    if (!decorationRenderNode.quads.isEmpty()) {
+        decorationTexture = getDecorationTexture();
+    }
+
+    if (shadowTexture) {
+        shadowRenderNode.texture = shadowTexture->texture();
+        shadowRenderNode.textureMatrix = shadowTexture->matrix(NormalizedCoordinates);
         shadowRenderNode.opacity = data.opacity();
         shadowRenderNode.hasAlpha = true;
-        shadowRenderNode.coordinateType = NormalizedCoordinates;
         shadowRenderNode.leafType = ShadowLeaf;
     }
 
-    RenderNode &decorationRenderNode = renderNodes[context.decorationOffset];
-    if (!decorationRenderNode.quads.isEmpty()) {
-        decorationRenderNode.texture = getDecorationTexture();
+    if (decorationTexture) {
+        decorationRenderNode.texture = decorationTexture->texture();
+        decorationRenderNode.textureMatrix = decorationTexture->matrix(UnnormalizedCoordinates);
         decorationRenderNode.opacity = data.opacity();
         decorationRenderNode.hasAlpha = true;
-        decorationRenderNode.coordinateType = UnnormalizedCoordinates;
         decorationRenderNode.leafType = DecorationLeaf;
     }
 
@@ -1289,13 +1938,15 @@ void OpenGLWindow::initializeRenderContext(RenderContext &context, const WindowP
     // when we visited the corresponding window pixmap. The DFS traversal probably doesn't
     // have a significant impact on performance. However, if that's the case, we could
     // keep a cache of window pixmaps in the order in which they'll be rendered.
-    QStack<WindowPixmap *> stack;
-    stack.push(currentPixmap);
+    // Effects may render a window outside of a frame, so the frame arena is off limits.
+    QVarLengthArray<WindowPixmap *, 16> stack;
+    stack.push_back(currentPixmap);
 
     int i = 0;
 
-    while (!stack.isEmpty()) {
-        OpenGLWindowPixmap *windowPixmap = static_cast<OpenGLWindowPixmap *>(stack.pop());
+    while (!stack.empty()) {
+        OpenGLWindowPixmap *windowPixmap = static_cast<OpenGLWindowPixmap *>(stack.back());
+        stack.pop_back();
 
         // If it's an unmapped sub-surface, don't render it and all of its children.
         if (!windowPixmap->isValid())
@@ -1303,14 +1954,14 @@ void OpenGLWindow::initializeRenderContext(RenderContext &context, const WindowP
 
         RenderNode &contentRenderNode = renderNodes[context.contentOffset + i++];
         contentRenderNode.texture = windowPixmap->texture();
+        contentRenderNode.textureMatrix = contentRenderNode.texture->matrix(UnnormalizedCoordinates);
         contentRenderNode.hasAlpha = windowPixmap->hasAlphaChannel();
         contentRenderNode.opacity = contentOpacity;
-        contentRenderNode.coordinateType = UnnormalizedCoordinates;
         contentRenderNode.leafType = ContentLeaf;
 
         const QVector<WindowPixmap *> children = windowPixmap->children();
         for (auto it = children.rbegin(); it != children.rend(); ++it) {
-            stack.push(*it);
+            stack.push_back(*it);
         }
     }
 
@@ -1345,9 +1996,9 @@ void OpenGLWindow::initializeRenderContext(RenderContext &context, const WindowP
             }
 
             previousContentRenderNode.texture = previous->texture();
+            previousContentRenderNode.textureMatrix = previousContentRenderNode.texture->matrix(NormalizedCoordinates);
             previousContentRenderNode.hasAlpha = previous->hasAlphaChannel();
             previousContentRenderNode.opacity = data.opacity() * (1.0 - data.crossFadeProgress());
-            previousContentRenderNode.coordinateType = NormalizedCoordinates;
             previousContentRenderNode.leafType = PreviousContentLeaf;
 
             context.quadCount += previousContentRenderNode.quads.count();
@@ -1379,15 +2030,116 @@ QMatrix4x4 OpenGLWindow::modelViewProjectionMatrix(int mask, const WindowPaintDa
     return scene->projectionMatrix() * mvMatrix;
 }
 
+void OpenGLWindow::setDepth(float depth)
+{
+    m_depth = depth;
+}
+
+void OpenGLWindow::resetDepth()
+{
+    m_depth.reset();
+}
+
+bool OpenGLWindow::isDepthTested(int mask, const WindowPaintData &data) const
+{
+    if (!m_depth) {
+        return false;
+    }
+    // The depth buffer only describes the window at its place in the stacking order.
+    if (mask & (Scene::PAINT_WINDOW_TRANSFORMED | Scene::PAINT_SCREEN_TRANSFORMED)) {
+        return false;
+    }
+    if (!data.projectionMatrix().isIdentity() || !data.modelViewMatrix().isIdentity()) {
+        return false;
+    }
+    // Effects may paint the window into their own render targets, which have no depth.
+    const SceneOpenGL2 *scene = static_cast<const SceneOpenGL2 *>(m_scene);
+    return scene->depthRenderTarget() == GLRenderTarget::currentRenderTarget();
+}
+
+bool OpenGLWindow::canBatch(int mask, const WindowPaintData &data) const
+{
+    if (mask & (Scene::PAINT_WINDOW_TRANSFORMED | Scene::PAINT_SCREEN_TRANSFORMED)) {
+        return false;
+    }
+    if (!(mask & Scene::PAINT_WINDOW_OPAQUE)) {
+        return false;
+    }
+    if (data.shader) {
+        return false;
+    }
+    if (data.opacity() != 1.0 || data.brightness() != 1.0 || data.saturation() != 1.0
+            || data.crossFadeProgress() != 1.0) {
+        return false;
+    }
+    return data.projectionMatrix().isIdentity() && data.modelViewMatrix().isIdentity();
+}
+
+bool OpenGLWindow::performBatchedPaint(BatchRenderer *renderer, int mask, const QRegion &region, const WindowPaintData &_data)
+{
+    WindowPaintData data = _data;
+    if (!beginRenderWindow(mask, region, data)) {
+        return true;
+    }
+
+    RenderContext &renderContext = m_renderContext;
+    initializeRenderContext(renderContext, data);
+
+    bool batchable = true;
+    for (const RenderNode &renderNode : qAsConst(renderContext.renderNodes)) {
+        if (renderNode.texture && !renderNode.quads.isEmpty() && !BatchRenderer::canBatch(renderNode.texture)) {
+            batchable = false;
+            break;
+        }
+    }
+
+    if (!batchable) {
+        endRenderWindow();
+        return false;
+    }
+
+    const QPointF offset(x(), y());
+    for (const RenderNode &renderNode : qAsConst(renderContext.renderNodes)) {
+        if (renderNode.quads.isEmpty() || !renderNode.texture) {
+            continue;
+        }
+        renderer->addQuads(renderNode.texture, renderNode.quads, renderNode.textureMatrix, offset,
+                           !renderNode.hasAlpha && renderNode.opacity == 1.0, m_depth.value_or(0));
+    }
+    renderer->addWindow();
+
+    endRenderWindow();
+    return true;
+}
+
 void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPaintData &_data)
 {
+    SceneOpenGL2 *scene = static_cast<SceneOpenGL2 *>(m_scene);
+    if (BatchRenderer *renderer = scene->activeBatchRenderer()) {
+        // Effects may paint windows into their own render targets, the batch is painted
+        // into the one that was bound when painting started.
+        if (renderer->renderTarget() == GLRenderTarget::currentRenderTarget()) {
+            if (canBatch(mask, _data) && performBatchedPaint(renderer, mask, region, _data)) {
+                return;
+            }
+            scene->flushBatch();
+        }
+    }
+
     WindowPaintData data = _data;
     if (!beginRenderWindow(mask, region, data))
         return;
 
     QMatrix4x4 windowMatrix = transformation(mask, data);
     const QMatrix4x4 modelViewProjection = modelViewProjectionMatrix(mask, data);
-    const QMatrix4x4 mvpMatrix = modelViewProjection * windowMatrix;
+    QMatrix4x4 mvpMatrix = modelViewProjection * windowMatrix;
+
+    const bool depthTest = isDepthTested(mask, data);
+    if (depthTest) {
+        mvpMatrix = depthMatrix(*m_depth, mvpMatrix);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+    }
 
     bool useX11TextureClamp = false;
 
@@ -1425,7 +2177,7 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
 
     shader->setUniform(GLShader::Saturation, data.saturation());
 
-    RenderContext renderContext;
+    RenderContext &renderContext = m_renderContext;
     initializeRenderContext(renderContext, data);
 
     const bool indexedQuads = GLVertexBuffer::supportsIndexedQuads();
@@ -1445,9 +2197,7 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
         renderNode.firstVertex = v;
         renderNode.vertexCount = renderNode.quads.count() * verticesPerQuad;
 
-        const QMatrix4x4 matrix = renderNode.texture->matrix(renderNode.coordinateType);
-
-        renderNode.quads.makeInterleavedArrays(primitiveType, &map[v], matrix);
+        renderNode.quads.makeInterleavedArrays(primitiveType, &map[v], renderNode.textureMatrix);
         v += renderNode.quads.count() * verticesPerQuad;
     }
 
@@ -1497,12 +2247,17 @@ void OpenGLWindow::performPaint(int mask, const QRegion &region, const WindowPai
 
         vbo->draw(region, primitiveType, renderNode.firstVertex,
                   renderNode.vertexCount, m_hardwareClipping);
+        m_scene->addDrawCalls(m_hardwareClipping ? region.rectCount() : 1);
     }
 
     vbo->unbindArrays();
 
     setBlendEnabled(false);
 
+    if (depthTest) {
+        glDisable(GL_DEPTH_TEST);
+    }
+
     if (!data.shader)
         ShaderManager::instance()->popShader();
 
@@ -1632,6 +2387,78 @@ bool OpenGLWindowPixmap::isValid() const
     return WindowPixmap::isValid();
 }
 
+static void clamp_row(int left, int width, int right, const uint32_t *src, uint32_t *dest)
+{
+    std::fill_n(dest, left, *src);
+    std::copy(src, src + width, dest + left);
+    std::fill_n(dest + left + width, right, *(src + width - 1));
+}
+
+static void clamp_sides(int left, int width, int right, const uint32_t *src, uint32_t *dest)
+{
+    std::fill_n(dest, left, *src);
+    std::fill_n(dest + left + width, right, *(src + width - 1));
+}
+
+static void clamp(QImage &image, const QRect &viewport)
+{
+    Q_ASSERT(image.depth() == 32);
+
+    const QRect rect = image.rect();
+
+    const int left = viewport.left() - rect.left();
+    const int top = viewport.top() - rect.top();
+    const int right = rect.right() - viewport.right();
+    const int bottom = rect.bottom() - viewport.bottom();
+
+    const int width = rect.width() - left - right;
+    const int height = rect.height() - top - bottom;
+
+    const uint32_t *firstRow = reinterpret_cast<uint32_t *>(image.scanLine(top));
+    const uint32_t *lastRow = reinterpret_cast<uint32_t *>(image.scanLine(top + height - 1));
+
+    for (int i = 0; i < top; ++i) {
+        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(i));
+        clamp_row(left, width, right, firstRow + left, dest);
+    }
+
+    for (int i = 0; i < height; ++i) {
+        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(top + i));
+        clamp_sides(left, width, right, dest + left, dest);
+    }
+
+    for (int i = 0; i < bottom; ++i) {
+        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(top + height + i));
+        clamp_row(left, width, right, lastRow + left, dest);
+    }
+}
+
+/**
+ * Uploads @p image into a new region of the texture atlas. The edges of the image are
+ * repeated into the padding around the region, so it can be sampled with linear filtering.
+ */
+static TextureAtlasRegion *uploadToAtlas(const QImage &image)
+{
+    if (image.isNull()) {
+        return nullptr;
+    }
+
+    const int padding = 1;
+    const QImage source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QImage padded(source.width() + 2 * padding, source.height() + 2 * padding, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < source.height(); ++y) {
+        uint32_t *dest = reinterpret_cast<uint32_t *>(padded.scanLine(y + padding)) + padding;
+        const uint32_t *src = reinterpret_cast<const uint32_t *>(source.constScanLine(y));
+        std::copy(src, src + source.width(), dest);
+    }
+    clamp(padded, QRect(padding, padding, source.width(), source.height()));
+
+    TextureAtlas *atlas = static_cast<SceneOpenGL *>(Compositor::self()->scene())->textureAtlas();
+    TextureAtlasRegion *region = atlas->allocate(source.size(), padding);
+    region->update(padded, QPoint(-padding, -padding));
+    return region;
+}
+
 //****************************************
 // SceneOpenGL::EffectFrame
 //****************************************
@@ -1714,6 +2541,10 @@ void SceneOpenGL::EffectFrame::crossFadeIcon()
     delete m_oldIconTexture;
     m_oldIconTexture = m_iconTexture;
     m_iconTexture = nullptr;
+    // The old icon can't be generated again if the texture atlas evicts it.
+    if (m_oldIconTexture) {
+        m_oldIconTexture->setPinned(true);
+    }
 }
 
 void SceneOpenGL::EffectFrame::crossFadeText()
@@ -1721,6 +2552,9 @@ void SceneOpenGL::EffectFrame::crossFadeText()
     delete m_oldTextTexture;
     m_oldTextTexture = m_textTexture;
     m_textTexture = nullptr;
+    if (m_oldTextTexture) {
+        m_oldTextTexture->setPinned(true);
+    }
 }
 
 void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, double frameOpacity)
@@ -1731,6 +2565,14 @@ void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, do
     Q_UNUSED(_region);
     const QRegion region = infiniteRegion(); // TODO: Old region doesn't seem to work with OpenGL
 
+    // Textures that have been evicted from the texture atlas are created again below.
+    for (TextureAtlasRegion **texture : {&m_texture, &m_textTexture, &m_iconTexture, &m_selectionTexture}) {
+        if (*texture && !(*texture)->isValid()) {
+            delete *texture;
+            *texture = nullptr;
+        }
+    }
+
     GLShader* shader = m_effectFrame->shader();
     if (!shader) {
         shader = ShaderManager::instance()->pushShader(ShaderTrait::MapTexture | ShaderTrait::Modulate);
@@ -1873,28 +2715,29 @@ void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, do
         if (!m_texture)   // Lazy creation
             updateTexture();
 
-        if (shader) {
-            const float a = opacity * frameOpacity;
-            shader->setUniform(GLShader::ModulationConstant, QVector4D(a, a, a, a));
-        }
-        m_texture->bind();
-        qreal left, top, right, bottom;
-        m_effectFrame->frame().getMargins(left, top, right, bottom);   // m_geometry is the inner geometry
-        const QRect rect = m_effectFrame->geometry().adjusted(-left, -top, right, bottom);
-
-        QMatrix4x4 mvp(projection);
-        mvp.translate(rect.x(), rect.y());
-        shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
+        if (m_texture) {
+            if (shader) {
+                const float a = opacity * frameOpacity;
+                shader->setUniform(GLShader::ModulationConstant, QVector4D(a, a, a, a));
+            }
+            m_texture->bind();
+            qreal left, top, right, bottom;
+            m_effectFrame->frame().getMargins(left, top, right, bottom);   // m_geometry is the inner geometry
+            const QRect rect = m_effectFrame->geometry().adjusted(-left, -top, right, bottom);
 
-        m_texture->render(region, rect);
-        m_texture->unbind();
+            QMatrix4x4 mvp(projection);
+            mvp.translate(rect.x(), rect.y());
+            shader->setUniform(GLShader::ModelViewProjectionMatrix, mvp);
 
+            m_texture->render(region, rect);
+            m_texture->unbind();
+        }
     }
     if (!m_effectFrame->selection().isNull()) {
         if (!m_selectionTexture) { // Lazy creation
             QPixmap pixmap = m_effectFrame->selectionFrame().framePixmap();
             if (!pixmap.isNull())
-                m_selectionTexture = new GLTexture(pixmap);
+                m_selectionTexture = uploadToAtlas(pixmap.toImage());
         }
         if (m_selectionTexture) {
             if (shader) {
@@ -1942,11 +2785,13 @@ void SceneOpenGL::EffectFrame::render(const QRegion &_region, double opacity, do
         }
 
         if (!m_iconTexture) { // lazy creation
-            m_iconTexture = new GLTexture(m_effectFrame->icon().pixmap(m_effectFrame->iconSize()));
+            m_iconTexture = uploadToAtlas(m_effectFrame->icon().pixmap(m_effectFrame->iconSize()).toImage());
+        }
+        if (m_iconTexture) {
+            m_iconTexture->bind();
+            m_iconTexture->render(region, QRect(topLeft, m_effectFrame->iconSize()));
+            m_iconTexture->unbind();
         }
-        m_iconTexture->bind();
-        m_iconTexture->render(region, QRect(topLeft, m_effectFrame->iconSize()));
-        m_iconTexture->unbind();
     }
 
     // Render text
@@ -1995,7 +2840,7 @@ void SceneOpenGL::EffectFrame::updateTexture()
     m_texture = nullptr;
     if (m_effectFrame->style() == EffectFrameStyled) {
         QPixmap pixmap = m_effectFrame->frame().framePixmap();
-        m_texture = new GLTexture(pixmap);
+        m_texture = uploadToAtlas(pixmap.toImage());
     }
 }
 
@@ -2031,7 +2876,7 @@ void SceneOpenGL::EffectFrame::updateTextTexture()
         p.setPen(Qt::white);
     p.drawText(rect, m_effectFrame->alignment(), text);
     p.end();
-    m_textTexture = new GLTexture(*m_textPixmap);
+    m_textTexture = uploadToAtlas(m_textPixmap->toImage());
 }
 
 void SceneOpenGL::EffectFrame::updateUnstyledTexture()
@@ -2072,12 +2917,12 @@ public:
     static DecorationShadowTextureCache &instance();
 
     void unregister(SceneOpenGLShadow *shadow);
-    QSharedPointer<GLTexture> getTexture(SceneOpenGLShadow *shadow);
+    QSharedPointer<TextureAtlasRegion> getTexture(SceneOpenGLShadow *shadow);
 
 private:
     DecorationShadowTextureCache() = default;
     struct Data {
-        QSharedPointer<GLTexture> texture;
+        QSharedPointer<TextureAtlasRegion> texture;
         QVector<SceneOpenGLShadow*> shadows;
     };
     QHash<KDecoration2::DecorationShadow*, Data> m_cache;
@@ -2117,7 +2962,7 @@ void DecorationShadowTextureCache::unregister(SceneOpenGLShadow *shadow)
     }
 }
 
-QSharedPointer<GLTexture> DecorationShadowTextureCache::getTexture(SceneOpenGLShadow *shadow)
+QSharedPointer<TextureAtlasRegion> DecorationShadowTextureCache::getTexture(SceneOpenGLShadow *shadow)
 {
     Q_ASSERT(shadow->hasDecorationShadow());
     unregister(shadow);
@@ -2127,11 +2972,16 @@ QSharedPointer<GLTexture> DecorationShadowTextureCache::getTexture(SceneOpenGLSh
     if (it != m_cache.end()) {
         Q_ASSERT(!it.value().shadows.contains(shadow));
         it.value().shadows << shadow;
+        // The texture atlas may have evicted the shadow, the other shadows that share it
+        // pick up the new texture when they notice that the old one is gone.
+        if (!it.value().texture->isValid()) {
+            it.value().texture.reset(uploadToAtlas(shadow->decorationShadowImage()));
+        }
         return it.value().texture;
     }
     Data d;
     d.shadows << shadow;
-    d.texture = QSharedPointer<GLTexture>::create(shadow->decorationShadowImage());
+    d.texture.reset(uploadToAtlas(shadow->decorationShadowImage()));
     m_cache.insert(decoShadow.data(), d);
     return d.texture;
 }
@@ -2151,6 +3001,15 @@ SceneOpenGLShadow::~SceneOpenGLShadow()
     }
 }
 
+TextureAtlasRegion *SceneOpenGLShadow::shadowTexture()
+{
+    if (m_texture && !m_texture->isValid()) {
+        // The texture atlas has evicted the shadow to make room for something else.
+        prepareBackend();
+    }
+    return m_texture.data();
+}
+
 static inline void distributeHorizontally(QRectF &leftRect, QRectF &rightRect)
 {
     if (leftRect.right() > rightRect.left()) {
@@ -2476,12 +3335,18 @@ bool SceneOpenGLShadow::prepareBackend()
 
     Scene *scene = Compositor::self()->scene();
     scene->makeOpenGLContextCurrent();
-    m_texture = QSharedPointer<GLTexture>::create(image);
 
-    if (m_texture->internalFormat() == GL_R8) {
-        // Swizzle red to alpha and all other channels to zero
-        m_texture->bind();
-        m_texture->setSwizzle(GL_ZERO, GL_ZERO, GL_ZERO, GL_RED);
+    if (image.format() == QImage::Format_Indexed8) {
+        // The atlas stores RGBA textures only, an alpha-only texture is smaller on its own.
+        GLTexture *texture = new GLTexture(image);
+        if (texture->internalFormat() == GL_R8) {
+            // Swizzle red to alpha and all other channels to zero
+            texture->bind();
+            texture->setSwizzle(GL_ZERO, GL_ZERO, GL_ZERO, GL_RED);
+        }
+        m_texture.reset(static_cast<SceneOpenGL *>(scene)->textureAtlas()->adopt(texture));
+    } else {
+        m_texture.reset(uploadToAtlas(image));
     }
 
     return true;
@@ -2526,60 +3391,28 @@ static QImage rotate(const QImage &srcImage, const QRect &srcRect)
     return image;
 }
 
-static void clamp_row(int left, int width, int right, const uint32_t *src, uint32_t *dest)
-{
-    std::fill_n(dest, left, *src);
-    std::copy(src, src + width, dest + left);
-    std::fill_n(dest + left + width, right, *(src + width - 1));
-}
-
-static void clamp_sides(int left, int width, int right, const uint32_t *src, uint32_t *dest)
-{
-    std::fill_n(dest, left, *src);
-    std::fill_n(dest + left + width, right, *(src + width - 1));
-}
-
-static void clamp(QImage &image, const QRect &viewport)
+void SceneOpenGLDecorationRenderer::render()
 {
-    Q_ASSERT(image.depth() == 32);
-
-    const QRect rect = image.rect();
-
-    const int left = viewport.left() - rect.left();
-    const int top = viewport.top() - rect.top();
-    const int right = rect.right() - viewport.right();
-    const int bottom = rect.bottom() - viewport.bottom();
-
-    const int width = rect.width() - left - right;
-    const int height = rect.height() - top - bottom;
-
-    const uint32_t *firstRow = reinterpret_cast<uint32_t *>(image.scanLine(top));
-    const uint32_t *lastRow = reinterpret_cast<uint32_t *>(image.scanLine(top + height - 1));
-
-    for (int i = 0; i < top; ++i) {
-        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(i));
-        clamp_row(left, width, right, firstRow + left, dest);
-    }
-
-    for (int i = 0; i < height; ++i) {
-        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(top + i));
-        clamp_sides(left, width, right, dest + left, dest);
+    if (m_texture && !m_texture->isValid()) {
+        // The texture atlas has evicted the decoration to make room for something else.
+        cancelRasterizing();
+        m_texture.reset();
+        schedule(client()->client()->rect());
     }
 
-    for (int i = 0; i < bottom; ++i) {
-        uint32_t *dest = reinterpret_cast<uint32_t *>(image.scanLine(top + height + i));
-        clamp_row(left, width, right, lastRow + left, dest);
-    }
-}
+    uploadRasterizedTiles();
 
-void SceneOpenGLDecorationRenderer::render()
-{
-    const QRegion scheduled = getScheduled();
+    QRegion scheduled = getScheduled();
     if (scheduled.isEmpty()) {
         return;
     }
-    if (areImageSizesDirty()) {
-        resizeTexture();
+    if (areImageSizesDirty() || !m_texture) {
+        if (resizeTexture()) {
+            // A new region of the texture atlas contains leftovers, paint all of it before
+            // the window is painted, it can't be shown without its decoration.
+            scheduled = client()->client()->rect();
+            finishRasterizing();
+        }
         resetImageSizesDirty();
     }
 
@@ -2593,8 +3426,10 @@ void SceneOpenGLDecorationRenderer::render()
 
     // We pad each part in the decoration atlas in order to avoid texture bleeding.
     const int padding = 1;
+    const qreal devicePixelRatio = client()->client()->screenScale();
 
-    auto renderPart = [=](const QRect &geo, const QRect &partRect, const QPoint &position, bool rotated = false) {
+    QVector<Tile> tiles;
+    auto renderPart = [&](const QRect &geo, const QRect &partRect, const QPoint &position, bool rotated = false) {
         if (!geo.isValid()) {
             return;
         }
@@ -2618,30 +3453,30 @@ void SceneOpenGLDecorationRenderer::render()
         }
 
         QRect viewport = geo.translated(-rect.x(), -rect.y());
-        const qreal devicePixelRatio = client()->client()->screenScale();
-
-        QImage image(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
-        image.setDevicePixelRatio(devicePixelRatio);
-        image.fill(Qt::transparent);
-
-        QPainter painter(&image);
-        painter.setRenderHint(QPainter::Antialiasing);
-        painter.setViewport(QRect(viewport.topLeft(), viewport.size() * devicePixelRatio));
-        painter.setWindow(QRect(geo.topLeft(), geo.size() * devicePixelRatio));
-        painter.setClipRect(geo);
-        renderToPainter(&painter, geo);
-        painter.end();
 
-        clamp(image, QRect(viewport.topLeft(), viewport.size() * devicePixelRatio));
+        Tile tile;
+        tile.rect = geo;
+        tile.viewport = viewport;
+        tile.size = rect.size() * devicePixelRatio;
+        tile.devicePixelRatio = devicePixelRatio;
+
+        const QRect clampRect(viewport.topLeft(), viewport.size() * devicePixelRatio);
+        const QSize size = rect.size();
+        tile.finish = [clampRect, size, rotated](QImage &image) {
+            clamp(image, clampRect);
+            if (rotated) {
+                // TODO: get this done directly when rendering to the image
+                image = rotate(image, QRect(QPoint(), size));
+            }
+        };
 
         if (rotated) {
-            // TODO: get this done directly when rendering to the image
-            image = rotate(image, QRect(QPoint(), rect.size()));
             viewport = QRect(viewport.y(), viewport.x(), viewport.height(), viewport.width());
         }
 
         const QPoint dirtyOffset = geo.topLeft() - partRect.topLeft();
-        m_texture->update(image, (position + dirtyOffset - viewport.topLeft()) * image.devicePixelRatio());
+        tile.offset = (position + dirtyOffset - viewport.topLeft()) * devicePixelRatio;
+        tiles.append(tile);
     };
 
     const QRect geometry = scheduled.boundingRect();
@@ -2655,14 +3490,18 @@ void SceneOpenGLDecorationRenderer::render()
     renderPart(top.intersected(geometry), top, topPosition);
     renderPart(right.intersected(geometry), right, rightPosition, true);
     renderPart(bottom.intersected(geometry), bottom, bottomPosition);
+
+    rasterize(tiles);
 }
 
-static int align(int value, int align)
+void SceneOpenGLDecorationRenderer::uploadTiles(const QVector<Tile> &tiles)
 {
-    return (value + align - 1) & ~(align - 1);
+    for (const Tile &tile : tiles) {
+        m_texture->update(tile.image, tile.offset);
+    }
 }
 
-void SceneOpenGLDecorationRenderer::resizeTexture()
+bool SceneOpenGLDecorationRenderer::resizeTexture()
 {
     QRect left, top, right, bottom;
     client()->client()->layoutDecorationRects(left, top, right, bottom);
@@ -2678,25 +3517,29 @@ void SceneOpenGLDecorationRenderer::resizeTexture()
     size.rwidth() += 2 * padding;
     size.rheight() += 4 * 2 * padding;
 
-    size.rwidth() = align(size.width(), 128);
-
     size *= client()->client()->screenScale();
     if (m_texture && m_texture->size() == size)
-        return;
+        return false;
 
+    // Release the old region first, its space can be used for the new one. The tiles that
+    // are being rasterized for the old region don't fit the new one.
+    cancelRasterizing();
+    m_texture.reset();
     if (!size.isEmpty()) {
-        m_texture.reset(new GLTexture(GL_RGBA8, size.width(), size.height()));
-        m_texture->setYInverted(true);
-        m_texture->setWrapMode(GL_CLAMP_TO_EDGE);
-        m_texture->clear();
-    } else {
-        m_texture.reset();
+        SceneOpenGL *scene = static_cast<SceneOpenGL *>(Compositor::self()->scene());
+        m_texture.reset(scene->textureAtlas()->allocate(size));
     }
+    return !m_texture.isNull();
 }
 
 void SceneOpenGLDecorationRenderer::reparent(Deleted *deleted)
 {
+    // The decoration of a closed window can't be painted again, finish it now.
+    finishRasterizing();
     render();
+    if (m_texture) {
+        m_texture->setPinned(true);
+    }
     Renderer::reparent(deleted);
 }
 
@@ -20,12 +20,19 @@
 
 #include "decorations/decorationrenderer.h"
 
+#include <optional>
+
 namespace KWin
 {
+class BatchRenderer;
 class LanczosFilter;
 class OpenGLBackend;
+class OpenGLWindow;
+class RenderTimeQueryPool;
 class SyncManager;
 class SyncObject;
+class TextureAtlas;
+class TextureAtlasRegion;
 
 class KWIN_EXPORT SceneOpenGL
     : public Scene
@@ -70,6 +77,17 @@ public:
     QVector<QByteArray> openGLPlatformInterfaceExtensions() const override;
     QSharedPointer<GLTexture> textureForOutput(AbstractOutput *output) const override;
 
+    FrameStatistics frameStatistics() const override;
+    /**
+     * Accounts for @p count draw calls in the statistics of the current frame.
+     */
+    void addDrawCalls(int count);
+
+    /**
+     * Returns the texture atlas that decorations, shadows and effect frames are stored in.
+     */
+    TextureAtlas *textureAtlas() const;
+
     static SceneOpenGL *createScene(QObject *parent);
 
 protected:
@@ -88,8 +106,11 @@ protected:
 
 protected:
     bool init_ok;
+    FrameStatistics m_frameStatistics;
 private:
     bool viewportLimitsMatched(const QSize &size) const;
+    Window *findScanoutCandidate(int screenId) const;
+    QVector<OpenGLBackend::OverlayCandidate> findOverlayCandidates(int screenId, QVector<Window *> *windows) const;
 
 private:
     bool m_resetOccurred = false;
@@ -97,6 +118,9 @@ private:
     OpenGLBackend *m_backend;
     SyncManager *m_syncManager;
     SyncObject *m_currentFence;
+    RenderTimeQueryPool *m_renderTimeQueries;
+    TextureAtlas *m_textureAtlas = nullptr;
+    QHash<int, QRegion> m_overlayRegions;
 };
 
 class SceneOpenGL2 : public SceneOpenGL
@@ -114,8 +138,46 @@ public:
     QMatrix4x4 projectionMatrix() const override { return m_projectionMatrix; }
     QMatrix4x4 screenProjectionMatrix() const override { return m_screenProjectionMatrix; }
 
+    /**
+     * Whether opaque untransformed windows are painted with as few draw calls as possible.
+     *
+     * This is disabled by default, unless the KWIN_GL_BATCHED_RENDERING environment
+     * variable is set to 1.
+     */
+    bool isBatchedRenderingEnabled() const;
+    void setBatchedRenderingEnabled(bool enabled);
+
+    /**
+     * Returns the batch renderer if windows can be batched at the moment, otherwise @c null.
+     */
+    BatchRenderer *activeBatchRenderer() const;
+    /**
+     * Paints all windows that have been batched so far.
+     */
+    void flushBatch();
+
+    /**
+     * Whether paintSimpleScreen() rejects occluded pixels with the depth buffer rather than
+     * clipping windows against the opaque regions of the windows above them. This requires
+     * a framebuffer with a depth buffer, otherwise regions are used regardless.
+     *
+     * This is disabled by default, unless the KWIN_GL_DEPTH_OCCLUSION environment variable
+     * is set to 1.
+     */
+    bool isDepthOcclusionEnabled() const;
+    void setDepthOcclusionEnabled(bool enabled);
+
+    /**
+     * Returns the render target that the depth buffer belongs to in the current frame.
+     */
+    GLRenderTarget *depthRenderTarget() const;
+
 protected:
     void paintSimpleScreen(int mask, const QRegion &region) override;
+    void paintWindow(Window *w, int mask, const QRegion &region, const WindowQuadList &quads) override;
+    bool usesDepthOcclusion() const override;
+    void beginDepthOcclusion(const FrameVector<Phase2Data> &phase2data) override;
+    void endDepthOcclusion() override;
     void paintGenericScreen(int mask, const ScreenPaintData &data) override;
     void doPaintBackground(const QVector< float >& vertices) override;
     Scene::Window *createWindow(Toplevel *t) override;
@@ -129,6 +191,14 @@ private:
 
 private:
     LanczosFilter *m_lanczosFilter;
+    QScopedPointer<BatchRenderer> m_batchRenderer;
+    bool m_batchedRendering;
+    bool m_depthOcclusion;
+    bool m_depthOcclusionActive = false;
+    float m_backgroundDepth = 1.0;
+    GLRenderTarget *m_depthRenderTarget = nullptr;
+    QVector<OpenGLWindow *> m_depthTestedWindows;
+    QVector<float> m_occluderVertices;
     QScopedPointer<GLTexture> m_cursorTexture;
     QMatrix4x4 m_projectionMatrix;
     QMatrix4x4 m_screenProjectionMatrix;
@@ -152,17 +222,20 @@ public:
             , vertexCount(0)
             , opacity(1.0)
             , hasAlpha(false)
-            , coordinateType(UnnormalizedCoordinates)
         {
         }
 
         GLTexture *texture;
+        /**
+         * Maps the texture coordinates of the quads to the texture, which may hold the
+         * contents of the node in a region of a texture atlas.
+         */
+        QMatrix4x4 textureMatrix;
         WindowQuadList quads;
         int firstVertex;
         int vertexCount;
         float opacity;
         bool hasAlpha;
-        TextureCoordinateType coordinateType;
         Leaf leafType;
     };
 
@@ -183,20 +256,38 @@ public:
     void performPaint(int mask, const QRegion &region, const WindowPaintData &data) override;
     QSharedPointer<GLTexture> windowTexture() override;
 
+    /**
+     * Sets the normalized device depth at which the window is painted in the current frame.
+     * Pixels that are occluded according to the depth buffer are rejected.
+     */
+    void setDepth(float depth);
+    void resetDepth();
+    /**
+     * Updates the window pixmap and the texture of a window that is shown without being
+     * painted, e.g. because its buffer is scanned out directly.
+     */
+    void updateTexture();
+
 private:
     QMatrix4x4 transformation(int mask, const WindowPaintData &data) const;
-    GLTexture *getDecorationTexture() const;
+    TextureAtlasRegion *getDecorationTexture() const;
     QMatrix4x4 modelViewProjectionMatrix(int mask, const WindowPaintData &data) const;
     QVector4D modulate(float opacity, float brightness) const;
     void setBlendEnabled(bool enabled);
     void initializeRenderContext(RenderContext &context, const WindowPaintData &data);
     bool beginRenderWindow(int mask, const QRegion &region, WindowPaintData &data);
     void endRenderWindow();
+    bool isDepthTested(int mask, const WindowPaintData &data) const;
+    bool canBatch(int mask, const WindowPaintData &data) const;
+    bool performBatchedPaint(BatchRenderer *renderer, int mask, const QRegion &region, const WindowPaintData &data);
     bool bindTexture();
 
     SceneOpenGL *m_scene;
+    // Kept around between frames so the window quad lists don't need to be reallocated.
+    RenderContext m_renderContext;
     bool m_hardwareClipping = false;
     bool m_blendingEnabled = false;
+    std::optional<float> m_depth;
 };
 
 class OpenGLWindowPixmap : public WindowPixmap
@@ -238,13 +329,13 @@ private:
     void updateTexture();
     void updateTextTexture();
 
-    GLTexture *m_texture;
-    GLTexture *m_textTexture;
-    GLTexture *m_oldTextTexture;
+    TextureAtlasRegion *m_texture;
+    TextureAtlasRegion *m_textTexture;
+    TextureAtlasRegion *m_oldTextTexture;
     QPixmap *m_textPixmap; // need to keep the pixmap around to workaround some driver problems
-    GLTexture *m_iconTexture;
-    GLTexture *m_oldIconTexture;
-    GLTexture *m_selectionTexture;
+    TextureAtlasRegion *m_iconTexture;
+    TextureAtlasRegion *m_oldIconTexture;
+    TextureAtlasRegion *m_selectionTexture;
     GLVertexBuffer *m_unstyledVBO;
     SceneOpenGL *m_scene;
 
@@ -266,14 +357,16 @@ public:
     explicit SceneOpenGLShadow(Toplevel *toplevel);
     ~SceneOpenGLShadow() override;
 
-    GLTexture *shadowTexture() {
-        return m_texture.data();
-    }
+    /**
+     * Returns the texture atlas region with the shadow, the shadow quads have normalized
+     * texture coordinates in it. The shadow is uploaded again if the atlas has evicted it.
+     */
+    TextureAtlasRegion *shadowTexture();
 protected:
     void buildQuads() override;
     bool prepareBackend() override;
 private:
-    QSharedPointer<GLTexture> m_texture;
+    QSharedPointer<TextureAtlasRegion> m_texture;
 };
 
 class SceneOpenGLDecorationRenderer : public Decoration::Renderer
@@ -293,16 +386,19 @@ public:
     void render() override;
     void reparent(Deleted *deleted) override;
 
-    GLTexture *texture() {
+    TextureAtlasRegion *texture() {
         return m_texture.data();
     }
-    GLTexture *texture() const {
+    TextureAtlasRegion *texture() const {
         return m_texture.data();
     }
 
+protected:
+    void uploadTiles(const QVector<Tile> &tiles) override;
+
 private:
-    void resizeTexture();
-    QScopedPointer<GLTexture> m_texture;
+    bool resizeTexture();
+    QScopedPointer<TextureAtlasRegion> m_texture;
 };
 
 inline bool SceneOpenGL::usesOverlayWindow() const
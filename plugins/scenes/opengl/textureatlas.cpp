@@ -0,0 +1,599 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "textureatlas.h"
+
+#include <logging.h>
+
+#include <QHash>
+
+#include <algorithm>
+#include <memory>
+
+namespace KWin
+{
+
+static const int s_maximumPageSize = 4096;
+static const int s_initialPageHeight = 256;
+static const int s_maximumPageCount = 4;
+
+/**
+ * Packs rectangles bottom-left first on top of a skyline, the outline of everything that
+ * has been packed so far. Space can't be freed, packing starts over instead.
+ */
+class SkylinePacker
+{
+public:
+    SkylinePacker() = default;
+    SkylinePacker(int width, int height);
+
+    int height() const;
+    void setHeight(int height);
+    /**
+     * Returns the height of the highest segment of the skyline.
+     */
+    int top() const;
+
+    bool insert(const QSize &size, QPoint *position);
+
+private:
+    bool fits(int index, const QSize &size, int *y) const;
+
+    struct Segment
+    {
+        int x;
+        int y;
+        int width;
+    };
+    QVector<Segment> m_skyline;
+    int m_width = 0;
+    int m_height = 0;
+};
+
+SkylinePacker::SkylinePacker(int width, int height)
+    : m_width(width)
+    , m_height(height)
+{
+    m_skyline.append(Segment{0, 0, width});
+}
+
+int SkylinePacker::height() const
+{
+    return m_height;
+}
+
+void SkylinePacker::setHeight(int height)
+{
+    m_height = height;
+}
+
+int SkylinePacker::top() const
+{
+    int top = 0;
+    for (const Segment &segment : m_skyline) {
+        top = std::max(top, segment.y);
+    }
+    return top;
+}
+
+bool SkylinePacker::fits(int index, const QSize &size, int *y) const
+{
+    if (m_skyline[index].x + size.width() > m_width) {
+        return false;
+    }
+
+    int top = 0;
+    int remaining = size.width();
+    for (int i = index; remaining > 0; ++i) {
+        top = std::max(top, m_skyline[i].y);
+        if (top + size.height() > m_height) {
+            return false;
+        }
+        remaining -= m_skyline[i].width;
+    }
+
+    *y = top;
+    return true;
+}
+
+bool SkylinePacker::insert(const QSize &size, QPoint *position)
+{
+    int bestIndex = -1;
+    int bestY = 0;
+    for (int i = 0; i < m_skyline.count(); ++i) {
+        int y;
+        if (fits(i, size, &y) && (bestIndex == -1 || y < bestY)) {
+            bestIndex = i;
+            bestY = y;
+        }
+    }
+    if (bestIndex == -1) {
+        return false;
+    }
+
+    const Segment segment{m_skyline[bestIndex].x, bestY + size.height(), size.width()};
+    m_skyline.insert(bestIndex, segment);
+
+    // Shrink or remove the segments that are covered by the new one.
+    const int right = segment.x + segment.width;
+    for (int i = bestIndex + 1; i < m_skyline.count();) {
+        Segment &next = m_skyline[i];
+        if (next.x >= right) {
+            break;
+        }
+        const int overlap = right - next.x;
+        if (next.width <= overlap) {
+            m_skyline.remove(i);
+            continue;
+        }
+        next.x += overlap;
+        next.width -= overlap;
+        break;
+    }
+
+    for (int i = 0; i < m_skyline.count() - 1;) {
+        if (m_skyline[i].y == m_skyline[i + 1].y) {
+            m_skyline[i].width += m_skyline[i + 1].width;
+            m_skyline.remove(i + 1);
+        } else {
+            ++i;
+        }
+    }
+
+    *position = QPoint(segment.x, bestY);
+    return true;
+}
+
+class TextureAtlasPage
+{
+public:
+    std::unique_ptr<GLTexture> texture;
+    SkylinePacker packer;
+    QVector<TextureAtlasRegion *> regions;
+    qint64 usedTexelCount = 0;
+};
+
+static qint64 area(const QSize &size)
+{
+    return qint64(size.width()) * size.height();
+}
+
+static int pageHeightFor(int height, int maximumHeight)
+{
+    int pageHeight = s_initialPageHeight;
+    while (pageHeight < height) {
+        pageHeight *= 2;
+    }
+    return std::min(pageHeight, maximumHeight);
+}
+
+static GLTexture *createTexture(const QSize &size)
+{
+    GLTexture *texture = new GLTexture(GL_RGBA8, size);
+    texture->setYInverted(true);
+    texture->setWrapMode(GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+/**
+ * Copies rectangles of @p source to the given positions in @p destination.
+ */
+static void copyTexels(GLTexture *source, GLTexture *destination, const QVector<QPair<QRect, QPoint>> &copies)
+{
+    GLRenderTarget renderTarget(*source);
+    GLRenderTarget::pushRenderTarget(&renderTarget);
+
+    destination->bind();
+    for (const auto &copy : copies) {
+        const QRect &rect = copy.first;
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, copy.second.x(), copy.second.y(),
+                            rect.x(), rect.y(), rect.width(), rect.height());
+    }
+    destination->unbind();
+
+    GLRenderTarget::popRenderTarget();
+}
+
+TextureAtlasRegion::TextureAtlasRegion(TextureAtlas *atlas, TextureAtlasPage *page, const QRect &rect, int padding)
+    : m_atlas(atlas)
+    , m_page(page)
+    , m_rect(rect)
+    , m_padding(padding)
+{
+}
+
+TextureAtlasRegion::~TextureAtlasRegion()
+{
+    if (m_atlas) {
+        m_atlas->release(this);
+    }
+}
+
+bool TextureAtlasRegion::isValid() const
+{
+    return m_page;
+}
+
+QSize TextureAtlasRegion::size() const
+{
+    return m_rect.size();
+}
+
+QRect TextureAtlasRegion::paddedRect() const
+{
+    return m_rect.adjusted(-m_padding, -m_padding, m_padding, m_padding);
+}
+
+GLTexture *TextureAtlasRegion::texture() const
+{
+    if (!m_page) {
+        return nullptr;
+    }
+    m_lastUsed = ++m_atlas->m_clock;
+    return m_page->texture.get();
+}
+
+QMatrix4x4 TextureAtlasRegion::matrix(TextureCoordinateType type) const
+{
+    if (!m_page) {
+        return QMatrix4x4();
+    }
+
+    QMatrix4x4 matrix = m_page->texture->matrix(UnnormalizedCoordinates);
+    matrix.translate(m_rect.x(), m_rect.y());
+    if (type == NormalizedCoordinates) {
+        matrix.scale(m_rect.width(), m_rect.height());
+    }
+    return matrix;
+}
+
+bool TextureAtlasRegion::isPinned() const
+{
+    return m_pinned;
+}
+
+void TextureAtlasRegion::setPinned(bool pinned)
+{
+    m_pinned = pinned;
+}
+
+void TextureAtlasRegion::update(const QImage &image, const QPoint &offset, const QRect &src)
+{
+    if (m_page) {
+        m_page->texture->update(image, m_rect.topLeft() + offset, src);
+    }
+}
+
+void TextureAtlasRegion::bind()
+{
+    if (m_page) {
+        m_page->texture->bind();
+    }
+}
+
+void TextureAtlasRegion::unbind()
+{
+    if (m_page) {
+        m_page->texture->unbind();
+    }
+}
+
+void TextureAtlasRegion::render(const QRegion &region, const QRect &rect, bool hardwareClipping)
+{
+    if (!m_page || rect.isEmpty()) {
+        return;
+    }
+
+    const QMatrix4x4 textureMatrix = matrix(NormalizedCoordinates);
+    const QPointF topLeft = textureMatrix.map(QPointF(0, 0));
+    const QPointF bottomRight = textureMatrix.map(QPointF(1, 1));
+
+    const float vertices[] = {
+        0.0f, 0.0f,
+        0.0f, float(rect.height()),
+        float(rect.width()), 0.0f,
+        float(rect.width()), float(rect.height()),
+    };
+    const float texcoords[] = {
+        float(topLeft.x()), float(topLeft.y()),
+        float(topLeft.x()), float(bottomRight.y()),
+        float(bottomRight.x()), float(topLeft.y()),
+        float(bottomRight.x()), float(bottomRight.y()),
+    };
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setData(4, 2, vertices, texcoords);
+    vbo->render(region, GL_TRIANGLE_STRIP, hardwareClipping);
+}
+
+TextureAtlas::TextureAtlas(QObject *parent)
+    : TextureAtlas(s_maximumPageSize, parent)
+{
+}
+
+TextureAtlas::TextureAtlas(int maximumPageSize, QObject *parent)
+    : QObject(parent)
+{
+    if (qgetenv("KWIN_TEXTURE_ATLAS") == QByteArrayLiteral("0")) {
+        qCDebug(KWIN_OPENGL) << "Texture atlas disabled by environment variable";
+        return;
+    }
+    // Regions are copied through a framebuffer object when a page is repacked.
+    if (!GLRenderTarget::supported()) {
+        qCDebug(KWIN_OPENGL) << "Texture atlas disabled, framebuffer objects are not supported";
+        return;
+    }
+
+    GLint maximumTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+    m_pageWidth = std::min(maximumPageSize, int(maximumTextureSize));
+    m_maximumPageHeight = m_pageWidth;
+    m_enabled = true;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    // Regions that outlive the atlas become invalid.
+    const QVector<TextureAtlasPage *> pages = m_pages + m_dedicatedPages;
+    for (TextureAtlasPage *page : pages) {
+        for (TextureAtlasRegion *region : qAsConst(page->regions)) {
+            region->m_atlas = nullptr;
+            region->m_page = nullptr;
+        }
+        delete page;
+    }
+}
+
+bool TextureAtlas::isEnabled() const
+{
+    return m_enabled;
+}
+
+TextureAtlasRegion *TextureAtlas::allocate(const QSize &size, int padding)
+{
+    if (size.isEmpty()) {
+        return nullptr;
+    }
+
+    const QSize paddedSize = size + QSize(2 * padding, 2 * padding);
+    if (!m_enabled || paddedSize.width() > m_pageWidth || paddedSize.height() > m_maximumPageHeight) {
+        return allocateDedicated(size, padding);
+    }
+
+    QPoint position;
+    for (TextureAtlasPage *page : qAsConst(m_pages)) {
+        if (page->packer.insert(paddedSize, &position)) {
+            return place(page, position, size, padding);
+        }
+    }
+
+    for (TextureAtlasPage *page : qAsConst(m_pages)) {
+        if (growPage(page, paddedSize, &position)) {
+            return place(page, position, size, padding);
+        }
+    }
+
+    if (m_pages.count() < s_maximumPageCount) {
+        TextureAtlasPage *page = createPage(pageHeightFor(paddedSize.height(), m_maximumPageHeight));
+        if (page->packer.insert(paddedSize, &position)) {
+            return place(page, position, size, padding);
+        }
+    }
+
+    // Reclaim the space of released regions, starting with the page that has the most of it.
+    QVector<TextureAtlasPage *> pages = m_pages;
+    std::sort(pages.begin(), pages.end(), [](const TextureAtlasPage *a, const TextureAtlasPage *b) {
+        return a->usedTexelCount < b->usedTexelCount;
+    });
+    for (TextureAtlasPage *page : qAsConst(pages)) {
+        if (repackPage(page, paddedSize, &position)) {
+            return place(page, position, size, padding);
+        }
+    }
+
+    qCDebug(KWIN_OPENGL) << "The texture atlas is full, using a dedicated texture of size" << size;
+    return allocateDedicated(size, padding);
+}
+
+TextureAtlasRegion *TextureAtlas::adopt(GLTexture *texture)
+{
+    TextureAtlasPage *page = new TextureAtlasPage;
+    page->texture.reset(texture);
+    m_dedicatedPages.append(page);
+    return place(page, QPoint(0, 0), texture->size(), 0);
+}
+
+TextureAtlasRegion *TextureAtlas::allocateDedicated(const QSize &size, int padding)
+{
+    TextureAtlasPage *page = new TextureAtlasPage;
+    page->texture.reset(createTexture(size + QSize(2 * padding, 2 * padding)));
+    m_dedicatedPages.append(page);
+    return place(page, QPoint(0, 0), size, padding);
+}
+
+TextureAtlasPage *TextureAtlas::createPage(int height)
+{
+    TextureAtlasPage *page = new TextureAtlasPage;
+    page->texture.reset(createTexture(QSize(m_pageWidth, height)));
+    page->packer = SkylinePacker(m_pageWidth, height);
+    m_pages.append(page);
+    return page;
+}
+
+TextureAtlasRegion *TextureAtlas::place(TextureAtlasPage *page, const QPoint &position, const QSize &size, int padding)
+{
+    TextureAtlasRegion *region = new TextureAtlasRegion(this, page, QRect(position + QPoint(padding, padding), size), padding);
+    region->m_lastUsed = ++m_clock;
+    page->regions.append(region);
+    page->usedTexelCount += area(region->paddedRect().size());
+    return region;
+}
+
+bool TextureAtlas::growPage(TextureAtlasPage *page, const QSize &size, QPoint *position)
+{
+    if (page->packer.height() >= m_maximumPageHeight) {
+        return false;
+    }
+
+    SkylinePacker packer = page->packer;
+    packer.setHeight(m_maximumPageHeight);
+    if (!packer.insert(size, position)) {
+        return false;
+    }
+
+    const int height = pageHeightFor(packer.top(), m_maximumPageHeight);
+    packer.setHeight(height);
+
+    GLTexture *texture = createTexture(QSize(m_pageWidth, height));
+    emit aboutToRearrange();
+
+    const int usedHeight = page->packer.top();
+    if (usedHeight > 0) {
+        copyTexels(page->texture.get(), texture, {qMakePair(QRect(0, 0, m_pageWidth, usedHeight), QPoint(0, 0))});
+    }
+
+    page->texture.reset(texture);
+    page->packer = packer;
+    return true;
+}
+
+bool TextureAtlas::repackPage(TextureAtlasPage *page, const QSize &size, QPoint *position)
+{
+    // Pinned regions are kept in any case, the other regions are kept in the order in which
+    // they have been used until the page is reasonably full, packing is not perfect.
+    QVector<TextureAtlasRegion *> candidates = page->regions;
+    std::sort(candidates.begin(), candidates.end(), [](const TextureAtlasRegion *a, const TextureAtlasRegion *b) {
+        if (a->m_pinned != b->m_pinned) {
+            return a->m_pinned;
+        }
+        return a->m_lastUsed > b->m_lastUsed;
+    });
+
+    const qint64 budget = qint64(m_pageWidth) * m_maximumPageHeight * 3 / 4;
+    qint64 usedTexelCount = area(size);
+    QVector<TextureAtlasRegion *> kept;
+    for (TextureAtlasRegion *region : qAsConst(candidates)) {
+        const qint64 regionTexelCount = area(region->paddedRect().size());
+        if (region->m_pinned || usedTexelCount + regionTexelCount <= budget) {
+            kept.append(region);
+            usedTexelCount += regionTexelCount;
+        }
+    }
+
+    // The skyline wastes the least space if the tallest rectangles are packed first. The
+    // requested region is represented by a null pointer.
+    kept.append(nullptr);
+    auto paddedHeight = [&size](const TextureAtlasRegion *region) {
+        return region ? region->paddedRect().height() : size.height();
+    };
+    std::stable_sort(kept.begin(), kept.end(), [&paddedHeight](const TextureAtlasRegion *a, const TextureAtlasRegion *b) {
+        return paddedHeight(a) > paddedHeight(b);
+    });
+
+    SkylinePacker packer(m_pageWidth, m_maximumPageHeight);
+    QHash<TextureAtlasRegion *, QPoint> positions;
+    for (TextureAtlasRegion *region : qAsConst(kept)) {
+        QPoint regionPosition;
+        if (!packer.insert(region ? region->paddedRect().size() : size, &regionPosition)) {
+            if (!region || region->m_pinned) {
+                return false;
+            }
+            continue;
+        }
+        if (region) {
+            positions.insert(region, regionPosition);
+        } else {
+            *position = regionPosition;
+        }
+    }
+
+    const int height = pageHeightFor(packer.top(), m_maximumPageHeight);
+    packer.setHeight(height);
+
+    GLTexture *texture = createTexture(QSize(m_pageWidth, height));
+    emit aboutToRearrange();
+
+    QVector<QPair<QRect, QPoint>> copies;
+    QVector<TextureAtlasRegion *> regions;
+    for (TextureAtlasRegion *region : qAsConst(page->regions)) {
+        const auto it = positions.constFind(region);
+        if (it == positions.constEnd()) {
+            page->usedTexelCount -= area(region->paddedRect().size());
+            region->m_page = nullptr;
+            continue;
+        }
+        copies.append(qMakePair(region->paddedRect(), *it));
+        region->m_rect.moveTopLeft(*it + QPoint(region->m_padding, region->m_padding));
+        regions.append(region);
+    }
+    copyTexels(page->texture.get(), texture, copies);
+
+    qCDebug(KWIN_OPENGL) << "Repacked a texture atlas page," << page->regions.count() - regions.count()
+                         << "regions have been evicted";
+
+    page->texture.reset(texture);
+    page->packer = packer;
+    page->regions = regions;
+    return true;
+}
+
+void TextureAtlas::release(TextureAtlasRegion *region)
+{
+    TextureAtlasPage *page = region->m_page;
+    if (!page) {
+        return;
+    }
+
+    page->regions.removeOne(region);
+    if (m_dedicatedPages.removeOne(page)) {
+        delete page;
+        return;
+    }
+
+    page->usedTexelCount -= area(region->paddedRect().size());
+    if (page->regions.isEmpty()) {
+        if (m_pages.count() > 1) {
+            m_pages.removeOne(page);
+            delete page;
+        } else {
+            page->packer = SkylinePacker(m_pageWidth, page->packer.height());
+        }
+    }
+}
+
+int TextureAtlas::pageCount() const
+{
+    return m_pages.count();
+}
+
+int TextureAtlas::dedicatedTextureCount() const
+{
+    return m_dedicatedPages.count();
+}
+
+qint64 TextureAtlas::texelCount() const
+{
+    qint64 texelCount = 0;
+    for (const TextureAtlasPage *page : m_pages) {
+        texelCount += area(page->texture->size());
+    }
+    return texelCount;
+}
+
+qint64 TextureAtlas::usedTexelCount() const
+{
+    qint64 usedTexelCount = 0;
+    for (const TextureAtlasPage *page : m_pages) {
+        usedTexelCount += page->usedTexelCount;
+    }
+    return usedTexelCount;
+}
+
+}
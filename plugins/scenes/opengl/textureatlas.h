@@ -0,0 +1,174 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwinglutils.h>
+
+#include <QMatrix4x4>
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+class TextureAtlas;
+class TextureAtlasPage;
+
+/**
+ * The TextureAtlasRegion class represents a rectangle in one of the textures of a
+ * TextureAtlas.
+ *
+ * The atlas may move a region to another place or to another texture when it runs out of
+ * space, so the texture and the texture matrix of a region must be looked up every time the
+ * region is painted. If the atlas has to give the place of a region to someone else, the
+ * region becomes invalid and its contents have to be uploaded again into a new region.
+ */
+class TextureAtlasRegion
+{
+public:
+    ~TextureAtlasRegion();
+
+    /**
+     * Returns @c true if the region still has a place in the texture atlas.
+     */
+    bool isValid() const;
+    QSize size() const;
+
+    /**
+     * Returns the texture that contains this region, and marks the region as recently used.
+     */
+    GLTexture *texture() const;
+    /**
+     * Returns the matrix that maps texture coordinates of the given @p type in this region
+     * to texture coordinates in texture().
+     */
+    QMatrix4x4 matrix(TextureCoordinateType type) const;
+
+    /**
+     * Pinned regions are never evicted from the atlas, use it for contents that can't be
+     * generated again, e.g. the decoration of a closed window.
+     */
+    bool isPinned() const;
+    void setPinned(bool pinned);
+
+    /**
+     * Uploads @p image at @p offset in this region, see GLTexture::update(). The offset may
+     * be negative in order to fill the padding around the region.
+     */
+    void update(const QImage &image, const QPoint &offset = QPoint(0, 0), const QRect &src = QRect());
+
+    void bind();
+    void unbind();
+    /**
+     * Renders the region into @p rect, like GLTexture::render(). The region must be bound.
+     */
+    void render(const QRegion &region, const QRect &rect, bool hardwareClipping = false);
+
+private:
+    TextureAtlasRegion(TextureAtlas *atlas, TextureAtlasPage *page, const QRect &rect, int padding);
+
+    QRect paddedRect() const;
+
+    TextureAtlas *m_atlas;
+    TextureAtlasPage *m_page;
+    QRect m_rect;
+    int m_padding;
+    bool m_pinned = false;
+    mutable quint64 m_lastUsed = 0;
+
+    friend class TextureAtlas;
+};
+
+/**
+ * The TextureAtlas packs the small textures of decorations, shadows and effect frames into
+ * a few large textures, so they don't fragment the video memory and windows can be painted
+ * without switching textures.
+ *
+ * Every texture of the atlas is a page that is packed with a skyline allocator. Pages start
+ * small and grow on demand. Space that is freed in a page is reclaimed when the page runs
+ * full, the regions that are still in use are then packed anew and copied into a new texture,
+ * the least recently used regions are evicted if they don't fit anymore. Regions that are
+ * too large for a page, or that don't fit even after that, get a dedicated texture.
+ *
+ * The atlas can be disabled by setting the environment variable KWIN_TEXTURE_ATLAS to 0,
+ * every region gets a dedicated texture then.
+ */
+class TextureAtlas : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TextureAtlas(QObject *parent = nullptr);
+    /**
+     * Creates an atlas whose pages are at most @p maximumPageSize texels wide and high.
+     */
+    explicit TextureAtlas(int maximumPageSize, QObject *parent = nullptr);
+    ~TextureAtlas() override;
+
+    bool isEnabled() const;
+
+    /**
+     * Allocates a region of the given @p size, with @p padding texels of space around it
+     * that can be filled in order to avoid texture bleeding. The caller takes the ownership
+     * of the returned region. Returns @c nullptr if @p size is empty.
+     */
+    TextureAtlasRegion *allocate(const QSize &size, int padding = 0);
+    /**
+     * Creates a region that covers the whole @p texture, for contents that can't be stored
+     * in the atlas, e.g. because they need a different texture format. The region takes the
+     * ownership of @p texture.
+     */
+    TextureAtlasRegion *adopt(GLTexture *texture);
+
+    /**
+     * Returns the number of shared textures in the atlas.
+     */
+    int pageCount() const;
+    /**
+     * Returns the number of textures that belong to only one region.
+     */
+    int dedicatedTextureCount() const;
+    /**
+     * Returns the number of texels in the shared textures of the atlas.
+     */
+    qint64 texelCount() const;
+    /**
+     * Returns the number of texels in the shared textures that are occupied by regions.
+     */
+    qint64 usedTexelCount() const;
+
+Q_SIGNALS:
+    /**
+     * This signal is emitted before regions are moved to another place or textures of the
+     * atlas are replaced. Painting that refers to regions and has been deferred must be done
+     * before that.
+     */
+    void aboutToRearrange();
+
+private:
+    TextureAtlasPage *createPage(int height);
+    TextureAtlasRegion *allocateDedicated(const QSize &size, int padding);
+    TextureAtlasRegion *place(TextureAtlasPage *page, const QPoint &position, const QSize &size, int padding);
+    bool growPage(TextureAtlasPage *page, const QSize &size, QPoint *position);
+    bool repackPage(TextureAtlasPage *page, const QSize &size, QPoint *position);
+    void release(TextureAtlasRegion *region);
+
+    QVector<TextureAtlasPage *> m_pages;
+    QVector<TextureAtlasPage *> m_dedicatedPages;
+    int m_pageWidth = 0;
+    int m_maximumPageHeight = 0;
+    quint64 m_clock = 0;
+    bool m_enabled = false;
+
+    friend class TextureAtlasRegion;
+};
+
+}
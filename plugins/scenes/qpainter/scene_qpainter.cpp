@@ -750,19 +750,19 @@ SceneQPainterDecorationRenderer::SceneQPainterDecorationRenderer(Decoration::Dec
 
 SceneQPainterDecorationRenderer::~SceneQPainterDecorationRenderer() = default;
 
-QImage SceneQPainterDecorationRenderer::image(SceneQPainterDecorationRenderer::DecorationPart part) const
-{
-    Q_ASSERT(part != DecorationPart::Count);
-    return m_images[int(part)];
-}
-
 void SceneQPainterDecorationRenderer::render()
 {
+    uploadRasterizedTiles();
+
     const QRegion scheduled = getScheduled();
     if (scheduled.isEmpty()) {
         return;
     }
     if (areImageSizesDirty()) {
+        // The tiles that are being rasterized don't fit the new layout of the decoration,
+        // and the new images have to be painted before the window is painted.
+        cancelRasterizing();
+        finishRasterizing();
         resizeImages();
         resetImageSizesDirty();
     }
@@ -777,26 +777,38 @@ void SceneQPainterDecorationRenderer::render()
     const QRect bottom(QPoint(0, left.y() + left.height()), imageSize(DecorationPart::Bottom));
 
     const QRect geometry = scheduled.boundingRect();
-    auto renderPart = [this](const QRect &rect, const QRect &partRect, int index) {
+    QVector<Tile> tiles;
+    auto renderPart = [this, &tiles](const QRect &rect, const QRect &partRect, int index) {
         if (rect.isEmpty()) {
             return;
         }
-        QPainter painter(&m_images[index]);
-        painter.setRenderHint(QPainter::Antialiasing);
-        painter.setWindow(QRect(partRect.topLeft(), partRect.size() * m_images[index].devicePixelRatio()));
-        painter.setClipRect(rect);
-        painter.save();
-        // clear existing part
-        painter.setCompositionMode(QPainter::CompositionMode_Source);
-        painter.fillRect(rect, Qt::transparent);
-        painter.restore();
-        client()->decoration()->paint(&painter, rect);
+        const qreal devicePixelRatio = m_images[index].devicePixelRatio();
+        Tile tile;
+        tile.rect = rect;
+        tile.viewport = QRect(QPoint(0, 0), rect.size());
+        tile.size = rect.size() * devicePixelRatio;
+        tile.devicePixelRatio = devicePixelRatio;
+        tile.part = index;
+        tile.offset = rect.topLeft() - partRect.topLeft();
+        tiles.append(tile);
     };
 
     renderPart(left.intersected(geometry), left, int(DecorationPart::Left));
     renderPart(top.intersected(geometry), top, int(DecorationPart::Top));
     renderPart(right.intersected(geometry), right, int(DecorationPart::Right));
     renderPart(bottom.intersected(geometry), bottom, int(DecorationPart::Bottom));
+
+    rasterize(tiles);
+}
+
+void SceneQPainterDecorationRenderer::uploadTiles(const QVector<Tile> &tiles)
+{
+    for (const Tile &tile : tiles) {
+        QPainter painter(&m_images[tile.part]);
+        // replace the existing part
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(tile.offset, tile.image);
+    }
 }
 
 void SceneQPainterDecorationRenderer::resizeImages()
@@ -822,6 +834,8 @@ void SceneQPainterDecorationRenderer::resizeImages()
 
 void SceneQPainterDecorationRenderer::reparent(Deleted *deleted)
 {
+    // The decoration of a closed window can't be painted again, finish it now.
+    finishRasterizing();
     render();
     Renderer::reparent(deleted);
 }
@@ -150,6 +150,9 @@ public:
 
     QImage image(DecorationPart part) const;
 
+protected:
+    void uploadTiles(const QVector<Tile> &tiles) override;
+
 private:
     void resizeImages();
     QImage m_images[int(DecorationPart::Count)];
@@ -192,6 +195,13 @@ const QImage &QPainterWindowPixmap::image()
     return m_image;
 }
 
+inline
+QImage SceneQPainterDecorationRenderer::image(SceneQPainterDecorationRenderer::DecorationPart part) const
+{
+    Q_ASSERT(part != DecorationPart::Count);
+    return m_images[int(part)];
+}
+
 } // KWin
 
 #endif // KWIN_SCENEQPAINTER_H
@@ -9,11 +9,15 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "pointer_input.h"
+#include "abstract_output.h"
+#include "composite.h"
 #include "platform.h"
+#include "renderloop.h"
 #include "x11client.h"
 #include "effects.h"
 #include "input_event.h"
 #include "input_event_spy.h"
+#include "inputlatencytracer.h"
 #include "osd.h"
 #include "screens.h"
 #include "wayland_server.h"
@@ -39,6 +43,8 @@
 
 #include <linux/input.h>
 
+#include <cmath>
+
 namespace KWin
 {
 
@@ -102,7 +108,13 @@ PointerInputRedirection::PointerInputRedirection(InputRedirection* parent)
     : InputDeviceHandler(parent)
     , m_cursor(nullptr)
     , m_supportsWarping(Application::usesLibinput())
+    , m_motionCoalescingEnabled(qgetenv("KWIN_POINTER_MOTION_COALESCING") == QByteArrayLiteral("1"))
 {
+    // Normally the coalesced motion is flushed when the next frame starts. The timer takes
+    // over if no frame is going to be rendered, e.g. with a hardware cursor or if the outputs
+    // are turned off.
+    m_coalescedMotionTimer.setSingleShot(true);
+    connect(&m_coalescedMotionTimer, &QTimer::timeout, this, &PointerInputRedirection::flushCoalescedMotion);
 }
 
 PointerInputRedirection::~PointerInputRedirection() = default;
@@ -209,7 +221,7 @@ public:
         if (s_counter == 0) {
             if (!s_scheduledPositions.isEmpty()) {
                 const auto pos = s_scheduledPositions.takeFirst();
-                m_pointer->processMotion(pos.pos, pos.delta, pos.deltaNonAccelerated, pos.time, pos.timeUsec, nullptr);
+                m_pointer->processMotion(pos.pos, pos.delta, pos.deltaNonAccelerated, pos.time, pos.timeUsec, nullptr, pos.coalescedMotions);
             }
         }
     }
@@ -218,8 +230,9 @@ public:
         return s_counter > 0;
     }
 
-    static void schedulePosition(const QPointF &pos, const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec) {
-        s_scheduledPositions.append({pos, delta, deltaNonAccelerated, time, timeUsec});
+    static void schedulePosition(const QPointF &pos, const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec,
+                                 const QVector<RelativeMotion> &coalescedMotions) {
+        s_scheduledPositions.append({pos, delta, deltaNonAccelerated, time, timeUsec, coalescedMotions});
     }
 
 private:
@@ -230,6 +243,7 @@ private:
         QSizeF deltaNonAccelerated;
         quint32 time;
         quint64 timeUsec;
+        QVector<RelativeMotion> coalescedMotions;
     };
     static QVector<ScheduledPosition> s_scheduledPositions;
 
@@ -239,13 +253,17 @@ private:
 int PositionUpdateBlocker::s_counter = 0;
 QVector<PositionUpdateBlocker::ScheduledPosition> PositionUpdateBlocker::s_scheduledPositions;
 
-void PointerInputRedirection::processMotion(const QPointF &pos, const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec, LibInput::Device *device)
+void PointerInputRedirection::processMotion(const QPointF &pos, const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec, LibInput::Device *device,
+                                            const QVector<RelativeMotion> &coalescedMotions)
 {
+    // Keep the order of events if a motion is processed while another one is held back.
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
     if (PositionUpdateBlocker::isPositionBlocked()) {
-        PositionUpdateBlocker::schedulePosition(pos, delta, deltaNonAccelerated, time, timeUsec);
+        PositionUpdateBlocker::schedulePosition(pos, delta, deltaNonAccelerated, time, timeUsec, coalescedMotions);
         return;
     }
 
@@ -255,14 +273,122 @@ void PointerInputRedirection::processMotion(const QPointF &pos, const QSizeF &de
                      input()->keyboardModifiers(), time,
                      delta, deltaNonAccelerated, timeUsec, device);
     event.setModifiersRelevantForGlobalShortcuts(input()->modifiersRelevantForGlobalShortcuts());
+    event.setCoalescedMotions(coalescedMotions);
 
     update();
     input()->processSpies(std::bind(&InputEventSpy::pointerEvent, std::placeholders::_1, &event));
     input()->processFilters(std::bind(&InputEventFilter::pointerEvent, std::placeholders::_1, &event, 0));
+
+    if (InputLatencyTracer *tracer = input()->latencyTracer()) {
+        if (!coalescedMotions.isEmpty()) {
+            for (const RelativeMotion &motion : coalescedMotions) {
+                tracer->inputProcessed(std::chrono::microseconds(motion.timestampMicroseconds));
+            }
+        } else if (timeUsec) {
+            tracer->inputProcessed(std::chrono::microseconds(timeUsec));
+        }
+    }
+}
+
+bool PointerInputRedirection::isMotionCoalescingActive() const
+{
+    // Without compositing there are no frames that the motions could be aligned to.
+    return m_motionCoalescingEnabled && Compositor::compositing();
+}
+
+/**
+ * Returns the refresh interval, in milliseconds, of the output that shows @p pos.
+ */
+static int refreshInterval(const QPointF &pos)
+{
+    Platform *platform = kwinApp()->platform();
+    RenderLoop *renderLoop = platform->renderLoop();
+    if (platform->isPerScreenRenderingEnabled()) {
+        const QVector<AbstractOutput *> outputs = platform->enabledOutputs();
+        const int screen = screens()->number(pos.toPoint());
+        if (screen >= 0 && screen < outputs.count()) {
+            renderLoop = outputs[screen]->renderLoop();
+        }
+    }
+    const int refreshRate = renderLoop ? renderLoop->refreshRate() : 0;
+    if (refreshRate <= 0) {
+        return 16;
+    }
+    return std::ceil(1000000.0 / refreshRate);
+}
+
+PointerInputRedirection::CoalescedMotion &PointerInputRedirection::coalesceMotion(LibInput::Device *device)
+{
+    if (m_coalescedMotion && m_coalescedMotion->device != device) {
+        flushCoalescedMotion();
+    }
+    if (!m_coalescedMotion) {
+        m_coalescedMotion = CoalescedMotion();
+        m_coalescedMotion->pos = m_pos;
+        m_coalescedMotion->device = device;
+        m_coalescedMotionTimer.start(refreshInterval(m_pos));
+        // The next frame flushes the motion. A software cursor has to be painted anyway, a
+        // hardware cursor moves without a frame, the timer flushes the motion then.
+        Platform *platform = kwinApp()->platform();
+        if (platform->usesSoftwareCursor() && !platform->isCursorHidden()) {
+            Compositor::self()->scheduleRepaint();
+        }
+    }
+    return *m_coalescedMotion;
+}
+
+void PointerInputRedirection::processRelativeMotion(const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec, LibInput::Device *device)
+{
+    if (!isMotionCoalescingActive()) {
+        processMotion(m_pos + QPointF(delta.width(), delta.height()), delta, deltaNonAccelerated, time, timeUsec, device);
+        return;
+    }
+
+    CoalescedMotion &motion = coalesceMotion(device);
+    // Confine every step, like separate motions would be, so pushing against a screen edge
+    // or a pointer constraint and back doesn't move the pointer away from the edge.
+    motion.pos = confinePosition(motion.pos + QPointF(delta.width(), delta.height()), motion.pos);
+    if (motion.relativeMotions.isEmpty()) {
+        motion.delta = delta;
+        motion.deltaNonAccelerated = deltaNonAccelerated;
+    } else {
+        motion.delta += delta;
+        motion.deltaNonAccelerated += deltaNonAccelerated;
+    }
+    motion.relativeMotions.append(RelativeMotion{delta, deltaNonAccelerated, timeUsec});
+    motion.time = time;
+    motion.timeUsec = timeUsec;
+}
+
+void PointerInputRedirection::processAbsoluteMotion(const QPointF &pos, uint32_t time, LibInput::Device *device)
+{
+    if (!isMotionCoalescingActive()) {
+        processMotion(pos, time, device);
+        return;
+    }
+
+    CoalescedMotion &motion = coalesceMotion(device);
+    motion.pos = pos;
+    motion.time = time;
+}
+
+void PointerInputRedirection::flushCoalescedMotion()
+{
+    if (!m_coalescedMotion) {
+        return;
+    }
+    m_coalescedMotionTimer.stop();
+
+    const CoalescedMotion motion = std::move(*m_coalescedMotion);
+    m_coalescedMotion.reset();
+    processMotion(motion.pos, motion.delta, motion.deltaNonAccelerated, motion.time, motion.timeUsec,
+                  motion.device, motion.relativeMotions);
 }
 
 void PointerInputRedirection::processButton(uint32_t button, InputRedirection::PointerButtonState state, uint32_t time, LibInput::Device *device)
 {
+    flushCoalescedMotion();
+
     QEvent::Type type;
     switch (state) {
     case InputRedirection::PointerButtonReleased:
@@ -300,6 +426,8 @@ void PointerInputRedirection::processButton(uint32_t button, InputRedirection::P
 void PointerInputRedirection::processAxis(InputRedirection::PointerAxis axis, qreal delta, qint32 discreteDelta,
     InputRedirection::PointerAxisSource source, uint32_t time, LibInput::Device *device)
 {
+    flushCoalescedMotion();
+
     update();
 
     emit input()->pointerAxisChanged(axis, delta);
@@ -320,6 +448,8 @@ void PointerInputRedirection::processAxis(InputRedirection::PointerAxis axis, qr
 void PointerInputRedirection::processSwipeGestureBegin(int fingerCount, quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -331,6 +461,8 @@ void PointerInputRedirection::processSwipeGestureBegin(int fingerCount, quint32
 void PointerInputRedirection::processSwipeGestureUpdate(const QSizeF &delta, quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -343,6 +475,8 @@ void PointerInputRedirection::processSwipeGestureUpdate(const QSizeF &delta, qui
 void PointerInputRedirection::processSwipeGestureEnd(quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -355,6 +489,8 @@ void PointerInputRedirection::processSwipeGestureEnd(quint32 time, KWin::LibInpu
 void PointerInputRedirection::processSwipeGestureCancelled(quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -367,6 +503,8 @@ void PointerInputRedirection::processSwipeGestureCancelled(quint32 time, KWin::L
 void PointerInputRedirection::processPinchGestureBegin(int fingerCount, quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -379,6 +517,8 @@ void PointerInputRedirection::processPinchGestureBegin(int fingerCount, quint32
 void PointerInputRedirection::processPinchGestureUpdate(qreal scale, qreal angleDelta, const QSizeF &delta, quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -391,6 +531,8 @@ void PointerInputRedirection::processPinchGestureUpdate(qreal scale, qreal angle
 void PointerInputRedirection::processPinchGestureEnd(quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -403,6 +545,8 @@ void PointerInputRedirection::processPinchGestureEnd(quint32 time, KWin::LibInpu
 void PointerInputRedirection::processPinchGestureCancelled(quint32 time, KWin::LibInput::Device *device)
 {
     Q_UNUSED(device)
+    flushCoalescedMotion();
+
     if (!inited()) {
         return;
     }
@@ -764,7 +908,7 @@ void PointerInputRedirection::warpXcbOnSurfaceLeft(KWaylandServer::SurfaceInterf
     xcb_flush(c);
 }
 
-QPointF PointerInputRedirection::applyPointerConfinement(const QPointF &pos) const
+QPointF PointerInputRedirection::applyPointerConfinement(const QPointF &pos, const QPointF &current) const
 {
     if (!focus()) {
         return pos;
@@ -787,23 +931,23 @@ QPointF PointerInputRedirection::applyPointerConfinement(const QPointF &pos) con
     }
     QPointF p = pos;
     // allow either x or y to pass
-    p = QPointF(m_pos.x(), pos.y());
+    p = QPointF(current.x(), pos.y());
     if (confinementRegion.contains(p.toPoint())) {
         return p;
     }
-    p = QPointF(pos.x(), m_pos.y());
+    p = QPointF(pos.x(), current.y());
     if (confinementRegion.contains(p.toPoint())) {
         return p;
     }
 
-    return m_pos;
+    return current;
 }
 
-void PointerInputRedirection::updatePosition(const QPointF &pos)
+QPointF PointerInputRedirection::confinePosition(const QPointF &pos, const QPointF &current) const
 {
     if (m_locked) {
         // locked pointer should not move
-        return;
+        return current;
     }
     // verify that at least one screen contains the pointer position
     QPointF p = pos;
@@ -811,17 +955,23 @@ void PointerInputRedirection::updatePosition(const QPointF &pos)
         const QRectF unitedScreensGeometry = screens()->geometry();
         p = confineToBoundingBox(p, unitedScreensGeometry);
         if (!screenContainsPos(p)) {
-            const QRectF currentScreenGeometry = screens()->geometry(screens()->number(m_pos.toPoint()));
+            const QRectF currentScreenGeometry = screens()->geometry(screens()->number(current.toPoint()));
             p = confineToBoundingBox(p, currentScreenGeometry);
         }
     }
-    p = applyPointerConfinement(p);
-    if (p == m_pos) {
-        // didn't change due to confinement
-        return;
-    }
+    p = applyPointerConfinement(p, current);
     // verify screen confinement
     if (!screenContainsPos(p)) {
+        return current;
+    }
+    return p;
+}
+
+void PointerInputRedirection::updatePosition(const QPointF &pos)
+{
+    const QPointF p = confinePosition(pos, m_pos);
+    if (p == m_pos) {
+        // didn't change due to confinement
         return;
     }
     m_pos = p;
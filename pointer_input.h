@@ -12,6 +12,7 @@
 #define KWIN_POINTER_INPUT_H
 
 #include "input.h"
+#include "input_event.h"
 #include "cursor.h"
 #include "xcursortheme.h"
 
@@ -19,6 +20,9 @@
 #include <QObject>
 #include <QPointer>
 #include <QPointF>
+#include <QTimer>
+
+#include <optional>
 
 class QWindow;
 
@@ -89,7 +93,26 @@ public:
     /**
      * @internal
      */
-    void processMotion(const QPointF &pos, const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec, LibInput::Device *device);
+    void processMotion(const QPointF &pos, const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec, LibInput::Device *device,
+                       const QVector<RelativeMotion> &coalescedMotions = QVector<RelativeMotion>());
+    /**
+     * Processes a relative motion of a pointer device. If motion coalescing is enabled,
+     * the motion is merged with other motions until the next frame starts.
+     * @internal
+     */
+    void processRelativeMotion(const QSizeF &delta, const QSizeF &deltaNonAccelerated, uint32_t time, quint64 timeUsec, LibInput::Device *device);
+    /**
+     * Processes an absolute motion of a pointer device. If motion coalescing is enabled,
+     * the motion is merged with other motions until the next frame starts.
+     * @internal
+     */
+    void processAbsoluteMotion(const QPointF &pos, uint32_t time, LibInput::Device *device);
+    /**
+     * Processes the pointer motion that has been held back by motion coalescing, if any.
+     *
+     * Motion coalescing can be enabled with KWIN_POINTER_MOTION_COALESCING=1.
+     */
+    void flushCoalescedMotion();
     /**
      * @internal
      */
@@ -144,11 +167,30 @@ private:
     void updatePosition(const QPointF &pos);
     void updateButton(uint32_t button, InputRedirection::PointerButtonState state);
     void warpXcbOnSurfaceLeft(KWaylandServer::SurfaceInterface *surface);
-    QPointF applyPointerConfinement(const QPointF &pos) const;
+    QPointF applyPointerConfinement(const QPointF &pos, const QPointF &current) const;
+    /**
+     * Returns where the pointer ends up if it's moved from @p current to @p pos, taking the
+     * screens, pointer constraints and locks into account.
+     */
+    QPointF confinePosition(const QPointF &pos, const QPointF &current) const;
     void disconnectConfinedPointerRegionConnection();
     void disconnectLockedPointerAboutToBeUnboundConnection();
     void disconnectPointerConstraintsConnection();
     void breakPointerConstraints(KWaylandServer::SurfaceInterface *surface);
+
+    struct CoalescedMotion
+    {
+        QPointF pos;
+        QSizeF delta;
+        QSizeF deltaNonAccelerated;
+        QVector<RelativeMotion> relativeMotions;
+        quint32 time = 0;
+        quint64 timeUsec = 0;
+        LibInput::Device *device = nullptr;
+    };
+    bool isMotionCoalescingActive() const;
+    CoalescedMotion &coalesceMotion(LibInput::Device *device);
+
     CursorImage *m_cursor;
     bool m_supportsWarping;
     QPointF m_pos;
@@ -164,6 +206,9 @@ private:
     bool m_confined = false;
     bool m_locked = false;
     bool m_enableConstraints = true;
+    bool m_motionCoalescingEnabled;
+    std::optional<CoalescedMotion> m_coalescedMotion;
+    QTimer m_coalescedMotionTimer;
 };
 
 class WaylandCursorImage : public QObject
@@ -0,0 +1,661 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "rectset.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+namespace KWin
+{
+
+namespace
+{
+
+/**
+ * Keeps a few storage blocks of every size class around so that sets which grow beyond
+ * the inline storage on every frame don't hit the allocator on every frame.
+ */
+class RectSetPool
+{
+public:
+    ~RectSetPool();
+
+    qint32 *acquire(int capacity);
+    void release(qint32 *block, int capacity);
+
+private:
+    static constexpr int s_minimumCapacity = 16;
+    static constexpr int s_classCount = 10;
+    static constexpr int s_maxFreeBlocks = 4;
+
+    static int classOf(int capacity);
+
+    qint32 *m_freeBlocks[s_classCount][s_maxFreeBlocks] = {};
+    int m_freeCount[s_classCount] = {};
+};
+
+thread_local RectSetPool s_pool;
+// The pool of the main thread is destroyed before sets with static storage duration.
+thread_local bool s_poolDestroyed = false;
+
+RectSetPool::~RectSetPool()
+{
+    for (int i = 0; i < s_classCount; ++i) {
+        for (int j = 0; j < m_freeCount[i]; ++j) {
+            std::free(m_freeBlocks[i][j]);
+        }
+    }
+    s_poolDestroyed = true;
+}
+
+int RectSetPool::classOf(int capacity)
+{
+    int sizeClass = 0;
+    while ((s_minimumCapacity << sizeClass) < capacity) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+qint32 *RectSetPool::acquire(int capacity)
+{
+    const int sizeClass = classOf(capacity);
+    if (sizeClass < s_classCount && m_freeCount[sizeClass] > 0) {
+        return m_freeBlocks[sizeClass][--m_freeCount[sizeClass]];
+    }
+    return static_cast<qint32 *>(std::malloc(4 * sizeof(qint32) * capacity));
+}
+
+void RectSetPool::release(qint32 *block, int capacity)
+{
+    const int sizeClass = classOf(capacity);
+    if (sizeClass < s_classCount && m_freeCount[sizeClass] < s_maxFreeBlocks) {
+        m_freeBlocks[sizeClass][m_freeCount[sizeClass]++] = block;
+        return;
+    }
+    std::free(block);
+}
+
+qint32 *acquireBlock(int capacity)
+{
+    if (s_poolDestroyed) {
+        return static_cast<qint32 *>(std::malloc(4 * sizeof(qint32) * capacity));
+    }
+    return s_pool.acquire(capacity);
+}
+
+void releaseBlock(qint32 *block, int capacity)
+{
+    if (s_poolDestroyed) {
+        std::free(block);
+    } else {
+        s_pool.release(block, capacity);
+    }
+}
+
+} // anonymous namespace
+
+RectSet::RectSet()
+    : m_data(m_inline)
+{
+}
+
+RectSet::RectSet(const QRect &rect)
+    : m_data(m_inline)
+{
+    if (!rect.isEmpty()) {
+        append(rect.x(), rect.y(), rect.x() + rect.width(), rect.y() + rect.height());
+    }
+}
+
+RectSet::RectSet(const QRegion &region)
+    : m_data(m_inline)
+{
+    // The rectangles of a QRegion don't overlap, so they can be taken as they are.
+    reserve(region.rectCount());
+    for (const QRect &rect : region) {
+        append(rect.x(), rect.y(), rect.x() + rect.width(), rect.y() + rect.height());
+    }
+}
+
+RectSet::RectSet(const RectSet &other)
+    : m_data(m_inline)
+{
+    copyFrom(other);
+}
+
+RectSet::RectSet(RectSet &&other)
+    : m_data(m_inline)
+{
+    moveFrom(other);
+}
+
+RectSet::~RectSet()
+{
+    if (!isInline()) {
+        releaseBlock(m_data, m_capacity);
+    }
+}
+
+RectSet &RectSet::operator=(const RectSet &other)
+{
+    if (this != &other) {
+        copyFrom(other);
+    }
+    return *this;
+}
+
+RectSet &RectSet::operator=(RectSet &&other)
+{
+    if (this != &other) {
+        if (!isInline()) {
+            releaseBlock(m_data, m_capacity);
+            m_data = m_inline;
+            m_capacity = s_inlineCapacity;
+        }
+        moveFrom(other);
+    }
+    return *this;
+}
+
+bool RectSet::isInline() const
+{
+    return m_data == m_inline;
+}
+
+void RectSet::copyFrom(const RectSet &other)
+{
+    m_count = 0;
+    reserve(other.m_count);
+    const size_t size = sizeof(qint32) * other.m_count;
+    std::memcpy(x1(), other.x1(), size);
+    std::memcpy(y1(), other.y1(), size);
+    std::memcpy(x2(), other.x2(), size);
+    std::memcpy(y2(), other.y2(), size);
+    m_count = other.m_count;
+}
+
+void RectSet::moveFrom(RectSet &other)
+{
+    if (other.isInline()) {
+        copyFrom(other);
+    } else {
+        m_data = other.m_data;
+        m_capacity = other.m_capacity;
+        m_count = other.m_count;
+        other.m_data = other.m_inline;
+        other.m_capacity = s_inlineCapacity;
+    }
+    other.m_count = 0;
+}
+
+void RectSet::reserve(int capacity)
+{
+    if (capacity <= m_capacity) {
+        return;
+    }
+    int newCapacity = std::max(2 * m_capacity, 16);
+    while (newCapacity < capacity) {
+        newCapacity *= 2;
+    }
+
+    qint32 *data = acquireBlock(newCapacity);
+    const size_t size = sizeof(qint32) * m_count;
+    std::memcpy(data, x1(), size);
+    std::memcpy(data + newCapacity, y1(), size);
+    std::memcpy(data + 2 * newCapacity, x2(), size);
+    std::memcpy(data + 3 * newCapacity, y2(), size);
+
+    if (!isInline()) {
+        releaseBlock(m_data, m_capacity);
+    }
+    m_data = data;
+    m_capacity = newCapacity;
+}
+
+void RectSet::append(qint32 left, qint32 top, qint32 right, qint32 bottom)
+{
+    if (m_count == m_capacity) {
+        reserve(m_count + 1);
+    }
+    x1()[m_count] = left;
+    y1()[m_count] = top;
+    x2()[m_count] = right;
+    y2()[m_count] = bottom;
+    ++m_count;
+}
+
+void RectSet::appendCoalesced(qint32 left, qint32 top, qint32 right, qint32 bottom)
+{
+    // Merge the new rectangle with rectangles that share a whole edge with it in order
+    // to keep the fragmentation caused by repeated unions in check.
+    for (int i = 0; i < m_count;) {
+        const bool sameRows = y1()[i] == top && y2()[i] == bottom;
+        const bool sameColumns = x1()[i] == left && x2()[i] == right;
+        if (sameRows && (x2()[i] == left || x1()[i] == right)) {
+            left = std::min(left, x1()[i]);
+            right = std::max(right, x2()[i]);
+        } else if (sameColumns && (y2()[i] == top || y1()[i] == bottom)) {
+            top = std::min(top, y1()[i]);
+            bottom = std::max(bottom, y2()[i]);
+        } else {
+            ++i;
+            continue;
+        }
+        removeAt(i);
+        i = 0;
+    }
+    append(left, top, right, bottom);
+}
+
+void RectSet::removeAt(int index)
+{
+    const int last = m_count - 1;
+    x1()[index] = x1()[last];
+    y1()[index] = y1()[last];
+    x2()[index] = x2()[last];
+    y2()[index] = y2()[last];
+    --m_count;
+}
+
+int RectSet::nextIntersecting(int from, int to, qint32 left, qint32 top, qint32 right, qint32 bottom) const
+{
+    const qint32 *lefts = x1();
+    const qint32 *tops = y1();
+    const qint32 *rights = x2();
+    const qint32 *bottoms = y2();
+
+    int i = from;
+#if defined(__SSE2__)
+    const __m128i otherLeft = _mm_set1_epi32(left);
+    const __m128i otherTop = _mm_set1_epi32(top);
+    const __m128i otherRight = _mm_set1_epi32(right);
+    const __m128i otherBottom = _mm_set1_epi32(bottom);
+
+    for (; i + 4 <= to; i += 4) {
+        const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lefts + i));
+        const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tops + i));
+        const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rights + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bottoms + i));
+
+        const __m128i horizontal = _mm_and_si128(_mm_cmplt_epi32(l, otherRight),
+                                                 _mm_cmplt_epi32(otherLeft, r));
+        const __m128i vertical = _mm_and_si128(_mm_cmplt_epi32(t, otherBottom),
+                                               _mm_cmplt_epi32(otherTop, b));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(horizontal, vertical)));
+        if (mask) {
+            return i + qCountTrailingZeroBits(uint(mask));
+        }
+    }
+#endif // __SSE2__
+    for (; i < to; ++i) {
+        if (lefts[i] < right && left < rights[i] && tops[i] < bottom && top < bottoms[i]) {
+            return i;
+        }
+    }
+    return to;
+}
+
+QRect RectSet::boundingRect() const
+{
+    if (m_count == 0) {
+        return QRect();
+    }
+    qint32 left = x1()[0];
+    qint32 top = y1()[0];
+    qint32 right = x2()[0];
+    qint32 bottom = y2()[0];
+    for (int i = 1; i < m_count; ++i) {
+        left = std::min(left, x1()[i]);
+        top = std::min(top, y1()[i]);
+        right = std::max(right, x2()[i]);
+        bottom = std::max(bottom, y2()[i]);
+    }
+    return QRect(left, top, right - left, bottom - top);
+}
+
+void RectSet::clear()
+{
+    m_count = 0;
+}
+
+bool RectSet::intersects(const QRect &rect) const
+{
+    if (rect.isEmpty()) {
+        return false;
+    }
+    return nextIntersecting(0, m_count, rect.x(), rect.y(),
+                            rect.x() + rect.width(), rect.y() + rect.height()) != m_count;
+}
+
+bool RectSet::intersects(const RectSet &other) const
+{
+    for (int i = 0; i < other.m_count; ++i) {
+        if (nextIntersecting(0, m_count, other.x1()[i], other.y1()[i], other.x2()[i], other.y2()[i]) != m_count) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RectSet::unite(const QRect &rect)
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+    const qint32 left = rect.x();
+    const qint32 top = rect.y();
+    const qint32 right = rect.x() + rect.width();
+    const qint32 bottom = rect.y() + rect.height();
+
+    for (int i = 0; i < m_count; ++i) {
+        if (x1()[i] <= left && y1()[i] <= top && right <= x2()[i] && bottom <= y2()[i]) {
+            return;
+        }
+    }
+
+    subtract(rect);
+    appendCoalesced(left, top, right, bottom);
+}
+
+void RectSet::unite(const RectSet &other)
+{
+    if (m_count == 0) {
+        *this = other;
+        return;
+    }
+    for (int i = 0; i < other.m_count; ++i) {
+        unite(other.rectAt(i));
+    }
+}
+
+void RectSet::subtract(const QRect &rect)
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+    const qint32 left = rect.x();
+    const qint32 top = rect.y();
+    const qint32 right = rect.x() + rect.width();
+    const qint32 bottom = rect.y() + rect.height();
+
+    // Rectangles that don't intersect the subtracted rectangle are compacted at the front,
+    // the remaining parts of the intersecting rectangles are appended after the original
+    // rectangles and moved down at the end.
+    const int count = m_count;
+    int write = 0;
+    int read = 0;
+    while (read < count) {
+        const int next = nextIntersecting(read, count, left, top, right, bottom);
+        if (write != read) {
+            const size_t size = sizeof(qint32) * (next - read);
+            std::memmove(x1() + write, x1() + read, size);
+            std::memmove(y1() + write, y1() + read, size);
+            std::memmove(x2() + write, x2() + read, size);
+            std::memmove(y2() + write, y2() + read, size);
+        }
+        write += next - read;
+        if (next == count) {
+            break;
+        }
+
+        const qint32 l = x1()[next];
+        const qint32 t = y1()[next];
+        const qint32 r = x2()[next];
+        const qint32 b = y2()[next];
+        const qint32 middleTop = std::max(t, top);
+        const qint32 middleBottom = std::min(b, bottom);
+        if (t < top) {
+            append(l, t, r, top);
+        }
+        if (bottom < b) {
+            append(l, bottom, r, b);
+        }
+        if (l < left) {
+            append(l, middleTop, left, middleBottom);
+        }
+        if (right < r) {
+            append(right, middleTop, r, middleBottom);
+        }
+        read = next + 1;
+    }
+
+    const int pieces = m_count - count;
+    if (write != count && pieces > 0) {
+        const size_t size = sizeof(qint32) * pieces;
+        std::memmove(x1() + write, x1() + count, size);
+        std::memmove(y1() + write, y1() + count, size);
+        std::memmove(x2() + write, x2() + count, size);
+        std::memmove(y2() + write, y2() + count, size);
+    }
+    m_count = write + pieces;
+}
+
+void RectSet::subtract(const RectSet &other)
+{
+    for (int i = 0; i < other.m_count && m_count > 0; ++i) {
+        subtract(other.rectAt(i));
+    }
+}
+
+void RectSet::intersect(const QRect &rect)
+{
+    if (rect.isEmpty()) {
+        clear();
+        return;
+    }
+    const qint32 left = rect.x();
+    const qint32 top = rect.y();
+    const qint32 right = rect.x() + rect.width();
+    const qint32 bottom = rect.y() + rect.height();
+
+    int write = 0;
+    for (int i = 0; i < m_count; ++i) {
+        const qint32 l = std::max(x1()[i], left);
+        const qint32 t = std::max(y1()[i], top);
+        const qint32 r = std::min(x2()[i], right);
+        const qint32 b = std::min(y2()[i], bottom);
+        if (l < r && t < b) {
+            x1()[write] = l;
+            y1()[write] = t;
+            x2()[write] = r;
+            y2()[write] = b;
+            ++write;
+        }
+    }
+    m_count = write;
+}
+
+void RectSet::intersect(const RectSet &other)
+{
+    if (other.m_count == 1) {
+        intersect(other.rectAt(0));
+        return;
+    }
+
+    // The rectangles in either set don't overlap, so neither do their pairwise intersections.
+    RectSet result;
+    for (int i = 0; i < m_count; ++i) {
+        for (int j = 0; j < other.m_count; ++j) {
+            const qint32 l = std::max(x1()[i], other.x1()[j]);
+            const qint32 t = std::max(y1()[i], other.y1()[j]);
+            const qint32 r = std::min(x2()[i], other.x2()[j]);
+            const qint32 b = std::min(y2()[i], other.y2()[j]);
+            if (l < r && t < b) {
+                result.append(l, t, r, b);
+            }
+        }
+    }
+    *this = std::move(result);
+}
+
+void RectSet::translate(const QPoint &offset)
+{
+    const qint32 dx = offset.x();
+    const qint32 dy = offset.y();
+    for (int i = 0; i < m_count; ++i) {
+        x1()[i] += dx;
+        x2()[i] += dx;
+    }
+    for (int i = 0; i < m_count; ++i) {
+        y1()[i] += dy;
+        y2()[i] += dy;
+    }
+}
+
+RectSet RectSet::united(const RectSet &other) const
+{
+    RectSet result(*this);
+    result.unite(other);
+    return result;
+}
+
+RectSet RectSet::subtracted(const RectSet &other) const
+{
+    RectSet result(*this);
+    result.subtract(other);
+    return result;
+}
+
+RectSet RectSet::intersected(const RectSet &other) const
+{
+    RectSet result(*this);
+    result.intersect(other);
+    return result;
+}
+
+RectSet RectSet::translated(const QPoint &offset) const
+{
+    RectSet result(*this);
+    result.translate(offset);
+    return result;
+}
+
+RectSet &RectSet::operator|=(const RectSet &other)
+{
+    unite(other);
+    return *this;
+}
+
+RectSet &RectSet::operator-=(const RectSet &other)
+{
+    subtract(other);
+    return *this;
+}
+
+RectSet &RectSet::operator&=(const RectSet &other)
+{
+    intersect(other);
+    return *this;
+}
+
+RectSet RectSet::operator|(const RectSet &other) const
+{
+    return united(other);
+}
+
+RectSet RectSet::operator-(const RectSet &other) const
+{
+    return subtracted(other);
+}
+
+RectSet RectSet::operator&(const RectSet &other) const
+{
+    return intersected(other);
+}
+
+QRegion RectSet::toRegion() const
+{
+    if (m_count == 0) {
+        return QRegion();
+    } else if (m_count == 1) {
+        return QRegion(rectAt(0));
+    }
+
+    struct Span
+    {
+        qint32 left;
+        qint32 right;
+
+        bool operator==(const Span &other) const
+        {
+            return left == other.left && right == other.right;
+        }
+    };
+
+    // Cut the set in horizontal bands at every top and bottom edge, merge the spans in
+    // every band and coalesce consecutive bands with identical spans. This yields the
+    // same y-x banded representation that QRegion uses internally.
+    QVarLengthArray<qint32, 4 * s_inlineCapacity> edges;
+    for (int i = 0; i < m_count; ++i) {
+        edges.append(y1()[i]);
+        edges.append(y2()[i]);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.resize(std::unique(edges.begin(), edges.end()) - edges.begin());
+
+    QVarLengthArray<QRect, 4 * s_inlineCapacity> rects;
+    QVarLengthArray<Span, s_inlineCapacity> spans;
+    QVarLengthArray<Span, s_inlineCapacity> previousSpans;
+    int previousBandStart = 0;
+    qint32 previousBottom = 0;
+
+    for (int e = 0; e + 1 < edges.count(); ++e) {
+        const qint32 top = edges[e];
+        const qint32 bottom = edges[e + 1];
+
+        spans.clear();
+        for (int i = 0; i < m_count; ++i) {
+            if (y1()[i] <= top && bottom <= y2()[i]) {
+                spans.append(Span{x1()[i], x2()[i]});
+            }
+        }
+        if (spans.isEmpty()) {
+            previousSpans.clear();
+            continue;
+        }
+
+        std::sort(spans.begin(), spans.end(), [](const Span &a, const Span &b) {
+            return a.left < b.left;
+        });
+        int merged = 0;
+        for (int i = 0; i < spans.count(); ++i) {
+            if (merged > 0 && spans[i].left <= spans[merged - 1].right) {
+                spans[merged - 1].right = std::max(spans[merged - 1].right, spans[i].right);
+            } else {
+                spans[merged++] = spans[i];
+            }
+        }
+        spans.resize(merged);
+
+        if (!previousSpans.isEmpty() && previousBottom == top && previousSpans == spans) {
+            for (int i = previousBandStart; i < rects.count(); ++i) {
+                rects[i].setBottom(bottom - 1);
+            }
+        } else {
+            previousBandStart = rects.count();
+            for (const Span &span : qAsConst(spans)) {
+                rects.append(QRect(span.left, top, span.right - span.left, bottom - top));
+            }
+            previousSpans = spans;
+        }
+        previousBottom = bottom;
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.count());
+    return region;
+}
+
+} // namespace KWin
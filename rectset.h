@@ -0,0 +1,120 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwinglobals.h"
+
+#include <QRect>
+#include <QRegion>
+
+namespace KWin
+{
+
+/**
+ * The RectSet class represents an area as a set of non-overlapping rectangles.
+ *
+ * Unlike QRegion, the rectangles are neither sorted nor kept in y-x bands, which makes
+ * unions and subtractions considerably cheaper. The rectangles are stored as four packed
+ * arrays of 32-bit coordinates so that hit tests can be vectorized. Small sets are stored
+ * inline, larger sets use storage blocks that are recycled through a per-thread pool.
+ *
+ * RectSet is meant to be used for region arithmetic in the compositing hot path. Use
+ * toRegion() to pass the result to code that expects a QRegion, e.g. effects.
+ */
+class KWIN_EXPORT RectSet
+{
+public:
+    RectSet();
+    RectSet(const QRect &rect);
+    explicit RectSet(const QRegion &region);
+    RectSet(const RectSet &other);
+    RectSet(RectSet &&other);
+    ~RectSet();
+
+    RectSet &operator=(const RectSet &other);
+    RectSet &operator=(RectSet &&other);
+
+    bool isEmpty() const;
+    int rectCount() const;
+    QRect rectAt(int index) const;
+    QRect boundingRect() const;
+
+    /**
+     * Removes all rectangles. The allocated storage is kept around for reuse.
+     */
+    void clear();
+
+    bool intersects(const QRect &rect) const;
+    bool intersects(const RectSet &other) const;
+
+    void unite(const QRect &rect);
+    void unite(const RectSet &other);
+    void subtract(const QRect &rect);
+    void subtract(const RectSet &other);
+    void intersect(const QRect &rect);
+    void intersect(const RectSet &other);
+    void translate(const QPoint &offset);
+
+    RectSet united(const RectSet &other) const;
+    RectSet subtracted(const RectSet &other) const;
+    RectSet intersected(const RectSet &other) const;
+    RectSet translated(const QPoint &offset) const;
+
+    RectSet &operator|=(const RectSet &other);
+    RectSet &operator-=(const RectSet &other);
+    RectSet &operator&=(const RectSet &other);
+
+    RectSet operator|(const RectSet &other) const;
+    RectSet operator-(const RectSet &other) const;
+    RectSet operator&(const RectSet &other) const;
+
+    /**
+     * Converts the set to a QRegion. The returned region is in canonical form, i.e. it
+     * compares equal to a QRegion that has been built from the same area using QRegion
+     * operations.
+     */
+    QRegion toRegion() const;
+
+private:
+    static constexpr int s_inlineCapacity = 8;
+
+    qint32 *x1() const { return m_data; }
+    qint32 *y1() const { return m_data + m_capacity; }
+    qint32 *x2() const { return m_data + 2 * m_capacity; }
+    qint32 *y2() const { return m_data + 3 * m_capacity; }
+
+    bool isInline() const;
+    void reserve(int capacity);
+    void append(qint32 left, qint32 top, qint32 right, qint32 bottom);
+    void appendCoalesced(qint32 left, qint32 top, qint32 right, qint32 bottom);
+    void removeAt(int index);
+    int nextIntersecting(int from, int to, qint32 left, qint32 top, qint32 right, qint32 bottom) const;
+    void copyFrom(const RectSet &other);
+    void moveFrom(RectSet &other);
+
+    qint32 *m_data;
+    int m_count = 0;
+    int m_capacity = s_inlineCapacity;
+    alignas(16) qint32 m_inline[4 * s_inlineCapacity];
+};
+
+inline bool RectSet::isEmpty() const
+{
+    return m_count == 0;
+}
+
+inline int RectSet::rectCount() const
+{
+    return m_count;
+}
+
+inline QRect RectSet::rectAt(int index) const
+{
+    return QRect(x1()[index], y1()[index], x2()[index] - x1()[index], y2()[index] - y1()[index]);
+}
+
+} // namespace KWin
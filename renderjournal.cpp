@@ -6,16 +6,149 @@
 
 #include "renderjournal.h"
 
+#include <QTextStream>
+#include <QtAlgorithms>
+
+#include <cmath>
+
 namespace KWin
 {
 
+static std::chrono::nanoseconds currentTimestamp()
+{
+    return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+std::chrono::nanoseconds RenderRecord::renderTime() const
+{
+    const std::chrono::nanoseconds end = std::max(renderEndTimestamp, gpuCompletionTimestamp);
+    return end - renderStartTimestamp;
+}
+
+std::chrono::nanoseconds RenderRecord::latency() const
+{
+    if (presentationTimestamp == std::chrono::nanoseconds::zero()) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return presentationTimestamp - renderStartTimestamp;
+}
+
+std::chrono::nanoseconds RenderRecord::wakeupError() const
+{
+    if (scheduledTimestamp == std::chrono::nanoseconds::zero() ||
+            dispatchTimestamp == std::chrono::nanoseconds::zero()) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return dispatchTimestamp - scheduledTimestamp;
+}
+
+static std::chrono::nanoseconds absolute(std::chrono::nanoseconds value)
+{
+    return value < std::chrono::nanoseconds::zero() ? -value : value;
+}
+
+// Frames that were rendered without going through the composite timer have no wakeup error.
+static bool hasWakeupError(const RenderRecord &record)
+{
+    return record.scheduledTimestamp != std::chrono::nanoseconds::zero()
+        && record.dispatchTimestamp != std::chrono::nanoseconds::zero();
+}
+
+int RenderHistogram::indexOf(std::chrono::nanoseconds value)
+{
+    const quint64 micros = std::max<qint64>(0, std::chrono::duration_cast<std::chrono::microseconds>(value).count());
+    if (micros < quint64(s_subBucketCount)) {
+        return int(micros);
+    }
+    const int magnitude = 63 - qCountLeadingZeroBits(micros);
+    const int shift = std::min(magnitude - s_subBucketBits + 1, s_maxShift);
+    const quint64 subBucket = std::min<quint64>(micros >> shift, s_subBucketCount - 1);
+    return shift * s_subBucketHalfCount + int(subBucket);
+}
+
+std::chrono::nanoseconds RenderHistogram::upperBoundOf(int index)
+{
+    if (index < s_subBucketCount) {
+        return std::chrono::microseconds(index);
+    }
+    const int shift = index / s_subBucketHalfCount - 1;
+    const quint64 subBucket = index - shift * s_subBucketHalfCount;
+    return std::chrono::microseconds(((subBucket + 1) << shift) - 1);
+}
+
+void RenderHistogram::add(std::chrono::nanoseconds value)
+{
+    m_buckets[indexOf(value)]++;
+    m_count++;
+}
+
+void RenderHistogram::remove(std::chrono::nanoseconds value)
+{
+    const int index = indexOf(value);
+    Q_ASSERT(m_buckets[index] > 0);
+    m_buckets[index]--;
+    m_count--;
+}
+
+void RenderHistogram::clear()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+}
+
+quint64 RenderHistogram::count() const
+{
+    return m_count;
+}
+
+std::chrono::nanoseconds RenderHistogram::percentile(qreal percentile) const
+{
+    if (!m_count) {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    const quint64 threshold = std::max<quint64>(1, std::ceil(m_count * std::clamp(percentile, 0.0, 100.0) / 100.0));
+    quint64 accumulated = 0;
+    for (int i = 0; i < s_bucketCount; ++i) {
+        accumulated += m_buckets[i];
+        if (accumulated >= threshold) {
+            return upperBoundOf(i);
+        }
+    }
+
+    return upperBoundOf(s_bucketCount - 1);
+}
+
 RenderJournal::RenderJournal()
 {
 }
 
+RenderRecord &RenderJournal::recordAt(quint64 sequence)
+{
+    return m_records[sequence % s_recordCapacity];
+}
+
+const RenderRecord &RenderJournal::recordAt(quint64 sequence) const
+{
+    return m_records[sequence % s_recordCapacity];
+}
+
+void RenderJournal::scheduleFrame(std::chrono::nanoseconds renderTimestamp,
+                                  std::chrono::nanoseconds presentationTimestamp)
+{
+    m_pending.scheduledTimestamp = renderTimestamp;
+    m_pending.targetPresentationTimestamp = presentationTimestamp;
+}
+
+void RenderJournal::dispatchFrame(std::chrono::nanoseconds timestamp)
+{
+    m_pending.dispatchTimestamp = timestamp;
+}
+
 void RenderJournal::beginFrame()
 {
     m_timer.start();
+    m_pending.renderStartTimestamp = currentTimestamp();
 }
 
 void RenderJournal::endFrame()
@@ -25,6 +158,104 @@ void RenderJournal::endFrame()
         m_log.dequeue();
     }
     m_log.enqueue(duration);
+
+    m_pending.renderEndTimestamp = m_pending.renderStartTimestamp + duration;
+
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    if (head >= quint64(s_recordCapacity)) {
+        const quint64 evicted = head - s_recordCapacity;
+        const RenderRecord &record = recordAt(evicted);
+        m_renderTimes.remove(record.renderTime());
+        if (hasWakeupError(record)) {
+            m_wakeupErrors.remove(absolute(record.wakeupError()));
+        }
+        if (record.presentationTimestamp != std::chrono::nanoseconds::zero()) {
+            m_latencies.remove(record.latency());
+        }
+        if (m_presentCursor <= evicted) {
+            m_presentCursor = evicted + 1;
+        }
+    }
+
+    recordAt(head) = m_pending;
+    if (m_pending.directScanout) {
+        m_directScanoutFrameCount++;
+    }
+    m_renderTimes.add(m_pending.renderTime());
+    if (hasWakeupError(m_pending)) {
+        m_wakeupErrors.add(absolute(m_pending.wakeupError()));
+    }
+    if (!m_gpuTimingAvailable) {
+        updatePrediction(m_pending.renderTime());
+    }
+    m_head.store(head + 1, std::memory_order_release);
+
+    m_pending = RenderRecord();
+}
+
+void RenderJournal::markDirectScanout()
+{
+    m_pending.directScanout = true;
+}
+
+void RenderJournal::setGpuCompletionTimestamp(quint64 sequence, std::chrono::nanoseconds timestamp)
+{
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    if (sequence >= head || sequence + s_recordCapacity < head) {
+        return;
+    }
+
+    RenderRecord &record = recordAt(sequence);
+    m_renderTimes.remove(record.renderTime());
+    if (record.presentationTimestamp != std::chrono::nanoseconds::zero()) {
+        m_latencies.remove(record.latency());
+    }
+    record.gpuCompletionTimestamp = timestamp;
+    m_renderTimes.add(record.renderTime());
+    if (record.presentationTimestamp != std::chrono::nanoseconds::zero()) {
+        m_latencies.add(record.latency());
+    }
+
+    if (!m_gpuTimingAvailable) {
+        // Don't mix CPU and GPU render times, start over with the GPU ones.
+        m_gpuTimingAvailable = true;
+        m_predictionValid = false;
+    }
+    updatePrediction(record.renderTime());
+}
+
+void RenderJournal::presentFrame(std::chrono::nanoseconds timestamp, std::chrono::nanoseconds vblankInterval)
+{
+    if (m_presentCursor >= m_head.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    RenderRecord &record = recordAt(m_presentCursor++);
+    record.presentationTimestamp = timestamp;
+    if (record.targetPresentationTimestamp != std::chrono::nanoseconds::zero()) {
+        record.missedVblank = timestamp > record.targetPresentationTimestamp + vblankInterval / 2;
+    }
+    if (record.missedVblank) {
+        m_missedFrameCount++;
+    }
+    m_latencies.add(record.latency());
+}
+
+void RenderJournal::dropFrame()
+{
+    if (m_presentCursor >= m_head.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    recordAt(m_presentCursor++).failed = true;
+}
+
+void RenderJournal::dropPendingFrames()
+{
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    while (m_presentCursor < head) {
+        recordAt(m_presentCursor++).failed = true;
+    }
 }
 
 std::chrono::nanoseconds RenderJournal::minimum() const
@@ -53,4 +284,99 @@ std::chrono::nanoseconds RenderJournal::average() const
     return result / m_log.count();
 }
 
+void RenderJournal::updatePrediction(std::chrono::nanoseconds renderTime)
+{
+    // The smoothing factor is chosen so the predictor adapts within a few dozen frames
+    // while a single slow frame doesn't throw it off.
+    static const qreal alpha = 0.1;
+
+    const qreal sample = renderTime.count();
+    if (!m_predictionValid) {
+        m_predictionMean = sample;
+        m_predictionVariance = 0;
+        m_predictionValid = true;
+        return;
+    }
+
+    const qreal delta = sample - m_predictionMean;
+    m_predictionMean += alpha * delta;
+    m_predictionVariance = (1 - alpha) * (m_predictionVariance + alpha * delta * delta);
+}
+
+std::chrono::nanoseconds RenderJournal::predictedRenderTime() const
+{
+    return std::chrono::nanoseconds(qint64(m_predictionMean));
+}
+
+std::chrono::nanoseconds RenderJournal::predictionMargin() const
+{
+    // Three standard deviations cover the vast majority of frames, but never go below one
+    // millisecond to leave room for scheduling jitter.
+    const std::chrono::nanoseconds margin(qint64(3 * std::sqrt(m_predictionVariance)));
+    return std::max<std::chrono::nanoseconds>(margin, std::chrono::milliseconds(1));
+}
+
+std::chrono::nanoseconds RenderJournal::renderTimePercentile(qreal percentile) const
+{
+    return m_renderTimes.percentile(percentile);
+}
+
+std::chrono::nanoseconds RenderJournal::latencyPercentile(qreal percentile) const
+{
+    return m_latencies.percentile(percentile);
+}
+
+std::chrono::nanoseconds RenderJournal::wakeupErrorPercentile(qreal percentile) const
+{
+    return m_wakeupErrors.percentile(percentile);
+}
+
+quint64 RenderJournal::frameCount() const
+{
+    return m_head.load(std::memory_order_acquire);
+}
+
+quint64 RenderJournal::missedFrameCount() const
+{
+    return m_missedFrameCount;
+}
+
+quint64 RenderJournal::directScanoutFrameCount() const
+{
+    return m_directScanoutFrameCount;
+}
+
+QVector<RenderRecord> RenderJournal::records() const
+{
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const quint64 tail = head > quint64(s_recordCapacity) ? head - s_recordCapacity : 0;
+
+    QVector<RenderRecord> result;
+    result.reserve(head - tail);
+    for (quint64 sequence = tail; sequence < head; ++sequence) {
+        result.append(recordAt(sequence));
+    }
+    return result;
+}
+
+void RenderJournal::dump(QTextStream &stream) const
+{
+    stream << "scheduled,dispatch,render_start,render_end,gpu_completion,target_presentation,"
+              "presentation,missed_vblank,failed,direct_scanout\n";
+
+    const QVector<RenderRecord> entries = records();
+    for (const RenderRecord &record : entries) {
+        stream << record.scheduledTimestamp.count() << ','
+               << record.dispatchTimestamp.count() << ','
+               << record.renderStartTimestamp.count() << ','
+               << record.renderEndTimestamp.count() << ','
+               << record.gpuCompletionTimestamp.count() << ','
+               << record.targetPresentationTimestamp.count() << ','
+               << record.presentationTimestamp.count() << ','
+               << int(record.missedVblank) << ','
+               << int(record.failed) << ','
+               << int(record.directScanout) << '\n';
+    }
+}
+
 } // namespace KWin
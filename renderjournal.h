@@ -10,19 +10,118 @@
 
 #include <QElapsedTimer>
 #include <QQueue>
+#include <QVector>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+class QTextStream;
 
 namespace KWin
 {
 
+/**
+ * The RenderRecord struct describes the life cycle of a single frame, from the moment it
+ * has been scheduled until it has been presented on the screen. All timestamps are sourced
+ * from the monotonic clock. A timestamp is zero if the corresponding event is unknown.
+ */
+struct RenderRecord
+{
+    std::chrono::nanoseconds scheduledTimestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds dispatchTimestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds renderStartTimestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds renderEndTimestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds gpuCompletionTimestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds targetPresentationTimestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds presentationTimestamp = std::chrono::nanoseconds::zero();
+    bool missedVblank = false;
+    bool failed = false;
+    bool directScanout = false;
+
+    /**
+     * Returns the amount of time it took to render the frame. If the GPU completion time
+     * is known, it is taken into account.
+     */
+    std::chrono::nanoseconds renderTime() const;
+
+    /**
+     * Returns the amount of time between the start of rendering and the presentation.
+     */
+    std::chrono::nanoseconds latency() const;
+
+    /**
+     * Returns how late the composite timer has woken up compared to the scheduled time.
+     * The returned value is negative if the timer has fired too early.
+     */
+    std::chrono::nanoseconds wakeupError() const;
+};
+
+/**
+ * The RenderHistogram class is a fixed size histogram with logarithmic buckets that are
+ * linearly subdivided, similar to HdrHistogram. Values are recorded with a microsecond
+ * resolution and a relative error of about 3%, up to roughly 16 seconds.
+ */
+class KWIN_EXPORT RenderHistogram
+{
+public:
+    void add(std::chrono::nanoseconds value);
+    void remove(std::chrono::nanoseconds value);
+    void clear();
+
+    /**
+     * Returns the number of recorded values.
+     */
+    quint64 count() const;
+
+    /**
+     * Returns the smallest value such that @a percentile percent of all recorded values
+     * are less than or equal to it. @a percentile must be in the range [0, 100].
+     */
+    std::chrono::nanoseconds percentile(qreal percentile) const;
+
+private:
+    static constexpr int s_subBucketBits = 5;
+    static constexpr int s_subBucketCount = 1 << s_subBucketBits;
+    static constexpr int s_subBucketHalfCount = s_subBucketCount / 2;
+    static constexpr int s_maxShift = 20;
+    static constexpr int s_bucketCount = s_subBucketHalfCount * (s_maxShift + 2);
+
+    static int indexOf(std::chrono::nanoseconds value);
+    static std::chrono::nanoseconds upperBoundOf(int index);
+
+    std::array<quint32, s_bucketCount> m_buckets = {};
+    quint64 m_count = 0;
+};
+
 /**
  * The RenderJournal class measures how long it takes to render frames and estimates how
  * long it will take to render the next frame.
+ *
+ * Besides the short log of CPU render times used by the minimum, maximum and average
+ * estimators, the journal keeps a ring buffer with the full RenderRecord of the most recent
+ * frames. The ring buffer never allocates memory, its write position is published with
+ * release semantics so the records can be inspected without taking a lock.
  */
 class KWIN_EXPORT RenderJournal
 {
 public:
+    static constexpr int s_recordCapacity = 256;
+
     RenderJournal();
 
+    /**
+     * This function must be called when a new frame is scheduled to be rendered at
+     * @a renderTimestamp and is expected to be presented at @a presentationTimestamp.
+     */
+    void scheduleFrame(std::chrono::nanoseconds renderTimestamp,
+                       std::chrono::nanoseconds presentationTimestamp);
+
+    /**
+     * This function must be called when the composite timer has fired at @a timestamp.
+     */
+    void dispatchFrame(std::chrono::nanoseconds timestamp);
+
     /**
      * This function must be called before starting rendering a new frame.
      */
@@ -33,6 +132,37 @@ public:
      */
     void endFrame();
 
+    /**
+     * Sets the time when the GPU finished executing the commands of the frame with the
+     * given @a sequence number. The sequence number of a frame is the value of frameCount()
+     * at the time the frame was being rendered.
+     *
+     * Once GPU completion times are reported, the predictor is fed with them instead of
+     * the CPU render times.
+     */
+    void setGpuCompletionTimestamp(quint64 sequence, std::chrono::nanoseconds timestamp);
+    /**
+     * This function must be called between beginFrame() and endFrame() if the frame is
+     * presented by scanning out a client buffer rather than by compositing.
+     */
+    void markDirectScanout();
+
+    /**
+     * This function must be called when the oldest pending frame has been presented at
+     * @a timestamp. @a vblankInterval is used to detect missed vblanks.
+     */
+    void presentFrame(std::chrono::nanoseconds timestamp, std::chrono::nanoseconds vblankInterval);
+
+    /**
+     * This function must be called when the oldest pending frame has been dropped.
+     */
+    void dropFrame();
+
+    /**
+     * Marks all frames that have been rendered but not presented yet as dropped.
+     */
+    void dropPendingFrames();
+
     /**
      * Returns the maximum estimated amount of time that it takes to render a single frame.
      */
@@ -48,10 +178,82 @@ public:
      */
     std::chrono::nanoseconds average() const;
 
+    /**
+     * Returns the exponentially weighted moving average of the render time.
+     */
+    std::chrono::nanoseconds predictedRenderTime() const;
+
+    /**
+     * Returns the safety margin that should be added to predictedRenderTime(). The margin
+     * is derived from the exponentially weighted variance of the render time.
+     */
+    std::chrono::nanoseconds predictionMargin() const;
+
+    /**
+     * Returns the render time percentile over the frames in the ring buffer.
+     */
+    std::chrono::nanoseconds renderTimePercentile(qreal percentile) const;
+
+    /**
+     * Returns the render-to-presentation latency percentile over the presented frames
+     * in the ring buffer.
+     */
+    std::chrono::nanoseconds latencyPercentile(qreal percentile) const;
+
+    /**
+     * Returns the percentile of the absolute composite timer wake-up error over the frames
+     * in the ring buffer.
+     */
+    std::chrono::nanoseconds wakeupErrorPercentile(qreal percentile) const;
+
+    /**
+     * Returns the total number of recorded frames.
+     */
+    quint64 frameCount() const;
+
+    /**
+     * Returns the total number of frames that missed their target vblank.
+     */
+    quint64 missedFrameCount() const;
+    /**
+     * Returns the total number of frames that have been presented with direct scanout.
+     * The remaining frames have been composited.
+     */
+    quint64 directScanoutFrameCount() const;
+
+    /**
+     * Returns the records in the ring buffer, from the oldest to the newest one.
+     */
+    QVector<RenderRecord> records() const;
+
+    /**
+     * Writes the records in the ring buffer to @a stream as comma separated values.
+     */
+    void dump(QTextStream &stream) const;
+
 private:
+    void updatePrediction(std::chrono::nanoseconds renderTime);
+
+    RenderRecord &recordAt(quint64 sequence);
+    const RenderRecord &recordAt(quint64 sequence) const;
+
     QElapsedTimer m_timer;
     QQueue<std::chrono::nanoseconds> m_log;
     int m_size = 15;
+
+    std::array<RenderRecord, s_recordCapacity> m_records;
+    std::atomic<quint64> m_head = 0;
+    quint64 m_presentCursor = 0;
+    quint64 m_missedFrameCount = 0;
+    quint64 m_directScanoutFrameCount = 0;
+    RenderRecord m_pending;
+    RenderHistogram m_renderTimes;
+    RenderHistogram m_latencies;
+    RenderHistogram m_wakeupErrors;
+    qreal m_predictionMean = 0;
+    qreal m_predictionVariance = 0;
+    bool m_predictionValid = false;
+    bool m_gpuTimingAvailable = false;
 };
 
 } // namespace KWin
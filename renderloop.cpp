@@ -9,6 +9,13 @@
 #include "renderloop_p.h"
 #include "utils.h"
 
+#if HAVE_SYS_TIMERFD_H
+#include <cerrno>
+#include <cstring>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
 namespace KWin
 {
 
@@ -27,12 +34,111 @@ RenderLoopPrivate::RenderLoopPrivate(RenderLoop *q)
     : q(q)
 {
     compositeTimer.setSingleShot(true);
-    QObject::connect(&compositeTimer, &QTimer::timeout, q, [this]() { dispatch(); });
+    QObject::connect(&compositeTimer, &QTimer::timeout, q, [this]() { handleTimerExpired(); });
+
+    if (qEnvironmentVariableIntValue("KWIN_PRECISE_COMPOSITE_TIMER") == 1) {
+        if (initializePreciseTimer()) {
+            timerType = RenderLoop::TimerType::Precise;
+        }
+    }
+}
+
+RenderLoopPrivate::~RenderLoopPrivate()
+{
+#if HAVE_SYS_TIMERFD_H
+    preciseTimerNotifier.reset();
+    if (preciseTimerFd != -1) {
+        close(preciseTimerFd);
+    }
+#endif
+}
+
+bool RenderLoopPrivate::initializePreciseTimer()
+{
+#if HAVE_SYS_TIMERFD_H
+    if (preciseTimerFd != -1) {
+        return true;
+    }
+
+    preciseTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (preciseTimerFd == -1) {
+        qCWarning(KWIN_CORE, "Failed to create a precise composite timer: %s", strerror(errno));
+        return false;
+    }
+
+    preciseTimerNotifier.reset(new QSocketNotifier(preciseTimerFd, QSocketNotifier::Read));
+    QObject::connect(preciseTimerNotifier.data(), &QSocketNotifier::activated, q, [this]() {
+        uint64_t expirations;
+        if (read(preciseTimerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            return;
+        }
+        preciseTimerArmed = false;
+        handleTimerExpired();
+    });
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool RenderLoopPrivate::isTimerActive() const
+{
+#if HAVE_SYS_TIMERFD_H
+    // The coarse timer is used as a fallback if the precise timer couldn't be armed.
+    if (preciseTimerArmed) {
+        return true;
+    }
+#endif
+    return compositeTimer.isActive();
+}
+
+void RenderLoopPrivate::startTimer(std::chrono::nanoseconds deadline)
+{
+    compositeDeadline = deadline;
+
+#if HAVE_SYS_TIMERFD_H
+    if (timerType == RenderLoop::TimerType::Precise) {
+        // A zero expiration time disarms the timer, so the deadline must be positive.
+        const std::chrono::nanoseconds expiration = std::max(deadline, std::chrono::nanoseconds(1));
+        const std::chrono::seconds seconds = std::chrono::duration_cast<std::chrono::seconds>(expiration);
+
+        itimerspec spec = {};
+        spec.it_value.tv_sec = seconds.count();
+        spec.it_value.tv_nsec = (expiration - seconds).count();
+        if (timerfd_settime(preciseTimerFd, TFD_TIMER_ABSTIME, &spec, nullptr) == 0) {
+            preciseTimerArmed = true;
+            return;
+        }
+        qCWarning(KWIN_CORE, "Failed to arm the precise composite timer: %s", strerror(errno));
+    }
+#endif
+
+    const std::chrono::nanoseconds currentTime(std::chrono::steady_clock::now().time_since_epoch());
+    const std::chrono::nanoseconds waitInterval = std::max(deadline - currentTime, std::chrono::nanoseconds::zero());
+    compositeTimer.start(std::chrono::duration_cast<std::chrono::milliseconds>(waitInterval));
+}
+
+void RenderLoopPrivate::stopTimer()
+{
+#if HAVE_SYS_TIMERFD_H
+    if (preciseTimerArmed) {
+        const itimerspec spec = {};
+        timerfd_settime(preciseTimerFd, 0, &spec, nullptr);
+        preciseTimerArmed = false;
+    }
+#endif
+    compositeTimer.stop();
+}
+
+void RenderLoopPrivate::handleTimerExpired()
+{
+    renderJournal.dispatchFrame(std::chrono::steady_clock::now().time_since_epoch());
+    dispatch();
 }
 
 void RenderLoopPrivate::scheduleRepaint()
 {
-    if (compositeTimer.isActive()) {
+    if (isTimerActive()) {
         return;
     }
 
@@ -47,7 +153,7 @@ void RenderLoopPrivate::scheduleRepaint()
     }
 
     // Estimate when it's a good time to perform the next compositing cycle.
-    const std::chrono::nanoseconds safetyMargin = std::chrono::milliseconds(3);
+    std::chrono::nanoseconds safetyMargin = std::chrono::milliseconds(3);
 
     std::chrono::nanoseconds renderTime;
     switch (options->latencyPolicy()) {
@@ -78,6 +184,16 @@ void RenderLoopPrivate::scheduleRepaint()
     case RenderTimeEstimatorAverage:
         renderTime = std::max(renderTime, renderJournal.average());
         break;
+    case RenderTimeEstimatorPercentile95:
+        renderTime = std::max(renderTime, renderJournal.renderTimePercentile(95));
+        break;
+    case RenderTimeEstimatorPercentile99:
+        renderTime = std::max(renderTime, renderJournal.renderTimePercentile(99));
+        break;
+    case RenderTimeEstimatorPredictive:
+        renderTime = std::max(renderTime, renderJournal.predictedRenderTime());
+        safetyMargin = renderJournal.predictionMargin();
+        break;
     }
 
     std::chrono::nanoseconds nextRenderTimestamp = nextPresentationTimestamp - renderTime - safetyMargin;
@@ -87,8 +203,8 @@ void RenderLoopPrivate::scheduleRepaint()
         nextRenderTimestamp = currentTime;
     }
 
-    const std::chrono::nanoseconds waitInterval = nextRenderTimestamp - currentTime;
-    compositeTimer.start(std::chrono::duration_cast<std::chrono::milliseconds>(waitInterval));
+    renderJournal.scheduleFrame(nextRenderTimestamp, nextPresentationTimestamp);
+    startTimer(nextRenderTimestamp);
 }
 
 void RenderLoopPrivate::delayScheduleRepaint()
@@ -109,6 +225,8 @@ void RenderLoopPrivate::notifyFrameFailed()
     Q_ASSERT(pendingFrameCount > 0);
     pendingFrameCount--;
 
+    renderJournal.dropFrame();
+
     if (!inhibitCount) {
         maybeScheduleRepaint();
     }
@@ -127,6 +245,8 @@ void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
         lastPresentationTimestamp = std::chrono::steady_clock::now().time_since_epoch();
     }
 
+    renderJournal.presentFrame(lastPresentationTimestamp, std::chrono::nanoseconds(1'000'000'000'000ull / refreshRate));
+
     if (!inhibitCount) {
         maybeScheduleRepaint();
     }
@@ -134,6 +254,11 @@ void RenderLoopPrivate::notifyFrameCompleted(std::chrono::nanoseconds timestamp)
     emit q->framePresented(q, timestamp);
 }
 
+void RenderLoopPrivate::notifyFrameRendered(quint64 sequence, std::chrono::nanoseconds timestamp)
+{
+    renderJournal.setGpuCompletionTimestamp(sequence, timestamp);
+}
+
 void RenderLoopPrivate::dispatch()
 {
     // On X11, we want to ignore repaints that are scheduled by windows right before
@@ -151,7 +276,8 @@ void RenderLoopPrivate::invalidate()
 {
     pendingReschedule = false;
     pendingFrameCount = 0;
-    compositeTimer.stop();
+    renderJournal.dropPendingFrames();
+    stopTimer();
 }
 
 RenderLoop::RenderLoop(QObject *parent)
@@ -164,12 +290,35 @@ RenderLoop::~RenderLoop()
 {
 }
 
+RenderLoop::TimerType RenderLoop::timerType() const
+{
+    return d->timerType;
+}
+
+void RenderLoop::setTimerType(TimerType type)
+{
+    if (type == TimerType::Precise && !d->initializePreciseTimer()) {
+        type = TimerType::Coarse;
+    }
+    if (d->timerType == type) {
+        return;
+    }
+
+    // Move a pending compositing cycle over to the new timer.
+    const bool wasActive = d->isTimerActive();
+    d->stopTimer();
+    d->timerType = type;
+    if (wasActive) {
+        d->startTimer(d->compositeDeadline);
+    }
+}
+
 void RenderLoop::inhibit()
 {
     d->inhibitCount++;
 
     if (d->inhibitCount == 1) {
-        d->compositeTimer.stop();
+        d->stopTimer();
     }
 }
 
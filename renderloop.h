@@ -28,9 +28,37 @@ class KWIN_EXPORT RenderLoop : public QObject
     Q_OBJECT
 
 public:
+    /**
+     * This enum type specifies the timer that is used to start compositing cycles.
+     */
+    enum class TimerType {
+        /**
+         * A QTimer with millisecond resolution.
+         */
+        Coarse,
+        /**
+         * A timerfd armed with absolute CLOCK_MONOTONIC deadlines.
+         */
+        Precise,
+    };
+
     explicit RenderLoop(QObject *parent = nullptr);
     ~RenderLoop() override;
 
+    /**
+     * Returns the type of the timer that is used to start compositing cycles.
+     */
+    TimerType timerType() const;
+
+    /**
+     * Sets the type of the timer that is used to start compositing cycles to @a type.
+     * If the precise timer is not available, the coarse timer will be used instead.
+     *
+     * The default timer type is Coarse, unless the KWIN_PRECISE_COMPOSITE_TIMER environment
+     * variable is set to 1.
+     */
+    void setTimerType(TimerType type);
+
     /**
      * Pauses the render loop. While the render loop is inhibited, scheduleRepaint()
      * requests are queued.
@@ -9,6 +9,9 @@
 #include "renderloop.h"
 #include "renderjournal.h"
 
+#include <config-kwin.h>
+
+#include <QSocketNotifier>
 #include <QTimer>
 
 namespace KWin
@@ -19,21 +22,36 @@ class KWIN_EXPORT RenderLoopPrivate
 public:
     static RenderLoopPrivate *get(RenderLoop *loop);
     explicit RenderLoopPrivate(RenderLoop *q);
+    ~RenderLoopPrivate();
 
     void dispatch();
     void invalidate();
 
+    bool initializePreciseTimer();
+    bool isTimerActive() const;
+    void startTimer(std::chrono::nanoseconds deadline);
+    void stopTimer();
+    void handleTimerExpired();
+
     void delayScheduleRepaint();
     void scheduleRepaint();
     void maybeScheduleRepaint();
 
     void notifyFrameFailed();
     void notifyFrameCompleted(std::chrono::nanoseconds timestamp);
+    void notifyFrameRendered(quint64 sequence, std::chrono::nanoseconds timestamp);
 
     RenderLoop *q;
     std::chrono::nanoseconds lastPresentationTimestamp = std::chrono::nanoseconds::zero();
     std::chrono::nanoseconds nextPresentationTimestamp = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds compositeDeadline = std::chrono::nanoseconds::zero();
+    RenderLoop::TimerType timerType = RenderLoop::TimerType::Coarse;
     QTimer compositeTimer;
+#if HAVE_SYS_TIMERFD_H
+    QScopedPointer<QSocketNotifier> preciseTimerNotifier;
+    int preciseTimerFd = -1;
+    bool preciseTimerArmed = false;
+#endif
     RenderJournal renderJournal;
     int refreshRate = 60000;
     int pendingFrameCount = 0;
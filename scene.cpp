@@ -60,12 +60,15 @@
 #include "platform.h"
 
 #include <QQuickWindow>
+#include <QVarLengthArray>
 #include <QVector2D>
 
 #include "x11client.h"
 #include "deleted.h"
 #include "effects.h"
+#include "framearena.h"
 #include "overlaywindow.h"
+#include "rectset.h"
 #include "renderloop.h"
 #include "screens.h"
 #include "shadow.h"
@@ -87,6 +90,7 @@ namespace KWin
 
 Scene::Scene(QObject *parent)
     : QObject(parent)
+    , m_incrementalOcclusion(qgetenv("KWIN_INCREMENTAL_OCCLUSION") != QByteArrayLiteral("0"))
 {
     if (kwinApp()->platform()->isPerScreenRenderingEnabled()) {
         connect(kwinApp()->platform(), &Platform::outputEnabled, this, &Scene::reallocRepaints);
@@ -121,6 +125,35 @@ void Scene::addRepaint(const QRegion &region)
     }
 }
 
+bool Scene::isIncrementalOcclusionEnabled() const
+{
+    return m_incrementalOcclusion;
+}
+
+void Scene::setIncrementalOcclusionEnabled(bool enabled)
+{
+    m_incrementalOcclusion = enabled;
+}
+
+Scene::FrameStatistics Scene::frameStatistics() const
+{
+    return FrameStatistics();
+}
+
+bool Scene::usesDepthOcclusion() const
+{
+    return false;
+}
+
+void Scene::beginDepthOcclusion(const FrameVector<Phase2Data> &phase2data)
+{
+    Q_UNUSED(phase2data)
+}
+
+void Scene::endDepthOcclusion()
+{
+}
+
 QRegion Scene::repaints(int screenId) const
 {
     const int index = screenId == -1 ? 0 : screenId;
@@ -155,12 +188,7 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     const QRegion displayRegion(0, 0, screenSize.width(), screenSize.height());
     *mask = (damage == displayRegion) ? 0 : PAINT_SCREEN_REGION;
 
-    if (Q_UNLIKELY(presentTime < m_expectedPresentTimestamp)) {
-        qCDebug(KWIN_CORE, "Provided presentation timestamp is invalid: %ld (current: %ld)",
-                presentTime.count(), m_expectedPresentTimestamp.count());
-    } else {
-        m_expectedPresentTimestamp = presentTime;
-    }
+    updateExpectedPresentTimestamp(presentTime);
 
     // preparation step
     static_cast<EffectsHandlerImpl*>(effects)->startPaint();
@@ -213,6 +241,44 @@ void Scene::paintScreen(int* mask, const QRegion &damage, const QRegion &repaint
     Q_ASSERT(!PaintClipper::clip());
 }
 
+/**
+ * Runs the pre-paint and the post-paint pass of the effects for a frame in which nothing is
+ * painted, e.g. because the buffer of a fullscreen window is presented directly. Animations
+ * keep going this way, and the repaints of the windows are consumed as in a painted frame.
+ */
+void Scene::skipPaintScreen(std::chrono::milliseconds presentTime)
+{
+    updateExpectedPresentTimestamp(presentTime);
+
+    static_cast<EffectsHandlerImpl*>(effects)->startPaint();
+
+    ScreenPrePaintData pdata;
+    pdata.mask = 0;
+    pdata.paint = QRegion();
+    effects->prePaintScreen(pdata, m_expectedPresentTimestamp);
+
+    // No window has gone through prePaintWindow(), so the effects don't get postPaintWindow()
+    // either.
+    for (Window *window : qAsConst(stacking_order)) {
+        window->resetRepaints(painted_screen);
+    }
+
+    effects->postPaintScreen();
+
+    repaint_region = QRegion();
+    damaged_region = QRegion();
+}
+
+void Scene::updateExpectedPresentTimestamp(std::chrono::milliseconds presentTime)
+{
+    if (Q_UNLIKELY(presentTime < m_expectedPresentTimestamp)) {
+        qCDebug(KWIN_CORE, "Provided presentation timestamp is invalid: %ld (current: %ld)",
+                presentTime.count(), m_expectedPresentTimestamp.count());
+    } else {
+        m_expectedPresentTimestamp = presentTime;
+    }
+}
+
 // the function that'll be eventually called by paintScreen() above
 void Scene::finalPaintScreen(int mask, const QRegion &region, ScreenPaintData& data)
 {
@@ -229,7 +295,7 @@ void Scene::finalPaintScreen(int mask, const QRegion &region, ScreenPaintData& d
 // It simply paints bottom-to-top.
 void Scene::paintGenericScreen(int orig_mask, const ScreenPaintData &)
 {
-    QVector<Phase2Data> phase2;
+    FrameVector<Phase2Data> phase2(Compositor::self()->frameArena());
     phase2.reserve(stacking_order.size());
     foreach (Window * w, stacking_order) { // bottom to top
         // Let the scene window update the window pixmap tree.
@@ -256,7 +322,7 @@ void Scene::paintGenericScreen(int orig_mask, const ScreenPaintData &)
         if (!w->isPaintingEnabled()) {
             continue;
         }
-        phase2.append({w, infiniteRegion(), data.clip, data.mask, data.quads});
+        phase2.push_back({w, infiniteRegion(), data.clip, data.mask, data.quads});
     }
 
     damaged_region = QRegion(QRect {{}, screens()->size()});
@@ -271,11 +337,55 @@ void Scene::paintGenericScreen(int orig_mask, const ScreenPaintData &)
     if (!(orig_mask & PAINT_SCREEN_BACKGROUND_FIRST)) {
         paintBackground(infiniteRegion());
     }
-    foreach (const Phase2Data & d, phase2) {
+    for (const Phase2Data &d : phase2) {
         paintWindow(d.window, d.mask, d.region, d.quads);
     }
 }
 
+bool Scene::prePaintSimpleWindow(int stackingIndex, int orig_mask, const QRegion &region, Phase2Data *phase2)
+{
+    Window *window = stacking_order[stackingIndex];
+    WindowPrePaintData data;
+    data.mask = orig_mask | (window->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
+    window->resetPaintingEnabled();
+    data.paint = region;
+    data.paint |= window->repaints(painted_screen);
+
+    // Let the scene window update the window pixmap tree.
+    window->preprocess();
+
+    // Reset the repaint_region.
+    // This has to be done here because many effects schedule a repaint for
+    // the next frame within Effects::prePaintWindow.
+    window->resetRepaints(painted_screen);
+
+    // Clip out the opaque parts of the window, the decoration is drawn in the second pass
+    bool coversShape = false;
+    if (m_incrementalOcclusion) {
+        data.clip = window->opaqueRegion(&coversShape);
+    } else {
+        data.clip = window->computeOpaqueRegion(&coversShape);
+    }
+    if (!window->isOpaque() && coversShape) {
+        data.mask = orig_mask | PAINT_WINDOW_OPAQUE;
+    }
+
+    data.quads = window->buildQuads();
+    // preparation step
+    effects->prePaintWindow(effectWindow(window), data, m_expectedPresentTimestamp);
+#if !defined(QT_NO_DEBUG)
+    if (data.quads.isTransformed()) {
+        qFatal("Pre-paint calls are not allowed to transform quads!");
+    }
+#endif
+    if (!window->isPaintingEnabled()) {
+        return false;
+    }
+
+    *phase2 = { window, data.paint, data.clip, data.mask, data.quads, stackingIndex };
+    return true;
+}
+
 // The optimized case without any transformations at all.
 // It can paint only the requested region and can use clipping
 // to reduce painting and improve performance.
@@ -283,75 +393,98 @@ void Scene::paintSimpleScreen(int orig_mask, const QRegion &region)
 {
     Q_ASSERT((orig_mask & (PAINT_SCREEN_TRANSFORMED
                          | PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS)) == 0);
-    QVector<Phase2Data> phase2data;
+    FrameArena *arena = Compositor::self()->frameArena();
+    FrameVector<Phase2Data> phase2data(arena);
     phase2data.reserve(stacking_order.size());
 
     QRegion dirtyArea = region;
     bool opaqueFullscreen = false;
+    if (!stacking_order.isEmpty()) {
+        // Only the topmost window can cover the whole screen. It decides even if it's culled.
+        Window *topmost = stacking_order.last();
+        AbstractClient *client = qobject_cast<AbstractClient *>(topmost->window());
+        opaqueFullscreen = topmost->isOpaque() && client && client->isFullScreen();
+    }
+
+    // Windows that don't intersect the damage of this frame can skip the pre-paint pass.
+    // The damage consists of the screen damage, the repaints needed to bring a reused
+    // back buffer up to date and the repaints of every window.
+    const bool cullUndamaged = m_incrementalOcclusion && !effects->hasActiveFullScreenEffect();
+    RectSet frameDamage;
+    if (cullUndamaged) {
+        frameDamage = RectSet(region);
+        frameDamage.unite(RectSet(repaint_region));
+        for (Window *window : qAsConst(stacking_order)) {
+            frameDamage.unite(RectSet(window->repaints(painted_screen)));
+        }
+    }
+    auto isCullable = [&](Window *window) {
+        Toplevel *toplevel = window->window();
+        if (!window->repaints(painted_screen).isEmpty()) {
+            return false;
+        }
+        // Sub-surfaces can be placed outside the visible rect of the main surface.
+        if (toplevel->surface() && !toplevel->surface()->childSubSurfaces().isEmpty()) {
+            return false;
+        }
+        return !frameDamage.intersects(toplevel->visibleRect());
+    };
+    FrameVector<int> culled(arena);
 
     // Traverse the scene windows from bottom to top.
     for (int i = 0; i < stacking_order.count(); ++i) {
         Window *window = stacking_order[i];
-        Toplevel *toplevel = window->window();
-        WindowPrePaintData data;
-        data.mask = orig_mask | (window->isOpaque() ? PAINT_WINDOW_OPAQUE : PAINT_WINDOW_TRANSLUCENT);
-        window->resetPaintingEnabled();
-        data.paint = region;
-        data.paint |= window->repaints(painted_screen);
+        if (cullUndamaged && isCullable(window)) {
+            culled.push_back(i);
+            continue;
+        }
 
-        // Let the scene window update the window pixmap tree.
-        window->preprocess();
+        Phase2Data data;
+        if (!prePaintSimpleWindow(i, orig_mask, region, &data)) {
+            continue;
+        }
+        dirtyArea |= data.region;
+        // Schedule the window for painting
+        phase2data.push_back(data);
+    }
 
-        // Reset the repaint_region.
-        // This has to be done here because many effects schedule a repaint for
-        // the next frame within Effects::prePaintWindow.
-        window->resetRepaints(painted_screen);
+    const QSize &screenSize = screens()->size();
+    const QRegion displayRegion(0, 0, screenSize.width(), screenSize.height());
 
-        // Clip out the decoration for opaque windows; the decoration is drawn in the second pass
-        opaqueFullscreen = false; // TODO: do we care about unmanged windows here (maybe input windows?)
-        AbstractClient *client = dynamic_cast<AbstractClient *>(toplevel);
-        if (window->isOpaque()) {
-            if (client) {
-                opaqueFullscreen = client->isFullScreen();
-            }
+    // Effects may have extended the paint region beyond the damage of the frame, in which
+    // case some culled windows have to be painted after all. Put them back in the stacking
+    // order; this repeats until the dirty area stops growing.
+    while (!culled.empty()) {
+        QRegion extendedArea = dirtyArea | repaint_region;
+        if (extendedArea != displayRegion) {
+            extendPaintRegion(extendedArea, opaqueFullscreen);
+        }
 
-            const WindowPixmap *windowPixmap = window->windowPixmap<WindowPixmap>();
-            if (windowPixmap) {
-                data.clip |= windowPixmap->mapToGlobal(windowPixmap->shape());
-            }
-        } else if (toplevel->hasAlpha() && toplevel->opacity() == 1.0) {
-            const WindowPixmap *windowPixmap = window->windowPixmap<WindowPixmap>();
-            if (windowPixmap) {
-                const QRegion shape = windowPixmap->shape();
-                const QRegion opaque = windowPixmap->opaque();
-                data.clip = windowPixmap->mapToGlobal(shape & opaque);
-
-                if (opaque == shape) {
-                    data.mask = orig_mask | PAINT_WINDOW_OPAQUE;
-                }
+        FrameVector<int> uncovered(arena);
+        for (auto it = culled.begin(); it != culled.end();) {
+            if (extendedArea.intersects(stacking_order[*it]->window()->visibleRect())) {
+                uncovered.push_back(*it);
+                it = culled.erase(it);
+            } else {
+                ++it;
             }
-        } else {
-            data.clip = QRegion();
         }
-
-        if (client && !client->decorationHasAlpha() && toplevel->opacity() == 1.0) {
-            data.clip |= window->decorationShape().translated(window->pos());
+        if (uncovered.empty()) {
+            break;
         }
 
-        data.quads = window->buildQuads();
-        // preparation step
-        effects->prePaintWindow(effectWindow(window), data, m_expectedPresentTimestamp);
-#if !defined(QT_NO_DEBUG)
-        if (data.quads.isTransformed()) {
-            qFatal("Pre-paint calls are not allowed to transform quads!");
-        }
-#endif
-        if (!window->isPaintingEnabled()) {
-            continue;
+        for (int stackingIndex : uncovered) {
+            Phase2Data data;
+            if (!prePaintSimpleWindow(stackingIndex, orig_mask, region, &data)) {
+                continue;
+            }
+            dirtyArea |= data.region;
+            auto it = std::lower_bound(phase2data.begin(), phase2data.end(), stackingIndex,
+                                       [](const Phase2Data &data, int index) {
+                                           return data.stackingIndex < index;
+                                       });
+            phase2data.insert(it, data);
         }
-        dirtyArea |= data.paint;
-        // Schedule the window for painting
-        phase2data.append({ window, data.paint, data.clip, data.mask, data.quads });
     }
 
     // Save the part of the repaint region that's exclusively rendered to
@@ -360,42 +493,55 @@ void Scene::paintSimpleScreen(int orig_mask, const QRegion &region)
     const QRegion repaintClip = repaint_region - dirtyArea;
     dirtyArea |= repaint_region;
 
-    const QSize &screenSize = screens()->size();
-    const QRegion displayRegion(0, 0, screenSize.width(), screenSize.height());
     bool fullRepaint(dirtyArea == displayRegion); // spare some expensive region operations
     if (!fullRepaint) {
         extendPaintRegion(dirtyArea, opaqueFullscreen);
         fullRepaint = (dirtyArea == displayRegion);
     }
 
-    QRegion allclips, upperTranslucentDamage;
-    upperTranslucentDamage = repaint_region;
-
-    // This is the occlusion culling pass
-    for (int i = phase2data.count() - 1; i >= 0; --i) {
-        Phase2Data *data = &phase2data[i];
+    const bool depthOcclusion = usesDepthOcclusion();
+    RectSet allclips;
+    RectSet upperTranslucentDamage(repaint_region);
 
-        if (fullRepaint) {
-            data->region = displayRegion;
-        } else {
-            data->region |= upperTranslucentDamage;
+    if (depthOcclusion) {
+        // The scene rejects occluded pixels by itself, so every window is painted in
+        // the whole dirty area and no region arithmetic is needed.
+        const QRegion windowRegion = fullRepaint ? displayRegion : dirtyArea;
+        for (Phase2Data &data : phase2data) {
+            data.region = windowRegion;
         }
+    } else {
+        // This is the occlusion culling pass
+        for (int i = int(phase2data.size()) - 1; i >= 0; --i) {
+            Phase2Data *data = &phase2data[i];
 
-        // subtract the parts which will possibly been drawn as part of
-        // a higher opaque window
-        data->region -= allclips;
-
-        // Here we rely on WindowPrePaintData::setTranslucent() to remove
-        // the clip if needed.
-        if (!data->clip.isEmpty() && !(data->mask & PAINT_WINDOW_TRANSLUCENT)) {
-            // clip away the opaque regions for all windows below this one
-            allclips |= data->clip;
-            // extend the translucent damage for windows below this by remaining (translucent) regions
-            if (!fullRepaint) {
-                upperTranslucentDamage |= data->region - data->clip;
+            RectSet windowRegion;
+            if (fullRepaint) {
+                windowRegion = RectSet(displayRegion.boundingRect());
+            } else {
+                windowRegion = RectSet(data->region);
+                windowRegion.unite(upperTranslucentDamage);
+            }
+
+            // subtract the parts which will possibly been drawn as part of
+            // a higher opaque window
+            windowRegion.subtract(allclips);
+
+            // Here we rely on WindowPrePaintData::setTranslucent() to remove
+            // the clip if needed.
+            if (!data->clip.isEmpty() && !(data->mask & PAINT_WINDOW_TRANSLUCENT)) {
+                const RectSet clip(data->clip);
+                // clip away the opaque regions for all windows below this one
+                allclips.unite(clip);
+                // extend the translucent damage for windows below this by remaining (translucent) regions
+                if (!fullRepaint) {
+                    upperTranslucentDamage.unite(windowRegion.subtracted(clip));
+                }
+            } else if (!fullRepaint) {
+                upperTranslucentDamage.unite(windowRegion);
             }
-        } else if (!fullRepaint) {
-            upperTranslucentDamage |= data->region;
+
+            data->region = windowRegion.toRegion();
         }
     }
 
@@ -408,21 +554,31 @@ void Scene::paintSimpleScreen(int orig_mask, const QRegion &region)
             paintBackground(infiniteRegion());
         }
     }
+    if (depthOcclusion) {
+        beginDepthOcclusion(phase2data);
+    }
     if (!(orig_mask & PAINT_SCREEN_BACKGROUND_FIRST)) {
-        paintedArea = dirtyArea - allclips;
+        paintedArea = depthOcclusion ? dirtyArea : RectSet(dirtyArea).subtracted(allclips).toRegion();
         paintBackground(paintedArea);
     }
 
     // Now walk the list bottom to top and draw the windows.
-    for (int i = 0; i < phase2data.count(); ++i) {
+    for (size_t i = 0; i < phase2data.size(); ++i) {
         Phase2Data *data = &phase2data[i];
 
         // add all regions which have been drawn so far
-        paintedArea |= data->region;
-        data->region = paintedArea;
+        if (depthOcclusion) {
+            paintedArea = data->region;
+        } else {
+            paintedArea |= data->region;
+            data->region = paintedArea;
+        }
 
         paintWindow(data->window, data->mask, data->region, data->quads);
     }
+    if (depthOcclusion) {
+        endDepthOcclusion();
+    }
 
     if (fullRepaint) {
         painted_region = displayRegion;
@@ -781,6 +937,14 @@ Scene::Window::Window(Toplevel *client, QObject *parent)
     connect(toplevel, &Toplevel::screenScaleChanged, this, &Window::discardQuads);
     connect(toplevel, &Toplevel::shadowChanged, this, &Window::discardQuads);
     connect(toplevel, &Toplevel::geometryShapeChanged, this, &Window::discardShape);
+
+    connect(toplevel, &Toplevel::frameGeometryChanged, this, &Window::discardOpaqueRegion);
+    connect(toplevel, &Toplevel::opacityChanged, this, &Window::discardOpaqueRegion);
+    connect(toplevel, &Toplevel::hasAlphaChanged, this, &Window::discardOpaqueRegion);
+    connect(toplevel, &Toplevel::shapedChanged, this, &Window::discardOpaqueRegion);
+    if (AbstractClient *client = qobject_cast<AbstractClient *>(toplevel)) {
+        connect(client, &AbstractClient::decorationHasAlphaChanged, this, &Window::discardOpaqueRegion);
+    }
 }
 
 Scene::Window::~Window()
@@ -828,6 +992,7 @@ void Scene::Window::unreferencePreviousPixmap()
 
 void Scene::Window::discardPixmap()
 {
+    discardOpaqueRegion();
     if (!m_currentPixmap.isNull()) {
         if (m_currentPixmap->isValid()) {
             m_previousPixmap.reset(m_currentPixmap.take());
@@ -840,6 +1005,8 @@ void Scene::Window::discardPixmap()
 
 void Scene::Window::updatePixmap()
 {
+    // The opaque region of a surface is double-buffered state, it may change with every commit.
+    discardOpaqueRegion();
     if (m_currentPixmap.isNull()) {
         m_currentPixmap.reset(createWindowPixmap());
     }
@@ -856,6 +1023,7 @@ void Scene::Window::discardShape()
     // reset the flag
     m_bufferShapeIsValid = false;
     discardQuads();
+    discardOpaqueRegion();
 }
 
 QRegion Scene::Window::bufferShape() const
@@ -905,6 +1073,52 @@ QRegion Scene::Window::clientShape() const
     return shape & clippingRect;
 }
 
+QRegion Scene::Window::opaqueRegion(bool *coversShape) const
+{
+    if (!m_opaqueRegionIsValid || m_opaqueRegionPixmap != windowPixmap<WindowPixmap>()) {
+        m_opaqueRegion = computeOpaqueRegion(&m_opaqueRegionCoversShape);
+        m_opaqueRegionPixmap = windowPixmap<WindowPixmap>();
+        m_opaqueRegionIsValid = true;
+    }
+    if (coversShape) {
+        *coversShape = m_opaqueRegionCoversShape;
+    }
+    return m_opaqueRegion;
+}
+
+QRegion Scene::Window::computeOpaqueRegion(bool *coversShape) const
+{
+    QRegion region;
+    *coversShape = false;
+
+    const WindowPixmap *windowPixmap = this->windowPixmap<WindowPixmap>();
+    if (isOpaque()) {
+        if (windowPixmap) {
+            region = windowPixmap->mapToGlobal(windowPixmap->shape());
+        }
+        *coversShape = true;
+    } else if (toplevel->hasAlpha() && toplevel->opacity() == 1.0) {
+        if (windowPixmap) {
+            const QRegion shape = windowPixmap->shape();
+            const QRegion opaque = windowPixmap->opaque();
+            region = windowPixmap->mapToGlobal(shape & opaque);
+            *coversShape = (opaque == shape);
+        }
+    }
+
+    const AbstractClient *client = qobject_cast<AbstractClient *>(toplevel);
+    if (client && !client->decorationHasAlpha() && toplevel->opacity() == 1.0) {
+        region |= decorationShape().translated(pos());
+    }
+
+    return region;
+}
+
+void Scene::Window::discardOpaqueRegion()
+{
+    m_opaqueRegionIsValid = false;
+}
+
 QRegion Scene::Window::decorationShape() const
 {
     return QRegion(toplevel->rect()) - toplevel->transparentRect();
@@ -1001,7 +1215,9 @@ WindowQuadList Scene::Window::buildQuads(bool force) const
             deleted->layoutDecorationRects(rects[0], rects[1], rects[2], rects[3]);
         }
 
-        *ret += makeDecorationQuads(rects, decorationShape());
+        RectSet decorationShape(toplevel->rect());
+        decorationShape.subtract(toplevel->transparentRect());
+        *ret += makeDecorationQuads(rects, decorationShape);
     }
     if (m_shadow && toplevel->wantsShadowToBeRendered()) {
         *ret << m_shadow->shadowQuads();
@@ -1011,7 +1227,7 @@ WindowQuadList Scene::Window::buildQuads(bool force) const
     return *ret;
 }
 
-WindowQuadList Scene::Window::makeDecorationQuads(const QRect *rects, const QRegion &region) const
+WindowQuadList Scene::Window::makeDecorationQuads(const QRect *rects, const RectSet &region) const
 {
     WindowQuadList list;
 
@@ -1038,10 +1254,10 @@ WindowQuadList Scene::Window::makeDecorationQuads(const QRect *rects, const QReg
     };
 
     for (int i = 0; i < 4; i++) {
-        const QRegion intersectedRegion = (region & rects[i]);
-        for (const QRect &r : intersectedRegion) {
-            if (!r.isValid())
-                continue;
+        RectSet intersectedRegion = region;
+        intersectedRegion.intersect(rects[i]);
+        for (int j = 0; j < intersectedRegion.rectCount(); ++j) {
+            const QRect r = intersectedRegion.rectAt(j);
 
             const bool swap = orientations[i] == Qt::Vertical;
 
@@ -1095,11 +1311,14 @@ WindowQuadList Scene::Window::makeContentsQuads() const
     // pixmap tree in the depth-first search manner and assign an id to each window quad.
     // The id is the time when we visited the window pixmap.
 
-    QStack<WindowPixmap *> stack;
-    stack.push(currentPixmap);
+    // Quads are also built outside of a frame, e.g. when an effect asks for them, so the
+    // frame arena can't be used here.
+    QVarLengthArray<WindowPixmap *, 16> stack;
+    stack.push_back(currentPixmap);
 
-    while (!stack.isEmpty()) {
-        WindowPixmap *windowPixmap = stack.pop();
+    while (!stack.empty()) {
+        WindowPixmap *windowPixmap = stack.back();
+        stack.pop_back();
 
         // If it's an unmapped sub-surface, don't generate window quads for it.
         if (!windowPixmap->isValid())
@@ -1136,7 +1355,7 @@ WindowQuadList Scene::Window::makeContentsQuads() const
         // in the depth-first search manner.
         const QVector<WindowPixmap *> children = windowPixmap->children();
         for (auto it = children.rbegin(); it != children.rend(); ++it) {
-            stack.push(*it);
+            stack.push_back(*it);
         }
     }
 
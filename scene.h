@@ -10,6 +10,7 @@
 #ifndef KWIN_SCENE_H
 #define KWIN_SCENE_H
 
+#include "framearena.h"
 #include "toplevel.h"
 #include "utils.h"
 #include "kwineffects.h"
@@ -39,6 +40,7 @@ class Deleted;
 class EffectFrameImpl;
 class EffectWindowImpl;
 class OverlayWindow;
+class RectSet;
 class Shadow;
 class WindowPixmap;
 class GLTexture;
@@ -200,6 +202,52 @@ public:
         return {};
     }
 
+    /**
+     * Whether paintSimpleScreen() skips the pre-paint pass for windows outside the damaged
+     * area and uses the cached opaque regions of windows for occlusion culling.
+     *
+     * This is enabled by default, unless the KWIN_INCREMENTAL_OCCLUSION environment variable
+     * is set to 0.
+     */
+    bool isIncrementalOcclusionEnabled() const;
+    void setIncrementalOcclusionEnabled(bool enabled);
+
+    struct FrameStatistics
+    {
+        /**
+         * The number of draw calls issued to paint windows.
+         */
+        int drawCallCount = 0;
+        /**
+         * The number of draw calls that painted batched windows.
+         */
+        int batchCount = 0;
+        /**
+         * The number of windows painted as part of a batch.
+         */
+        int batchedWindowCount = 0;
+        /**
+         * The number of shared textures in the texture atlas.
+         */
+        int atlasPageCount = 0;
+        /**
+         * The number of textures of the texture atlas that hold only one region.
+         */
+        int atlasDedicatedTextureCount = 0;
+        /**
+         * The number of texels in the shared textures of the texture atlas, and how many
+         * of them are in use.
+         */
+        qint64 atlasTexelCount = 0;
+        qint64 atlasUsedTexelCount = 0;
+    };
+
+    /**
+     * Returns statistics about the most recently painted frame. The default implementation
+     * returns empty statistics, scenes that track draw calls should override it.
+     */
+    virtual FrameStatistics frameStatistics() const;
+
 Q_SIGNALS:
     void frameRendered();
     void resetCompositing();
@@ -217,6 +265,8 @@ protected:
                      std::chrono::milliseconds presentTime,
                      const QMatrix4x4 &projection = QMatrix4x4(),
                      const QRect &outputGeometry = QRect(), qreal screenScale = 1.0);
+    // lets the effects and the windows know about a frame that is presented without painting
+    void skipPaintScreen(std::chrono::milliseconds presentTime);
     // Render cursor texture in case hardware cursor is disabled/non-applicable
     virtual void paintCursor(const QRegion &region) = 0;
     friend class EffectsHandlerImpl;
@@ -256,7 +306,24 @@ protected:
         QRegion clip;
         int mask = 0;
         WindowQuadList quads;
+        int stackingIndex = -1;
     };
+    bool prePaintSimpleWindow(int stackingIndex, int mask, const QRegion &region, Phase2Data *phase2);
+    /**
+     * Returns @c true if the scene rejects occluded pixels with a depth buffer. In that case
+     * paintSimpleScreen() doesn't clip windows against the opaque regions of the windows above
+     * them, and calls beginDepthOcclusion() before painting anything.
+     *
+     * The default implementation returns @c false.
+     */
+    virtual bool usesDepthOcclusion() const;
+    /**
+     * Called by paintSimpleScreen() if usesDepthOcclusion() returns @c true. @p phase2data
+     * contains the windows that will be painted, in the bottom to top order. The windows
+     * are painted in that order afterwards, and endDepthOcclusion() is called when done.
+     */
+    virtual void beginDepthOcclusion(const FrameVector<Phase2Data> &phase2data);
+    virtual void endDepthOcclusion();
     // The region which actually has been painted by paintScreen() and should be
     // copied from the buffer to the screen. I.e. the region returned from Scene::paintScreen().
     // Since prePaintWindow() can extend areas to paint, these changes would have to propagate
@@ -272,6 +339,7 @@ protected:
 private:
     void paintWindowThumbnails(Scene::Window *w, const QRegion &region, qreal opacity, qreal brightness, qreal saturation);
     void paintDesktopThumbnails(Scene::Window *w);
+    void updateExpectedPresentTimestamp(std::chrono::milliseconds presentTime);
     std::chrono::milliseconds m_expectedPresentTimestamp = std::chrono::milliseconds::zero();
     void reallocRepaints();
     QHash< Toplevel*, Window* > m_windows;
@@ -280,6 +348,7 @@ private:
     QVector<QRegion> m_repaints;
     // how many times finalPaintScreen() has been called
     int m_paintScreenCount = 0;
+    bool m_incrementalOcclusion = true;
 };
 
 /**
@@ -354,6 +423,16 @@ public:
     QRegion decorationShape() const;
     QPoint bufferOffset() const;
     void discardShape();
+    /**
+     * Returns the part of the window in global coordinates that is known to be opaque. If
+     * @a coversShape is not null, it is set to whether the whole client shape is opaque.
+     *
+     * The region is cached until the geometry, the shape, the opacity or the window pixmap
+     * of the window changes.
+     */
+    QRegion opaqueRegion(bool *coversShape = nullptr) const;
+    QRegion computeOpaqueRegion(bool *coversShape) const;
+    void discardOpaqueRegion();
     void updateToplevel(Deleted *deleted);
     // creates initial quad list for the window
     virtual WindowQuadList buildQuads(bool force = false) const;
@@ -391,7 +470,7 @@ public:
     template<typename T> T *previousWindowPixmap() const;
 
 protected:
-    WindowQuadList makeDecorationQuads(const QRect *rects, const QRegion &region) const;
+    WindowQuadList makeDecorationQuads(const QRect *rects, const RectSet &region) const;
     WindowQuadList makeContentsQuads() const;
     /**
      * @brief Factory method to create a WindowPixmap.
@@ -414,6 +493,10 @@ private:
     int disable_painting;
     mutable QRegion m_bufferShape;
     mutable bool m_bufferShapeIsValid = false;
+    mutable QRegion m_opaqueRegion;
+    mutable const WindowPixmap *m_opaqueRegionPixmap = nullptr;
+    mutable bool m_opaqueRegionCoversShape = false;
+    mutable bool m_opaqueRegionIsValid = false;
     mutable QScopedPointer<WindowQuadList> cached_quad_list;
     Q_DISABLE_COPY(Window)
 };
@@ -0,0 +1,260 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "schedulingpolicy.h"
+#include "utils.h"
+
+#include <config-kwin.h>
+
+#include <QMutexLocker>
+#include <QStringList>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sched.h>
+
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace KWin
+{
+
+#if defined(Q_OS_LINUX) && defined(SYS_sched_setattr)
+#define KWIN_HAVE_SCHED_DEADLINE 1
+
+// Mirrors struct sched_attr, which the C library doesn't necessarily provide.
+struct DeadlineAttributes
+{
+    uint32_t size;
+    uint32_t policy;
+    uint64_t flags;
+    int32_t nice;
+    uint32_t priority;
+    uint64_t runtime;
+    uint64_t deadline;
+    uint64_t period;
+};
+
+static const uint32_t s_schedDeadline = 6;
+static const uint64_t s_schedFlagResetOnFork = 0x01;
+#else
+#define KWIN_HAVE_SCHED_DEADLINE 0
+#endif
+
+static int readPriority(const char *name, int defaultPriority)
+{
+    bool ok = false;
+    const int priority = qEnvironmentVariableIntValue(name, &ok);
+    if (!ok) {
+        return defaultPriority;
+    }
+#if HAVE_SCHED_RESET_ON_FORK
+    return qBound(0, priority, sched_get_priority_max(SCHED_RR));
+#else
+    return priority;
+#endif
+}
+
+static QVector<int> readCpus(const char *name)
+{
+    QVector<int> cpus;
+    const QList<QByteArray> ranges = qgetenv(name).split(',');
+    for (const QByteArray &range : ranges) {
+        if (range.trimmed().isEmpty()) {
+            continue;
+        }
+        const int separator = range.indexOf('-');
+        bool firstOk = false;
+        bool lastOk = true;
+        const int first = range.left(separator).trimmed().toInt(&firstOk);
+        const int last = separator == -1 ? first : range.mid(separator + 1).trimmed().toInt(&lastOk);
+        if (!firstOk || !lastOk || first < 0 || last < first) {
+            qCWarning(KWIN_CORE) << "Ignoring invalid CPU range" << range << "in" << name;
+            continue;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            if (!cpus.contains(cpu)) {
+                cpus.append(cpu);
+            }
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+static QString formatCpus(const QVector<int> &cpus)
+{
+    if (cpus.isEmpty()) {
+        return QStringLiteral("all");
+    }
+    QStringList list;
+    for (int cpu : cpus) {
+        list.append(QString::number(cpu));
+    }
+    return list.join(QLatin1Char(','));
+}
+
+SchedulingPolicy *SchedulingPolicy::self()
+{
+    static SchedulingPolicy policy;
+    return &policy;
+}
+
+SchedulingPolicy::SchedulingPolicy()
+{
+#if HAVE_SCHED_RESET_ON_FORK
+    const int defaultPriority = sched_get_priority_min(SCHED_RR);
+#else
+    const int defaultPriority = 0;
+#endif
+    m_compositor.priority = readPriority("KWIN_RT_PRIORITY_COMPOSITOR", defaultPriority);
+    m_compositor.cpus = readCpus("KWIN_RT_CPUS_COMPOSITOR");
+    m_input.priority = readPriority("KWIN_RT_PRIORITY_INPUT", defaultPriority);
+    m_input.cpus = readCpus("KWIN_RT_CPUS_INPUT");
+
+    m_deadline = qgetenv("KWIN_RT_DEADLINE") == QByteArrayLiteral("1");
+    bool ok = false;
+    const int runtime = qEnvironmentVariableIntValue("KWIN_RT_DEADLINE_RUNTIME", &ok);
+    if (ok) {
+        m_deadlineRuntime = qBound(1, runtime, 95);
+    }
+
+    // The kernel only accepts SCHED_DEADLINE threads that may run on all CPUs.
+    if (m_deadline && !m_compositor.cpus.isEmpty()) {
+        qCWarning(KWIN_CORE) << "KWIN_RT_CPUS_COMPOSITOR is ignored with SCHED_DEADLINE";
+        m_compositor.cpus.clear();
+    }
+
+    m_compositor.state = m_input.state = QStringLiteral("not applied");
+}
+
+SchedulingPolicy::RolePolicy &SchedulingPolicy::policy(Role role)
+{
+    return role == Role::Compositor ? m_compositor : m_input;
+}
+
+void SchedulingPolicy::gainRealTime()
+{
+    QMutexLocker locker(&m_mutex);
+    const int priority = std::max(m_compositor.priority, m_input.priority);
+    if (priority > 0) {
+        applyPriority(Role::Compositor, priority, false);
+    }
+}
+
+void SchedulingPolicy::applyToCurrentThread(Role role, bool resetOnFork)
+{
+    QMutexLocker locker(&m_mutex);
+    applyPriority(role, policy(role).priority, resetOnFork);
+    applyAffinity(role);
+}
+
+void SchedulingPolicy::applyPriority(Role role, int priority, bool resetOnFork)
+{
+    RolePolicy &rolePolicy = policy(role);
+#if HAVE_SCHED_RESET_ON_FORK
+    struct sched_param sp;
+    int schedPolicy;
+    if (priority > 0) {
+        schedPolicy = SCHED_RR;
+        sp.sched_priority = priority;
+    } else {
+        schedPolicy = SCHED_OTHER;
+        sp.sched_priority = 0;
+    }
+    if (resetOnFork) {
+        schedPolicy |= SCHED_RESET_ON_FORK;
+    }
+    if (sched_setscheduler(0, schedPolicy, &sp) == 0) {
+        rolePolicy.state = priority > 0 ? QStringLiteral("SCHED_RR, priority %1").arg(priority)
+                                        : QStringLiteral("SCHED_OTHER");
+    } else {
+        rolePolicy.state = QStringLiteral("SCHED_RR priority %1 failed: %2").arg(priority).arg(QString::fromLocal8Bit(strerror(errno)));
+    }
+#else
+    Q_UNUSED(priority)
+    Q_UNUSED(resetOnFork)
+    rolePolicy.state = QStringLiteral("real-time scheduling is not supported");
+#endif
+}
+
+void SchedulingPolicy::applyAffinity(Role role)
+{
+    const RolePolicy &rolePolicy = policy(role);
+    if (rolePolicy.cpus.isEmpty()) {
+        return;
+    }
+#ifdef Q_OS_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : rolePolicy.cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+        qCWarning(KWIN_CORE, "Failed to pin a thread to CPUs %s: %s",
+                  qPrintable(formatCpus(rolePolicy.cpus)), strerror(errno));
+    }
+#endif
+}
+
+bool SchedulingPolicy::wantsDeadline() const
+{
+    return m_deadline;
+}
+
+bool SchedulingPolicy::applyDeadline(int refreshRate)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_deadline) {
+        return false;
+    }
+    if (refreshRate <= 0) {
+        m_compositor.state += QStringLiteral(" (SCHED_DEADLINE needs a known refresh rate)");
+        return false;
+    }
+
+#if KWIN_HAVE_SCHED_DEADLINE
+    const uint64_t period = Q_UINT64_C(1000000000000) / refreshRate;
+    const uint64_t runtime = period * m_deadlineRuntime / 100;
+
+    DeadlineAttributes attributes = {};
+    attributes.size = sizeof(attributes);
+    attributes.policy = s_schedDeadline;
+    attributes.flags = s_schedFlagResetOnFork;
+    attributes.runtime = runtime;
+    attributes.deadline = period;
+    attributes.period = period;
+
+    if (syscall(SYS_sched_setattr, 0, &attributes, 0) == 0) {
+        m_compositor.state = QStringLiteral("SCHED_DEADLINE, runtime %1 us, period %2 us")
+                                 .arg(runtime / 1000)
+                                 .arg(period / 1000);
+        return true;
+    }
+    const int error = errno;
+    qCWarning(KWIN_CORE, "Failed to switch the compositor to SCHED_DEADLINE: %s", strerror(error));
+    m_compositor.state += QStringLiteral(" (SCHED_DEADLINE failed: %1)").arg(QString::fromLocal8Bit(strerror(error)));
+#else
+    m_compositor.state += QStringLiteral(" (SCHED_DEADLINE is not supported)");
+#endif
+    return false;
+}
+
+QString SchedulingPolicy::supportInformation() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString support;
+    support.append(QStringLiteral("Compositor: %1; CPUs: %2\n").arg(m_compositor.state, formatCpus(m_compositor.cpus)));
+    support.append(QStringLiteral("Input: %1; CPUs: %2\n").arg(m_input.state, formatCpus(m_input.cpus)));
+    return support;
+}
+
+} // namespace KWin
@@ -0,0 +1,93 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <kwin_export.h>
+
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * The SchedulingPolicy decides how the latency sensitive threads of kwin_wayland are scheduled.
+ *
+ * Every role gets its own real-time priority and set of CPUs. The compositor can also run with
+ * SCHED_DEADLINE, where the period matches the refresh rate of the fastest output. The policy is
+ * read from the environment once:
+ *
+ * @li KWIN_RT_PRIORITY_COMPOSITOR, KWIN_RT_PRIORITY_INPUT: the SCHED_RR priority, 0 disables
+ * real-time scheduling for the role. Both default to the minimum SCHED_RR priority.
+ * @li KWIN_RT_CPUS_COMPOSITOR, KWIN_RT_CPUS_INPUT: the CPUs the role is pinned to, e.g. "2,4-5".
+ * @li KWIN_RT_DEADLINE=1: run the compositor with SCHED_DEADLINE instead of SCHED_RR.
+ * @li KWIN_RT_DEADLINE_RUNTIME: the share of every period reserved for the compositor, in
+ * percent. Defaults to 80.
+ *
+ * Raising the priority of a thread requires CAP_SYS_NICE, which kwin_wayland drops right after
+ * startup, so the main thread gains the highest priority of all roles first and every thread
+ * lowers itself to the priority of its role later on.
+ */
+class KWIN_EXPORT SchedulingPolicy
+{
+public:
+    enum class Role {
+        Compositor,
+        Input,
+    };
+
+    static SchedulingPolicy *self();
+
+    /**
+     * Gives the calling thread the highest real-time priority of all roles. Threads created by
+     * it afterwards inherit the priority.
+     */
+    void gainRealTime();
+    /**
+     * Applies the priority and the CPU set of @p role to the calling thread. If @p resetOnFork
+     * is @c true, processes and threads created by the calling thread afterwards don't inherit
+     * the real-time priority.
+     */
+    void applyToCurrentThread(Role role, bool resetOnFork = false);
+
+    /**
+     * Returns @c true if the compositor wants to use SCHED_DEADLINE, which keeps requiring
+     * CAP_SYS_NICE until applyDeadline() has been called.
+     */
+    bool wantsDeadline() const;
+    /**
+     * Switches the calling thread to SCHED_DEADLINE with a period of one frame at @p refreshRate,
+     * in millihertz. Falls back to the compositor priority if the kernel refuses the
+     * reservation. Returns @c true on success.
+     */
+    bool applyDeadline(int refreshRate);
+
+    QString supportInformation() const;
+
+private:
+    SchedulingPolicy();
+
+    struct RolePolicy
+    {
+        int priority = 0;
+        QVector<int> cpus;
+        QString state;
+    };
+
+    RolePolicy &policy(Role role);
+    void applyPriority(Role role, int priority, bool resetOnFork);
+    void applyAffinity(Role role);
+
+    RolePolicy m_compositor;
+    RolePolicy m_input;
+    bool m_deadline = false;
+    int m_deadlineRuntime = 80;
+    mutable QMutex m_mutex;
+};
+
+} // namespace KWin
@@ -0,0 +1,153 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+/*
+ * Measures how long a window manager takes to manage the windows that exist when it starts,
+ * which is what happens on session restore. Creates the given number of dummy clients,
+ * launches the window manager and waits until all of them show up in _NET_CLIENT_LIST.
+ *
+ * Run it in a nested X server, e.g.
+ *
+ *   xvfb-run -a -s "-screen 0 1920x1080x24" x11startupbenchmark --clients 500 kwin_x11
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QThread>
+
+#include <xcb/xcb.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static xcb_atom_t internAtom(xcb_connection_t *c, const char *name)
+{
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(c, xcb_intern_atom(c, false, strlen(name), name), nullptr);
+    if (!reply) {
+        return XCB_ATOM_NONE;
+    }
+    const xcb_atom_t atom = reply->atom;
+    free(reply);
+    return atom;
+}
+
+static void createClients(xcb_connection_t *c, xcb_screen_t *screen, int count)
+{
+    const xcb_atom_t pidAtom = internAtom(c, "_NET_WM_PID");
+    const xcb_atom_t nameAtom = internAtom(c, "_NET_WM_NAME");
+    const xcb_atom_t utf8Atom = internAtom(c, "UTF8_STRING");
+    const uint32_t pid = QCoreApplication::applicationPid();
+    static const char windowClass[] = "x11startupbenchmark\0X11StartupBenchmark";
+
+    for (int i = 0; i < count; ++i) {
+        const xcb_window_t window = xcb_generate_id(c);
+        const uint32_t values[] = {screen->white_pixel};
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, window, screen->root,
+                          (i * 16) % 1000, (i * 9) % 600, 300, 200, 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                          XCB_CW_BACK_PIXEL, values);
+
+        const QByteArray name = QByteArrayLiteral("Dummy client ") + QByteArray::number(i);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING,
+                            8, name.size(), name.constData());
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, nameAtom, utf8Atom,
+                            8, name.size(), name.constData());
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING,
+                            8, sizeof(windowClass), windowClass);
+        xcb_change_property(c, XCB_PROP_MODE_REPLACE, window, pidAtom, XCB_ATOM_CARDINAL,
+                            32, 1, &pid);
+        xcb_map_window(c, window);
+    }
+    xcb_flush(c);
+}
+
+static int managedClientCount(xcb_connection_t *c, xcb_window_t root, xcb_atom_t clientListAtom)
+{
+    xcb_get_property_cookie_t cookie = xcb_get_property_unchecked(c, false, root, clientListAtom,
+                                                                  XCB_ATOM_WINDOW, 0, UINT32_MAX);
+    xcb_get_property_reply_t *reply = xcb_get_property_reply(c, cookie, nullptr);
+    if (!reply) {
+        return 0;
+    }
+    const int count = xcb_get_property_value_length(reply) / sizeof(xcb_window_t);
+    free(reply);
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures how long a window manager needs to manage existing clients"));
+    parser.addHelpOption();
+    QCommandLineOption clientsOption(QStringLiteral("clients"),
+                                     QStringLiteral("The number of dummy clients to create."),
+                                     QStringLiteral("count"), QStringLiteral("100"));
+    QCommandLineOption timeoutOption(QStringLiteral("timeout"),
+                                     QStringLiteral("How long to wait for the window manager, in seconds."),
+                                     QStringLiteral("seconds"), QStringLiteral("60"));
+    parser.addOption(clientsOption);
+    parser.addOption(timeoutOption);
+    parser.addPositionalArgument(QStringLiteral("command"),
+                                 QStringLiteral("The window manager to start, e.g. kwin_x11."),
+                                 QStringLiteral("command [arguments...]"));
+    parser.process(app);
+
+    QStringList command = parser.positionalArguments();
+    if (command.isEmpty()) {
+        parser.showHelp(1);
+    }
+    const int clientCount = parser.value(clientsOption).toInt();
+    const int timeout = parser.value(timeoutOption).toInt() * 1000;
+
+    int screenNumber = 0;
+    xcb_connection_t *c = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "Could not connect to the X server\n");
+        return 1;
+    }
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(c));
+    for (int i = 0; i < screenNumber; ++i) {
+        xcb_screen_next(&it);
+    }
+    xcb_screen_t *screen = it.data;
+    const xcb_atom_t clientListAtom = internAtom(c, "_NET_CLIENT_LIST");
+
+    createClients(c, screen, clientCount);
+
+    QProcess windowManager;
+    windowManager.setProcessChannelMode(QProcess::ForwardedChannels);
+
+    QElapsedTimer timer;
+    timer.start();
+    windowManager.start(command.takeFirst(), command);
+    if (!windowManager.waitForStarted()) {
+        fprintf(stderr, "Could not start the window manager\n");
+        return 1;
+    }
+
+    int managed = 0;
+    while (managed < clientCount && timer.elapsed() < timeout) {
+        QThread::msleep(5);
+        managed = managedClientCount(c, screen->root, clientListAtom);
+    }
+    const qint64 elapsed = timer.elapsed();
+
+    windowManager.terminate();
+    windowManager.waitForFinished();
+    xcb_disconnect(c);
+
+    if (managed < clientCount) {
+        fprintf(stderr, "Only %d of %d clients have been managed after %lld ms\n", managed, clientCount, elapsed);
+        return 1;
+    }
+    printf("Managed %d clients in %lld ms\n", clientCount, elapsed);
+    return 0;
+}
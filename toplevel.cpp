@@ -23,6 +23,7 @@
 #include <KWaylandServer/surface_interface.h>
 
 #include <QDebug>
+#include <QVarLengthArray>
 
 namespace KWin
 {
@@ -149,9 +150,9 @@ QRect Toplevel::visibleRect() const
     return rect;
 }
 
-Xcb::Property Toplevel::fetchWmClientLeader() const
+Xcb::Property Toplevel::fetchWmClientLeader(xcb_window_t window)
 {
-    return Xcb::Property(false, window(), atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
+    return Xcb::Property(false, window, atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
 }
 
 void Toplevel::readWmClientLeader(Xcb::Property &prop)
@@ -161,7 +162,7 @@ void Toplevel::readWmClientLeader(Xcb::Property &prop)
 
 void Toplevel::getWmClientLeader()
 {
-    auto prop = fetchWmClientLeader();
+    auto prop = fetchWmClientLeader(window());
     readWmClientLeader(prop);
 }
 
@@ -353,15 +354,12 @@ bool Toplevel::resetAndFetchDamage()
 
     xcb_connection_t *conn = connection();
 
-    // Create a new region and copy the damage region to it,
-    // resetting the damaged state.
-    xcb_xfixes_region_t region = xcb_generate_id(conn);
-    xcb_xfixes_create_region(conn, region, 0, nullptr);
-    xcb_damage_subtract(conn, damage_handle, 0, region);
-
-    // Send a fetch-region request and destroy the region
+    // Move the damage to the shared region, resetting the damaged state, and
+    // send a fetch-region request. The X server processes the requests in order,
+    // so the region can be reused by the next window before the reply arrives.
+    const xcb_xfixes_region_t region = Compositor::self()->damageFetchRegion();
+    xcb_damage_subtract(conn, damage_handle, XCB_NONE, region);
     m_regionCookie = xcb_xfixes_fetch_region_unchecked(conn, region);
-    xcb_xfixes_destroy_region(conn, region);
 
     m_isDamaged = false;
     m_damageReplyPending = true;
@@ -383,18 +381,16 @@ void Toplevel::getDamageRegionReply()
     if (!reply)
         return;
 
-    // Convert the reply to a QRegion
+    // Convert the reply to a QRegion, the rectangles are small enough to stay on the stack
     int count = xcb_xfixes_fetch_region_rectangles_length(reply);
     QRegion region;
 
     if (count > 1 && count < 16) {
-        xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(reply);
-
-        QVector<QRect> qrects;
-        qrects.reserve(count);
+        const xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(reply);
 
+        QVarLengthArray<QRect, 16> qrects(count);
         for (int i = 0; i < count; i++)
-            qrects << QRect(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+            qrects[i] = QRect(rects[i].x, rects[i].y, rects[i].width, rects[i].height);
 
         region.setRects(qrects.constData(), count);
     } else
@@ -669,9 +665,9 @@ xcb_window_t Toplevel::frameId() const
     return m_client;
 }
 
-Xcb::Property Toplevel::fetchSkipCloseAnimation() const
+Xcb::Property Toplevel::fetchSkipCloseAnimation(xcb_window_t window)
 {
-    return Xcb::Property(false, window(), atoms->kde_skip_close_animation, XCB_ATOM_CARDINAL, 0, 1);
+    return Xcb::Property(false, window, atoms->kde_skip_close_animation, XCB_ATOM_CARDINAL, 0, 1);
 }
 
 void Toplevel::readSkipCloseAnimation(Xcb::Property &property)
@@ -681,7 +677,7 @@ void Toplevel::readSkipCloseAnimation(Xcb::Property &property)
 
 void Toplevel::getSkipCloseAnimation()
 {
-    Xcb::Property property = fetchSkipCloseAnimation();
+    Xcb::Property property = fetchSkipCloseAnimation(window());
     readSkipCloseAnimation(property);
 }
 
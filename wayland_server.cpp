@@ -244,6 +244,16 @@ void WaylandServer::registerShellClient(AbstractClient *client)
         connect(client, &AbstractClient::windowShown, this, &WaylandServer::shellClientShown);
     }
     m_clients << client;
+
+    if (SurfaceInterface *surface = client->surface()) {
+        m_clientsBySurface.insert(surface, client);
+        // The client may outlive its surface, drop the entry before the address is reused.
+        connect(surface, &QObject::destroyed, client, [this, surface, client]() {
+            if (m_clientsBySurface.value(surface) == client) {
+                m_clientsBySurface.remove(surface);
+            }
+        });
+    }
 }
 
 void WaylandServer::registerXdgToplevelClient(XdgToplevelClient *client)
@@ -733,6 +743,9 @@ void WaylandServer::createInternalConnection()
 void WaylandServer::removeClient(AbstractClient *c)
 {
     m_clients.removeAll(c);
+    if (c->surface() && m_clientsBySurface.value(c->surface()) == c) {
+        m_clientsBySurface.remove(c->surface());
+    }
     emit shellClientRemoved(c);
 }
 
@@ -747,28 +760,12 @@ void WaylandServer::dispatch()
     m_display->dispatchEvents();
 }
 
-static AbstractClient *findClientInList(const QList<AbstractClient *> &clients, KWaylandServer::SurfaceInterface *surface)
-{
-    auto it = std::find_if(clients.begin(), clients.end(),
-        [surface] (AbstractClient *c) {
-            return c->surface() == surface;
-        }
-    );
-    if (it == clients.end()) {
-        return nullptr;
-    }
-    return *it;
-}
-
 AbstractClient *WaylandServer::findClient(SurfaceInterface *surface) const
 {
     if (!surface) {
         return nullptr;
     }
-    if (AbstractClient *c = findClientInList(m_clients, surface)) {
-        return c;
-    }
-    return nullptr;
+    return m_clientsBySurface.value(surface);
 }
 
 XdgToplevelClient *WaylandServer::findXdgToplevelClient(SurfaceInterface *surface) const
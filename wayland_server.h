@@ -12,6 +12,7 @@
 #include <kwinglobals.h>
 #include "keyboard_input.h"
 
+#include <QHash>
 #include <QObject>
 
 class QThread;
@@ -301,6 +302,7 @@ private:
     KWaylandServer::XdgForeignV2Interface *m_XdgForeign = nullptr;
     KWaylandServer::KeyStateInterface *m_keyState = nullptr;
     QList<AbstractClient *> m_clients;
+    QHash<KWaylandServer::SurfaceInterface *, AbstractClient *> m_clientsBySurface;
     InitializationFlags m_initFlags;
     QVector<KWaylandServer::PlasmaShellSurfaceInterface*> m_plasmaShellSurfaces;
     KWIN_SINGLETON(WaylandServer)
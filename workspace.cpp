@@ -12,6 +12,7 @@
 #include "workspace.h"
 // kwin libs
 #include <kwinglplatform.h>
+#include <kwinglutils.h>
 // kwin
 #ifdef KWIN_BUILD_ACTIVITIES
 #include "activities.h"
@@ -35,6 +36,7 @@
 #include "placement.h"
 #include "pluginmanager.h"
 #include "rules.h"
+#include "schedulingpolicy.h"
 #include "screenedge.h"
 #include "screens.h"
 #include "platform.h"
@@ -59,6 +61,8 @@
 #include <KStartupInfo>
 // Qt
 #include <QtConcurrentRun>
+// std
+#include <vector>
 
 namespace KWin
 {
@@ -390,6 +394,8 @@ void Workspace::initializeX11()
             windowGeometries[i] = Xcb::WindowGeometry(wins[i]);
         }
 
+        std::vector<X11ClientPrefetch> prefetches;
+
         // Get the replies
         for (int i = 0; i < tree->children_len; i++) {
             Xcb::WindowAttributes attr(windowAttributes.at(i));
@@ -407,12 +413,21 @@ void Workspace::initializeX11()
                 if (Application::wasCrash()) {
                     fixPositionAfterCrash(wins[i], windowGeometries.at(i).data());
                 }
+                if (prefetches.empty()) {
+                    prefetches.reserve(tree->children_len - i);
+                }
 
-                // ### This will request the attributes again
-                createClient(wins[i], true);
+                // Only send the requests for now, so the replies for all clients
+                // arrive in one round-trip rather than a few per client. The
+                // attributes and the geometry have been requested above already
+                prefetches.emplace_back(wins[i], attr, windowGeometries.at(i));
             }
         }
 
+        for (X11ClientPrefetch &prefetch : prefetches) {
+            createClient(prefetch, true);
+        }
+
         // Propagate clients, will really happen at the end of the updates blocker block
         updateStackingOrder(true);
 
@@ -539,6 +554,12 @@ void Workspace::setupClientConnections(AbstractClient *c)
 }
 
 X11Client *Workspace::createClient(xcb_window_t w, bool is_mapped)
+{
+    X11ClientPrefetch prefetch(w);
+    return createClient(prefetch, is_mapped);
+}
+
+X11Client *Workspace::createClient(X11ClientPrefetch &prefetch, bool is_mapped)
 {
     StackingUpdatesBlocker blocker(this);
     X11Client *c = nullptr;
@@ -552,7 +573,7 @@ X11Client *Workspace::createClient(xcb_window_t w, bool is_mapped)
         connect(c, &X11Client::blockingCompositingChanged, compositor, &X11Compositor::updateClientCompositeBlocking);
     }
     connect(c, &X11Client::clientFullScreenSet, ScreenEdges::self(), &ScreenEdges::checkBlocking);
-    if (!c->manage(w, is_mapped)) {
+    if (!c->manage(prefetch, is_mapped)) {
         X11Client::deleteClient(c);
         return nullptr;
     }
@@ -594,6 +615,11 @@ void Workspace::addClient(X11Client *c)
     }
     clients.append(c);
     m_allClients.append(c);
+    m_toplevelsById.insert(c->internalId(), c);
+    m_x11WindowIndex.insert(c->window(), c, X11WindowIndex::Role::Client);
+    m_x11WindowIndex.insert(c->wrapperId(), c, X11WindowIndex::Role::Wrapper);
+    m_x11WindowIndex.insert(c->frameId(), c, X11WindowIndex::Role::Frame);
+    m_x11WindowIndex.insert(c->inputId(), c, X11WindowIndex::Role::Input);
     if (!unconstrained_stacking_order.contains(c))
         unconstrained_stacking_order.append(c);   // Raise if it hasn't got any stacking position yet
     if (!stacking_order.contains(c))    // It'll be updated later, and updateToolWindows() requires
@@ -618,6 +644,8 @@ void Workspace::addClient(X11Client *c)
 void Workspace::addUnmanaged(Unmanaged* c)
 {
     m_unmanaged.append(c);
+    m_toplevelsById.insert(c->internalId(), c);
+    m_x11WindowIndex.insert(c->window(), c, X11WindowIndex::Role::Unmanaged);
     markXStackingOrderAsDirty();
 }
 
@@ -643,6 +671,11 @@ void Workspace::removeClient(X11Client *c)
     // TODO: if marked client is removed, notify the marked list
     clients.removeAll(c);
     m_allClients.removeAll(c);
+    m_toplevelsById.remove(c->internalId());
+    m_x11WindowIndex.remove(c->window(), c);
+    m_x11WindowIndex.remove(c->wrapperId(), c);
+    m_x11WindowIndex.remove(c->frameId(), c);
+    m_x11WindowIndex.remove(c->inputId(), c);
     markXStackingOrderAsDirty();
     attention_chain.removeAll(c);
     Group* group = findGroup(c->window());
@@ -666,10 +699,26 @@ void Workspace::removeClient(X11Client *c)
     updateTabbox();
 }
 
+/**
+ * Updates the window id index after the input window of the client \a c has been
+ * created or destroyed.
+ */
+void Workspace::clientInputWindowChanged(X11Client *c, xcb_window_t oldInputId)
+{
+    // The input window is also updated while the client is being managed or released.
+    if (m_x11WindowIndex.find(c->window(), X11WindowIndex::Role::Client) != c) {
+        return;
+    }
+    m_x11WindowIndex.remove(oldInputId, c);
+    m_x11WindowIndex.insert(c->inputId(), c, X11WindowIndex::Role::Input);
+}
+
 void Workspace::removeUnmanaged(Unmanaged* c)
 {
     Q_ASSERT(m_unmanaged.contains(c));
     m_unmanaged.removeAll(c);
+    m_toplevelsById.remove(c->internalId());
+    m_x11WindowIndex.remove(c->window(), c);
     emit unmanagedRemoved(c);
     markXStackingOrderAsDirty();
 }
@@ -732,6 +781,7 @@ void Workspace::addShellClient(AbstractClient *client)
         }
     }
     m_allClients.append(client);
+    m_toplevelsById.insert(client->internalId(), client);
     if (!unconstrained_stacking_order.contains(client)) {
         unconstrained_stacking_order.append(client); // Raise if it hasn't got any stacking position yet
     }
@@ -768,6 +818,7 @@ void Workspace::removeShellClient(AbstractClient *client)
 {
     clientHidden(client);
     m_allClients.removeAll(client);
+    m_toplevelsById.remove(client->internalId());
     if (client == most_recently_raised) {
         most_recently_raised = nullptr;
     }
@@ -1473,6 +1524,13 @@ QString Workspace::supportInformation() const
     support.append(kwinApp()->platform()->supportInformation());
     support.append(QStringLiteral("\n"));
 
+    if (kwinApp()->shouldUseWaylandForCompositing()) {
+        support.append(QStringLiteral("Scheduling\n"));
+        support.append(QStringLiteral("==========\n"));
+        support.append(SchedulingPolicy::self()->supportInformation());
+        support.append(QStringLiteral("\n"));
+    }
+
     const Cursor *cursor = Cursors::self()->mouse();
     support.append(QLatin1String("Cursor\n"));
     support.append(QLatin1String("======\n"));
@@ -1624,6 +1682,7 @@ QString Workspace::supportInformation() const
             }
 
             support.append(QStringLiteral("OpenGL 2 Shaders are used\n"));
+            support.append(ShaderManager::instance()->supportInformation());
             break;
         }
         case XRenderCompositing:
@@ -1703,30 +1762,20 @@ Unmanaged *Workspace::findUnmanaged(std::function<bool (const Unmanaged*)> func)
 
 Unmanaged *Workspace::findUnmanaged(xcb_window_t w) const
 {
-    return findUnmanaged([w](const Unmanaged *u) {
-        return u->window() == w;
-    });
+    return static_cast<Unmanaged *>(m_x11WindowIndex.find(w, X11WindowIndex::Role::Unmanaged));
 }
 
 X11Client *Workspace::findClient(Predicate predicate, xcb_window_t w) const
 {
     switch (predicate) {
     case Predicate::WindowMatch:
-        return findClient([w](const X11Client *c) {
-            return c->window() == w;
-        });
+        return static_cast<X11Client *>(m_x11WindowIndex.find(w, X11WindowIndex::Role::Client));
     case Predicate::WrapperIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->wrapperId() == w;
-        });
+        return static_cast<X11Client *>(m_x11WindowIndex.find(w, X11WindowIndex::Role::Wrapper));
     case Predicate::FrameIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->frameId() == w;
-        });
+        return static_cast<X11Client *>(m_x11WindowIndex.find(w, X11WindowIndex::Role::Frame));
     case Predicate::InputIdMatch:
-        return findClient([w](const X11Client *c) {
-            return c->inputId() == w;
-        });
+        return static_cast<X11Client *>(m_x11WindowIndex.find(w, X11WindowIndex::Role::Input));
     }
     return nullptr;
 }
@@ -1747,9 +1796,7 @@ Toplevel *Workspace::findToplevel(std::function<bool (const Toplevel*)> func) co
 
 Toplevel *Workspace::findToplevel(const QUuid &internalId) const
 {
-    return findToplevel([internalId] (const KWin::Toplevel* l) -> bool {
-        return internalId == l->internalId();
-    });
+    return m_toplevelsById.value(internalId);
 }
 
 void Workspace::forEachToplevel(std::function<void (Toplevel *)> func)
@@ -1834,6 +1881,7 @@ void Workspace::updateTabbox()
 void Workspace::addInternalClient(InternalClient *client)
 {
     m_internalClients.append(client);
+    m_toplevelsById.insert(client->internalId(), client);
 
     setupClientConnections(client);
     client->updateLayer();
@@ -1853,6 +1901,7 @@ void Workspace::addInternalClient(InternalClient *client)
 void Workspace::removeInternalClient(InternalClient *client)
 {
     m_internalClients.removeOne(client);
+    m_toplevelsById.remove(client->internalId());
 
     markXStackingOrderAsDirty();
     updateStackingOrder(true);
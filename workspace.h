@@ -17,8 +17,11 @@
 #include "options.h"
 #include "sm.h"
 #include "utils.h"
+#include "x11windowindex.h"
 // Qt
+#include <QHash>
 #include <QTimer>
+#include <QUuid>
 #include <QVector>
 // std
 #include <functional>
@@ -52,6 +55,7 @@ class Toplevel;
 class Unmanaged;
 class UserActionsMenu;
 class X11Client;
+struct X11ClientPrefetch;
 class X11EventFilter;
 enum class Predicate;
 
@@ -329,6 +333,7 @@ public:
     bool showingDesktop() const;
 
     void removeClient(X11Client *);   // Only called from X11Client::destroyClient() or X11Client::releaseWindow()
+    void clientInputWindowChanged(X11Client *c, xcb_window_t oldInputId);   // Only called from X11Client
     void setActiveClient(AbstractClient*);
     Group* findGroup(xcb_window_t leader) const;
     void addGroup(Group* group);
@@ -560,6 +565,7 @@ private:
 
     /// This is the right way to create a new client
     X11Client *createClient(xcb_window_t w, bool is_mapped);
+    X11Client *createClient(X11ClientPrefetch &prefetch, bool is_mapped);
     void setupClientConnections(AbstractClient *client);
     void addClient(X11Client *c);
     Unmanaged* createUnmanaged(xcb_window_t w);
@@ -602,8 +608,10 @@ private:
     QList<X11Client *> clients;
     QList<AbstractClient*> m_allClients;
     QList<Unmanaged *> m_unmanaged;
+    X11WindowIndex m_x11WindowIndex; // Windows of clients and m_unmanaged
     QList<Deleted *> deleted;
     QList<InternalClient *> m_internalClients;
+    QHash<QUuid, Toplevel *> m_toplevelsById; // Clients, m_unmanaged and m_internalClients
 
     QList<Toplevel *> unconstrained_stacking_order; // Topmost last
     QList<Toplevel *> stacking_order; // Topmost last
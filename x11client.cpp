@@ -308,17 +308,42 @@ void X11Client::destroyClient()
     deleteClient(this);
 }
 
+/**
+ * Sends the requests for the properties that manage() needs, without waiting for the replies.
+ */
+X11ClientPrefetch::X11ClientPrefetch(xcb_window_t window)
+    : X11ClientPrefetch(window, Xcb::WindowAttributes(window), Xcb::WindowGeometry(window))
+{
+}
+
+X11ClientPrefetch::X11ClientPrefetch(xcb_window_t window, const Xcb::WindowAttributes &attributes, const Xcb::WindowGeometry &geometry)
+    : window(window)
+    , attributes(attributes)
+    , geometry(geometry)
+    , wmClientLeader(X11Client::fetchWmClientLeader(window))
+    , skipCloseAnimation(X11Client::fetchSkipCloseAnimation(window))
+    , showOnScreenEdge(X11Client::fetchShowOnScreenEdge(window))
+    , preferredColorScheme(X11Client::fetchPreferredColorScheme(window))
+    , firstInTabBox(X11Client::fetchFirstInTabBox(window))
+    , transient(X11Client::fetchTransient(window))
+    , activities(X11Client::fetchActivities(window))
+    , applicationMenuServiceName(X11Client::fetchApplicationMenuServiceName(window))
+    , applicationMenuObjectPath(X11Client::fetchApplicationMenuObjectPath(window))
+{
+}
+
 /**
  * Manages the clients. This means handling the very first maprequest:
  * reparenting, initial geometry, initial state, placement, etc.
  * Returns false if KWin is not going to manage this window.
  */
-bool X11Client::manage(xcb_window_t w, bool isMapped)
+bool X11Client::manage(X11ClientPrefetch &prefetch, bool isMapped)
 {
     StackingUpdatesBlocker stacking_blocker(workspace());
 
-    Xcb::WindowAttributes attr(w);
-    Xcb::WindowGeometry windowGeometry(w);
+    const xcb_window_t w = prefetch.window;
+    Xcb::WindowAttributes &attr = prefetch.attributes;
+    Xcb::WindowGeometry &windowGeometry = prefetch.geometry;
     if (attr.isNull() || windowGeometry.isNull()) {
         return false;
     }
@@ -364,16 +389,6 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
         NET::WM2DesktopFileName |
         NET::WM2GTKFrameExtents;
 
-    auto wmClientLeaderCookie = fetchWmClientLeader();
-    auto skipCloseAnimationCookie = fetchSkipCloseAnimation();
-    auto showOnScreenEdgeCookie = fetchShowOnScreenEdge();
-    auto colorSchemeCookie = fetchPreferredColorScheme();
-    auto firstInTabBoxCookie = fetchFirstInTabBox();
-    auto transientCookie = fetchTransient();
-    auto activitiesCookie = fetchActivities();
-    auto applicationMenuServiceNameCookie = fetchApplicationMenuServiceName();
-    auto applicationMenuObjectPathCookie = fetchApplicationMenuObjectPath();
-
     m_geometryHints.init(window());
     m_motif.init(window());
     info = new WinInfo(this, m_client, rootWindow(), properties, properties2);
@@ -389,7 +404,7 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
     m_colormap = attr->colormap;
 
     getResourceClass();
-    readWmClientLeader(wmClientLeaderCookie);
+    readWmClientLeader(prefetch.wmClientLeader);
     getWmClientMachine();
     getSyncCounter();
     // First only read the caption text, so that setupWindowRules() can use it for matching,
@@ -414,7 +429,7 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
     updateAllowedActions(); // Group affects isMinimizable()
 
     setModal((info->state() & NET::Modal) != 0);   // Needs to be valid before handling groups
-    readTransientProperty(transientCookie);
+    readTransientProperty(prefetch.transient);
     setDesktopFileName(rules()->checkDesktopFile(QByteArray(info->desktopFileName()), true).toUtf8());
     getIcons();
     connect(this, &X11Client::desktopFileNameChanged, this, &X11Client::getIcons);
@@ -422,14 +437,14 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
     m_geometryHints.read();
     getMotifHints();
     getWmOpaqueRegion();
-    readSkipCloseAnimation(skipCloseAnimationCookie);
+    readSkipCloseAnimation(prefetch.skipCloseAnimation);
 
     // TODO: Try to obey all state information from info->state()
 
     setOriginalSkipTaskbar((info->state() & NET::SkipTaskbar) != 0);
     setSkipPager((info->state() & NET::SkipPager) != 0);
     setSkipSwitcher((info->state() & NET::SkipSwitcher) != 0);
-    readFirstInTabBox(firstInTabBoxCookie);
+    readFirstInTabBox(prefetch.firstInTabBox);
 
     setupCompositing();
 
@@ -453,7 +468,7 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
     init_minimize = rules()->checkMinimize(init_minimize, !isMapped);
     noborder = rules()->checkNoBorder(noborder, !isMapped);
 
-    readActivities(activitiesCookie);
+    readActivities(prefetch.activities);
 
     // Initial desktop placement
     int desk = 0;
@@ -600,10 +615,10 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
 
     // Create client group if the window will have a decoration
     bool dontKeepInArea = false;
-    setColorScheme(readPreferredColorScheme(colorSchemeCookie));
+    setColorScheme(readPreferredColorScheme(prefetch.preferredColorScheme));
 
-    readApplicationMenuServiceName(applicationMenuServiceNameCookie);
-    readApplicationMenuObjectPath(applicationMenuObjectPathCookie);
+    readApplicationMenuServiceName(prefetch.applicationMenuServiceName);
+    readApplicationMenuObjectPath(prefetch.applicationMenuObjectPath);
 
     updateDecoration(false);   // Also gravitates
     // TODO: Is CentralGravity right here, when resizing is done after gravitating?
@@ -864,7 +879,7 @@ bool X11Client::manage(xcb_window_t w, bool isMapped)
     updateWindowRules(Rules::All); // Was blocked while !isManaged()
 
     setBlockingCompositing(info->isBlockingCompositing());
-    readShowOnScreenEdge(showOnScreenEdgeCookie);
+    readShowOnScreenEdge(prefetch.showOnScreenEdge);
 
     // Forward all opacity values to the frame in case there'll be other CM running.
     connect(Compositor::self(), &Compositor::compositingToggled, this,
@@ -983,7 +998,11 @@ void X11Client::updateInputWindow()
     }
 
     if (region.isEmpty()) {
-        m_decoInputExtent.reset();
+        if (m_decoInputExtent.isValid()) {
+            const xcb_window_t oldInputId = m_decoInputExtent;
+            m_decoInputExtent.reset();
+            workspace()->clientInputWindowChanged(this, oldInputId);
+        }
         return;
     }
 
@@ -1006,6 +1025,7 @@ void X11Client::updateInputWindow()
             XCB_EVENT_MASK_POINTER_MOTION
         };
         m_decoInputExtent.create(bounds, XCB_WINDOW_CLASS_INPUT_ONLY, mask, values);
+        workspace()->clientInputWindowChanged(this, XCB_WINDOW_NONE);
         if (mapping_state == Mapped)
             m_decoInputExtent.map();
     } else {
@@ -1088,7 +1108,11 @@ void X11Client::destroyDecoration()
             emit geometryShapeChanged(this, oldgeom);
         }
     }
-    m_decoInputExtent.reset();
+    if (m_decoInputExtent.isValid()) {
+        const xcb_window_t oldInputId = m_decoInputExtent;
+        m_decoInputExtent.reset();
+        workspace()->clientInputWindowChanged(this, oldInputId);
+    }
 }
 
 void X11Client::layoutDecorationRects(QRect &left, QRect &top, QRect &right, QRect &bottom) const
@@ -2447,11 +2471,12 @@ void X11Client::updateAllowedActions(bool force)
     }
 }
 
-Xcb::StringProperty X11Client::fetchActivities() const
+Xcb::StringProperty X11Client::fetchActivities(xcb_window_t window)
 {
 #ifdef KWIN_BUILD_ACTIVITIES
-    return Xcb::StringProperty(window(), atoms->activities);
+    return Xcb::StringProperty(window, atoms->activities);
 #else
+    Q_UNUSED(window)
     return Xcb::StringProperty();
 #endif
 }
@@ -2514,7 +2539,7 @@ void X11Client::readActivities(Xcb::StringProperty &property)
 void X11Client::checkActivities()
 {
 #ifdef KWIN_BUILD_ACTIVITIES
-    Xcb::StringProperty property = fetchActivities();
+    Xcb::StringProperty property = fetchActivities(window());
     readActivities(property);
 #endif
 }
@@ -2525,9 +2550,9 @@ void X11Client::setSessionActivityOverride(bool needed)
     updateActivities(false);
 }
 
-Xcb::Property X11Client::fetchFirstInTabBox() const
+Xcb::Property X11Client::fetchFirstInTabBox(xcb_window_t window)
 {
-    return Xcb::Property(false, m_client, atoms->kde_first_in_window_list,
+    return Xcb::Property(false, window, atoms->kde_first_in_window_list,
                          atoms->kde_first_in_window_list, 0, 1);
 }
 
@@ -2539,13 +2564,13 @@ void X11Client::readFirstInTabBox(Xcb::Property &property)
 void X11Client::updateFirstInTabBox()
 {
     // TODO: move into KWindowInfo
-    Xcb::Property property = fetchFirstInTabBox();
+    Xcb::Property property = fetchFirstInTabBox(window());
     readFirstInTabBox(property);
 }
 
-Xcb::StringProperty X11Client::fetchPreferredColorScheme() const
+Xcb::StringProperty X11Client::fetchPreferredColorScheme(xcb_window_t window)
 {
-    return Xcb::StringProperty(m_client, atoms->kde_color_sheme);
+    return Xcb::StringProperty(window, atoms->kde_color_sheme);
 }
 
 QString X11Client::readPreferredColorScheme(Xcb::StringProperty &property) const
@@ -2555,7 +2580,7 @@ QString X11Client::readPreferredColorScheme(Xcb::StringProperty &property) const
 
 QString X11Client::preferredColorScheme() const
 {
-    Xcb::StringProperty property = fetchPreferredColorScheme();
+    Xcb::StringProperty property = fetchPreferredColorScheme(window());
     return readPreferredColorScheme(property);
 }
 
@@ -2695,9 +2720,9 @@ QMatrix4x4 X11Client::inputTransformation() const
     return matrix;
 }
 
-Xcb::Property X11Client::fetchShowOnScreenEdge() const
+Xcb::Property X11Client::fetchShowOnScreenEdge(xcb_window_t window)
 {
-    return Xcb::Property(false, window(), atoms->kde_screen_edge_show, XCB_ATOM_CARDINAL, 0, 1);
+    return Xcb::Property(false, window, atoms->kde_screen_edge_show, XCB_ATOM_CARDINAL, 0, 1);
 }
 
 void X11Client::readShowOnScreenEdge(Xcb::Property &property)
@@ -2768,7 +2793,7 @@ void X11Client::readShowOnScreenEdge(Xcb::Property &property)
 
 void X11Client::updateShowOnScreenEdge()
 {
-    Xcb::Property property = fetchShowOnScreenEdge();
+    Xcb::Property property = fetchShowOnScreenEdge(window());
     readShowOnScreenEdge(property);
 }
 
@@ -2806,9 +2831,9 @@ QSize X11Client::resizeIncrements() const
     return m_geometryHints.resizeIncrements();
 }
 
-Xcb::StringProperty X11Client::fetchApplicationMenuServiceName() const
+Xcb::StringProperty X11Client::fetchApplicationMenuServiceName(xcb_window_t window)
 {
-    return Xcb::StringProperty(m_client, atoms->kde_net_wm_appmenu_service_name);
+    return Xcb::StringProperty(window, atoms->kde_net_wm_appmenu_service_name);
 }
 
 void X11Client::readApplicationMenuServiceName(Xcb::StringProperty &property)
@@ -2818,13 +2843,13 @@ void X11Client::readApplicationMenuServiceName(Xcb::StringProperty &property)
 
 void X11Client::checkApplicationMenuServiceName()
 {
-    Xcb::StringProperty property = fetchApplicationMenuServiceName();
+    Xcb::StringProperty property = fetchApplicationMenuServiceName(window());
     readApplicationMenuServiceName(property);
 }
 
-Xcb::StringProperty X11Client::fetchApplicationMenuObjectPath() const
+Xcb::StringProperty X11Client::fetchApplicationMenuObjectPath(xcb_window_t window)
 {
-    return Xcb::StringProperty(m_client, atoms->kde_net_wm_appmenu_object_path);
+    return Xcb::StringProperty(window, atoms->kde_net_wm_appmenu_object_path);
 }
 
 void X11Client::readApplicationMenuObjectPath(Xcb::StringProperty &property)
@@ -2834,7 +2859,7 @@ void X11Client::readApplicationMenuObjectPath(Xcb::StringProperty &property)
 
 void X11Client::checkApplicationMenuObjectPath()
 {
-    Xcb::StringProperty property = fetchApplicationMenuObjectPath();
+    Xcb::StringProperty property = fetchApplicationMenuObjectPath(window());
     readApplicationMenuObjectPath(property);
 }
 
@@ -3035,9 +3060,9 @@ bool X11Client::sameAppWindowRoleMatch(const X11Client *c1, const X11Client *c2,
  - every window in the group : group()->members()
 */
 
-Xcb::TransientFor X11Client::fetchTransient() const
+Xcb::TransientFor X11Client::fetchTransient(xcb_window_t window)
 {
-    return Xcb::TransientFor(window());
+    return Xcb::TransientFor(window);
 }
 
 void X11Client::readTransientProperty(Xcb::TransientFor &transientFor)
@@ -3055,7 +3080,7 @@ void X11Client::readTransientProperty(Xcb::TransientFor &transientFor)
 
 void X11Client::readTransient()
 {
-    Xcb::TransientFor transientFor = fetchTransient();
+    Xcb::TransientFor transientFor = fetchTransient(window());
     readTransientProperty(transientFor);
 }
 
@@ -46,6 +46,38 @@ enum class Predicate {
     InputIdMatch
 };
 
+/**
+ * The X11ClientPrefetch struct holds the requests that X11Client::manage() needs to read
+ * the initial state of a window. Constructing it only sends the requests, the replies are
+ * read when the window is managed.
+ *
+ * Creating the prefetches for a batch of windows before managing any of them lets the X
+ * server answer all requests in a single round-trip rather than several round-trips per
+ * window.
+ */
+struct KWIN_EXPORT X11ClientPrefetch
+{
+    explicit X11ClientPrefetch(xcb_window_t window);
+    /**
+     * Reuses the @p attributes and @p geometry requests that have already been sent for the
+     * @p window, the prefetch takes over their replies.
+     */
+    X11ClientPrefetch(xcb_window_t window, const Xcb::WindowAttributes &attributes, const Xcb::WindowGeometry &geometry);
+
+    xcb_window_t window;
+    Xcb::WindowAttributes attributes;
+    Xcb::WindowGeometry geometry;
+    Xcb::Property wmClientLeader;
+    Xcb::Property skipCloseAnimation;
+    Xcb::Property showOnScreenEdge;
+    Xcb::StringProperty preferredColorScheme;
+    Xcb::Property firstInTabBox;
+    Xcb::TransientFor transient;
+    Xcb::StringProperty activities;
+    Xcb::StringProperty applicationMenuServiceName;
+    Xcb::StringProperty applicationMenuObjectPath;
+};
+
 class KWIN_EXPORT X11Client : public AbstractClient
 {
     Q_OBJECT
@@ -118,7 +150,7 @@ public:
     bool windowEvent(xcb_generic_event_t *e);
     NET::WindowType windowType(bool direct = false, int supported_types = 0) const override;
 
-    bool manage(xcb_window_t w, bool isMapped);
+    bool manage(X11ClientPrefetch &prefetch, bool isMapped);
     void releaseWindow(bool on_shutdown = false);
     void destroyClient() override;
 
@@ -251,10 +283,10 @@ public:
 
     void layoutDecorationRects(QRect &left, QRect &top, QRect &right, QRect &bottom) const override;
 
-    Xcb::Property fetchFirstInTabBox() const;
+    static Xcb::Property fetchFirstInTabBox(xcb_window_t window);
     void readFirstInTabBox(Xcb::Property &property);
     void updateFirstInTabBox();
-    Xcb::StringProperty fetchPreferredColorScheme() const;
+    static Xcb::StringProperty fetchPreferredColorScheme(xcb_window_t window);
     QString readPreferredColorScheme(Xcb::StringProperty &property) const;
     QString preferredColorScheme() const override;
 
@@ -270,11 +302,11 @@ public:
      */
     void showOnScreenEdge() override;
 
-    Xcb::StringProperty fetchApplicationMenuServiceName() const;
+    static Xcb::StringProperty fetchApplicationMenuServiceName(xcb_window_t window);
     void readApplicationMenuServiceName(Xcb::StringProperty &property);
     void checkApplicationMenuServiceName();
 
-    Xcb::StringProperty fetchApplicationMenuObjectPath() const;
+    static Xcb::StringProperty fetchApplicationMenuObjectPath(xcb_window_t window);
     void readApplicationMenuObjectPath(Xcb::StringProperty &property);
     void checkApplicationMenuObjectPath();
 
@@ -426,7 +458,7 @@ private:
 
     void updateInputWindow();
 
-    Xcb::Property fetchShowOnScreenEdge() const;
+    static Xcb::Property fetchShowOnScreenEdge(xcb_window_t window);
     void readShowOnScreenEdge(Xcb::Property &property);
     /**
      * Reads the property and creates/destroys the screen edge if required
@@ -454,7 +486,7 @@ private:
     };
     MappingState mapping_state;
 
-    Xcb::TransientFor fetchTransient() const;
+    static Xcb::TransientFor fetchTransient(xcb_window_t window);
     void readTransientProperty(Xcb::TransientFor &transientFor);
     void readTransient();
     xcb_window_t verifyTransientFor(xcb_window_t transient_for, bool set);
@@ -496,8 +528,9 @@ private:
     friend struct ResetupRulesProcedure;
 
     friend bool performTransiencyCheck();
+    friend struct X11ClientPrefetch;
 
-    Xcb::StringProperty fetchActivities() const;
+    static Xcb::StringProperty fetchActivities(xcb_window_t window);
     void readActivities(Xcb::StringProperty &property);
     void checkActivities();
     bool activitiesDefined; //whether the x property was actually set
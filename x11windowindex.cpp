@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "x11windowindex.h"
+
+namespace KWin
+{
+
+void X11WindowIndex::insert(xcb_window_t window, Toplevel *toplevel, Role role)
+{
+    if (window == XCB_WINDOW_NONE) {
+        return;
+    }
+    m_entries.insert(window, Entry{toplevel, role});
+}
+
+void X11WindowIndex::remove(xcb_window_t window, Toplevel *toplevel)
+{
+    auto it = m_entries.find(window);
+    if (it != m_entries.end() && it->toplevel == toplevel) {
+        m_entries.erase(it);
+    }
+}
+
+Toplevel *X11WindowIndex::find(xcb_window_t window, Role role) const
+{
+    auto it = m_entries.constFind(window);
+    if (it != m_entries.constEnd() && it->role == role) {
+        return it->toplevel;
+    }
+    return nullptr;
+}
+
+int X11WindowIndex::count() const
+{
+    return m_entries.count();
+}
+
+void X11WindowIndex::clear()
+{
+    m_entries.clear();
+}
+
+} // namespace KWin
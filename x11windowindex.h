@@ -0,0 +1,77 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kwinglobals.h"
+
+#include <QHash>
+
+#include <xcb/xcb.h>
+
+namespace KWin
+{
+
+class Toplevel;
+
+/**
+ * The X11WindowIndex class maps X11 window ids to the Toplevels that own them.
+ *
+ * A managed client owns several windows: the client window itself, the wrapper, the frame
+ * and the optional input window. X11 window ids are unique, so a single hash table is
+ * enough to map all of them. Every entry remembers which role the window plays for its
+ * owner, so a lookup for a frame doesn't return a client whose client window happens to
+ * match.
+ *
+ * The index never dereferences the Toplevel pointers, it's the responsibility of the
+ * Workspace to keep the index in sync with its client lists.
+ */
+class KWIN_EXPORT X11WindowIndex
+{
+public:
+    enum class Role {
+        Client,
+        Wrapper,
+        Frame,
+        Input,
+        Unmanaged,
+    };
+
+    /**
+     * Adds the @p window owned by the given @p toplevel to the index. Nothing is done if
+     * the @p window is @c XCB_WINDOW_NONE.
+     */
+    void insert(xcb_window_t window, Toplevel *toplevel, Role role);
+
+    /**
+     * Removes the @p window from the index if it's owned by the specified @p toplevel.
+     */
+    void remove(xcb_window_t window, Toplevel *toplevel);
+
+    /**
+     * Returns the Toplevel that owns the given @p window in the specified @p role, or
+     * @c null if there is no such Toplevel.
+     */
+    Toplevel *find(xcb_window_t window, Role role) const;
+
+    /**
+     * Returns the number of indexed windows.
+     */
+    int count() const;
+
+    void clear();
+
+private:
+    struct Entry
+    {
+        Toplevel *toplevel;
+        Role role;
+    };
+
+    QHash<xcb_window_t, Entry> m_entries;
+};
+
+} // namespace KWin
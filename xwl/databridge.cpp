@@ -26,6 +26,8 @@
 #include <KWaylandServer/datadevice_interface.h>
 #include <KWaylandServer/seat_interface.h>
 
+#include <QThread>
+
 using namespace KWayland::Client;
 using namespace KWaylandServer;
 
@@ -74,9 +76,30 @@ DataBridge::DataBridge(QObject *parent)
 
 DataBridge::~DataBridge()
 {
+    // The transfers have to be gone before their thread is stopped
+    delete m_clipboard;
+    m_clipboard = nullptr;
+    delete m_dnd;
+    m_dnd = nullptr;
+
+    if (m_transferThread) {
+        m_transferThread->quit();
+        m_transferThread->wait();
+        delete m_transferThread;
+    }
     s_self = nullptr;
 }
 
+QThread *DataBridge::transferThread()
+{
+    if (!m_transferThread) {
+        m_transferThread = new QThread();
+        m_transferThread->setObjectName(QStringLiteral("xwayland transfers"));
+        m_transferThread->start();
+    }
+    return m_transferThread;
+}
+
 void DataBridge::init()
 {
     m_clipboard = new Clipboard(atoms->clipboard, this);
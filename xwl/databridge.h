@@ -15,6 +15,8 @@
 #include <QObject>
 #include <QPoint>
 
+class QThread;
+
 namespace KWayland
 {
 namespace Client
@@ -68,6 +70,11 @@ public:
         return m_dnd;
     }
 
+    /**
+     * Returns the thread that does the pipe I/O of the selection transfers.
+     */
+    QThread *transferThread();
+
     bool nativeEventFilter(const QByteArray &eventType, void *message, long int *result) override;
 
 private:
@@ -75,6 +82,7 @@ private:
 
     Clipboard *m_clipboard = nullptr;
     Dnd *m_dnd = nullptr;
+    QThread *m_transferThread = nullptr;
 
     /* Internal data device interface */
     KWayland::Client::DataDevice *m_dataDevice = nullptr;
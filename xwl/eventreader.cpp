@@ -0,0 +1,241 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "eventreader.h"
+
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+
+#include <cstdlib>
+
+#include <xcb/damage.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+static quint64 makeKey(quint32 high, quint32 low)
+{
+    return (quint64(high) << 32) | low;
+}
+
+EventCoalescer::EventCoalescer(uint8_t damageNotifyEvent)
+    : m_damageNotifyEvent(damageNotifyEvent)
+{
+}
+
+EventCoalescer::Category EventCoalescer::classify(const xcb_generic_event_t *event) const
+{
+    // Events sent by other clients can mean anything, leave them alone.
+    if (event->response_type & 0x80) {
+        return Category::Other;
+    }
+
+    const uint8_t eventType = event->response_type;
+    switch (eventType) {
+    case XCB_PROPERTY_NOTIFY:
+        return Category::Property;
+    case XCB_CONFIGURE_NOTIFY:
+        return Category::Configure;
+    case XCB_SELECTION_CLEAR:
+    case XCB_SELECTION_REQUEST:
+    case XCB_SELECTION_NOTIFY:
+        return Category::Selection;
+    case XCB_MOTION_NOTIFY:
+        return Category::Motion;
+    default:
+        break;
+    }
+    if (m_damageNotifyEvent && eventType == m_damageNotifyEvent) {
+        return Category::Damage;
+    }
+    return Category::Other;
+}
+
+int EventCoalescer::coalesce(QVector<xcb_generic_event_t *> &events) const
+{
+    QSet<quint64> damages;
+    QSet<quint64> newProperties;
+    QSet<quint64> deletedProperties;
+    QSet<quint64> configures;
+    const xcb_generic_event_t *next = nullptr;
+    int removed = 0;
+
+    // Walk backwards, the latest event for every key is seen first and survives.
+    for (int i = events.count() - 1; i >= 0; --i) {
+        xcb_generic_event_t *event = events[i];
+        bool superseded = false;
+
+        switch (classify(event)) {
+        case Category::Damage: {
+            const auto damage = reinterpret_cast<xcb_damage_notify_event_t *>(event);
+            const quint64 key = damage->damage;
+            superseded = damages.contains(key);
+            damages.insert(key);
+            break;
+        }
+        case Category::Property: {
+            const auto property = reinterpret_cast<xcb_property_notify_event_t *>(event);
+            QSet<quint64> &seen = property->state == XCB_PROPERTY_DELETE ? deletedProperties : newProperties;
+            const quint64 key = makeKey(property->window, property->atom);
+            superseded = seen.contains(key);
+            seen.insert(key);
+            break;
+        }
+        case Category::Configure: {
+            const auto configure = reinterpret_cast<xcb_configure_notify_event_t *>(event);
+            const quint64 key = makeKey(configure->event, configure->window);
+            superseded = configures.contains(key);
+            configures.insert(key);
+            break;
+        }
+        case Category::Motion:
+            if (next && classify(next) == Category::Motion) {
+                const auto motion = reinterpret_cast<xcb_motion_notify_event_t *>(event);
+                const auto nextMotion = reinterpret_cast<const xcb_motion_notify_event_t *>(next);
+                superseded = motion->event == nextMotion->event
+                        && motion->child == nextMotion->child
+                        && motion->state == nextMotion->state;
+            }
+            break;
+        case Category::Selection:
+        case Category::Other:
+            break;
+        }
+
+        if (superseded) {
+            free(event);
+            events[i] = nullptr;
+            ++removed;
+        } else {
+            next = event;
+        }
+    }
+
+    if (removed) {
+        events.removeAll(nullptr);
+    }
+    return removed;
+}
+
+static uint8_t damageNotifyEvent(xcb_connection_t *connection)
+{
+    const xcb_query_extension_reply_t *extension = xcb_get_extension_data(connection, &xcb_damage_id);
+    if (!extension || !extension->present) {
+        return 0;
+    }
+    return extension->first_event + XCB_DAMAGE_NOTIFY;
+}
+
+EventReader::EventReader(xcb_connection_t *connection, QObject *parent)
+    : QObject(parent)
+    , m_connection(connection)
+    , m_coalescer(damageNotifyEvent(connection))
+{
+    // The reader thread is woken up with an event sent to this window when it has to quit.
+    const xcb_screen_t *screen = xcb_setup_roots_iterator(xcb_get_setup(connection)).data;
+    m_wakeUpWindow = xcb_generate_id(connection);
+    xcb_create_window(connection, XCB_COPY_FROM_PARENT, m_wakeUpWindow, screen->root,
+                      -1, -1, 1, 1, 0, XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT,
+                      0, nullptr);
+    xcb_flush(connection);
+
+    m_thread = QThread::create([this]() {
+        run();
+    });
+    m_thread->setObjectName(QStringLiteral("xwayland events"));
+    m_thread->start();
+}
+
+EventReader::~EventReader()
+{
+    m_quit = true;
+
+    // If the connection is broken, the reader thread quits on its own.
+    xcb_client_message_event_t event = {};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = m_wakeUpWindow;
+    xcb_send_event(m_connection, false, m_wakeUpWindow, XCB_EVENT_MASK_NO_EVENT,
+                   reinterpret_cast<const char *>(&event));
+    xcb_destroy_window(m_connection, m_wakeUpWindow);
+    xcb_flush(m_connection);
+
+    m_thread->wait();
+    delete m_thread;
+
+    for (xcb_generic_event_t *pending : qAsConst(m_events)) {
+        free(pending);
+    }
+}
+
+QVector<xcb_generic_event_t *> EventReader::takeEvents()
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<xcb_generic_event_t *> events;
+    events.swap(m_events);
+    return events;
+}
+
+bool EventReader::isWakeUp(const xcb_generic_event_t *event) const
+{
+    if ((event->response_type & ~0x80) != XCB_CLIENT_MESSAGE) {
+        return false;
+    }
+    return reinterpret_cast<const xcb_client_message_event_t *>(event)->window == m_wakeUpWindow;
+}
+
+void EventReader::run()
+{
+    QVector<xcb_generic_event_t *> batch;
+
+    while (!m_quit) {
+        xcb_generic_event_t *event = xcb_wait_for_event(m_connection);
+        if (!event) {
+            // The connection has broken, the main thread will find out in eventsAvailable().
+            break;
+        }
+
+        // Collect everything that has been read along with the first event.
+        do {
+            if (isWakeUp(event)) {
+                free(event);
+            } else {
+                batch.append(event);
+            }
+        } while ((event = xcb_poll_for_queued_event(m_connection)));
+
+        if (batch.isEmpty()) {
+            continue;
+        }
+
+        bool notify;
+        {
+            QMutexLocker locker(&m_mutex);
+            notify = m_events.isEmpty();
+            m_events += batch;
+            m_coalescer.coalesce(m_events);
+        }
+        batch.clear();
+
+        // The main thread hasn't taken the previous events yet if the queue wasn't empty,
+        // it will get these ones along with them.
+        if (notify) {
+            Q_EMIT eventsAvailable();
+        }
+    }
+
+    if (!m_quit) {
+        Q_EMIT eventsAvailable();
+    }
+}
+
+} // namespace Xwl
+} // namespace KWin
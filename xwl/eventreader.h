@@ -0,0 +1,114 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KWIN_XWL_EVENTREADER
+#define KWIN_XWL_EVENTREADER
+
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include <xcb/xcb.h>
+
+#include <atomic>
+
+class QThread;
+
+namespace KWin
+{
+namespace Xwl
+{
+
+/**
+ * Drops X11 events that are superseded by a later event of the same kind, so the
+ * main thread doesn't have to handle every intermediate state of a burst of events.
+ */
+class EventCoalescer
+{
+public:
+    enum class Category {
+        Damage,
+        Property,
+        Configure,
+        Selection,
+        Motion,
+        Other,
+    };
+
+    /**
+     * @p damageNotifyEvent is the event code of DamageNotify, or 0 if the DAMAGE
+     * extension is not available.
+     */
+    explicit EventCoalescer(uint8_t damageNotifyEvent = 0);
+
+    Category classify(const xcb_generic_event_t *event) const;
+
+    /**
+     * Removes the events from @p events that are superseded by a later event and frees
+     * them. The order of the remaining events is preserved. Returns the number of
+     * removed events.
+     *
+     * An event is superseded by:
+     * @li a later DamageNotify for the same damage object
+     * @li a later PropertyNotify for the same window, atom, and state
+     * @li a later ConfigureNotify for the same window, reported to the same window
+     * @li an immediately following MotionNotify for the same window and modifier state
+     *
+     * Selection events are never dropped, every one of them is part of a protocol.
+     */
+    int coalesce(QVector<xcb_generic_event_t *> &events) const;
+
+private:
+    uint8_t m_damageNotifyEvent;
+};
+
+/**
+ * Reads the events of an X11 connection on a separate thread.
+ *
+ * The thread waits for events, collects everything that has arrived into a batch and
+ * coalesces it with the events that the main thread hasn't taken yet. The main thread
+ * gets notified with eventsAvailable() and takes the events with takeEvents().
+ */
+class EventReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EventReader(xcb_connection_t *connection, QObject *parent = nullptr);
+    ~EventReader() override;
+
+    /**
+     * Returns the pending events, the caller takes the ownership of them.
+     */
+    QVector<xcb_generic_event_t *> takeEvents();
+
+Q_SIGNALS:
+    /**
+     * Emitted on the reader thread when events become available, or when the connection
+     * has broken.
+     */
+    void eventsAvailable();
+
+private:
+    void run();
+    bool isWakeUp(const xcb_generic_event_t *event) const;
+
+    xcb_connection_t *m_connection;
+    xcb_window_t m_wakeUpWindow;
+    EventCoalescer m_coalescer;
+    QThread *m_thread = nullptr;
+    std::atomic<bool> m_quit{false};
+
+    QMutex m_mutex;
+    QVector<xcb_generic_event_t *> m_events;
+};
+
+} // namespace Xwl
+} // namespace KWin
+
+#endif
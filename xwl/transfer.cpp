@@ -9,6 +9,7 @@
 #include "transfer.h"
 
 #include "databridge.h"
+#include "transferpipe.h"
 #include "xwayland.h"
 
 #include "abstract_client.h"
@@ -41,24 +42,20 @@ namespace Xwl
 // in Bytes: equals 64KB
 static const uint32_t s_incrChunkSize = 63 * 1024;
 
+// The buffers of flushed chunks are reused by the following chunks and transfers
+static ChunkPool *chunkPool()
+{
+    static ChunkPool pool(s_incrChunkSize);
+    return &pool;
+}
+
 Transfer::Transfer(xcb_atom_t selection, qint32 fd, xcb_timestamp_t timestamp, QObject *parent)
     : QObject(parent)
     , m_atom(selection)
     , m_fd(fd)
     , m_timestamp(timestamp)
 {
-}
-
-void Transfer::createSocketNotifier(QSocketNotifier::Type type)
-{
-    delete m_notifier;
-    m_notifier = new QSocketNotifier(m_fd, type, this);
-}
-
-void Transfer::clearSocketNotifier()
-{
-    delete m_notifier;
-    m_notifier = nullptr;
+    m_elapsedTimer.start();
 }
 
 void Transfer::timeout()
@@ -71,8 +68,12 @@ void Transfer::timeout()
 
 void Transfer::endTransfer()
 {
-    clearSocketNotifier();
     closeFd();
+
+    const qint64 elapsed = m_elapsedTimer.elapsed();
+    qCDebug(KWIN_XWL) << "Transferred" << m_transferredBytes << "bytes in" << elapsed << "ms,"
+                      << (m_transferredBytes / 1024) * 1000 / qMax<qint64>(elapsed, 1) << "KiB/s";
+
     Q_EMIT finished();
 }
 
@@ -94,19 +95,26 @@ TransferWltoX::TransferWltoX(xcb_atom_t selection, xcb_selection_request_event_t
 
 TransferWltoX::~TransferWltoX()
 {
+    if (m_reader) {
+        m_reader->destroy();
+        m_reader = nullptr;
+    }
     delete m_request;
     m_request = nullptr;
 }
 
 void TransferWltoX::startTransferFromSource()
 {
-    createSocketNotifier(QSocketNotifier::Read);
-    connect(socketNotifier(), &QSocketNotifier::activated, this,
-            [this](int socket) {
-                Q_UNUSED(socket);
-                readWlSource();
-            }
-    );
+    m_reader = new PipeReader(takeFd(), chunkPool(), DataBridge::self()->transferThread());
+    connect(m_reader, &PipeReader::chunkRead, this, &TransferWltoX::handleChunkRead);
+    connect(m_reader, &PipeReader::finished, this, &TransferWltoX::handleSourceEnd);
+    connect(m_reader, &PipeReader::failed, this, [this]() {
+        qCWarning(KWIN_XWL) << "Error reading in Wl data.";
+
+        // TODO: cleanup X side?
+        endTransfer();
+    });
+    m_reader->start();
 }
 
 int TransferWltoX::flushSourceData()
@@ -119,15 +127,18 @@ int TransferWltoX::flushSourceData()
                         m_request->property,
                         m_request->target,
                         8,
-                        m_chunks.first().first.size(),
-                        m_chunks.first().first.data());
+                        m_chunks.first().size(),
+                        m_chunks.first().constData());
     xcb_flush(xcbConn);
 
     m_propertyIsSet = true;
     resetTimeout();
 
-    const auto rm = m_chunks.takeFirst();
-    return rm.first.size();
+    // xcb doesn't reference the data anymore, the buffer can be reused for another chunk
+    QByteArray chunk = m_chunks.takeFirst();
+    const int size = chunk.size();
+    chunkPool()->release(std::move(chunk));
+    return size;
 }
 
 void TransferWltoX::startIncr()
@@ -159,66 +170,50 @@ void TransferWltoX::startIncr()
     Q_EMIT selectionNotify(m_request, true);
 }
 
-void TransferWltoX::readWlSource()
+void TransferWltoX::handleChunkRead(const QByteArray &chunk)
 {
-    if (m_chunks.size() == 0 ||
-            m_chunks.last().second == s_incrChunkSize) {
-        // append new chunk
-        auto next = QPair<QByteArray, int>();
-        next.first.resize(s_incrChunkSize);
-        next.second = 0;
-        m_chunks.append(next);
-    }
-
-    const auto oldLen = m_chunks.last().second;
-    const auto avail = s_incrChunkSize - m_chunks.last().second;
-    Q_ASSERT(avail > 0);
+    addTransferredBytes(chunk.size());
+    m_chunks.append(chunk);
 
-    ssize_t readLen = read(fd(), m_chunks.last().first.data() + oldLen, avail);
-    if (readLen == -1) {
-        qCWarning(KWIN_XWL) << "Error reading in Wl data.";
-
-        // TODO: cleanup X side?
-        endTransfer();
-        return;
-    }
-    m_chunks.last().second = oldLen + readLen;
-
-    if (readLen == 0) {
-        // at the fd end - complete transfer now
-        m_chunks.last().first.resize(m_chunks.last().second);
-
-        if (incr()) {
-            // incremental transfer is to be completed now
-            m_flushPropertyOnDelete = true;
-            if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
-                flushSourceData();
-            }
-            clearSocketNotifier();
-        } else {
-            // non incremental transfer is to be completed now,
-            // data can be transferred to X client via a single property set
+    if (incr()) {
+        m_flushPropertyOnDelete = true;
+        if (!m_propertyIsSet) {
+            // flush if target's property is not set at the moment
             flushSourceData();
-            Q_EMIT selectionNotify(m_request, true);
-            endTransfer();
         }
-    } else if (m_chunks.last().second == s_incrChunkSize) {
+    } else {
         // first chunk full, but not yet at fd end -> go incremental
-        if (incr()) {
-            m_flushPropertyOnDelete = true;
-            if (!m_propertyIsSet) {
-                // flush if target's property is not set at the moment
-                flushSourceData();
-            }
-        } else {
-            // starting incremental transfer
-            startIncr();
-        }
+        startIncr();
     }
     resetTimeout();
 }
 
+void TransferWltoX::handleSourceEnd(const QByteArray &lastChunk)
+{
+    // at the fd end - complete transfer now
+    m_reader->destroy();
+    m_reader = nullptr;
+
+    addTransferredBytes(lastChunk.size());
+    m_chunks.append(lastChunk);
+
+    if (incr()) {
+        // incremental transfer is to be completed now
+        m_flushPropertyOnDelete = true;
+        if (!m_propertyIsSet) {
+            // flush if target's property is not set at the moment
+            flushSourceData();
+        }
+        resetTimeout();
+    } else {
+        // non incremental transfer is to be completed now,
+        // data can be transferred to X client via a single property set
+        flushSourceData();
+        Q_EMIT selectionNotify(m_request, true);
+        endTransfer();
+    }
+}
+
 bool TransferWltoX::handlePropertyNotify(xcb_property_notify_event_t *event)
 {
     if (event->window == m_request->requestor) {
@@ -240,7 +235,7 @@ void TransferWltoX::handlePropertyDelete()
     m_propertyIsSet = false;
 
     if (m_flushPropertyOnDelete) {
-        if (!socketNotifier() && m_chunks.isEmpty()) {
+        if (!m_reader && m_chunks.isEmpty()) {
             // transfer complete
             xcb_connection_t *xcbConn = kwinApp()->x11Connection();
 
@@ -297,6 +292,12 @@ TransferXtoWl::TransferXtoWl(xcb_atom_t selection, xcb_atom_t target, qint32 fd,
 
 TransferXtoWl::~TransferXtoWl()
 {
+    // The writer may still reference the data of the receiver
+    if (m_writer) {
+        m_writer->destroy();
+        m_writer = nullptr;
+    }
+
     xcb_connection_t *xcbConn = kwinApp()->x11Connection();
     xcb_destroy_window(xcbConn, m_window);
     xcb_flush(xcbConn);
@@ -542,41 +543,39 @@ void MozUrlReceiver::setData(const char *value, int length)
 
 void TransferXtoWl::dataSourceWrite()
 {
-    QByteArray property = m_receiver->data();
-
-    ssize_t len = write(fd(), property.constData(), property.size());
-    if (len == -1) {
-        qCWarning(KWIN_XWL) << "X11 to Wayland write error on fd:" << fd();
-        endTransfer();
-        return;
+    if (!m_writer) {
+        m_writer = new PipeWriter(takeFd(), DataBridge::self()->transferThread());
+        connect(m_writer, &PipeWriter::bytesWritten, this, [this](qint64 count) {
+            addTransferredBytes(count);
+            resetTimeout();
+        });
+        connect(m_writer, &PipeWriter::drained, this, &TransferXtoWl::handleDataWritten);
+        connect(m_writer, &PipeWriter::failed, this, [this]() {
+            qCWarning(KWIN_XWL) << "X11 to Wayland write error";
+            endTransfer();
+        });
     }
 
-    m_receiver->partRead(len);
-    if (len == property.size()) {
-        // property completely transferred
-        if (incr()) {
-            clearSocketNotifier();
-            xcb_connection_t *xcbConn = kwinApp()->x11Connection();
-            xcb_delete_property(xcbConn,
-                                m_window,
-                                atoms->wl_selection);
-            xcb_flush(xcbConn);
-        } else {
-            // transfer complete
-            endTransfer();
-        }
+    // The data is written straight from the property reply, which stays
+    // around until the writer is done with it
+    m_writer->send(m_receiver->data());
+    resetTimeout();
+}
+
+void TransferXtoWl::handleDataWritten()
+{
+    // property completely transferred
+    m_receiver->partRead(m_receiver->data().size());
+    if (incr()) {
+        xcb_connection_t *xcbConn = kwinApp()->x11Connection();
+        xcb_delete_property(xcbConn,
+                            m_window,
+                            atoms->wl_selection);
+        xcb_flush(xcbConn);
     } else {
-        if (!socketNotifier()) {
-            createSocketNotifier(QSocketNotifier::Write);
-            connect(socketNotifier(), &QSocketNotifier::activated, this,
-                [this](int socket) {
-                    Q_UNUSED(socket);
-                    dataSourceWrite();
-                }
-            );
-        }
+        // transfer complete
+        endTransfer();
     }
-    resetTimeout();
 }
 
 } // namespace Xwl
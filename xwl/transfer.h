@@ -9,8 +9,8 @@
 #ifndef KWIN_XWL_TRANSFER
 #define KWIN_XWL_TRANSFER
 
+#include <QElapsedTimer>
 #include <QObject>
-#include <QSocketNotifier>
 #include <QVector>
 
 #include <xcb/xcb.h>
@@ -32,6 +32,8 @@ namespace KWin
 {
 namespace Xwl
 {
+class PipeReader;
+class PipeWriter;
 
 /**
  * Represents for an arbitrary selection a data transfer between
@@ -66,8 +68,13 @@ protected:
     xcb_atom_t atom() const {
         return m_atom;
     }
-    qint32 fd() const {
-        return m_fd;
+    /**
+     * Hands the file descriptor over to the caller, the transfer won't close it.
+     */
+    qint32 takeFd() {
+        const qint32 fd = m_fd;
+        m_fd = -1;
+        return fd;
     }
 
     void setIncr(bool set) {
@@ -79,10 +86,8 @@ protected:
     void resetTimeout() {
         m_timeout = false;
     }
-    void createSocketNotifier(QSocketNotifier::Type type);
-    void clearSocketNotifier();
-    QSocketNotifier *socketNotifier() const {
-        return m_notifier;
+    void addTransferredBytes(qint64 count) {
+        m_transferredBytes += count;
     }
 private:
     void closeFd();
@@ -91,7 +96,8 @@ private:
     qint32 m_fd;
     xcb_timestamp_t m_timestamp = XCB_CURRENT_TIME;
 
-    QSocketNotifier *m_notifier = nullptr;
+    QElapsedTimer m_elapsedTimer;
+    qint64 m_transferredBytes = 0;
     bool m_incr = false;
     bool m_timeout = false;
 
@@ -120,16 +126,16 @@ Q_SIGNALS:
 
 private:
     void startIncr();
-    void readWlSource();
+    void handleChunkRead(const QByteArray &chunk);
+    void handleSourceEnd(const QByteArray &lastChunk);
     int flushSourceData();
     void handlePropertyDelete();
 
     xcb_selection_request_event_t *m_request = nullptr;
+    PipeReader *m_reader = nullptr;
 
-    /* contains all received data portioned in chunks
-     * TODO: explain second QPair component
-     */
-    QVector<QPair<QByteArray, int> > m_chunks;
+    /* contains all received data portioned in chunks */
+    QVector<QByteArray> m_chunks;
 
     bool m_propertyIsSet = false;
     bool m_flushPropertyOnDelete = false;
@@ -204,11 +210,13 @@ public:
 
 private:
     void dataSourceWrite();
+    void handleDataWritten();
     void startTransfer();
     void getIncrChunk();
 
     xcb_window_t m_window;
     DataReceiver *m_receiver = nullptr;
+    PipeWriter *m_writer = nullptr;
 
     Q_DISABLE_COPY(TransferXtoWl)
 };
@@ -0,0 +1,205 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "transferpipe.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace KWin
+{
+namespace Xwl
+{
+
+ChunkPool::ChunkPool(int chunkSize, int maximumCount)
+    : m_chunkSize(chunkSize)
+    , m_maximumCount(maximumCount)
+{
+}
+
+int ChunkPool::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_chunks.count();
+}
+
+QByteArray ChunkPool::acquire()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_chunks.isEmpty()) {
+        locker.unlock();
+        return QByteArray(m_chunkSize, Qt::Uninitialized);
+    }
+    QByteArray chunk = m_chunks.takeLast();
+    locker.unlock();
+
+    // The last chunk of a transfer has been shrunk, growing it back doesn't reallocate.
+    chunk.resize(m_chunkSize);
+    return chunk;
+}
+
+void ChunkPool::release(QByteArray &&chunk)
+{
+    if (!chunk.isDetached() || chunk.capacity() < m_chunkSize) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    if (m_chunks.count() < m_maximumCount) {
+        m_chunks.append(std::move(chunk));
+    }
+}
+
+TransferPipe::TransferPipe(int fd, QSocketNotifier::Type type, QThread *thread)
+    : m_notifierType(type)
+    , m_fd(fd)
+{
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+    moveToThread(thread);
+}
+
+TransferPipe::~TransferPipe()
+{
+    delete m_notifier;
+    close(m_fd);
+}
+
+void TransferPipe::destroy()
+{
+    QThread *workerThread = thread();
+    if (workerThread != QThread::currentThread() && workerThread->isRunning()) {
+        QMetaObject::invokeMethod(this, [this]() {
+            delete this;
+        }, Qt::BlockingQueuedConnection);
+    } else {
+        delete this;
+    }
+}
+
+void TransferPipe::setNotifierEnabled(bool enabled)
+{
+    if (!m_notifier) {
+        if (!enabled) {
+            return;
+        }
+        m_notifier = new QSocketNotifier(m_fd, m_notifierType);
+        connect(m_notifier, &QSocketNotifier::activated, this, [this]() {
+            handleNotifier();
+        });
+    }
+    m_notifier->setEnabled(enabled);
+}
+
+PipeReader::PipeReader(int fd, ChunkPool *pool, QThread *thread)
+    : TransferPipe(fd, QSocketNotifier::Read, thread)
+    , m_pool(pool)
+{
+}
+
+void PipeReader::start()
+{
+    QMetaObject::invokeMethod(this, [this]() {
+        handleNotifier();
+    }, Qt::QueuedConnection);
+}
+
+void PipeReader::handleNotifier()
+{
+    if (m_chunk.isNull()) {
+        m_chunk = m_pool->acquire();
+        m_chunkLength = 0;
+    }
+
+    while (true) {
+        const ssize_t readLength = read(fd(), m_chunk.data() + m_chunkLength, m_chunk.size() - m_chunkLength);
+        if (readLength == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                setNotifierEnabled(true);
+                return;
+            }
+            setNotifierEnabled(false);
+            Q_EMIT failed();
+            return;
+        }
+
+        if (readLength == 0) {
+            setNotifierEnabled(false);
+            m_chunk.resize(m_chunkLength);
+            Q_EMIT finished(m_chunk);
+            m_chunk = QByteArray();
+            return;
+        }
+
+        m_chunkLength += readLength;
+        if (m_chunkLength == m_chunk.size()) {
+            Q_EMIT chunkRead(m_chunk);
+            m_chunk = QByteArray();
+            // Hand out at most one chunk at a time so destroy() never has to wait for
+            // long, the notifier fires again right away if there is more data.
+            setNotifierEnabled(true);
+            return;
+        }
+    }
+}
+
+PipeWriter::PipeWriter(int fd, QThread *thread)
+    : TransferPipe(fd, QSocketNotifier::Write, thread)
+{
+}
+
+void PipeWriter::send(const QByteArray &data)
+{
+    QMetaObject::invokeMethod(this, [this, data]() {
+        m_data = data;
+        m_offset = 0;
+        handleNotifier();
+    }, Qt::QueuedConnection);
+}
+
+void PipeWriter::handleNotifier()
+{
+    qint64 written = 0;
+    while (m_offset < m_data.size()) {
+        const ssize_t length = write(fd(), m_data.constData() + m_offset, m_data.size() - m_offset);
+        if (length == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            setNotifierEnabled(false);
+            m_data = QByteArray();
+            Q_EMIT failed();
+            return;
+        }
+        m_offset += length;
+        written += length;
+    }
+
+    if (written > 0) {
+        Q_EMIT bytesWritten(written);
+    }
+    if (m_offset < m_data.size()) {
+        setNotifierEnabled(true);
+        return;
+    }
+
+    setNotifierEnabled(false);
+    m_data = QByteArray();
+    Q_EMIT drained();
+}
+
+} // namespace Xwl
+} // namespace KWin
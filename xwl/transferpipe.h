@@ -0,0 +1,160 @@
+/*
+    KWin - the KDE window manager
+    This file is part of the KDE project.
+
+    SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef KWIN_XWL_TRANSFERPIPE
+#define KWIN_XWL_TRANSFERPIPE
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QSocketNotifier>
+#include <QVector>
+
+class QThread;
+
+namespace KWin
+{
+namespace Xwl
+{
+
+/**
+ * Keeps the buffers of finished chunks around so the next chunks can reuse them
+ * instead of allocating new memory. The pool can be used from several threads.
+ */
+class ChunkPool
+{
+public:
+    explicit ChunkPool(int chunkSize, int maximumCount = 16);
+
+    int chunkSize() const {
+        return m_chunkSize;
+    }
+    /**
+     * Returns the number of buffers waiting to be reused.
+     */
+    int count() const;
+
+    /**
+     * Returns a buffer of chunkSize() bytes, the contents are undefined.
+     */
+    QByteArray acquire();
+    /**
+     * Gives the buffer of the @p chunk back to the pool. The chunk is dropped if
+     * its buffer is still shared or if the pool is full.
+     */
+    void release(QByteArray &&chunk);
+
+private:
+    mutable QMutex m_mutex;
+    QVector<QByteArray> m_chunks;
+    const int m_chunkSize;
+    const int m_maximumCount;
+};
+
+/**
+ * Moves the data of a transfer between a pipe and memory on a worker thread, so big
+ * payloads or peers that are slow to read don't block the main thread.
+ *
+ * The pipe takes over the file descriptor and closes it when it's destroyed. The
+ * signals are emitted on the worker thread, connect to them with a receiver on the
+ * main thread to get them queued.
+ */
+class TransferPipe : public QObject
+{
+    Q_OBJECT
+
+public:
+    TransferPipe(int fd, QSocketNotifier::Type type, QThread *thread);
+    ~TransferPipe() override;
+
+    /**
+     * Destroys the pipe. Unlike deleteLater(), the worker thread is done with the pipe
+     * and with any memory handed to it when this function returns.
+     */
+    void destroy();
+
+Q_SIGNALS:
+    void failed();
+
+protected:
+    int fd() const {
+        return m_fd;
+    }
+    void setNotifierEnabled(bool enabled);
+    virtual void handleNotifier() = 0;
+
+private:
+    QSocketNotifier *m_notifier = nullptr;
+    QSocketNotifier::Type m_notifierType;
+    int m_fd;
+};
+
+/**
+ * Reads the pipe until the end and hands the data out in chunks taken from a ChunkPool.
+ */
+class PipeReader : public TransferPipe
+{
+    Q_OBJECT
+
+public:
+    PipeReader(int fd, ChunkPool *pool, QThread *thread);
+
+    void start();
+
+Q_SIGNALS:
+    /**
+     * Emitted for every chunk that has been filled completely.
+     */
+    void chunkRead(const QByteArray &chunk);
+    /**
+     * Emitted at the end of the pipe with the data read after the last complete
+     * chunk, which may be empty.
+     */
+    void finished(const QByteArray &lastChunk);
+
+protected:
+    void handleNotifier() override;
+
+private:
+    ChunkPool *m_pool;
+    QByteArray m_chunk;
+    int m_chunkLength = 0;
+};
+
+/**
+ * Writes data to the pipe. The data is written without copying it, so it has to
+ * stay valid until drained() is emitted or the writer is destroyed.
+ */
+class PipeWriter : public TransferPipe
+{
+    Q_OBJECT
+
+public:
+    PipeWriter(int fd, QThread *thread);
+
+    /**
+     * Starts writing @p data. Must not be called before the previous data is drained.
+     */
+    void send(const QByteArray &data);
+
+Q_SIGNALS:
+    void bytesWritten(qint64 count);
+    void drained();
+
+protected:
+    void handleNotifier() override;
+
+private:
+    QByteArray m_data;
+    int m_offset = 0;
+};
+
+} // namespace Xwl
+} // namespace KWin
+
+#endif
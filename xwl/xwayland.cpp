@@ -10,6 +10,7 @@
 */
 #include "xwayland.h"
 #include "databridge.h"
+#include "eventreader.h"
 
 #include "main_wayland.h"
 #include "options.h"
@@ -180,6 +181,14 @@ void Xwayland::restart()
     start();
 }
 
+static void dispatchEvent(xcb_generic_event_t *event)
+{
+    long result = 0;
+    QAbstractEventDispatcher *dispatcher = QCoreApplication::eventDispatcher();
+    dispatcher->filterNativeEvent(QByteArrayLiteral("xcb_generic_event_t"), event, &result);
+    free(event);
+}
+
 void Xwayland::dispatchEvents()
 {
     xcb_connection_t *connection = kwinApp()->x11Connection();
@@ -195,11 +204,15 @@ void Xwayland::dispatchEvents()
         return;
     }
 
-    while (xcb_generic_event_t *event = xcb_poll_for_event(connection)) {
-        long result = 0;
-        QAbstractEventDispatcher *dispatcher = QCoreApplication::eventDispatcher();
-        dispatcher->filterNativeEvent(QByteArrayLiteral("xcb_generic_event_t"), event, &result);
-        free(event);
+    if (m_eventReader) {
+        const QVector<xcb_generic_event_t *> events = m_eventReader->takeEvents();
+        for (xcb_generic_event_t *event : events) {
+            dispatchEvent(event);
+        }
+    } else {
+        while (xcb_generic_event_t *event = xcb_poll_for_event(connection)) {
+            dispatchEvent(event);
+        }
     }
 
     xcb_flush(connection);
@@ -207,10 +220,17 @@ void Xwayland::dispatchEvents()
 
 void Xwayland::installSocketNotifier()
 {
-    const int fileDescriptor = xcb_get_file_descriptor(kwinApp()->x11Connection());
+    if (qgetenv("KWIN_XWAYLAND_EVENT_THREAD") == QByteArrayLiteral("1")) {
+        // The events are read and coalesced on the reader thread, the main thread only
+        // handles what is left of them.
+        m_eventReader = new EventReader(kwinApp()->x11Connection());
+        connect(m_eventReader, &EventReader::eventsAvailable, this, &Xwayland::dispatchEvents, Qt::QueuedConnection);
+    } else {
+        const int fileDescriptor = xcb_get_file_descriptor(kwinApp()->x11Connection());
 
-    m_socketNotifier = new QSocketNotifier(fileDescriptor, QSocketNotifier::Read, this);
-    connect(m_socketNotifier, &QSocketNotifier::activated, this, &Xwayland::dispatchEvents);
+        m_socketNotifier = new QSocketNotifier(fileDescriptor, QSocketNotifier::Read, this);
+        connect(m_socketNotifier, &QSocketNotifier::activated, this, &Xwayland::dispatchEvents);
+    }
 
     QAbstractEventDispatcher *dispatcher = QCoreApplication::eventDispatcher();
     connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &Xwayland::dispatchEvents);
@@ -225,6 +245,9 @@ void Xwayland::uninstallSocketNotifier()
 
     delete m_socketNotifier;
     m_socketNotifier = nullptr;
+
+    delete m_eventReader;
+    m_eventReader = nullptr;
 }
 
 void Xwayland::handleXwaylandStarted()
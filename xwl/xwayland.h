@@ -22,6 +22,7 @@ class ApplicationWaylandAbstract;
 
 namespace Xwl
 {
+class EventReader;
 
 class Xwayland : public XwaylandInterface
 {
@@ -101,6 +102,7 @@ private:
     int m_xcbConnectionFd = -1;
     QProcess *m_xwaylandProcess = nullptr;
     QSocketNotifier *m_socketNotifier = nullptr;
+    EventReader *m_eventReader = nullptr;
     QTimer *m_resetCrashCountTimer = nullptr;
     QByteArray m_displayName;
     QFutureWatcher<QByteArray> *m_watcher = nullptr;